@@ -70,6 +70,20 @@ long ctlListView::AppendItem(int icon, const wxString &val, const wxString &val2
 }
 
 
+void ctlListView::UpdateItem(long row, long col, const wxString &text)
+{
+	if (GetText(row, col) != text)
+		SetItem(row, col, text);
+}
+
+
+void ctlListView::UpdateItemBackgroundColour(long row, const wxColour &colour)
+{
+	if (GetItemBackgroundColour(row) != colour)
+		SetItemBackgroundColour(row, colour);
+}
+
+
 void ctlListView::CreateColumns(wxImageList *images, const wxString &left, const wxString &right, int leftSize)
 {
 	int rightSize;
@@ -0,0 +1,280 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// ctlLogList.cpp - virtual listview control showing the tail of a server log
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// App headers
+#include "ctl/ctlLogList.h"
+
+
+size_t ctlLogRow::GetSize() const
+{
+	size_t size = sizeof(ctlLogRow);
+	for (int i = 0; i < LOGLIST_COLUMNS; i++)
+		size += cols[i].Length() * sizeof(wxChar);
+	return size;
+}
+
+
+ctlLogList::ctlLogList(wxWindow *p, int id, wxPoint pos, wxSize siz, long attr)
+	: ctlListView(p, id, pos, siz, attr | wxLC_VIRTUAL)
+{
+	capacity = 1024;
+	rows = new ctlLogRow*[capacity];
+	head = 0;
+	count = 0;
+	firstNumber = 0;
+	usedBytes = 0;
+
+	levelColumn = -1;
+
+	filterLevel = LOGLEVEL_DEBUG;
+	shownStart = 0;
+	filteredUpTo = 0;
+}
+
+
+ctlLogList::~ctlLogList()
+{
+	for (long i = 0; i < count; i++)
+		delete rows[(head + i) % capacity];
+	delete [] rows;
+}
+
+
+int ctlLogList::GetLevel(const wxString &severity)
+{
+	wxString level = severity.Strip(wxString::both);
+
+	if (level.StartsWith(wxT("DEBUG")))
+		return LOGLEVEL_DEBUG;
+	if (level == wxT("LOG") || level == wxT("INFO"))
+		return LOGLEVEL_LOG;
+	if (level == wxT("NOTICE"))
+		return LOGLEVEL_NOTICE;
+	if (level == wxT("WARNING"))
+		return LOGLEVEL_WARNING;
+	if (level == wxT("ERROR"))
+		return LOGLEVEL_ERROR;
+	if (level == wxT("FATAL"))
+		return LOGLEVEL_FATAL;
+	if (level == wxT("PANIC"))
+		return LOGLEVEL_PANIC;
+
+	// DETAIL, HINT, STATEMENT, CONTEXT and the like
+	return LOGLEVEL_UNKNOWN;
+}
+
+
+void ctlLogList::AddRow(const wxString &text)
+{
+	if (count == capacity)
+	{
+		// Grow the ring, putting the oldest row first again
+		long newCapacity = capacity * 2;
+		ctlLogRow **newRows = new ctlLogRow*[newCapacity];
+
+		for (long i = 0; i < count; i++)
+			newRows[i] = rows[(head + i) % capacity];
+
+		delete [] rows;
+		rows = newRows;
+		capacity = newCapacity;
+		head = 0;
+	}
+
+	long number = firstNumber + count;
+	ctlLogRow *row = new ctlLogRow();
+
+	if (count && levelColumn >= 0)
+	{
+		// Part of the record above, unless it gets a level of its own
+		ctlLogRow *prev = GetRow(number - 1);
+		row->record = prev->record;
+		row->level = prev->level;
+	}
+	else
+		row->record = number;
+
+	rows[(head + count) % capacity] = row;
+	count++;
+	usedBytes += row->GetSize();
+
+	if (!text.IsEmpty())
+		SetLastItem(0, text);
+
+	while (usedBytes > LOGLIST_MEMORY_BUDGET && count > 1)
+		DropOldest();
+}
+
+
+void ctlLogList::SetLastItem(int col, const wxString &text)
+{
+	if (!count || col < 0 || col >= LOGLIST_COLUMNS)
+		return;
+
+	long number = firstNumber + count - 1;
+	ctlLogRow *row = GetRow(number);
+
+	usedBytes -= row->GetSize();
+	row->cols[col] = text;
+	usedBytes += row->GetSize();
+
+	if (col == levelColumn)
+	{
+		int level = GetLevel(text);
+		if (level != LOGLEVEL_UNKNOWN)
+		{
+			row->record = number;
+			row->level = level;
+		}
+	}
+}
+
+
+void ctlLogList::DropOldest()
+{
+	ctlLogRow *row = rows[head];
+	usedBytes -= row->GetSize();
+	delete row;
+
+	head = (head + 1) % capacity;
+	count--;
+	firstNumber++;
+
+	while (shownStart < shown.GetCount() && shown.Item(shownStart) < firstNumber)
+		shownStart++;
+
+	// Don't move the rest of the numbers down for every row dropped
+	if (shownStart > 1024 && shownStart > shown.GetCount() / 2)
+	{
+		shown.RemoveAt(0, shownStart);
+		shownStart = 0;
+	}
+}
+
+
+void ctlLogList::Flush()
+{
+	if (IsFiltered())
+	{
+		FilterRows();
+		SetItemCount(shown.GetCount() - shownStart);
+	}
+	else
+		SetItemCount(count);
+
+	Refresh();
+}
+
+
+void ctlLogList::ClearRows()
+{
+	for (long i = 0; i < count; i++)
+		delete rows[(head + i) % capacity];
+
+	head = 0;
+	count = 0;
+	firstNumber = 0;
+	usedBytes = 0;
+
+	shown.Empty();
+	shownStart = 0;
+	filteredUpTo = 0;
+
+	SetItemCount(0);
+	Refresh();
+}
+
+
+void ctlLogList::SetFilter(int minLevel, const wxString &text)
+{
+	filterLevel = minLevel;
+	filterText = text.Lower();
+
+	shown.Empty();
+	shownStart = 0;
+	filteredUpTo = firstNumber;
+
+	Flush();
+}
+
+
+bool ctlLogList::RowMatches(ctlLogRow *row) const
+{
+	if (filterText.IsEmpty())
+		return true;
+
+	for (int i = 0; i < LOGLIST_COLUMNS; i++)
+	{
+		if (!row->cols[i].IsEmpty() && row->cols[i].Lower().Find(filterText) >= 0)
+			return true;
+	}
+	return false;
+}
+
+
+// Filter the records added since the last time. The last record may have
+// got more rows since then, so it's filtered again.
+void ctlLogList::FilterRows()
+{
+	long end = firstNumber + count;
+	long number = wxMax(filteredUpTo, firstNumber);
+
+	while (shown.GetCount() > shownStart && shown.Last() >= number)
+		shown.RemoveAt(shown.GetCount() - 1);
+
+	while (number < end)
+	{
+		ctlLogRow *row = GetRow(number);
+		long record = row->record, next = number + 1;
+		bool matches = RowMatches(row);
+
+		while (next < end && GetRow(next)->record == record)
+		{
+			if (!matches)
+				matches = RowMatches(GetRow(next));
+			next++;
+		}
+
+		if (matches && (filterLevel <= LOGLEVEL_DEBUG || row->level >= filterLevel))
+		{
+			for (long i = number; i < next; i++)
+				shown.Add(i);
+		}
+
+		filteredUpTo = number;
+		number = next;
+	}
+}
+
+
+wxString ctlLogList::OnGetItemText(long item, long col) const
+{
+	long number;
+
+	if (IsFiltered())
+	{
+		if (item < 0 || shownStart + item >= shown.GetCount())
+			return wxEmptyString;
+		number = shown.Item(shownStart + item);
+	}
+	else
+		number = firstNumber + item;
+
+	if (number < firstNumber || number >= firstNumber + count || col < 0 || col >= LOGLIST_COLUMNS)
+		return wxEmptyString;
+
+	return GetRow(number)->cols[col];
+}
@@ -18,6 +18,7 @@
 
 // App headers
 #include "db/pgSet.h"
+#include "db/pgCompletionCache.h"
 #include "ctl/ctlSQLBox.h"
 #include "dlg/dlgFindReplace.h"
 #include "frm/menu.h"
@@ -53,6 +54,8 @@ IMPLEMENT_DYNAMIC_CLASS(ctlSQLBox, wxStyledTextCtrl)
 ctlSQLBox::ctlSQLBox()
 {
 	m_dlgFindReplace = 0;
+	m_database = NULL;
+	m_completionCache = NULL;
 	m_autoIndent = false;
 	m_autocompDisabled = false;
 	process = 0;
@@ -65,6 +68,7 @@ ctlSQLBox::ctlSQLBox(wxWindow *parent, wxWindowID id, const wxPoint &pos, const
 	m_dlgFindReplace = 0;
 
 	m_database = NULL;
+	m_completionCache = NULL;
 
 	m_autocompDisabled = false;
 	process = 0;
@@ -178,7 +182,16 @@ void ctlSQLBox::Create(wxWindow *parent, wxWindowID id, const wxPoint &pos, cons
 
 void ctlSQLBox::SetDatabase(pgConn *db)
 {
+	if (m_completionCache)
+	{
+		m_completionCache->Release();
+		m_completionCache = NULL;
+	}
+
 	m_database = db;
+
+	if (db)
+		m_completionCache = pgCompletionCache::Acquire(db);
 }
 
 void ctlSQLBox::OnSearchReplace(wxCommandEvent &ev)
@@ -787,10 +800,35 @@ ctlSQLBox::~ctlSQLBox()
 		m_dlgFindReplace->Destroy();
 		m_dlgFindReplace = 0;
 	}
+	if (m_completionCache)
+		m_completionCache->Release();
 	AbortProcess();
 }
 
 
+// Format the names as expected by tab-complete.c
+static char *CompletionString(const wxArrayString &names)
+{
+	wxString ret = wxString();
+
+	for (size_t i = 0; i < names.GetCount(); i++)
+	{
+		const wxString &tmp = names.Item(i);
+		if (tmp.Mid(tmp.Length() - 1) == wxT("."))
+			ret += tmp + wxT("\t");
+		else
+			ret += tmp + wxT(" \t");
+	}
+
+	ret.Trim();
+	// Trims both space and tab, but we want to keep the space!
+	if (ret.Length() > 0)
+		ret += wxT(" ");
+
+	return strdup(ret.mb_str(wxConvUTF8));
+}
+
+
 /*
  * Callback function from tab-complete.c, bridging the gap between C++ and C.
  * Execute a query using the C++ APIs, returning it as a tab separated
@@ -806,31 +844,37 @@ char *pg_query_to_single_ordered_string(char *query, void *dbptr)
 	if (!res)
 		return NULL;
 
-	wxString ret = wxString();
-	wxString tmp;
-
+	wxArrayString names;
 	while (!res->Eof())
 	{
-		tmp =  res->GetVal(0);
-		if (tmp.Mid(tmp.Length() - 1) == wxT("."))
-			ret += tmp + wxT("\t");
-		else
-			ret += tmp + wxT(" \t");
-
+		names.Add(res->GetVal(0));
 		res->MoveNext();
 	}
+	delete res;
 
-	if(res)
-	{
-		delete res;
-		res = NULL;
-	}
-	ret.Trim();
-	// Trims both space and tab, but we want to keep the space!
-	if (ret.Length() > 0)
-		ret += wxT(" ");
+	return CompletionString(names);
+}
 
-	return strdup(ret.mb_str(wxConvUTF8));
+
+/*
+ * Callback function from tab-complete.c: the names of the given kind, as read
+ * in the background by the completion cache of the database. Returns NULL if
+ * they aren't known (yet), so the query is sent to the server instead; an
+ * empty string if the cache knows there are none.
+ */
+extern "C"
+char *pg_cached_completion(const char *kind, const char *text, const char *addon, void *dbptr)
+{
+	pgConn *db = (pgConn *)dbptr;
+	pgCompletionCache *cache = pgCompletionCache::Find(db);
+	if (!cache)
+		return NULL;
+
+	wxArrayString names;
+	if (!cache->Complete(db, kind, wxString(text, wxConvUTF8), addon ? wxString(addon, wxConvUTF8) : wxString(), names))
+		return NULL;
+
+	return CompletionString(names);
 }
 
 
@@ -452,16 +452,44 @@ void ctlSQLGrid::AutoSizeColumn(int col, bool setAsMin, bool doLimit)
 
 void ctlSQLGrid::AutoSizeColumns(bool setAsMin)
 {
-	wxCoord newSize, oldSize;
-	wxCoord maxSize, totalSize = 0, availSize;
 	int col, nCols = GetNumberCols();
 	int row, nRows = GetNumberRows();
-	colMaxSizes.Empty();
+	wxArrayInt cellSizes;
 
 	/* We need to check each cell's width to choose best. wxGrid::AutoSizeColumns()
 	 * is good, but looping through long result sets gives a noticeable slowdown.
 	 * Thus we'll check every first 500 cells for each column.
 	 */
+	cellSizes.Alloc(nCols);
+	for (col = 0 ; col < nCols; col++)
+	{
+		int cellSize = 0;
+
+		// The user-specified size will be restored
+		if (colSizes.find(GetColKeyValue(col)) == colSizes.end())
+		{
+			for (row = 0 ; row < wxMin(nRows, 500) ; row++)
+			{
+				wxSize size = GetBestSize(row, col);
+				if ( size.x > cellSize )
+					cellSize = size.x;
+			}
+		}
+		cellSizes.Add(cellSize);
+	}
+
+	SetColumnSizes(cellSizes);
+}
+
+void ctlSQLGrid::SetColumnSizes(const wxArrayInt &cellSizes)
+{
+	wxCoord newSize, oldSize;
+	wxCoord maxSize, totalSize = 0, availSize;
+	int col, nCols = GetNumberCols();
+	colMaxSizes.Empty();
+
+	wxClientDC dc(GetGridWindow());
+	dc.SetFont( GetLabelFont() );
 
 	// First pass: auto-size columns
 	for (col = 0 ; col < nCols; col++)
@@ -474,18 +502,11 @@ void ctlSQLGrid::AutoSizeColumns(bool setAsMin)
 		}
 		else
 		{
-			wxClientDC dc(GetGridWindow());
-			newSize = 0;
 			// get cells's width
-			for (row = 0 ; row < wxMin(nRows, 500) ; row++)
-			{
-				wxSize size = GetBestSize(row, col);
-				if ( size.x > newSize )
-					newSize = size.x;
-			}
+			newSize = col < (int)cellSizes.GetCount() ? cellSizes[col] : 0;
+
 			// get column's label width
 			wxCoord w, h;
-			dc.SetFont( GetLabelFont() );
 			dc.GetMultiLineTextExtent( GetColLabelValue(col), &w, &h );
 			if ( GetColLabelTextOrientation() == wxVERTICAL )
 				w = h;
@@ -17,10 +17,22 @@
 
 #include "db/pgConn.h"
 #include "db/pgQueryThread.h"
+#include "db/pgRowStore.h"
+#include "db/pgResultView.h"
 #include "ctl/ctlSQLResult.h"
 #include "utils/sysSettings.h"
 #include "frm/frmExport.h"
 
+wxWindowID CTLSQL_STREAM_TIMER_ID = ::wxNewId();
+wxWindowID CTLSQL_SORT_ASC_ID = ::wxNewId();
+wxWindowID CTLSQL_SORT_DESC_ID = ::wxNewId();
+wxWindowID CTLSQL_FILTER_ID = ::wxNewId();
+wxWindowID CTLSQL_RESET_VIEW_ID = ::wxNewId();
+wxWindowID CTLSQL_SIZING_DONE_ID = ::wxNewId();
+wxWindowID CTLSQL_COPY_INSERT_ID = ::wxNewId();
+wxWindowID CTLSQL_COPY_COPY_ID = ::wxNewId();
+
+static sqlResultGlyphWidthsMap glyphWidthsCache;
 
 
 ctlSQLResult::ctlSQLResult(wxWindow *parent, pgConn *_conn, wxWindowID id, const wxPoint &pos, const wxSize &size)
@@ -28,13 +40,33 @@ ctlSQLResult::ctlSQLResult(wxWindow *parent, pgConn *_conn, wxWindowID id, const
 {
 	conn = _conn;
 	thread = NULL;
+	rowcountSuppressed = false;
+
+	rowStore = NULL;
+	publishedRows = 0;
+	publishedCols = 0;
+	publishedGeneration = 0;
+	streamTimer = new wxTimer(this, CTLSQL_STREAM_TIMER_ID);
+	viewCol = -1;
+	sizer = NULL;
 
-	SetTable(new sqlResultTable(), true);
+	sqlResultTable *table = new sqlResultTable();
+	table->SetView(&resultView);
+	SetTable(table, true);
 
 	EnableEditing(false);
 	SetSizer(new wxBoxSizer(wxVERTICAL));
 
 	Connect(wxID_ANY, wxEVT_GRID_RANGE_SELECT, wxGridRangeSelectEventHandler(ctlSQLResult::OnGridSelect));
+	Connect(CTLSQL_STREAM_TIMER_ID, wxEVT_TIMER, wxTimerEventHandler(ctlSQLResult::OnStreamTimer));
+	Connect(wxID_ANY, wxEVT_GRID_LABEL_RIGHT_CLICK, wxGridEventHandler(ctlSQLResult::OnLabelRightClick));
+	Connect(CTLSQL_SORT_ASC_ID, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(ctlSQLResult::OnSortColumn));
+	Connect(CTLSQL_SORT_DESC_ID, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(ctlSQLResult::OnSortColumn));
+	Connect(CTLSQL_FILTER_ID, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(ctlSQLResult::OnFilterColumn));
+	Connect(CTLSQL_RESET_VIEW_ID, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(ctlSQLResult::OnResetView));
+	Connect(CTLSQL_SIZING_DONE_ID, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(ctlSQLResult::OnSizingDone));
+	Connect(CTLSQL_COPY_INSERT_ID, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(ctlSQLResult::OnCopyAs));
+	Connect(CTLSQL_COPY_COPY_ID, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(ctlSQLResult::OnCopyAs));
 }
 
 
@@ -54,6 +86,14 @@ ctlSQLResult::~ctlSQLResult()
 		delete thread;
 		thread = NULL;
 	}
+
+	delete streamTimer;
+
+	if (rowStore)
+	{
+		delete rowStore;
+		rowStore = NULL;
+	}
 }
 
 
@@ -80,7 +120,7 @@ bool ctlSQLResult::ToFile()
 	{
 		frmExport dlg(this);
 		if (dlg.ShowModal() == wxID_OK)
-			return dlg.Export(thread->DataSet());
+			return dlg.Export(IsStreaming() ? NULL : thread->DataSet());
 	}
 	return false;
 }
@@ -89,6 +129,10 @@ bool ctlSQLResult::ToFile(frmExport *frm)
 {
 	if (NumRows() > 0)
 	{
+		// The result-set does not hold the streamed rows
+		if (IsStreaming())
+			return frm->Export(NULL, this);
+
 		return frm->Export(thread->DataSet());
 	}
 	return false;
@@ -118,12 +162,22 @@ int ctlSQLResult::Execute(const wxString &query, int resultToRetrieve, wxWindow
 	ProcessTableMessage(*msg);
 	delete msg;
 
+	resultView.SetSource(NULL, NULL);
 	Abort();
 
 	colNames.Empty();
 	colTypes.Empty();
 	colTypClasses.Empty();
 
+	if (rowStore)
+	{
+		delete rowStore;
+		rowStore = NULL;
+	}
+	publishedRows = 0;
+	publishedCols = 0;
+	table->SetStreamedSize(0, 0);
+
 	thread = new pgQueryThread(conn, query, resultToRetrieve, caller, eventId, data);
 
 	if (thread->Create() != wxTHREAD_NO_ERROR)
@@ -132,17 +186,37 @@ int ctlSQLResult::Execute(const wxString &query, int resultToRetrieve, wxWindow
 		return -1;
 	}
 
-	((sqlResultTable *)GetTable())->SetThread(thread);
+	// Show the rows, while they are being retrieved
+	if (settings->GetStreamResults())
+	{
+		rowStore = new pgRowStore(*conn->GetConv(), (size_t)settings->GetStreamMemoryCap() * 1024 * 1024);
+		publishedGeneration = rowStore->GetGeneration();
+		thread->SetRowStore(rowStore);
+	}
+	table->SetRowStore(rowStore);
+	table->SetThread(thread);
 
 	thread->Run();
+
+	if (rowStore)
+		streamTimer->Start(CTLSQL_STREAM_INTERVAL);
+
 	return RunStatus();
 }
 
 
 int ctlSQLResult::Abort()
 {
+	streamTimer->Stop();
+	StopSizing();
+	resultView.SetSource(NULL, NULL);
+
 	if (thread)
 	{
+		// Throw away the rows streamed in so far
+		if (thread->IsRunning() && publishedCols > 0)
+			ClearStreamedRows();
+
 		((sqlResultTable *)GetTable())->SetThread(0);
 
 		if (thread->IsRunning())
@@ -167,28 +241,62 @@ void ctlSQLResult::DisplayData(bool single)
 	if (thread->ReturnCode() != PGRES_TUPLES_OK)
 		return;
 
+	streamTimer->Stop();
+
 	rowcountSuppressed = single;
 	Freeze();
 
-	/*
-	 * Resize and repopulate by informing it to delete all the rows and
-	 * columns, then append the correct number of them. Probably is a
-	 * better way to do this.
-	 */
 	wxGridTableMessage *msg;
 	sqlResultTable *table = (sqlResultTable *)GetTable();
-	msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_ROWS_DELETED, 0, GetNumberRows());
-	ProcessTableMessage(*msg);
-	delete msg;
-	msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_COLS_DELETED, 0, GetNumberCols());
-	ProcessTableMessage(*msg);
-	delete msg;
-	msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_ROWS_APPENDED, NumRows());
-	ProcessTableMessage(*msg);
-	delete msg;
-	msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_COLS_APPENDED, thread->DataSet()->NumCols());
-	ProcessTableMessage(*msg);
-	delete msg;
+
+	// If the rows have already been shown while being retrieved, we just
+	// need to add the remaining ones (and keep the user's scroll position).
+	bool incremental = IsStreaming() && publishedCols > 0 &&
+	                   publishedCols == thread->DataSet()->NumCols() &&
+	                   publishedGeneration == rowStore->GetGeneration();
+
+	if (incremental)
+	{
+		long nRows = NumRows();
+
+		table->SetStreamedSize(nRows, publishedCols);
+		if (nRows > publishedRows)
+		{
+			msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_ROWS_APPENDED, nRows - publishedRows);
+			ProcessTableMessage(*msg);
+			delete msg;
+		}
+		publishedRows = nRows;
+	}
+	else
+	{
+		/*
+		 * Resize and repopulate by informing it to delete all the rows and
+		 * columns, then append the correct number of them. Probably is a
+		 * better way to do this.
+		 */
+		msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_ROWS_DELETED, 0, GetNumberRows());
+		ProcessTableMessage(*msg);
+		delete msg;
+		msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_COLS_DELETED, 0, GetNumberCols());
+		ProcessTableMessage(*msg);
+		delete msg;
+
+		if (IsStreaming())
+		{
+			publishedRows = NumRows();
+			publishedCols = thread->DataSet()->NumCols();
+			publishedGeneration = rowStore->GetGeneration();
+			table->SetStreamedSize(publishedRows, publishedCols);
+		}
+
+		msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_ROWS_APPENDED, NumRows());
+		ProcessTableMessage(*msg);
+		delete msg;
+		msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_COLS_APPENDED, thread->DataSet()->NumCols());
+		ProcessTableMessage(*msg);
+		delete msg;
+	}
 
 	if (single)
 	{
@@ -196,13 +304,16 @@ void ctlSQLResult::DisplayData(bool single)
 		colTypes.Add(wxT(""));
 		colTypClasses.Add(0L);
 
-		AutoSizeColumn(0, false, false);
+		if (!incremental)
+			AutoSizeColumn(0, false, false);
 	}
 	else
 	{
 		long col, nCols = thread->DataSet()->NumCols();
 
-		AutoSizeColumns(false);
+		// Show the grid right away, the cells are measured in the background
+		if (!incremental)
+			SetColumnSizes(wxArrayInt());
 
 		for (col = 0 ; col < nCols ; col++)
 		{
@@ -220,11 +331,405 @@ void ctlSQLResult::DisplayData(bool single)
 				SetColAttr(col, attr);
 			}
 		}
+
+		if (!incremental)
+			StartSizing(colTypClasses);
+	}
+
+	// All the rows are there, they can be sorted and filtered now
+	resultView.SetSource(GetDataSet(), GetRowStore());
+
+	Thaw();
+}
+
+
+bool ctlSQLResult::IsStreaming() const
+{
+	return thread && rowStore && thread->IsStreaming();
+}
+
+
+pgSet *ctlSQLResult::GetDataSet() const
+{
+	if (thread && thread->DataValid() && !IsStreaming())
+		return thread->DataSet();
+	return NULL;
+}
+
+
+pgRowStore *ctlSQLResult::GetRowStore() const
+{
+	return IsStreaming() ? rowStore : NULL;
+}
+
+
+void ctlSQLResult::OnStreamTimer(wxTimerEvent &event)
+{
+	if (!thread || !rowStore)
+	{
+		streamTimer->Stop();
+		return;
+	}
+
+	if (!thread->IsRunning())
+	{
+		streamTimer->Stop();
+
+		// Do not leave the partial rows of a failed (or, cancelled) query
+		if (thread->ReturnCode() != PGRES_TUPLES_OK)
+		{
+			if (publishedCols > 0)
+				ClearStreamedRows();
+			return;
+		}
 	}
+
+	PublishStreamedRows();
+}
+
+
+// Tell the grid about the rows, which have been streamed in since the last
+// time, so that it fills up progressively.
+void ctlSQLResult::PublishStreamedRows()
+{
+	wxGridTableMessage *msg;
+	sqlResultTable *table = (sqlResultTable *)GetTable();
+
+	// A new result set has been started (i.e. multiple statements)
+	if (publishedGeneration != rowStore->GetGeneration())
+	{
+		if (publishedCols > 0)
+			ClearStreamedRows();
+		publishedGeneration = rowStore->GetGeneration();
+	}
+
+	long nRows = rowStore->NumRows(), nCols = rowStore->NumCols();
+	bool firstRows = false;
+
+	if (nCols == 0 || nRows <= publishedRows)
+		return;
+
+	Freeze();
+
+	if (publishedCols == 0)
+	{
+		table->SetStreamedSize(publishedRows, nCols);
+		msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_COLS_APPENDED, nCols);
+		ProcessTableMessage(*msg);
+		delete msg;
+
+		publishedCols = nCols;
+		firstRows = true;
+	}
+
+	table->SetStreamedSize(nRows, publishedCols);
+	msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_ROWS_APPENDED, nRows - publishedRows);
+	ProcessTableMessage(*msg);
+	delete msg;
+
+	publishedRows = nRows;
+
+	// Size the columns by the first rows, that's what we have got so far
+	if (firstRows)
+	{
+		wxArrayLong typClasses;
+		for (long col = 0 ; col < nCols ; col++)
+			typClasses.Add(pgSet::TypClassFromOid(rowStore->ColTypeOid(col)));
+
+		SetColumnSizes(wxArrayInt());
+		StartSizing(typClasses);
+	}
+
 	Thaw();
 }
 
 
+void ctlSQLResult::ClearStreamedRows()
+{
+	wxGridTableMessage *msg;
+	sqlResultTable *table = (sqlResultTable *)GetTable();
+
+	StopSizing();
+	table->SetStreamedSize(0, 0);
+
+	msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_ROWS_DELETED, 0, GetNumberRows());
+	ProcessTableMessage(*msg);
+	delete msg;
+	msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_COLS_DELETED, 0, GetNumberCols());
+	ProcessTableMessage(*msg);
+	delete msg;
+
+	publishedRows = 0;
+	publishedCols = 0;
+}
+
+
+
+void ctlSQLResult::OnCopyAs(wxCommandEvent &event)
+{
+	CopyAs(event.GetId() == CTLSQL_COPY_INSERT_ID ? EXPORT_FORMAT_INSERT : EXPORT_FORMAT_COPY);
+}
+
+
+int ctlSQLResult::Copy()
+{
+	return CopyAs(EXPORT_FORMAT_DISPLAY);
+}
+
+
+// The table the selected columns come from, to copy them to; the user is
+// asked for it, if they don't come from a single table
+wxString ctlSQLResult::GetCopyTable(const wxArrayInt &cols)
+{
+	pgSet *set = GetDataSet();
+	pgRowStore *store = GetRowStore();
+	OID table = 0;
+	size_t i;
+
+	for (i = 0 ; i < cols.GetCount() ; i++)
+	{
+		OID colTable = set ? set->ColTableOid(cols.Item(i)) : store->ColTableOid(cols.Item(i));
+		if (!colTable || (i && colTable != table))
+		{
+			table = 0;
+			break;
+		}
+		table = colTable;
+	}
+
+	// The connection is free, once the query is done
+	wxString name;
+	if (table && conn && (!thread || !thread->IsRunning()))
+		name = conn->ExecuteScalar(wxT("SELECT ") + NumToStr(table) + wxT("::oid::regclass"), false);
+
+	if (name.IsEmpty())
+		name = wxGetTextFromUser(_("The rows don't come from a single table.\nName of the table to copy them to:"),
+		                         _("Copy rows"), wxEmptyString, this);
+	return name;
+}
+
+
+// Format the selected cells straight from the result, rather than from the
+// grid's cells, in chunks by the export workers.
+int ctlSQLResult::CopyAs(int format)
+{
+	pgSet *set = GetDataSet();
+	pgRowStore *store = GetRowStore();
+
+	if (!set && !store)
+		return format == EXPORT_FORMAT_DISPLAY ? ctlSQLGrid::Copy() : 0;
+
+	wxArrayInt rows, cols;
+	long firstRow = 0, numRows;
+	int col, nCols = GetNumberCols();
+	size_t i;
+
+	if (GetSelectedRows().GetCount())
+	{
+		rows = GetSelectedRows();
+		numRows = rows.GetCount();
+	}
+	else if (GetSelectedCols().GetCount())
+	{
+		cols = GetSelectedCols();
+		numRows = GetNumberRows();
+	}
+	else if (GetSelectionBlockTopLeft().GetCount() > 0 &&
+	         GetSelectionBlockBottomRight().GetCount() > 0)
+	{
+		int x1 = GetSelectionBlockTopLeft()[0].GetCol();
+		int x2 = GetSelectionBlockBottomRight()[0].GetCol();
+		int y1 = GetSelectionBlockTopLeft()[0].GetRow();
+		int y2 = GetSelectionBlockBottomRight()[0].GetRow();
+
+		for (col = x1 ; col <= x2 ; col++)
+			cols.Add(col);
+		firstRow = y1;
+		numRows = y2 - y1 + 1;
+	}
+	else
+	{
+		cols.Add(GetGridCursorCol());
+		firstRow = GetGridCursorRow();
+		numRows = 1;
+	}
+
+	if (cols.IsEmpty())
+	{
+		for (col = 0 ; col < nCols ; col++)
+			cols.Add(col);
+	}
+	if (numRows <= 0 || firstRow < 0 || cols.IsEmpty() || cols.Item(0) < 0)
+		return 0;
+
+	exportJob job(set, store, numRows, cols.GetCount());
+	job.format = format;
+	job.columns = cols;
+	job.firstRow = firstRow;
+	job.rowList = rows.IsEmpty() ? NULL : &rows;
+	job.view = GetResultView();
+	job.fileConv = &wxConvUTF8;
+
+	// The names and types of the columns are only in colNames etc., once
+	// the query has finished
+	wxString header, trailer, names, table;
+	wxArrayLong typClasses;
+	sqlResultFormat displayFormat;
+	for (i = 0 ; i < cols.GetCount() ; i++)
+	{
+		col = cols.Item(i);
+		if (i)
+			names += wxT(", ");
+		if (set)
+		{
+			names += qtIdent(set->ColName(col));
+			typClasses.Add(set->ColTypClass(col));
+		}
+		else
+		{
+			names += qtIdent(store->ColName(col));
+			typClasses.Add(pgSet::TypClassFromOid(store->ColTypeOid(col)));
+		}
+	}
+
+	if (format == EXPORT_FORMAT_INSERT || format == EXPORT_FORMAT_COPY)
+	{
+		table = GetCopyTable(cols);
+		if (table.IsEmpty())
+			return 0;
+	}
+
+	switch (format)
+	{
+		case EXPORT_FORMAT_INSERT:
+			job.rowPrefix = wxT("INSERT INTO ") + table + wxT(" (") + names + wxT(") VALUES (");
+			job.colSeparator = wxT(", ");
+			job.rowSeparator = wxString(wxT(");")) + END_OF_LINE;
+			break;
+
+		case EXPORT_FORMAT_COPY:
+			header = wxT("COPY ") + table + wxT(" (") + names + wxT(") FROM stdin;") + END_OF_LINE;
+			trailer = wxString(wxT("\\.")) + END_OF_LINE;
+			job.colSeparator = wxT("\t");
+			job.rowSeparator = END_OF_LINE;
+			break;
+
+		default:
+			AppendColumnHeader(header, cols);
+			job.colSeparator = settings->GetCopyColSeparator();
+			job.quoteChar = settings->GetCopyQuoteChar();
+			job.rowSeparator = END_OF_LINE;
+
+			// The values are copied as they're shown, i.e. formatted, and
+			// with <NULL> for NULL, if that's shown
+			displayFormat.Load();
+			job.displayFormat = &displayFormat;
+			job.typClasses = typClasses;
+			break;
+	}
+
+	int quoting = settings->GetCopyQuoting();
+	for (i = 0 ; i < cols.GetCount() ; i++)
+	{
+		bool needQuote;
+
+		if (format == EXPORT_FORMAT_INSERT)
+			needQuote = typClasses.Item(i) != PGTYPCLASS_NUMERIC;
+		else if (quoting == 1)
+			needQuote = typClasses.Item(i) != PGTYPCLASS_NUMERIC && typClasses.Item(i) != PGTYPCLASS_BOOL;
+		else
+			needQuote = (quoting == 2);
+
+		if (format == EXPORT_FORMAT_DISPLAY && job.quoteChar.IsEmpty())
+			needQuote = false;
+		job.quoteCols.Add(needQuote ? 1 : 0);
+	}
+
+	wxMemoryBuffer buffer;
+	long skipped = 0;
+	{
+		wxBusyCursor wait;
+		if (!job.Run(buffer, this, skipped))
+			return 0;
+	}
+
+	// As before, a single row goes without the line end
+	size_t len = buffer.GetDataLen();
+	if (format == EXPORT_FORMAT_DISPLAY && numRows == 1)
+	{
+		size_t eolLen = strlen(wxString(END_OF_LINE).mb_str(wxConvUTF8));
+		if (len >= eolLen)
+			len -= eolLen;
+	}
+
+	wxString str = header;
+	if (len)
+		str += wxString((const char *)buffer.GetData(), wxConvUTF8, len);
+	str += trailer;
+
+	if (!wxTheClipboard->Open())
+		return 0;
+
+	wxTheClipboard->SetData(new wxTextDataObject(str));
+	wxTheClipboard->Close();
+
+	return numRows;
+}
+
+
+void ctlSQLResult::StartSizing(const wxArrayLong &typClasses)
+{
+	StopSizing();
+
+	pgSet *set = GetDataSet();
+	pgRowStore *store = GetRowStore();
+	if ((!set && !store) || typClasses.IsEmpty())
+		return;
+
+	sizer = new sqlResultSizer(this, set, store, NumRows(), typClasses,
+	                           sqlResultGlyphWidths::Get(GetGridWindow(), GetDefaultCellFont()));
+	if (sizer->Create() != wxTHREAD_NO_ERROR || sizer->Run() != wxTHREAD_NO_ERROR)
+	{
+		delete sizer;
+		sizer = NULL;
+		AutoSizeColumns(false);
+	}
+}
+
+
+// The rows have to stay, while the sizer is looking at them
+void ctlSQLResult::StopSizing()
+{
+	if (sizer)
+	{
+		sizer->Cancel();
+		sizer->Wait();
+		delete sizer;
+		sizer = NULL;
+	}
+}
+
+
+void ctlSQLResult::OnSizingDone(wxCommandEvent &event)
+{
+	// A sizer, which has been stopped meanwhile
+	if (!sizer || !sizer->IsDone())
+		return;
+
+	sizer->Wait();
+	wxArrayInt cellSizes = sizer->cellSizes;
+	delete sizer;
+	sizer = NULL;
+
+	if ((int)cellSizes.GetCount() != GetNumberCols())
+		return;
+
+	BeginBatch();
+	SetColumnSizes(cellSizes);
+	EndBatch();
+}
+
+
 
 wxString ctlSQLResult::GetMessagesAndClear()
 {
@@ -251,6 +756,8 @@ pgError ctlSQLResult::GetResultError()
 
 long ctlSQLResult::NumRows() const
 {
+	if (IsStreaming())
+		return rowStore->NumRows();
 	if (thread && thread->DataValid())
 		return thread->DataSet()->NumRows();
 	return 0;
@@ -298,6 +805,10 @@ wxString ctlSQLResult::OnGetItemText(long item, long col) const
 		}
 		if (item >= 0)
 		{
+			item = resultView.SourceRow(item);
+			if (IsStreaming())
+				return rowStore->GetVal(item, col);
+
 			thread->DataSet()->Locate(item + 1);
 			return thread->DataSet()->GetVal(col);
 		}
@@ -313,80 +824,336 @@ void ctlSQLResult::OnGridSelect(wxGridRangeSelectEvent &event)
 }
 
 
+void ctlSQLResult::OnLabelRightClick(wxGridEvent &event)
+{
+	int col = event.GetCol();
+	if (col < 0 || col >= (int)colTypClasses.GetCount())
+	{
+		event.Skip();
+		return;
+	}
+	viewCol = col;
+
+	// Only the complete result can be sorted or filtered
+	bool complete = thread && !thread->IsRunning() && (GetDataSet() || GetRowStore());
+
+	wxMenu *xmenu = new wxMenu();
+	xmenu->Append(CTLSQL_SORT_ASC_ID, _("Sort &ascending"), _("Sort the rows by this column, in ascending order."));
+	xmenu->Append(CTLSQL_SORT_DESC_ID, _("Sort &descending"), _("Sort the rows by this column, in descending order."));
+	xmenu->Append(CTLSQL_FILTER_ID, _("&Filter..."), _("Show the rows, whose value in this column matches a condition."));
+	xmenu->AppendSeparator();
+	xmenu->Append(CTLSQL_RESET_VIEW_ID, _("&Remove sort and filter"), _("Show all the rows, in the order they were retrieved."));
+	xmenu->AppendSeparator();
+	xmenu->Append(CTLSQL_COPY_INSERT_ID, _("Copy as &INSERT statements"), _("Copy the selected cells to the clipboard, as INSERT statements."));
+	xmenu->Append(CTLSQL_COPY_COPY_ID, _("Copy as C&OPY data"), _("Copy the selected cells to the clipboard, as the data of a COPY statement."));
+
+	xmenu->Enable(CTLSQL_SORT_ASC_ID, complete);
+	xmenu->Enable(CTLSQL_SORT_DESC_ID, complete);
+	xmenu->Enable(CTLSQL_FILTER_ID, complete);
+	xmenu->Enable(CTLSQL_RESET_VIEW_ID, complete && resultView.IsActive());
+	xmenu->Enable(CTLSQL_COPY_INSERT_ID, GetDataSet() || GetRowStore());
+	xmenu->Enable(CTLSQL_COPY_COPY_ID, GetDataSet() || GetRowStore());
+
+	PopupMenu(xmenu);
+	delete xmenu;
+}
 
-bool sqlResultTable::GetIsNull(int row, int col)
+
+void ctlSQLResult::OnSortColumn(wxCommandEvent &event)
 {
-	bool isNull = false;
-	if (col >=0 && thread && thread->DataValid() && thread->DataSet()->NumRows() >= row + 1)
+	if (viewCol < 0 || viewCol >= (int)colTypClasses.GetCount())
+		return;
+
+	long oldRows = GetNumberRows();
+	wxBusyCursor wait;
+
+	if (resultView.Sort(viewCol, (pgTypClass)colTypClasses.Item(viewCol), event.GetId() == CTLSQL_SORT_ASC_ID))
+		ShowView(oldRows);
+}
+
+
+void ctlSQLResult::OnFilterColumn(wxCommandEvent &event)
+{
+	if (viewCol < 0 || viewCol >= (int)colTypClasses.GetCount())
+		return;
+
+	wxString expr = wxGetTextFromUser(_("Show the rows, whose value is\n(e.g. \"= 42\", \"<> abc\", \"~ text\" or \"IS NULL\"):"),
+	                                  _("Filter rows"), lastFilter, this);
+
+	pgResultFilterOp op;
+	wxString value;
+	if (!pgResultView::ParseFilter(expr, op, value))
+		return;
+	lastFilter = expr;
+
+	long oldRows = GetNumberRows();
+	wxBusyCursor wait;
+
+	if (resultView.Filter(viewCol, (pgTypClass)colTypClasses.Item(viewCol), op, value))
+		ShowView(oldRows);
+}
+
+
+void ctlSQLResult::OnResetView(wxCommandEvent &event)
+{
+	long oldRows = GetNumberRows();
+
+	resultView.Reset();
+	ShowView(oldRows);
+}
+
+
+// Tell the grid, that the rows (and, maybe, their number) have changed
+void ctlSQLResult::ShowView(long oldRows)
+{
+	wxGridTableMessage *msg;
+	sqlResultTable *table = (sqlResultTable *)GetTable();
+	long newRows = resultView.NumRows();
+
+	BeginBatch();
+	ClearSelection();
+	table->SetView(&resultView);
+
+	if (newRows < oldRows)
 	{
-		thread->DataSet()->Locate(row + 1);
-		if (thread->DataSet()->IsNull(col))
-			isNull = true;
+		msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_ROWS_DELETED, newRows, oldRows - newRows);
+		ProcessTableMessage(*msg);
+		delete msg;
 	}
-	return isNull;
+	else if (newRows > oldRows)
+	{
+		msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_ROWS_APPENDED, newRows - oldRows);
+		ProcessTableMessage(*msg);
+		delete msg;
+	}
+	EndBatch();
+
+	ForceRefresh();
+}
+
+
+
+bool sqlResultTable::IsStreaming()
+{
+	return thread && rowStore && thread->IsStreaming();
+}
+
+
+pgTypClass sqlResultTable::ColTypClass(int col)
+{
+	if (thread->DataValid())
+		return thread->DataSet()->ColTypClass(col);
+
+	// The connection is busy, while the rows are being streamed - we can't
+	// look at the catalog yet.
+	return pgSet::TypClassFromOid(rowStore->ColTypeOid(col));
+}
+
+
+bool sqlResultTable::GetIsNull(int row, int col)
+{
+	if (col < 0 || row < 0 || row >= GetNumberRows() || col >= GetNumberCols())
+		return false;
+
+	sqlResultCacheBlock *block = GetCacheBlock(row, col);
+
+	return block->nulls[(row % CTLSQL_CACHE_BLOCK_ROWS) * block->numCols + col % CTLSQL_CACHE_BLOCK_COLS] != 0;
 }
 
 wxString sqlResultTable::GetValue(int row, int col)
 {
-	if (thread && thread->DataValid())
+	if (col < 0)
 	{
-		if (col >= 0)
+		if (!IsStreaming() && thread && thread->DataValid())
+			return thread->DataSet()->ColName(col);
+		return wxEmptyString;
+	}
+
+	if (row < 0 || row >= GetNumberRows() || col >= GetNumberCols())
+		return wxEmptyString;
+
+	sqlResultCacheBlock *block = GetCacheBlock(row, col);
+
+	return block->values[(row % CTLSQL_CACHE_BLOCK_ROWS) * block->numCols + col % CTLSQL_CACHE_BLOCK_COLS];
+}
+
+
+// Find the block of formatted cells containing the given cell, and fill it
+// if required. Painting the grid asks for each visible cell many times, so
+// only do the conversion and formatting once.
+sqlResultCacheBlock *sqlResultTable::GetCacheBlock(int row, int col)
+{
+	bool streaming = IsStreaming();
+	bool dataValid = thread && thread->DataValid();
+
+	// The type classes are only known for sure, once the query has finished
+	if (cacheFormatGeneration != settings->GetResultFormatGeneration() ||
+	        cacheStreaming != streaming || cacheDataValid != dataValid)
+	{
+		ClearCache();
+		format.Load();
+		cacheFormatGeneration = settings->GetResultFormatGeneration();
+		cacheStreaming = streaming;
+		cacheDataValid = dataValid;
+	}
+
+	int firstRow = row - row % CTLSQL_CACHE_BLOCK_ROWS;
+	int firstCol = col - col % CTLSQL_CACHE_BLOCK_COLS;
+	wxLongLong_t key = (wxLongLong_t)(row / CTLSQL_CACHE_BLOCK_ROWS) * 65536 + col / CTLSQL_CACHE_BLOCK_COLS;
+
+	sqlResultCacheBlock *block = NULL;
+	sqlResultCacheMap::iterator it = cellCache.find(key);
+
+	if (it != cellCache.end())
+	{
+		block = it->second;
+
+		// More rows may have been streamed in, since it was filled
+		if (row - firstRow >= block->numRows)
 		{
-			thread->DataSet()->Locate(row + 1);
-			if (settings->GetIndicateNull() && thread->DataSet()->IsNull(col))
-				return wxT("<NULL>");
-			else
+			delete block;
+			cellCache.erase(it);
+			block = NULL;
+		}
+	}
+
+	if (!block)
+	{
+		if (cellCache.size() >= CTLSQL_CACHE_MAX_BLOCKS)
+		{
+			sqlResultCacheMap::iterator victim = cellCache.begin();
+			for (it = cellCache.begin(); it != cellCache.end(); ++it)
 			{
+				if (it->second->lastUsed < victim->second->lastUsed)
+					victim = it;
+			}
+			delete victim->second;
+			cellCache.erase(victim);
+		}
 
-				wxString decimalMark = wxT(".");
-				wxString s = thread->DataSet()->GetVal(col);
-
-				if (thread->DataSet()->ColTypClass(col) == PGTYPCLASS_NUMERIC &&
-				        settings->GetDecimalMark().Length() > 0)
-				{
-					decimalMark = settings->GetDecimalMark();
-					s.Replace(wxT("."), decimalMark);
-
-				}
-				if (thread->DataSet()->ColTypClass(col) == PGTYPCLASS_NUMERIC &&
-				        settings->GetThousandsSeparator().Length() > 0)
-				{
-					/* Add thousands separator */
-					size_t pos = s.find(decimalMark);
-					if (pos == wxString::npos)
-						pos = s.length();
-					while (pos > 3)
-					{
-						pos -= 3;
-						if (pos > 1 || !s.StartsWith(wxT("-")))
-							s.insert(pos, settings->GetThousandsSeparator());
-					}
-					return s;
-				}
-				else if (thread->DataSet()->ColTypClass(col) == PGTYPCLASS_BOOL)
-				{
-					return StrToBool(thread->DataSet()->GetVal(col)) ? wxT("TRUE") : wxT("FALSE");
-				}
-				else
-				{
-					wxString data = thread->DataSet()->GetVal(col);
-
-					if (data.Length() > (size_t)settings->GetMaxColSize())
-						return thread->DataSet()->GetVal(col).Left(settings->GetMaxColSize()) + wxT(" (...)");
-					else
-						return thread->DataSet()->GetVal(col);
-				}
+		block = new sqlResultCacheBlock;
+		block->numRows = wxMin(CTLSQL_CACHE_BLOCK_ROWS, GetNumberRows() - firstRow);
+		block->numCols = wxMin(CTLSQL_CACHE_BLOCK_COLS, GetNumberCols() - firstCol);
+		block->values.Alloc(block->numRows * block->numCols);
+		block->nulls.Alloc(block->numRows * block->numCols);
+
+		for (int r = 0; r < block->numRows; r++)
+		{
+			for (int c = 0; c < block->numCols; c++)
+			{
+				bool isNull;
+				block->values.Add(FormatValue(firstRow + r, firstCol + c, isNull));
+				block->nulls.Add(isNull ? 1 : 0);
 			}
 		}
+		cellCache[key] = block;
+	}
+
+	block->lastUsed = ++cacheUseCounter;
+	return block;
+}
+
+
+void sqlResultTable::ClearCache()
+{
+	sqlResultCacheMap::iterator it;
+	for (it = cellCache.begin(); it != cellCache.end(); ++it)
+		delete it->second;
+	cellCache.clear();
+}
+
+
+wxString sqlResultTable::FormatValue(int row, int col, bool &isNull)
+{
+	wxString s;
+
+	if (view)
+		row = view->SourceRow(row);
+
+	if (IsStreaming())
+	{
+		isNull = rowStore->IsNull(row, col);
+		if (!isNull)
+			s = rowStore->GetVal(row, col);
+	}
+	else
+	{
+		thread->DataSet()->Locate(row + 1);
+		isNull = thread->DataSet()->IsNull(col);
+		if (!isNull)
+			s = thread->DataSet()->GetVal(col);
+	}
+
+	return FormatText(s, isNull, ColTypClass(col), format);
+}
+
+
+wxString sqlResultTable::FormatText(const wxString &value, bool isNull, pgTypClass typClass, const sqlResultFormat &format)
+{
+	if (format.indicateNull && isNull)
+		return wxT("<NULL>");
+
+	// Only use the strings of the format read-only
+	wxString s = value;
+	const wxChar *decimalMark = wxT(".");
+
+	if (typClass == PGTYPCLASS_NUMERIC &&
+	        format.decimalMark.Length() > 0)
+	{
+		decimalMark = format.decimalMark.c_str();
+		s.Replace(wxT("."), decimalMark);
+
+	}
+	if (typClass == PGTYPCLASS_NUMERIC &&
+	        format.thousandsSeparator.Length() > 0)
+	{
+		/* Add thousands separator */
+		size_t pos = s.find(decimalMark);
+		if (pos == wxString::npos)
+			pos = s.length();
+		while (pos > 3)
+		{
+			pos -= 3;
+			if (pos > 1 || !s.StartsWith(wxT("-")))
+				s.insert(pos, format.thousandsSeparator.c_str());
+		}
+		return s;
+	}
+	else if (typClass == PGTYPCLASS_BOOL)
+	{
+		return StrToBool(s) ? wxT("TRUE") : wxT("FALSE");
+	}
+	else
+	{
+		if (s.Length() > (size_t)format.maxColSize)
+			return s.Left(format.maxColSize) + wxT(" (...)");
 		else
-			return thread->DataSet()->ColName(col);
+			return s;
 	}
-	return wxEmptyString;
+}
+
+
+void sqlResultFormat::Load()
+{
+	indicateNull = settings->GetIndicateNull();
+	decimalMark = settings->GetDecimalMark();
+	thousandsSeparator = settings->GetThousandsSeparator();
+	maxColSize = settings->GetMaxColSize();
 }
 
 sqlResultTable::sqlResultTable()
 {
 	thread = NULL;
+	rowStore = NULL;
+	view = NULL;
+	streamedRows = 0;
+	streamedCols = 0;
+
+	cacheUseCounter = 0;
+	cacheFormatGeneration = settings->GetResultFormatGeneration();
+	format.Load();
+	cacheStreaming = false;
+	cacheDataValid = false;
 
 	colourOdd = wxColour(255,255,255);
 	colourOddNull = wxColour(255,255,229);
@@ -405,6 +1172,8 @@ sqlResultTable::sqlResultTable()
 
 sqlResultTable::~sqlResultTable()
 {
+	ClearCache();
+
 	attrOdd->DecRef();
 	attrOddNull->DecRef();
 	attrEven->DecRef();
@@ -413,6 +1182,10 @@ sqlResultTable::~sqlResultTable()
 
 int sqlResultTable::GetNumberRows()
 {
+	if (view && view->IsActive())
+		return view->NumRows();
+	if (IsStreaming())
+		return streamedRows;
 	if (thread && thread->DataValid())
 		return thread->DataSet()->NumRows();
 	return 0;
@@ -424,11 +1197,16 @@ wxString sqlResultTable::GetColLabelValue(int col)
 	if (thread && thread->DataValid())
 		return thread->DataSet()->ColName(col) + wxT("\n") +
 		       thread->DataSet()->ColFullType(col);
+	// The type names will be known, once the query has finished
+	if (IsStreaming() && col < streamedCols && col < rowStore->NumCols())
+		return rowStore->ColName(col) + wxT("\n");
 	return wxEmptyString;
 }
 
 int sqlResultTable::GetNumberCols()
 {
+	if (IsStreaming())
+		return streamedCols;
 	if (thread && thread->DataValid())
 		return thread->DataSet()->NumCols();
 	return 0;
@@ -445,3 +1223,145 @@ wxGridCellAttr *sqlResultTable::GetAttr(int row, int col, wxGridCellAttr::wxAttr
 	attr->IncRef();
 	return attr;
 }
+
+
+sqlResultGlyphWidths *sqlResultGlyphWidths::Get(wxWindow *window, const wxFont &font)
+{
+	wxString key = font.GetNativeFontInfoDesc();
+	sqlResultGlyphWidthsMap::iterator it = glyphWidthsCache.find(key);
+	if (it != glyphWidthsCache.end())
+		return it->second;
+
+	sqlResultGlyphWidths *glyphs = new sqlResultGlyphWidths();
+	wxClientDC dc(window);
+	wxCoord w, h;
+
+	dc.SetFont(font);
+	for (int c = 0 ; c < 256 ; c++)
+	{
+		// Control characters aren't drawn
+		if (c < 32 || (c >= 127 && c < 160))
+			glyphs->widths[c] = 0;
+		else
+		{
+			dc.GetTextExtent(wxString((wxChar)c, 1), &w, &h);
+			glyphs->widths[c] = w;
+		}
+	}
+	glyphs->widths['\t'] = glyphs->widths[' '];
+
+	// CJK characters and the like are about the same width
+	dc.GetTextExtent(wxString((wxChar)0x4E2D, 1), &w, &h);
+	glyphs->wideWidth = w;
+	glyphs->otherWidth = glyphs->widths['M'];
+
+	glyphWidthsCache[key] = glyphs;
+	return glyphs;
+}
+
+
+int sqlResultGlyphWidths::GetWidth(const wxString &text) const
+{
+	int width = 0, lineWidth = 0;
+	size_t i, len = text.Length();
+
+	for (i = 0 ; i < len ; i++)
+	{
+		wxChar c = text.GetChar(i);
+
+		if (c == '\n')
+		{
+			width = wxMax(width, lineWidth);
+			lineWidth = 0;
+		}
+		else if ((unsigned int)c < 256)
+			lineWidth += widths[(unsigned int)c];
+		else if ((unsigned int)c >= 0x2E80)
+			lineWidth += wideWidth;
+		else
+			lineWidth += otherWidth;
+	}
+	return wxMax(width, lineWidth);
+}
+
+
+sqlResultSizer::sqlResultSizer(wxEvtHandler *_handler, pgSet *_set, pgRowStore *_store, long _nRows,
+                               const wxArrayLong &_typClasses, const sqlResultGlyphWidths *_glyphs)
+	: wxThread(wxTHREAD_JOINABLE)
+{
+	handler = _handler;
+	set = _set;
+	store = _store;
+	nRows = _nRows;
+	typClasses = _typClasses;
+	glyphs = _glyphs;
+	format.Load();
+	cancelled = false;
+	done = false;
+}
+
+
+void *sqlResultSizer::Entry()
+{
+	int col, nCols = typClasses.GetCount();
+	long i, row;
+	wxArrayLong rows;
+
+	// The first rows (which are seen first), then the rest evenly spread
+	if (nRows <= CTLSQL_SIZE_SAMPLES)
+	{
+		for (row = 0 ; row < nRows ; row++)
+			rows.Add(row);
+	}
+	else
+	{
+		long spread = CTLSQL_SIZE_SAMPLES - CTLSQL_SIZE_HEAD_ROWS;
+		double step = (double)(nRows - CTLSQL_SIZE_HEAD_ROWS) / spread;
+
+		for (row = 0 ; row < CTLSQL_SIZE_HEAD_ROWS ; row++)
+			rows.Add(row);
+		for (i = 0 ; i < spread ; i++)
+			rows.Add(CTLSQL_SIZE_HEAD_ROWS + (long)(i * step));
+	}
+
+	cellSizes.Alloc(nCols);
+	for (col = 0 ; col < nCols ; col++)
+	{
+		int cellSize = 0;
+
+		for (i = 0 ; i < (long)rows.GetCount() ; i++)
+		{
+			if (cancelled)
+				return NULL;
+
+			wxString value;
+			bool isNull;
+
+			row = rows.Item(i);
+			if (set)
+			{
+				isNull = set->IsNull(row, col);
+				if (!isNull)
+					value = wxString(set->GetCharPtr(row, col), set->GetConversion());
+			}
+			else
+			{
+				isNull = store->IsNull(row, col);
+				if (!isNull)
+					value = store->GetVal(row, col);
+			}
+
+			int width = glyphs->GetWidth(sqlResultTable::FormatText(value, isNull, (pgTypClass)typClasses.Item(col), format));
+			if (width > cellSize)
+				cellSize = width;
+		}
+		cellSizes.Add(cellSize);
+	}
+
+	done = true;
+
+	wxCommandEvent event(wxEVT_COMMAND_MENU_SELECTED, CTLSQL_SIZING_DONE_ID);
+	handler->AddPendingEvent(event);
+
+	return NULL;
+}
@@ -0,0 +1,253 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// lockGraphCanvas.cpp - Lock wait-for graph Canvas
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// App headers
+#include "pgAdmin3.h"
+
+#include "ctl/lockGraphCanvas.h"
+
+#define SHAPE_WIDTH     200
+#define SHAPE_HEIGHT    60
+#define LAYER_OFFSET    260
+#define SLOT_OFFSET     80
+#define BORDER          20
+#define PIXPERUNIT      20
+
+
+LockGraphShape::LockGraphShape(long _pid)
+	: wxRectangleShape(SHAPE_WIDTH, SHAPE_HEIGHT)
+{
+	pid = _pid;
+	layer = -1;
+	slot = -1;
+	seen = false;
+	SetCornerRadius(-0.1);
+}
+
+
+LockGraphCanvas::LockGraphCanvas(wxWindow *parent)
+	: wxShapeCanvas(parent)
+{
+	SetDiagram(new wxDiagram);
+	GetDiagram()->SetCanvas(this);
+	SetBackgroundColour(*wxWHITE);
+}
+
+
+LockGraphCanvas::~LockGraphCanvas()
+{
+}
+
+
+void LockGraphCanvas::Clear()
+{
+	lines.Clear();
+	shapes.clear();
+	GetDiagram()->DeleteAllShapes();
+	Refresh();
+}
+
+
+void LockGraphCanvas::RemoveLines()
+{
+	wxNode *node = lines.GetFirst();
+	while (node)
+	{
+		wxLineShape *line = (wxLineShape *)node->GetData();
+		line->Unlink();
+		delete line;
+		node = node->GetNext();
+	}
+	lines.Clear();
+}
+
+
+// Close the gaps in a column, which have been left by the backends gone
+void LockGraphCanvas::PackLayer(int layer)
+{
+	wxArrayPtrVoid column;
+	LockGraphShapeMap::iterator it;
+
+	for (it = shapes.begin(); it != shapes.end(); ++it)
+	{
+		LockGraphShape *shape = it->second;
+		if (shape->layer != layer)
+			continue;
+
+		size_t pos = 0;
+		while (pos < column.GetCount() && ((LockGraphShape *)column[pos])->slot < shape->slot)
+			pos++;
+		column.Insert(shape, pos);
+	}
+
+	for (size_t i = 0; i < column.GetCount(); i++)
+		((LockGraphShape *)column[i])->slot = i;
+}
+
+
+void LockGraphCanvas::SetGraph(const lockGraph &graph, const LockGraphQueryMap &queries)
+{
+	wxClientDC dc(this);
+	PrepareDC(dc);
+
+	const wxArrayInt &order = graph.GetOrder();
+	size_t count = wxMin(order.GetCount(), (size_t)LOCKGRAPH_MAX_SHAPES), i, j;
+	LockGraphShapeMap::iterator it;
+	int layer, layers = 0;
+
+	RemoveLines();
+
+	for (it = shapes.begin(); it != shapes.end(); ++it)
+		it->second->seen = false;
+
+	for (i = 0; i < count; i++)
+	{
+		const lockGraphNode &node = graph.GetNode(order[i]);
+		LockGraphShape *shape;
+
+		it = shapes.find(node.pid);
+		if (it == shapes.end())
+		{
+			shape = new LockGraphShape(node.pid);
+			shape->SetCanvas(this);
+			AddShape(shape);
+			shape->Show(true);
+			shapes[node.pid] = shape;
+		}
+		else
+			shape = it->second;
+
+		shape->seen = true;
+
+		// Backends, which now wait for another one, are placed again
+		if (shape->layer != node.layer)
+		{
+			shape->layer = node.layer;
+			shape->slot = -1;
+		}
+		layers = wxMax(layers, node.layer + 1);
+
+		wxColour colour;
+		wxString text = wxString::Format(_("PID %ld"), node.pid);
+		if (node.inCycle)
+		{
+			text += wxT(" ") + wxString(_("(deadlock)"));
+			colour = wxColour(255, 170, 255);
+		}
+		else if (node.layer == 0)
+			colour = wxColour(255, 190, 190);
+		else
+			colour = wxColour(255, 255, 200);
+
+		text += wxT("\n");
+		if (node.layer == 0)
+			text += wxString::Format(_("Blocking %ld"), node.blocked);
+		else
+			text += node.waitingOn;
+
+		LockGraphQueryMap::const_iterator query = queries.find(node.pid);
+		if (query != queries.end())
+			text += wxT("\n") + query->second.Left(40);
+
+		shape->SetBrush(wxTheBrushList->FindOrCreateBrush(colour, wxSOLID));
+		shape->FormatText(dc, text);
+	}
+
+	// Drop the backends, which aren't waiting or waited for anymore
+	wxArrayLong gone;
+	for (it = shapes.begin(); it != shapes.end(); ++it)
+	{
+		if (!it->second->seen)
+			gone.Add(it->first);
+	}
+	for (i = 0; i < gone.GetCount(); i++)
+	{
+		delete shapes[gone[i]];
+		shapes.erase(gone[i]);
+	}
+
+	// Add the new ones below the others of their column
+	wxArrayInt lastSlot, used;
+	lastSlot.Add(-1, layers);
+	used.Add(0, layers);
+	for (it = shapes.begin(); it != shapes.end(); ++it)
+	{
+		LockGraphShape *shape = it->second;
+		used[shape->layer]++;
+		if (shape->slot >= 0)
+			lastSlot[shape->layer] = wxMax(lastSlot[shape->layer], shape->slot);
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		LockGraphShape *shape = shapes[graph.GetNode(order[i]).pid];
+		if (shape->slot < 0)
+			shape->slot = ++lastSlot[shape->layer];
+	}
+
+	int slots = 0;
+	for (layer = 0; layer < layers; layer++)
+	{
+		if (lastSlot[layer] + 1 > used[layer] * 2 + 4)
+		{
+			PackLayer(layer);
+			lastSlot[layer] = used[layer] - 1;
+		}
+		slots = wxMax(slots, lastSlot[layer] + 1);
+	}
+
+	for (it = shapes.begin(); it != shapes.end(); ++it)
+	{
+		LockGraphShape *shape = it->second;
+		shape->SetX(BORDER + SHAPE_WIDTH / 2 + shape->layer * LAYER_OFFSET);
+		shape->SetY(BORDER + SHAPE_HEIGHT / 2 + shape->slot * SLOT_OFFSET);
+	}
+
+	// Draw an arrow from each backend to the ones it waits for
+	for (i = 0; i < count; i++)
+	{
+		const lockGraphNode &node = graph.GetNode(order[i]);
+		LockGraphShape *from = shapes[node.pid];
+
+		for (j = 0; j < node.waitsFor.GetCount(); j++)
+		{
+			const lockGraphNode &holder = graph.GetNode(node.waitsFor[j]);
+			it = shapes.find(holder.pid);
+			if (it == shapes.end())
+				continue;
+
+			wxColour colour = node.inCycle && holder.inCycle ? *wxRED : *wxBLACK;
+			wxLineShape *line = new wxLineShape();
+			line->SetCanvas(this);
+			line->SetPen(wxThePenList->FindOrCreatePen(colour, 1, wxSOLID));
+			line->SetBrush(wxTheBrushList->FindOrCreateBrush(colour, wxSOLID));
+			line->AddArrow(ARROW_ARROW, ARROW_POSITION_END, 10.0);
+			line->MakeLineControlPoints(2);
+			from->AddLine(line, it->second);
+			InsertShape(line);
+			line->Show(true);
+			lines.Append(line);
+		}
+	}
+
+	for (it = shapes.begin(); it != shapes.end(); ++it)
+		it->second->MoveLinks();
+
+	int w = (BORDER * 2 + layers * LAYER_OFFSET + PIXPERUNIT - 1) / PIXPERUNIT;
+	int h = (BORDER * 2 + slots * SLOT_OFFSET + PIXPERUNIT - 1) / PIXPERUNIT;
+	SetScrollbars(PIXPERUNIT, PIXPERUNIT, w, h);
+
+	Refresh();
+}
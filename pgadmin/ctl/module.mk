@@ -16,6 +16,7 @@ pgadmin3_SOURCES += \
         ctl/ctlColourPicker.cpp \
         ctl/ctlComboBox.cpp \
         ctl/ctlListView.cpp \
+        ctl/ctlLogList.cpp \
         ctl/ctlMenuToolbar.cpp \
         ctl/ctlSQLBox.cpp \
         ctl/ctlSQLGrid.cpp \
@@ -27,6 +28,7 @@ pgadmin3_SOURCES += \
         ctl/ctlProgressStatusBar.cpp \
         ctl/explainCanvas.cpp \
         ctl/explainShape.cpp \
+        ctl/lockGraphCanvas.cpp \
         ctl/timespin.cpp \
         ctl/xh_calb.cpp \
         ctl/xh_ctlcolourpicker.cpp \
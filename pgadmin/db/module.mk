@@ -11,9 +11,14 @@
 
 pgadmin3_SOURCES += \
 	db/keywords.c \
+	db/pgCompletionCache.cpp \
 	db/pgConn.cpp \
+	db/pgConnMonitor.cpp \
+	db/pgConnPool.cpp \
 	db/pgSet.cpp \
-	db/pgQueryThread.cpp
+	db/pgQueryThread.cpp \
+	db/pgResultView.cpp \
+	db/pgRowStore.cpp
 
 EXTRA_DIST += \
         db/module.mk
@@ -0,0 +1,496 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgCompletionCache.cpp - Names of a database for the autocompletion
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// App headers
+#include "db/pgCompletionCache.h"
+#include "db/pgSet.h"
+
+pgCompletionCacheMap pgCompletionCache::caches;
+
+
+void *pgCompletionLoader::Entry()
+{
+	cache->Run();
+	cache->LoaderDone();
+	return NULL;
+}
+
+
+pgCompletionNames::~pgCompletionNames()
+{
+	pgCompletionColumnsMap::iterator it;
+	for (it = columns.begin(); it != columns.end(); ++it)
+		delete it->second;
+}
+
+
+// Sort the names, dropping the duplicates
+static void SortNames(wxArrayString &names)
+{
+	names.Sort();
+
+	size_t i, kept = 0;
+	for (i = 0; i < names.GetCount(); i++)
+	{
+		if (!kept || names.Item(i) != names.Item(kept - 1))
+			names[kept++] = names.Item(i);
+	}
+	if (kept < names.GetCount())
+		names.RemoveAt(kept, names.GetCount() - kept);
+}
+
+
+static int KindOf(wxChar relkind)
+{
+	switch (relkind)
+	{
+		case 'r':
+			return COMPLETION_TABLE;
+		case 'v':
+			return COMPLETION_VIEW;
+		case 'S':
+			return COMPLETION_SEQUENCE;
+		case 'i':
+			return COMPLETION_INDEX;
+		case 'f':
+			return COMPLETION_FUNCTION;
+	}
+	return -1;
+}
+
+
+pgCompletionCache::pgCompletionCache(const wxString &_key)
+	: condition(mutex)
+{
+	key = _key;
+	refCount = 1;
+	conn = NULL;
+	loaderStarted = false;
+	failed = false;
+	connectFailed = false;
+	loaderRunning = false;
+
+	names = NULL;
+	checkRequested = false;
+	stopping = false;
+	lastCheck = 0;
+}
+
+
+pgCompletionCache::~pgCompletionCache()
+{
+	if (conn)
+		delete conn;
+	if (names)
+		delete names;
+}
+
+
+// Two databases of the same name, on servers only told apart by the port or
+// the socket directory, mustn't share their names
+wxString pgCompletionCache::GetKey(pgConn *conn)
+{
+	if (!conn->save_service.IsEmpty())
+		return wxT("service=") + conn->save_service + wxT("/") + conn->save_username;
+
+	return conn->save_server + wxT("/") + conn->save_hostaddr + wxString::Format(wxT(":%d/"), conn->save_port) +
+	       conn->save_database + wxT("/") + conn->save_username;
+}
+
+
+pgCompletionCache *pgCompletionCache::Acquire(pgConn *conn)
+{
+	wxString key = GetKey(conn);
+	pgCompletionCacheMap::iterator it = caches.find(key);
+
+	if (it != caches.end())
+	{
+		it->second->refCount++;
+		return it->second;
+	}
+
+	pgCompletionCache *cache = new pgCompletionCache(key);
+	caches[key] = cache;
+	return cache;
+}
+
+
+pgCompletionCache *pgCompletionCache::Find(pgConn *conn)
+{
+	pgCompletionCacheMap::iterator it = caches.find(GetKey(conn));
+	return it == caches.end() ? NULL : it->second;
+}
+
+
+void pgCompletionCache::Release()
+{
+	if (--refCount > 0)
+		return;
+
+	caches.erase(key);
+
+	// The UI doesn't wait for a loader, which may be stuck on a slow
+	// server: the query it runs is cancelled, and it deletes the cache
+	// itself when it's done. The lock keeps the cache alive meanwhile.
+	mutex.Lock();
+	stopping = true;
+	condition.Signal();
+	if (loaderRunning)
+	{
+		conn->CancelExecution();
+		mutex.Unlock();
+		return;
+	}
+	mutex.Unlock();
+
+	delete this;
+}
+
+
+void pgCompletionCache::LoaderDone()
+{
+	mutex.Lock();
+	loaderRunning = false;
+	bool released = stopping;
+	mutex.Unlock();
+
+	if (released)
+		delete this;
+}
+
+
+// The names are read on a connection of their own, so the SQL box's
+// connection stays free for the user's queries. The loader connects it, so
+// a slow server doesn't hold up the typing.
+bool pgCompletionCache::StartLoader(pgConn *from)
+{
+	conn = from->Duplicate(wxEmptyString, wxEmptyString, 0, false);
+	loaderStarted = true;
+
+	pgCompletionLoader *loader = new pgCompletionLoader(this);
+	if (loader->Create() != wxTHREAD_NO_ERROR)
+	{
+		delete loader;
+		return false;
+	}
+
+	loaderRunning = true;
+	if (loader->Run() != wxTHREAD_NO_ERROR)
+	{
+		loaderRunning = false;
+		delete loader;
+		return false;
+	}
+	return true;
+}
+
+
+// The names are sorted: start at the first one, which isn't less than the
+// text. The names are copied as a whole, as the loader may delete them.
+void pgCompletionCache::AddMatches(const wxArrayString &names, const wxString &text, wxArrayString &matches, const wxChar *suffix)
+{
+	size_t lo = 0, hi = names.GetCount();
+
+	while (lo < hi)
+	{
+		size_t mid = (lo + hi) / 2;
+		if (names.Item(mid).Cmp(text) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo < names.GetCount() && names.Item(lo).StartsWith(text); lo++)
+		matches.Add(wxString(names.Item(lo).c_str()) + suffix);
+}
+
+
+bool pgCompletionCache::Complete(pgConn *from, const char *kind, const wxString &text, const wxString &addon, wxArrayString &matches)
+{
+	if (!loaderStarted)
+	{
+		// Don't try to connect on every keystroke
+		if (failed || !StartLoader(from))
+		{
+			failed = true;
+			return false;
+		}
+	}
+
+	wxMutexLocker lock(mutex);
+
+	if (connectFailed)
+	{
+		connectFailed = false;
+		failed = true;
+		wxLogInfo(wxT("Could not connect to read the names for the autocompletion"));
+	}
+	if (failed)
+		return false;
+
+	// Have the loader look for changes of the catalog now and then
+	wxLongLong now = wxGetLocalTimeMillis();
+	if (now - lastCheck > COMPLETION_CHECK_INTERVAL * 1000)
+	{
+		lastCheck = now;
+		checkRequested = true;
+		condition.Signal();
+	}
+
+	if (!names)
+		return false;
+
+	if (!strcmp(kind, "a"))
+	{
+		pgCompletionColumnsMap::iterator it = names->columns.find(addon);
+		if (it == names->columns.end())
+		{
+			// Read them for the next time
+			if (pendingColumns.Index(addon) == wxNOT_FOUND)
+			{
+				pendingColumns.Add(wxString(addon.c_str()));
+				condition.Signal();
+			}
+			return false;
+		}
+		AddMatches(*it->second, text, matches);
+	}
+	else if (!strcmp(kind, "n"))
+		AddMatches(names->schemas, text, matches);
+	else
+	{
+		for (const char *k = kind; *k; k++)
+		{
+			int i = KindOf(*k);
+			if (i < 0)
+				return false;
+
+			if (text.Find('.') != wxNOT_FOUND)
+				AddMatches(names->qualified[i], text, matches);
+			else
+				AddMatches(names->visible[i], text, matches);
+		}
+
+		// The schemas, to go on with a qualified name
+		if (text.Find('.') == wxNOT_FOUND)
+			AddMatches(names->schemas, text, matches, wxT("."));
+	}
+
+	SortNames(matches);
+	return true;
+}
+
+
+void pgCompletionCache::Run()
+{
+	bool first = true;
+
+	if (!conn->Connect())
+	{
+		wxMutexLocker lock(mutex);
+		connectFailed = true;
+		return;
+	}
+
+	while (true)
+	{
+		bool check;
+		wxArrayString relations;
+
+		mutex.Lock();
+		while (!stopping && !first && !checkRequested && pendingColumns.IsEmpty())
+			condition.Wait();
+
+		if (stopping)
+		{
+			mutex.Unlock();
+			break;
+		}
+
+		check = first || checkRequested;
+		checkRequested = false;
+		for (size_t i = 0; i < pendingColumns.GetCount(); i++)
+			relations.Add(wxString(pendingColumns.Item(i).c_str()));
+		pendingColumns.Empty();
+		mutex.Unlock();
+
+		first = false;
+
+		if (check)
+		{
+			// Only read all the names again, if the catalog has been changed
+			wxString sig = ReadSignature();
+			if (!names || (!sig.IsEmpty() && sig != signature))
+			{
+				pgCompletionNames *newNames = ReadNames(), *oldNames;
+				if (newNames)
+				{
+					signature = sig;
+
+					mutex.Lock();
+					oldNames = names;
+					names = newNames;
+					mutex.Unlock();
+
+					if (oldNames)
+						delete oldNames;
+				}
+			}
+		}
+
+		for (size_t i = 0; i < relations.GetCount(); i++)
+		{
+			wxArrayString *columns = ReadColumns(relations.Item(i));
+			if (!columns)
+				continue;
+
+			mutex.Lock();
+			if (names && names->columns.find(relations.Item(i)) == names->columns.end())
+			{
+				names->columns[relations.Item(i)] = columns;
+				columns = NULL;
+			}
+			mutex.Unlock();
+
+			if (columns)
+				delete columns;
+		}
+	}
+}
+
+
+// Changes to the catalog show up in the statistics of its tables. This is
+// cheap enough to be asked for again and again.
+wxString pgCompletionCache::ReadSignature()
+{
+	wxString sig;
+	pgSet *set = conn->ExecuteSet(
+	                 wxT("SELECT (SELECT coalesce(sum(n_tup_ins + n_tup_upd + n_tup_del), 0)\n")
+	                 wxT("          FROM pg_catalog.pg_stat_sys_tables\n")
+	                 wxT("         WHERE relname IN ('pg_class', 'pg_proc', 'pg_namespace', 'pg_attribute'))::text\n")
+	                 wxT("       || ':' || (SELECT max(oid) FROM pg_catalog.pg_class)::text AS signature"));
+
+	if (set)
+	{
+		if (!set->Eof())
+			sig = set->GetVal(0);
+		delete set;
+	}
+	return sig;
+}
+
+
+pgCompletionNames *pgCompletionCache::ReadNames()
+{
+	pgSet *set;
+	int i;
+
+	wxLogInfo(wxT("Reading the names for the autocompletion"));
+
+	set = conn->ExecuteSet(
+	          wxT("SELECT c.relkind, pg_catalog.quote_ident(n.nspname) AS nspname, pg_catalog.quote_ident(c.relname) AS relname,\n")
+	          wxT("       pg_catalog.pg_table_is_visible(c.oid) AS visible\n")
+	          wxT("  FROM pg_catalog.pg_class c\n")
+	          wxT("  JOIN pg_catalog.pg_namespace n ON n.oid = c.relnamespace\n")
+	          wxT(" WHERE c.relkind IN ('r', 'v', 'S', 'i')"));
+	if (!set)
+		return NULL;
+
+	pgCompletionNames *newNames = new pgCompletionNames();
+
+	while (!set->Eof())
+	{
+		i = KindOf(set->GetVal(0)[0]);
+		if (i >= 0)
+		{
+			newNames->qualified[i].Add(set->GetVal(1) + wxT(".") + set->GetVal(2));
+			if (set->GetBool(3))
+				newNames->visible[i].Add(set->GetVal(2));
+		}
+		set->MoveNext();
+	}
+	delete set;
+
+	set = conn->ExecuteSet(
+	          wxT("SELECT DISTINCT pg_catalog.quote_ident(n.nspname) AS nspname, pg_catalog.quote_ident(p.proname) AS proname,\n")
+	          wxT("       pg_catalog.pg_function_is_visible(p.oid) AS visible\n")
+	          wxT("  FROM pg_catalog.pg_proc p\n")
+	          wxT("  JOIN pg_catalog.pg_namespace n ON n.oid = p.pronamespace"));
+	if (!set)
+	{
+		delete newNames;
+		return NULL;
+	}
+
+	while (!set->Eof())
+	{
+		newNames->qualified[COMPLETION_FUNCTION].Add(set->GetVal(0) + wxT(".") + set->GetVal(1));
+		if (set->GetBool(2))
+			newNames->visible[COMPLETION_FUNCTION].Add(set->GetVal(1));
+		set->MoveNext();
+	}
+	delete set;
+
+	set = conn->ExecuteSet(wxT("SELECT pg_catalog.quote_ident(nspname) AS nspname FROM pg_catalog.pg_namespace"));
+	if (!set)
+	{
+		delete newNames;
+		return NULL;
+	}
+
+	while (!set->Eof())
+	{
+		newNames->schemas.Add(set->GetVal(0));
+		set->MoveNext();
+	}
+	delete set;
+
+	for (i = 0; i < COMPLETION_KINDS; i++)
+	{
+		SortNames(newNames->visible[i]);
+		SortNames(newNames->qualified[i]);
+	}
+	SortNames(newNames->schemas);
+
+	return newNames;
+}
+
+
+// The columns of a relation, as it's named in the query
+wxArrayString *pgCompletionCache::ReadColumns(const wxString &relation)
+{
+	pgSet *set = conn->ExecuteSet(
+	                 wxT("SELECT pg_catalog.quote_ident(attname) AS attname\n")
+	                 wxT("  FROM pg_catalog.pg_attribute a, pg_catalog.pg_class c\n")
+	                 wxT(" WHERE c.oid = a.attrelid\n")
+	                 wxT("   AND a.attnum > 0\n")
+	                 wxT("   AND NOT a.attisdropped\n")
+	                 wxT("   AND pg_catalog.quote_ident(relname) = ") + conn->qtDbString(relation) + wxT("\n")
+	                 wxT("   AND pg_catalog.pg_table_is_visible(c.oid)"));
+	if (!set)
+		return NULL;
+
+	wxArrayString *columns = new wxArrayString();
+	while (!set->Eof())
+	{
+		columns->Add(set->GetVal(0));
+		set->MoveNext();
+	}
+	delete set;
+
+	SortNames(*columns);
+	return columns;
+}
@@ -39,8 +39,10 @@ typedef u_long in_addr_t;
 #include "utils/misc.h"
 #include "utils/sysLogger.h"
 #include "db/pgConn.h"
+#include "db/pgConnPool.h"
 #include "utils/misc.h"
 #include "db/pgSet.h"
+#include "utils/pgDefs.h"
 
 double pgConn::libpqVersion = 8.0;
 
@@ -52,10 +54,12 @@ static void pgNoticeProcessor(void *arg, const char *message)
 pgConn::pgConn(const wxString &server, const wxString &service, const wxString &hostaddr, const wxString &database, const wxString &username, const wxString &password,
                int port, const wxString &rolename, int sslmode, OID oid, const wxString &applicationname,
                const wxString &sslcert, const wxString &sslkey, const wxString &sslrootcert, const wxString &sslcrl,
-               const bool sslcompression) : m_cancelConn(NULL)
+               const bool sslcompression, const bool connect) : m_cancelConn(NULL)
 {
 	wxString msg;
 
+	InitTypeCache();
+
 	save_server = server;
 	save_hostaddr = hostaddr;
 	save_service = service;
@@ -84,6 +88,9 @@ pgConn::pgConn(const wxString &server, const wxString &service, const wxString &
 	conn = 0;
 	noticeArg = 0;
 	connStatus = PGCONN_BAD;
+	parkedIn = NULL;
+	lastUsed = wxDateTime::GetTimeNow();
+	threadUsers = 0;
 
 	// Create the connection string
 	if (!server.IsEmpty())
@@ -220,7 +227,8 @@ pgConn::pgConn(const wxString &server, const wxString &service, const wxString &
 	cleanConnStr.Replace(qtConnString(password), wxT("'XXXXXX'"));
 	wxLogInfo(wxT("Opening connection with connection string: %s"), cleanConnStr.c_str());
 
-	DoConnect();
+	if (connect)
+		DoConnect();
 }
 
 
@@ -327,6 +335,11 @@ bool pgConn::Initialize()
 
 void pgConn::Close()
 {
+	if (parkedIn)
+	{
+		parkedIn->RemoveParked(this);
+		parkedIn = NULL;
+	}
 	if (conn)
 	{
 		CancelExecution();
@@ -337,6 +350,140 @@ void pgConn::Close()
 }
 
 
+// Hand the session to the pool, which lends it to others until this
+// connection is used again. A session in a transaction, or used by a
+// thread, isn't idle and stays.
+bool pgConn::Park(pgConnPool *pool)
+{
+	if (parkedIn || !conn || threadUsers > 0 || GetStatus() != PGCONN_OK ||
+	        PQtransactionStatus(conn) != PQTRANS_IDLE)
+		return false;
+
+	pgConn *session = Duplicate(wxEmptyString, wxEmptyString, 0, false);
+	session->SwapSession(this);
+
+	parkedIn = pool;
+	pool->AddParked(this);
+	pool->Return(session);
+
+	wxLogInfo(wxT("Parked the idle connection to %s"), GetName().c_str());
+	return true;
+}
+
+
+// The pool has gone with the server's connection; the session can't be
+// taken back any more
+void pgConn::Unpark()
+{
+	parkedIn = NULL;
+	connStatus = PGCONN_BROKEN;
+}
+
+
+// Called before the session is used: take back a parked one, from the
+// pool it's been lent from, or as a new connection
+bool pgConn::Use()
+{
+	lastUsed = wxDateTime::GetTimeNow();
+
+	if (!parkedIn)
+		return true;
+
+	pgConnPool *pool = parkedIn;
+	pool->RemoveParked(this);
+	parkedIn = NULL;
+
+	pgConn *session = pool->Borrow(save_database, save_oid);
+	if (!session)
+	{
+		connStatus = PGCONN_BROKEN;
+		return false;
+	}
+
+	SwapSession(session);
+	delete session;
+
+	return GetStatus() == PGCONN_OK;
+}
+
+
+// Exchange the libpq sessions of two connections to the same database
+void pgConn::SwapSession(pgConn *other)
+{
+	PGconn *tmpConn = conn;
+	conn = other->conn;
+	other->conn = tmpConn;
+
+	int tmpStatus = connStatus;
+	connStatus = other->connStatus;
+	other->connStatus = tmpStatus;
+
+	wxMBConv *tmpConv = conv;
+	conv = other->conv;
+	other->conv = tmpConv;
+
+	bool tmpQuoting = needColQuoting;
+	needColQuoting = other->needColQuoting;
+	other->needColQuoting = tmpQuoting;
+
+	bool tmpUtf = utfConnectString;
+	utfConnectString = other->utfConnectString;
+	other->utfConnectString = tmpUtf;
+
+	OID tmpOid = dbOid;
+	dbOid = other->dbOid;
+	other->dbOid = tmpOid;
+
+	tmpOid = lastSystemOID;
+	lastSystemOID = other->lastSystemOID;
+	other->lastSystemOID = tmpOid;
+
+	// The notices go to the connection the session belongs to now
+	if (conn)
+		PQsetNoticeProcessor(conn, pgNoticeProcessor, this);
+	if (other->conn)
+		PQsetNoticeProcessor(other->conn, pgNoticeProcessor, other);
+}
+
+
+// Put the session back into the state it was connected in: whatever has
+// been SET since, the temporary tables, the prepared statements, the
+// LISTENs and the role are discarded. Only possible from 8.3 on.
+bool pgConn::ResetSession()
+{
+	if (GetStatus() != PGCONN_OK || !BackendMinimumVersion(8, 3))
+		return false;
+
+	wxString encoding = wxString(PQparameterStatus(conn, "client_encoding"), wxConvLibc);
+
+	// DISCARD ALL can't be run in a transaction block, i.e. with the
+	// other statements
+	if (!ExecuteVoid(wxT("DISCARD ALL"), false))
+		return false;
+
+	wxString sql = wxT("SET DateStyle=ISO;\nSET client_min_messages=notice;\n");
+	if (BackendMinimumVersion(9, 0))
+		sql += wxT("SET bytea_output=escape;\n");
+	if (!encoding.IsEmpty())
+		sql += wxT("SET client_encoding=") + qtString(encoding) + wxT(";\n");
+	if (!dbRole.IsEmpty() && BackendMinimumVersion(8, 1))
+		sql += wxT("SET ROLE TO ") + qtIdent(dbRole) + wxT(";\n");
+
+	return ExecuteVoid(sql, false);
+}
+
+
+// Open a connection, which has been made without connecting, e.g. in a
+// worker thread, so the UI doesn't wait for the server
+bool pgConn::Connect()
+{
+	if (conn)
+		return GetStatus() == PGCONN_OK;
+
+	return DoConnect();
+}
+
+
 // Reconnect to the server
 bool pgConn::Reconnect()
 {
@@ -357,13 +504,15 @@ bool pgConn::Reconnect()
 }
 
 
-pgConn *pgConn::Duplicate(const wxString &_appName)
+pgConn *pgConn::Duplicate(const wxString &_appName, const wxString &_database, OID _oid, bool connect)
 {
+	bool sameDatabase = _database.IsEmpty() || _database == save_database;
+
 	pgConn *res = new pgConn(wxString(save_server), wxString(save_service),
-	                         wxString(save_hostaddr), wxString(save_database), wxString(save_username),
-	                         wxString(save_password), save_port, save_rolename, save_sslmode, save_oid,
+	                         wxString(save_hostaddr), sameDatabase ? wxString(save_database) : _database, wxString(save_username),
+	                         wxString(save_password), save_port, save_rolename, save_sslmode, sameDatabase ? save_oid : _oid,
 	                         _appName.IsEmpty() ? save_applicationname : _appName, save_sslcert, save_sslkey,
-	                         save_sslrootcert, save_sslcrl, save_sslcompression);
+	                         save_sslrootcert, save_sslcrl, save_sslcompression, connect);
 
 	// Save the version and features information from the existing connection
 	res->majorVersion = majorVersion;
@@ -371,10 +520,15 @@ pgConn *pgConn::Duplicate(const wxString &_appName)
 	res->patchVersion = patchVersion;
 	res->isEdb = isEdb;
 	res->isGreenplum = isGreenplum;
-	res->reservedNamespaces = reservedNamespaces;
 
-	for (size_t index = FEATURE_INITIALIZED; index < FEATURE_LAST; index++)
-		res->features[index] = features[index];
+	// The features depend on the functions installed in the database, the
+	// reserved namespaces on its replication schemas
+	if (sameDatabase)
+	{
+		res->reservedNamespaces = reservedNamespaces;
+		for (size_t index = FEATURE_INITIALIZED; index < FEATURE_LAST; index++)
+			res->features[index] = features[index];
+	}
 
 	return res;
 }
@@ -693,9 +847,11 @@ void pgConn::Notice(const char *msg)
 	{
 		wxString str(msg, *conv);
 
+#if !defined(PGSCLI)
 		// Display the notice if required
 		if (settings->GetShowNotices())
 			wxMessageBox(str, _("Notice"), wxICON_INFORMATION | wxOK);
+#endif // PGSCLI
 
 		wxLogNotice(wxT("%s"), str.Trim().c_str());
 	}
@@ -720,6 +876,10 @@ pgNotification *pgConn::GetNotification()
 
 int pgConn::GetTxStatus()
 {
+	// A parked session has been left idle
+	if (parkedIn)
+		return PQTRANS_IDLE;
+
 	return PQtransactionStatus(conn);
 }
 
@@ -729,6 +889,8 @@ int pgConn::GetTxStatus()
 
 bool pgConn::ExecuteVoid(const wxString &sql, bool reportError)
 {
+	Use();
+
 	if (GetStatus() != PGCONN_OK)
 		return false;
 
@@ -764,6 +926,8 @@ wxString pgConn::ExecuteScalar(const wxString &sql, bool reportError)
 {
 	wxString result;
 
+	Use();
+
 	if (GetStatus() == PGCONN_OK)
 	{
 		// Execute the query and get the status.
@@ -807,6 +971,8 @@ wxString pgConn::ExecuteScalar(const wxString &sql, bool reportError)
 
 pgSet *pgConn::ExecuteSet(const wxString &sql, bool reportError)
 {
+	Use();
+
 	// Execute the query and get the status.
 	if (GetStatus() == PGCONN_OK)
 	{
@@ -817,28 +983,94 @@ pgSet *pgConn::ExecuteSet(const wxString &sql, bool reportError)
 		qryRes = PQexec(conn, sql.mb_str(*conv));
 		ResetConnCancel();
 
-		lastResultStatus = PQresultStatus(qryRes);
-		SetLastResultError(qryRes);
+		return MakeSet(qryRes, reportError);
+	}
+	return new pgSet();
+}
+
+
+bool pgConn::Prepare(const wxString &name, const wxString &sql, int nParams, bool reportError)
+{
+	Use();
 
-		if (lastResultStatus == PGRES_TUPLES_OK || lastResultStatus == PGRES_COMMAND_OK)
+	if (GetStatus() != PGCONN_OK)
+		return false;
+
+	PGresult *qryRes;
+	wxLogSql(wxT("Prepare query %s (%s:%d): %s"), name.c_str(), this->GetHost().c_str(), this->GetPort(), sql.c_str());
+
+	SetConnCancel();
+	qryRes = PQprepare(conn, name.mb_str(*conv), sql.mb_str(*conv), nParams, NULL);
+	ResetConnCancel();
+
+	lastResultStatus = PQresultStatus(qryRes);
+	SetLastResultError(qryRes);
+
+	if (lastResultStatus != PGRES_COMMAND_OK)
+	{
+		LogError(!reportError);
+		PQclear(qryRes);
+		return false;
+	}
+
+	PQclear(qryRes);
+	return true;
+}
+
+
+pgSet *pgConn::ExecutePrepared(const wxString &name, const wxArrayString &params, bool reportError)
+{
+	Use();
+
+	if (GetStatus() == PGCONN_OK)
+	{
+		PGresult *qryRes;
+		wxLogSql(wxT("Prepared query %s (%s:%d)"), name.c_str(), this->GetHost().c_str(), this->GetPort());
+
+		// The converted values have to be kept until the query has been sent
+		size_t count = params.GetCount(), i;
+		wxCharBuffer *values = new wxCharBuffer[count];
+		const char **paramValues = new const char *[count];
+		for (i = 0; i < count; i++)
 		{
-			pgSet *set = new pgSet(qryRes, this, *conv, needColQuoting);
-			if (!set)
-			{
-				if (reportError)
-					wxLogError(_("Couldn't create a pgSet object!"));
-				else
-					wxLogQuietError(_("Couldn't create a pgSet object!"));
-				PQclear(qryRes);
-			}
-			return set;
+			values[i] = params.Item(i).mb_str(*conv);
+			paramValues[i] = values[i].data() ? values[i].data() : "";
 		}
-		else
+
+		SetConnCancel();
+		qryRes = PQexecPrepared(conn, name.mb_str(*conv), (int)count, paramValues, NULL, NULL, 0);
+		ResetConnCancel();
+
+		delete[] paramValues;
+		delete[] values;
+
+		return MakeSet(qryRes, reportError);
+	}
+	return new pgSet();
+}
+
+
+pgSet *pgConn::MakeSet(PGresult *qryRes, bool reportError)
+{
+	lastResultStatus = PQresultStatus(qryRes);
+	SetLastResultError(qryRes);
+
+	if (lastResultStatus == PGRES_TUPLES_OK || lastResultStatus == PGRES_COMMAND_OK)
+	{
+		pgSet *set = new pgSet(qryRes, this, *conv, needColQuoting);
+		if (!set)
 		{
-			LogError(!reportError);
+			if (reportError)
+				wxLogError(_("Couldn't create a pgSet object!"));
+			else
+				wxLogQuietError(_("Couldn't create a pgSet object!"));
 			PQclear(qryRes);
 		}
+		return set;
 	}
+
+	LogError(!reportError);
+	PQclear(qryRes);
 	return new pgSet();
 }
 
@@ -846,8 +1078,10 @@ pgSet *pgConn::ExecuteSet(const wxString &sql, bool reportError)
 // COPY functions
 //////////////////////////////////////////////////////////////////////////
 
-bool pgConn::StartCopy(const wxString query)
+bool pgConn::StartCopy(const wxString query, bool reportError)
 {
+	Use();
+
 	if (GetStatus() != PGCONN_OK)
 		return false;
 
@@ -862,12 +1096,13 @@ bool pgConn::StartCopy(const wxString query)
 	// Check for errors
 	if (lastResultStatus != PGRES_COPY_IN)
 	{
-		LogError(false);
+		LogError(!reportError);
 		PQclear(qryRes);
 		return false;
 	}
 
-	// NO cleanup & exit
+	// The data follows
+	PQclear(qryRes);
 	return  true;
 }
 
@@ -892,7 +1127,7 @@ bool pgConn::EndPutCopy(const wxString errormsg)
 	return result == 1;
 }
 
-bool pgConn::GetCopyFinalStatus(void)
+bool pgConn::GetCopyFinalStatus(bool reportError)
 {
 	PGresult   *qryRes;
 
@@ -900,10 +1135,15 @@ bool pgConn::GetCopyFinalStatus(void)
 	qryRes = PQgetResult(conn);
 	lastResultStatus = PQresultStatus(qryRes);
 
+	// Drain the results left, so that the connection can be used again
+	PGresult *nextRes;
+	while ((nextRes = PQgetResult(conn)) != NULL)
+		PQclear(nextRes);
+
 	// Check for errors
 	if (lastResultStatus != PGRES_COMMAND_OK)
 	{
-		LogError(false);
+		LogError(!reportError);
 		PQclear(qryRes);
 		return false;
 	}
@@ -913,6 +1153,59 @@ bool pgConn::GetCopyFinalStatus(void)
 	return  true;
 }
 
+bool pgConn::StartCopyOut(const wxString query)
+{
+	Use();
+
+	if (GetStatus() != PGCONN_OK)
+		return false;
+
+	// Execute the query and get the status
+	PGresult *qryRes;
+
+	wxLogSql(wxT("COPY query (%s:%d): %s"), this->GetHost().c_str(), this->GetPort(), query.c_str());
+	SetConnCancel();
+	qryRes = PQexec(conn, query.mb_str(*conv));
+	lastResultStatus = PQresultStatus(qryRes);
+	SetLastResultError(qryRes);
+
+	// Check for errors
+	if (lastResultStatus != PGRES_COPY_OUT)
+	{
+		ResetConnCancel();
+		LogError(false);
+		PQclear(qryRes);
+		return false;
+	}
+
+	// The data follows, the query can still be cancelled
+	PQclear(qryRes);
+	return  true;
+}
+
+// Returns the length of the row read, 0 if no complete row has arrived yet,
+// -1 at the end of the data, and -2 on error. The buffer must be freed with
+// PQfreemem(). With wait, it blocks until a row has arrived, and never
+// returns 0.
+int pgConn::GetCopyData(char **buffer, bool wait)
+{
+	int result = PQgetCopyData(conn, buffer, wait ? 0 : 1);
+
+	// The connection has been lost, if no more input can be read
+	if (result == 0)
+	{
+		if (PQconsumeInput(conn))
+			result = PQgetCopyData(conn, buffer, 1);
+		else
+			result = -2;
+	}
+
+	if (result < 0)
+		ResetConnCancel();
+
+	return result;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Info
 //////////////////////////////////////////////////////////////////////////
@@ -959,6 +1252,10 @@ void pgConn::LogError(const bool quiet)
 
 bool pgConn::IsAlive()
 {
+	// The pool checks a session before it's taken back
+	if (parkedIn)
+		return true;
+
 	if (GetStatus() != PGCONN_OK)
 	{
 		if (conn)
@@ -1008,6 +1305,7 @@ int pgConn::GetStatus() const
 
 void pgConn::Reset()
 {
+	Use();
 	PQreset(conn);
 
 	// Reset any vars that need to be in a defined state before connecting
@@ -1231,6 +1529,206 @@ bool pgConn::TableHasColumn(wxString schemaname, wxString tblname, const wxStrin
 	return false;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Data type cache
+//////////////////////////////////////////////////////////////////////////
+
+// The built-in types, which do not need a round trip to the server
+static const struct
+{
+	OID typoid;
+	const wxChar *name;
+} builtinTypes[] =
+{
+	{ PGOID_TYPE_BOOL, wxT("boolean") },
+	{ PGOID_TYPE_BYTEA, wxT("bytea") },
+	{ PGOID_TYPE_CHAR, wxT("\"char\"") },
+	{ PGOID_TYPE_NAME, wxT("name") },
+	{ PGOID_TYPE_INT8, wxT("bigint") },
+	{ PGOID_TYPE_INT2, wxT("smallint") },
+	{ PGOID_TYPE_INT4, wxT("integer") },
+	{ PGOID_TYPE_TEXT, wxT("text") },
+	{ PGOID_TYPE_OID, wxT("oid") },
+	{ PGOID_TYPE_TID, wxT("tid") },
+	{ PGOID_TYPE_XID, wxT("xid") },
+	{ PGOID_TYPE_CID, wxT("cid") },
+	{ PGOID_TYPE_FLOAT4, wxT("real") },
+	{ PGOID_TYPE_FLOAT8, wxT("double precision") },
+	{ PGOID_TYPE_MONEY, wxT("money") },
+	{ PGOID_TYPE_BPCHAR, wxT("character") },
+	{ PGOID_TYPE_VARCHAR, wxT("character varying") },
+	{ PGOID_TYPE_DATE, wxT("date") },
+	{ PGOID_TYPE_TIME, wxT("time without time zone") },
+	{ PGOID_TYPE_TIMESTAMP, wxT("timestamp without time zone") },
+	{ PGOID_TYPE_TIMESTAMPTZ, wxT("timestamp with time zone") },
+	{ PGOID_TYPE_INTERVAL, wxT("interval") },
+	{ PGOID_TYPE_TIMETZ, wxT("time with time zone") },
+	{ PGOID_TYPE_BIT, wxT("bit") },
+	{ PGOID_TYPE_NUMERIC, wxT("numeric") },
+	{ 0, 0 }
+};
+
+
+void pgConn::InitTypeCache()
+{
+	typeInfo.clear();
+	fullTypeNames.clear();
+
+	for (int i = 0; builtinTypes[i].name; i++)
+	{
+		OID typoid = builtinTypes[i].typoid;
+		pgTypeInfo &info = typeInfo[typoid];
+
+		info.typClass = pgSet::TypClassFromOid(typoid);
+		info.name = builtinTypes[i].name;
+
+		// format_type() reports bpchar and bit without a typmod differently,
+		// as they'd mean char(1) and bit(1) otherwise.
+		if (typoid != PGOID_TYPE_BPCHAR && typoid != PGOID_TYPE_BIT)
+			fullTypeNames[TypeModKey(typoid, -1)] = info.name;
+	}
+}
+
+
+wxString pgConn::TypeModKey(OID typoid, long typmod)
+{
+	return NumToStr(typoid) + wxT(":") + NumToStr(typmod);
+}
+
+
+// Look up all the types not in the cache yet with a single query
+void pgConn::CacheTypes(const wxArrayLong &typoids, const wxArrayLong &typmods)
+{
+	wxString values;
+	wxArrayString keys;
+
+	wxASSERT(typoids.GetCount() == typmods.GetCount());
+
+	for (size_t i = 0; i < typoids.GetCount(); i++)
+	{
+		OID typoid = (OID)typoids[i];
+		wxString key = TypeModKey(typoid, typmods[i]);
+
+		if (typeInfo.find(typoid) != typeInfo.end() &&
+		        fullTypeNames.find(key) != fullTypeNames.end())
+			continue;
+		if (keys.Index(key) != wxNOT_FOUND)
+			continue;
+
+		keys.Add(key);
+		if (!values.IsEmpty())
+			values += wxT(", ");
+		values += wxT("(") + NumToStr(typoid) + wxT("::oid, ") + NumToStr(typmods[i]) + wxT(")");
+	}
+
+	if (keys.IsEmpty())
+		return;
+
+	pgSet *set = ExecuteSet(
+	                 wxT("SELECT t.oid, CASE WHEN t.typbasetype=0 THEN t.oid ELSE t.typbasetype END AS basetype,\n")
+	                 wxT("       format_type(t.oid, NULL) AS typname, format_type(t.oid, m.typmod) AS fulltype, m.typmod\n")
+	                 wxT("  FROM (VALUES ") + values + wxT(") m(typoid, typmod)\n")
+	                 wxT("  JOIN pg_type t ON t.oid = m.typoid"));
+
+	// Don't remember anything, if the query failed (i.e. in an aborted
+	// transaction), so we'll try again next time.
+	if (!set->NumCols())
+	{
+		delete set;
+		return;
+	}
+
+	while (!set->Eof())
+	{
+		OID typoid = set->GetOid(wxT("oid"));
+		pgTypeInfo &info = typeInfo[typoid];
+
+		info.typClass = pgSet::TypClassFromOid(set->GetOid(wxT("basetype")));
+		info.name = set->GetVal(wxT("typname"));
+		fullTypeNames[TypeModKey(typoid, set->GetLong(wxT("typmod")))] = set->GetVal(wxT("fulltype"));
+
+		set->MoveNext();
+	}
+	delete set;
+
+	// Types not found are not going to show up later either
+	for (size_t i = 0; i < keys.GetCount(); i++)
+	{
+		if (fullTypeNames.find(keys[i]) == fullTypeNames.end())
+			fullTypeNames[keys[i]] = wxEmptyString;
+	}
+	for (size_t i = 0; i < typoids.GetCount(); i++)
+	{
+		OID typoid = (OID)typoids[i];
+		if (typeInfo.find(typoid) == typeInfo.end())
+		{
+			typeInfo[typoid].typClass = PGTYPCLASS_OTHER;
+			typeInfo[typoid].name = wxEmptyString;
+		}
+	}
+}
+
+
+pgTypClass pgConn::GetTypeClass(OID typoid)
+{
+	pgTypeInfoMap::iterator it = typeInfo.find(typoid);
+
+	if (it == typeInfo.end())
+	{
+		wxArrayLong typoids, typmods;
+		typoids.Add((long)typoid);
+		typmods.Add(-1);
+		CacheTypes(typoids, typmods);
+
+		it = typeInfo.find(typoid);
+		if (it == typeInfo.end())
+			return PGTYPCLASS_OTHER;
+	}
+
+	return it->second.typClass;
+}
+
+
+wxString pgConn::GetTypeName(OID typoid)
+{
+	pgTypeInfoMap::iterator it = typeInfo.find(typoid);
+
+	if (it == typeInfo.end())
+	{
+		wxArrayLong typoids, typmods;
+		typoids.Add((long)typoid);
+		typmods.Add(-1);
+		CacheTypes(typoids, typmods);
+
+		it = typeInfo.find(typoid);
+		if (it == typeInfo.end())
+			return wxEmptyString;
+	}
+
+	return it->second.name;
+}
+
+
+wxString pgConn::GetFullTypeName(OID typoid, long typmod)
+{
+	wxString key = TypeModKey(typoid, typmod);
+	pgTypeNameMap::iterator it = fullTypeNames.find(key);
+
+	if (it == fullTypeNames.end())
+	{
+		wxArrayLong typoids, typmods;
+		typoids.Add((long)typoid);
+		typmods.Add(typmod);
+		CacheTypes(typoids, typmods);
+
+		it = fullTypeNames.find(key);
+		if (it == fullTypeNames.end())
+			return wxEmptyString;
+	}
+
+	return it->second;
+}
+
 void pgError::SetError(PGresult *_res, wxMBConv *_conv)
 {
 	if (!_conv)
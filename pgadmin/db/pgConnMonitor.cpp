@@ -0,0 +1,541 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgConnMonitor.cpp - Background checks whether the servers can be reached
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// PostgreSQL headers
+#include <libpq-fe.h>
+
+// Network headers
+#ifndef __WXMSW__
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <errno.h>
+#endif
+
+// App headers
+#include "db/pgConnMonitor.h"
+
+#include <wx/arrimpl.cpp>
+WX_DEFINE_OBJARRAY(pgConnMonitorTargets);
+
+DEFINE_EVENT_TYPE(CONNMONITOR_STATE_EVENT)
+
+// Longest wait (ms) for the sockets, before checking whether to stop
+#define CONNMONITOR_SLICE 250
+
+
+pgConnMonitor::pgConnMonitor(wxEvtHandler *_handler)
+	: wxThread(wxTHREAD_JOINABLE), wakeup(mutex)
+{
+	handler = _handler;
+	stopping = false;
+}
+
+
+int pgConnMonitor::FindTarget(void *key)
+{
+	for (size_t i = 0; i < targets.GetCount(); i++)
+	{
+		if (targets.Item(i).key == key)
+			return i;
+	}
+	return -1;
+}
+
+
+void pgConnMonitor::Watch(void *key, pgConn *conn, bool handshake)
+{
+	wxMutexLocker lock(mutex);
+
+	int i = FindTarget(key);
+	if (i < 0)
+	{
+		pgConnMonitorTarget *target = new pgConnMonitorTarget;
+		target->key = key;
+		targets.Add(target);
+		i = targets.GetCount() - 1;
+	}
+
+	// The thread gets copies of its own of the strings
+	targets.Item(i).connstr = wxString(conn->connstr.c_str());
+	targets.Item(i).utf = conn->GetNeedUtfConnectString();
+	targets.Item(i).handshake = handshake;
+
+	// It's just been connected to
+	targets.Item(i).stats.alive = true;
+}
+
+
+void pgConnMonitor::Unwatch(void *key)
+{
+	wxMutexLocker lock(mutex);
+
+	int i = FindTarget(key);
+	if (i >= 0)
+		targets.RemoveAt(i);
+}
+
+
+bool pgConnMonitor::IsAlive(void *key)
+{
+	wxMutexLocker lock(mutex);
+
+	int i = FindTarget(key);
+	return i < 0 || targets.Item(i).stats.alive;
+}
+
+
+bool pgConnMonitor::GetStats(void *key, pgConnMonitorStats &stats)
+{
+	wxMutexLocker lock(mutex);
+
+	int i = FindTarget(key);
+	if (i < 0)
+		return false;
+
+	stats = targets.Item(i).stats;
+	return true;
+}
+
+
+void pgConnMonitor::Stop()
+{
+	{
+		wxMutexLocker lock(mutex);
+		stopping = true;
+		wakeup.Signal();
+	}
+	Wait();
+}
+
+
+void *pgConnMonitor::Entry()
+{
+	mutex.Lock();
+	while (!stopping)
+	{
+		// The servers are probed without holding the lock, so they can be
+		// watched and unwatched meanwhile
+		pgConnMonitorTargets probes;
+		size_t i;
+		for (i = 0; i < targets.GetCount(); i++)
+		{
+			pgConnMonitorTarget *probe = new pgConnMonitorTarget;
+			probe->key = targets.Item(i).key;
+			probe->connstr = wxString(targets.Item(i).connstr.c_str());
+			probe->utf = targets.Item(i).utf;
+			probe->handshake = targets.Item(i).handshake;
+			probes.Add(probe);
+		}
+		mutex.Unlock();
+
+		ProbeAll(probes);
+
+		mutex.Lock();
+		for (i = 0; i < probes.GetCount() && !stopping; i++)
+		{
+			const pgConnMonitorStats &probe = probes.Item(i).stats;
+			int t = FindTarget(probes.Item(i).key);
+			if (t < 0)
+				continue;
+
+			pgConnMonitorStats &stats = targets.Item(t).stats;
+			stats.probes++;
+			if (probe.alive)
+			{
+				stats.lastLatency = probe.lastLatency;
+				if (stats.minLatency < 0 || probe.lastLatency < stats.minLatency)
+					stats.minLatency = probe.lastLatency;
+				if (probe.lastLatency > stats.maxLatency)
+					stats.maxLatency = probe.lastLatency;
+				stats.totalLatency += probe.lastLatency;
+			}
+			else
+				stats.failures++;
+
+			if (stats.alive != probe.alive)
+			{
+				stats.alive = probe.alive;
+
+				wxCommandEvent event(CONNMONITOR_STATE_EVENT, wxID_ANY);
+				event.SetClientData(probes.Item(i).key);
+				event.SetInt(probe.alive ? 1 : 0);
+				event.SetExtraLong(probe.lastLatency);
+				wxPostEvent(handler, event);
+			}
+		}
+
+		if (!stopping)
+			wakeup.WaitTimeout(CONNMONITOR_INTERVAL * 1000);
+	}
+	mutex.Unlock();
+
+	return NULL;
+}
+
+
+// Whether the connection has got past connecting the socket: the server is
+// listening then, whatever it'll say to the session
+static bool Reached(PGconn *conn)
+{
+	switch (PQstatus(conn))
+	{
+		case CONNECTION_STARTED:
+		case CONNECTION_BAD:
+		case CONNECTION_NEEDED:
+			return false;
+		default:
+			return true;
+	}
+}
+
+
+// Whether the server has answered the startup packet (or the SSL request)
+// libpq sent: the first byte of the answer is peeked at, and left in the
+// socket. An authentication request, an error or the answer to the SSL
+// request all come from the server itself.
+static bool Answered(PGconn *conn)
+{
+	char c;
+	return recv(PQsocket(conn), &c, 1, MSG_PEEK) > 0;
+}
+
+
+// Connect to all the servers at once. A server is alive, if its socket
+// could be connected to within CONNMONITOR_TIMEOUT; the connection is
+// closed again right away, before the startup packet is sent. So the
+// server doesn't start a backend or check a password for the probe, and a
+// server, which would refuse the session (too many clients, a rejected
+// login), still counts as answering. Only socket errors and timeouts fail.
+//
+// The port of an SSH tunnel is the local end of the tunnel, which accepts
+// connections even when the other end is dead. So for these targets, the
+// startup packet is sent, and the server is alive once the first byte of
+// its answer has arrived. The first time libpq waits to read is for that
+// answer, and the connection is closed before the password is sent.
+void pgConnMonitor::ProbeAll(pgConnMonitorTargets &probes)
+{
+	size_t count = probes.GetCount(), pending = 0, i;
+	if (!count)
+		return;
+
+	PGconn **conns = new PGconn *[count];
+	PostgresPollingStatusType *polling = new PostgresPollingStatusType[count];
+	wxLongLong *started = new wxLongLong[count];
+
+	for (i = 0; i < count; i++)
+	{
+		pgConnMonitorTarget &probe = probes.Item(i);
+		probe.stats.alive = false;
+
+		// Resolving the host name may block, but only this thread
+		started[i] = wxGetLocalTimeMillis();
+		if (probe.utf)
+			conns[i] = PQconnectStart(probe.connstr.mb_str(wxConvUTF8));
+		else
+			conns[i] = PQconnectStart(probe.connstr.mb_str(wxConvLibc));
+
+		if (!conns[i] || PQstatus(conns[i]) == CONNECTION_BAD)
+			polling[i] = PGRES_POLLING_FAILED;
+		else if (Reached(conns[i]) && !probe.handshake)
+		{
+			// A local socket is connected at once
+			probe.stats.alive = true;
+			probe.stats.lastLatency = (wxGetLocalTimeMillis() - started[i]).ToLong();
+			polling[i] = PGRES_POLLING_OK;
+		}
+		else
+		{
+			polling[i] = PGRES_POLLING_WRITING;
+			pending++;
+		}
+	}
+
+	wxLongLong start = wxGetLocalTimeMillis();
+	while (pending > 0 && !stopping)
+	{
+		long left = CONNMONITOR_TIMEOUT - (wxGetLocalTimeMillis() - start).ToLong();
+		if (left <= 0)
+			break;
+
+		fd_set readFds, writeFds;
+		int maxFd = -1;
+
+		FD_ZERO(&readFds);
+		FD_ZERO(&writeFds);
+
+		for (i = 0; i < count; i++)
+		{
+			if (polling[i] == PGRES_POLLING_OK || polling[i] == PGRES_POLLING_FAILED)
+				continue;
+
+			int sock = PQsocket(conns[i]);
+			if (sock < 0)
+			{
+				polling[i] = PGRES_POLLING_FAILED;
+				pending--;
+				continue;
+			}
+
+			FD_SET(sock, polling[i] == PGRES_POLLING_READING ? &readFds : &writeFds);
+			if (sock > maxFd)
+				maxFd = sock;
+		}
+
+		if (maxFd < 0)
+			break;
+
+		struct timeval tv;
+		long wait = wxMin(left, (long)CONNMONITOR_SLICE);
+		tv.tv_sec = wait / 1000;
+		tv.tv_usec = (wait % 1000) * 1000;
+
+		if (select(maxFd + 1, &readFds, &writeFds, NULL, &tv) < 0)
+		{
+#ifndef __WXMSW__
+			if (errno == EINTR)
+				continue;
+#endif
+			wxLogInfo(wxT("select() failed in the connection monitor (error %d)"), wxSysErrorCode());
+			break;
+		}
+
+		for (i = 0; i < count; i++)
+		{
+			if (polling[i] == PGRES_POLLING_OK || polling[i] == PGRES_POLLING_FAILED)
+				continue;
+
+			int sock = PQsocket(conns[i]);
+			if (!FD_ISSET(sock, polling[i] == PGRES_POLLING_READING ? &readFds : &writeFds))
+				continue;
+
+			if (probes.Item(i).handshake && polling[i] == PGRES_POLLING_READING)
+				polling[i] = Answered(conns[i]) ? PGRES_POLLING_OK : PGRES_POLLING_FAILED;
+			else
+				polling[i] = PQconnectPoll(conns[i]);
+
+			if (polling[i] == PGRES_POLLING_OK || (polling[i] != PGRES_POLLING_FAILED && !probes.Item(i).handshake && Reached(conns[i])))
+			{
+				probes.Item(i).stats.alive = true;
+				probes.Item(i).stats.lastLatency = (wxGetLocalTimeMillis() - started[i]).ToLong();
+				polling[i] = PGRES_POLLING_OK;
+				pending--;
+			}
+			else if (polling[i] == PGRES_POLLING_FAILED)
+				pending--;
+		}
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		if (conns[i])
+			PQfinish(conns[i]);
+	}
+
+	delete[] conns;
+	delete[] polling;
+	delete[] started;
+}
+
+
+void pgConnCheck::CheckAll()
+{
+	if (conns.IsEmpty())
+		return;
+
+	// Only the UI needs to be kept painted
+	if (!wxThread::IsMain() || Create() != wxTHREAD_NO_ERROR || Run() != wxTHREAD_NO_ERROR)
+	{
+		// Check them here then, which still takes CONNMONITOR_TIMEOUT at most
+		Entry();
+		return;
+	}
+
+	while (IsRunning())
+	{
+		wxSafeYield();
+		wxMilliSleep(10);
+	}
+	Wait();
+}
+
+
+void *pgConnCheck::Entry()
+{
+	size_t count = conns.GetCount(), pending = 0, i;
+
+	// Whether each connection waits to send the query (1), for the answer
+	// (2), or is done (0)
+	int *state = new int[count];
+	bool *alive = new bool[count];
+
+	for (i = 0; i < count; i++)
+	{
+		pgConn *conn = (pgConn *)conns.Item(i);
+		state[i] = 0;
+		alive[i] = false;
+
+		// A parked session is checked when it's taken back
+		if (conn->IsParked())
+		{
+			alive[i] = true;
+			continue;
+		}
+
+		if (conn->GetStatus() != PGCONN_OK)
+			continue;
+
+		// The connection is busy with a query of another thread, which
+		// shows it's working well enough
+		if (PQtransactionStatus(conn->conn) == PQTRANS_ACTIVE)
+		{
+			alive[i] = true;
+			continue;
+		}
+
+		const char *sql = "SELECT 1;";
+		if (PQtransactionStatus(conn->conn) == PQTRANS_INERROR)
+			sql = "ROLLBACK TRANSACTION; SELECT 1;";
+
+		PQsetnonblocking(conn->conn, 1);
+		if (PQsendQuery(conn->conn, sql))
+		{
+			state[i] = 1;
+			pending++;
+		}
+	}
+
+	wxLongLong start = wxGetLocalTimeMillis();
+	while (pending > 0)
+	{
+		long left = CONNMONITOR_TIMEOUT - (wxGetLocalTimeMillis() - start).ToLong();
+		if (left <= 0)
+			break;
+
+		fd_set readFds, writeFds;
+		int maxFd = -1;
+
+		FD_ZERO(&readFds);
+		FD_ZERO(&writeFds);
+
+		for (i = 0; i < count; i++)
+		{
+			if (!state[i])
+				continue;
+
+			pgConn *conn = (pgConn *)conns.Item(i);
+			int sock = PQsocket(conn->conn);
+			if (sock < 0)
+			{
+				state[i] = 0;
+				pending--;
+				continue;
+			}
+
+			FD_SET(sock, state[i] == 1 ? &writeFds : &readFds);
+			if (sock > maxFd)
+				maxFd = sock;
+		}
+
+		if (maxFd < 0)
+			break;
+
+		struct timeval tv;
+		long wait = wxMin(left, (long)CONNMONITOR_SLICE);
+		tv.tv_sec = wait / 1000;
+		tv.tv_usec = (wait % 1000) * 1000;
+
+		if (select(maxFd + 1, &readFds, &writeFds, NULL, &tv) < 0)
+		{
+#ifndef __WXMSW__
+			if (errno == EINTR)
+				continue;
+#endif
+			break;
+		}
+
+		for (i = 0; i < count; i++)
+		{
+			if (!state[i])
+				continue;
+
+			pgConn *conn = (pgConn *)conns.Item(i);
+			int sock = PQsocket(conn->conn);
+
+			if (state[i] == 1)
+			{
+				if (!FD_ISSET(sock, &writeFds))
+					continue;
+
+				int rc = PQflush(conn->conn);
+				if (rc == 0)
+					state[i] = 2;
+				else if (rc < 0)
+				{
+					state[i] = 0;
+					pending--;
+				}
+				continue;
+			}
+
+			if (!FD_ISSET(sock, &readFds))
+				continue;
+
+			if (!PQconsumeInput(conn->conn))
+			{
+				state[i] = 0;
+				pending--;
+				continue;
+			}
+
+			// The status of the last result is what counts
+			while (state[i] && !PQisBusy(conn->conn))
+			{
+				PGresult *res = PQgetResult(conn->conn);
+				if (!res)
+				{
+					state[i] = 0;
+					pending--;
+					break;
+				}
+				alive[i] = (PQresultStatus(res) == PGRES_TUPLES_OK);
+				PQclear(res);
+			}
+		}
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		pgConn *conn = (pgConn *)conns.Item(i);
+
+		if (state[i])
+			alive[i] = false;
+
+		if (!alive[i] && conn->conn)
+		{
+			PQfinish(conn->conn);
+			conn->conn = 0;
+			conn->connStatus = PGCONN_BROKEN;
+		}
+		else if (conn->conn)
+			PQsetnonblocking(conn->conn, 0);
+	}
+
+	delete[] state;
+	delete[] alive;
+
+	return NULL;
+}
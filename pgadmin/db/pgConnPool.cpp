@@ -0,0 +1,186 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgConnPool.cpp - Idle connections of a server, lent out again
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// App headers
+#include "db/pgConnPool.h"
+#include "db/pgConnMonitor.h"
+
+#include <wx/arrimpl.cpp>
+WX_DEFINE_OBJARRAY(pgConnPoolEntries);
+
+
+pgConnPool::pgConnPool(pgConn *_templ, const wxString &_applicationname)
+{
+	templ = _templ;
+	applicationname = _applicationname;
+}
+
+
+pgConnPool::~pgConnPool()
+{
+	wxMutexLocker lock(mutex);
+
+	while (idle.GetCount() > 0)
+		CloseEntry(idle.GetCount() - 1);
+
+	// Their sessions have just been closed
+	for (size_t i = 0; i < parked.GetCount(); i++)
+		((pgConn *)parked.Item(i))->Unpark();
+}
+
+
+void pgConnPool::CloseEntry(size_t i)
+{
+	delete idle.Item(i).conn;
+	idle.RemoveAt(i);
+}
+
+
+pgConn *pgConnPool::Borrow(const wxString &database, OID oid)
+{
+	wxString dbname = database.IsEmpty() ? templ->GetDbname() : database;
+	time_t now = wxDateTime::GetTimeNow();
+
+	for (;;)
+	{
+		pgConn *conn = NULL;
+		bool check = false;
+
+		{
+			wxMutexLocker lock(mutex);
+
+			// The connection given back last is the one most likely alive,
+			// and has the most of the catalog cached on the server
+			size_t i = idle.GetCount();
+			while (i-- > 0)
+			{
+				if (idle.Item(i).database == dbname)
+				{
+					conn = idle.Item(i).conn;
+					check = now - idle.Item(i).since >= CONNPOOL_CHECK_AGE;
+					idle.RemoveAt(i);
+					break;
+				}
+			}
+		}
+
+		if (!conn)
+			break;
+		if (!check)
+			return conn;
+
+		// Checked without holding up the others using the pool, and for
+		// CONNMONITOR_TIMEOUT at most
+		pgConnCheck alive;
+		alive.Add(conn);
+		alive.CheckAll();
+		if (conn->GetStatus() == PGCONN_OK)
+			return conn;
+
+		// The server may have been restarted since; it's connected again
+		// below, when no other connection is left
+		wxLogInfo(wxT("Dropping a broken connection to %s from the pool"), dbname.c_str());
+		delete conn;
+	}
+
+	// Connect only now, without holding up the others using the pool.
+	// The version and the features are copied from the template, rather
+	// than read from the server again.
+	pgConn *conn = templ->Duplicate(applicationname, dbname, oid);
+	if (conn && conn->GetStatus() != PGCONN_OK)
+	{
+		wxLogError(wxT("%s"), conn->GetLastError().c_str());
+		delete conn;
+		return NULL;
+	}
+	return conn;
+}
+
+
+void pgConnPool::Return(pgConn *conn)
+{
+	if (!conn)
+		return;
+
+	// Its session is in the pool already
+	if (conn->IsParked())
+	{
+		delete conn;
+		return;
+	}
+
+	// A transaction left open is rolled back, and the session is reset;
+	// sessions, which can't be cleaned up that way (before 8.3), aren't
+	// lent to anybody else
+	if (conn->GetStatus() == PGCONN_OK && conn->GetTxStatus() != PGCONN_TXSTATUS_IDLE)
+		conn->ExecuteVoid(wxT("ROLLBACK"), false);
+
+	if (conn->GetStatus() != PGCONN_OK || conn->GetTxStatus() != PGCONN_TXSTATUS_IDLE ||
+	        !conn->ResetSession())
+	{
+		delete conn;
+		return;
+	}
+
+	wxMutexLocker lock(mutex);
+
+	pgConnPoolEntry *entry = new pgConnPoolEntry;
+	entry->conn = conn;
+	entry->database = conn->GetDbname();
+	entry->since = wxDateTime::GetTimeNow();
+	idle.Add(entry);
+
+	if (idle.GetCount() > CONNPOOL_MAX_IDLE)
+		CloseEntry(0);
+}
+
+
+void pgConnPool::Close(const wxString &database)
+{
+	wxMutexLocker lock(mutex);
+
+	size_t i = idle.GetCount();
+	while (i-- > 0)
+	{
+		if (idle.Item(i).database == database)
+			CloseEntry(i);
+	}
+}
+
+
+void pgConnPool::Prune()
+{
+	wxMutexLocker lock(mutex);
+	time_t now = wxDateTime::GetTimeNow();
+
+	// The entries are in the order they were given back
+	while (idle.GetCount() > 0 && now - idle.Item(0).since >= CONNPOOL_MAX_IDLE_TIME)
+		CloseEntry(0);
+}
+
+
+void pgConnPool::AddParked(pgConn *conn)
+{
+	wxMutexLocker lock(mutex);
+	parked.Add(conn);
+}
+
+
+void pgConnPool::RemoveParked(pgConn *conn)
+{
+	wxMutexLocker lock(mutex);
+	parked.Remove(conn);
+}
@@ -17,8 +17,17 @@
 // PostgreSQL headers
 #include <libpq-fe.h>
 
+// Network headers
+#ifndef __WXMSW__
+#include <sys/select.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
 // App headers
 #include "db/pgSet.h"
+#include "db/pgRowStore.h"
 #include "db/pgConn.h"
 #include "db/pgQueryThread.h"
 #include "db/pgQueryResultEvent.h"
@@ -27,6 +36,10 @@
 
 const wxEventType PGQueryResultEvent = wxNewEventType();
 
+// Maximum time (in milliseconds) to block on the backend socket, when we
+// can not be woken up through the self-pipe (i.e. on Windows)
+#define PGQUERYTHREAD_POLL_INTERVAL 10
+
 // default notice processor for the pgQueryThread
 // we do assume that the argument passed will be always the
 // object of pgQueryThread
@@ -48,8 +61,15 @@ pgQueryThread::pgQueryThread(pgConn *_conn, wxEvtHandler *_caller,
 	wxThread(wxTHREAD_JOINABLE), m_currIndex(-1), m_conn(_conn),
 	m_cancelled(false), m_multiQueries(true), m_useCallable(false),
 	m_caller(_caller), m_processor(pgNoticeProcessor), m_noticeHandler(NULL),
-	m_eventOnCancellation(true)
+	m_eventOnCancellation(true), m_rowStore(NULL), m_streaming(false)
 {
+	// The session mustn't be parked, while the thread uses it
+	if (m_conn)
+	{
+		m_conn->Use();
+		m_conn->threadUsers++;
+	}
+
 	// check if we can really use the enterprisedb callable statement and
 	// required
 #ifdef __WXMSW__
@@ -78,6 +98,7 @@ pgQueryThread::pgQueryThread(pgConn *_conn, wxEvtHandler *_caller,
 	{
 		PQsetnonblocking(m_conn->conn, 1);
 	}
+	InitWakeUp();
 
 	if (_processor != NULL)
 	{
@@ -98,12 +119,20 @@ pgQueryThread::pgQueryThread(pgConn *_conn, const wxString &_qry,
 	: wxThread(wxTHREAD_JOINABLE), m_currIndex(-1), m_conn(_conn),
 	  m_cancelled(false), m_multiQueries(false), m_useCallable(false),
 	  m_caller(NULL), m_processor(pgNoticeProcessor), m_noticeHandler(NULL),
-	  m_eventOnCancellation(true)
+	  m_eventOnCancellation(true), m_rowStore(NULL), m_streaming(false)
 {
+	if (m_conn)
+	{
+		m_conn->Use();
+		m_conn->threadUsers++;
+	}
+
 	if (m_conn && m_conn->conn)
 	{
 		PQsetnonblocking(m_conn->conn, 1);
 	}
+	InitWakeUp();
+
 	m_queries.Add(
 	    new pgBatchQuery(_qry, (pgParamsArray *)NULL, _eventId, _data, false,
 	                     _resultToRetrieve));
@@ -131,13 +160,144 @@ void pgQueryThread::AddQuery(const wxString &_qry, pgParamsArray *_params,
 	                     m_useCallable && _useCallable, _resultToRetrieve));
 
 	wxLogInfo(wxT("queueing (%ld): %s"), GetId(), _qry.c_str());
+
+	// Let the thread pick up the new query immediately
+	WakeUp();
+}
+
+
+void pgQueryThread::CancelExecution()
+{
+	m_cancelled = true;
+
+	// The thread might be blocked on the backend socket
+	WakeUp();
+}
+
+
+void pgQueryThread::InitWakeUp()
+{
+	m_wakeupPipe[0] = m_wakeupPipe[1] = -1;
+
+#ifndef __WXMSW__
+	if (pipe(m_wakeupPipe) != 0)
+	{
+		wxLogInfo(wxT("Could not create the wake-up pipe for the query thread, falling back to polling"));
+		m_wakeupPipe[0] = m_wakeupPipe[1] = -1;
+		return;
+	}
+
+	fcntl(m_wakeupPipe[0], F_SETFL, fcntl(m_wakeupPipe[0], F_GETFL) | O_NONBLOCK);
+	fcntl(m_wakeupPipe[1], F_SETFL, fcntl(m_wakeupPipe[1], F_GETFL) | O_NONBLOCK);
+#endif
+}
+
+
+void pgQueryThread::WakeUp()
+{
+#ifndef __WXMSW__
+	if (m_wakeupPipe[1] >= 0)
+	{
+		char c = 0;
+
+		// Nothing to worry about, if the pipe is already full - the thread
+		// will be woken up anyway.
+		if (write(m_wakeupPipe[1], &c, 1) < 0 && errno != EAGAIN)
+			wxLogInfo(wxT("Could not wake up the query thread (errno %d)"), errno);
+	}
+#endif
+}
+
+
+// Wait for something to do, instead of polling the connection.
+//
+// The thread is woken up, when the backend socket has data to be consumed
+// (or, can accept the rest of the query, which libpq could not send in the
+// non-blocking mode), when the execution has been cancelled, or when a new
+// query has been queued.
+void pgQueryThread::WaitForEvents(bool _waitForBackend, long _timeout)
+{
+	fd_set         readFds, writeFds;
+	struct timeval tv, *ptv = NULL;
+	int            sock = -1, maxFd = -1;
+
+	FD_ZERO(&readFds);
+	FD_ZERO(&writeFds);
+
+	if (_waitForBackend && m_conn && m_conn->conn)
+		sock = PQsocket(m_conn->conn);
+
+	if (sock >= 0)
+	{
+		FD_SET(sock, &readFds);
+		if (PQflush(m_conn->conn) == 1)
+			FD_SET(sock, &writeFds);
+		maxFd = sock;
+	}
+
+#ifndef __WXMSW__
+	if (m_wakeupPipe[0] >= 0)
+	{
+		FD_SET(m_wakeupPipe[0], &readFds);
+		if (m_wakeupPipe[0] > maxFd)
+			maxFd = m_wakeupPipe[0];
+	}
+	else
+#endif
+	{
+		// We can't be woken up - check for the cancellation every now and then
+		if (_timeout < 0 || _timeout > PGQUERYTHREAD_POLL_INTERVAL)
+			_timeout = PGQUERYTHREAD_POLL_INTERVAL;
+	}
+
+	if (maxFd < 0)
+	{
+		// Nothing to wait on (i.e. connection lost), let the caller handle it
+		wxThread::Sleep(_timeout < 0 ? PGQUERYTHREAD_POLL_INTERVAL : _timeout);
+		return;
+	}
+
+	if (_timeout >= 0)
+	{
+		tv.tv_sec = _timeout / 1000;
+		tv.tv_usec = (_timeout % 1000) * 1000;
+		ptv = &tv;
+	}
+
+	if (select(maxFd + 1, &readFds, &writeFds, NULL, ptv) < 0)
+	{
+#ifndef __WXMSW__
+		if (errno == EINTR)
+			return;
+#endif
+		wxLogInfo(wxT("select() failed in the query thread (error %d)"), wxSysErrorCode());
+		return;
+	}
+
+#ifndef __WXMSW__
+	// Drain the wake-up pipe
+	if (m_wakeupPipe[0] >= 0 && FD_ISSET(m_wakeupPipe[0], &readFds))
+	{
+		char buf[64];
+		while (read(m_wakeupPipe[0], buf, sizeof(buf)) > 0)
+			;
+	}
+#endif
 }
 
 
 pgQueryThread::~pgQueryThread()
 {
+	m_conn->threadUsers--;
 	m_conn->RegisterNoticeProcessor(0, 0);
 	WX_CLEAR_ARRAY(m_queries);
+
+#ifndef __WXMSW__
+	if (m_wakeupPipe[0] >= 0)
+		close(m_wakeupPipe[0]);
+	if (m_wakeupPipe[1] >= 0)
+		close(m_wakeupPipe[1]);
+#endif
 }
 
 
@@ -339,6 +499,16 @@ continue_without_error:
 	int resultsRetrieved = 0;
 	PGresult *lastResult = 0;
 	bool connExecutionCancelled = false;
+	// Result (1-based), whose rows are currently in the row store
+	int streamedResult = 0;
+
+	m_streaming = false;
+#ifdef HAVE_SINGLE_ROW_MODE
+	// Ask for the rows one by one, they will be appended to the row store as
+	// soon as they arrive
+	if (m_rowStore && !useCallable && pgConn::GetLibpqVersion() >= 9.2)
+		m_streaming = (PQsetSingleRowMode(m_conn->conn) == 1);
+#endif
 
 	while (true)
 	{
@@ -416,8 +586,7 @@ continue_without_error:
 
 		if (PQisBusy(m_conn->conn))
 		{
-			Yield();
-			this->Sleep(10);
+			WaitForEvents(true);
 
 			continue;
 		}
@@ -473,16 +642,33 @@ continue_without_error:
 				res = NULL;
 
 				if (PQisBusy(m_conn->conn))
-				{
-					Yield();
-					this->Sleep(10);
-				}
+					WaitForEvents(true);
 			}
 			while (true);
 
 			break;
 		}
 
+#ifdef HAVE_SINGLE_ROW_MODE
+		if (PQresultStatus(res) == PGRES_SINGLE_TUPLE)
+		{
+			// Keep only the rows of the result, the component asked for.
+			// A zero-row PGRES_TUPLES_OK result follows the last row.
+			if (!m_cancelled && (resultToRetrieve <= 0 || resultsRetrieved + 1 == resultToRetrieve))
+			{
+				if (streamedResult != resultsRetrieved + 1)
+				{
+					m_rowStore->Reset();
+					streamedResult = resultsRetrieved + 1;
+				}
+				m_rowStore->AppendRow(res);
+			}
+			PQclear(res);
+
+			continue;
+		}
+#endif
+
 #if defined (__WXMSW__) || (EDB_LIBPQ)
 		// there should be 2 results in the callable statement - the first is the
 		// dummy, the second contains our out params.
@@ -503,7 +689,6 @@ continue_without_error:
 			int copyRc;
 			char *buf;
 			int copyRows = 0;
-			int lastCopyRc = 0;
 
 			rc = PGRES_COPY_OUT;
 
@@ -520,7 +705,15 @@ continue_without_error:
 						m_conn->CancelExecution();
 						connExecutionCancelled = true;
 					}
-					continue;
+					if (buf != NULL)
+					{
+						PQfreemem(buf);
+						buf = NULL;
+					}
+					// We still need to consume the input, when no copy data
+					// is available yet
+					if (copyRc > 0)
+						continue;
 				}
 
 				if (buf != NULL)
@@ -540,13 +733,10 @@ continue_without_error:
 				if (copyRc > 0)
 					copyRows++;
 
-				if (lastCopyRc == 0 && copyRc == 0)
-				{
-					Yield();
-					this->Sleep(10);
-				}
 				if (copyRc == 0)
 				{
+					WaitForEvents(true);
+
 					if (!PQconsumeInput(m_conn->conn))
 					{
 						// It might be the case - it is a result of the
@@ -581,7 +771,6 @@ continue_without_error:
 						return(RaiseEvent(rc));
 					}
 				}
-				lastCopyRc = copyRc;
 			}
 
 			res = PQgetResult(m_conn->conn);
@@ -596,13 +785,26 @@ continue_without_error:
 		// But - only if the execution is not cancelled
 		if (!m_cancelled && resultsRetrieved == resultToRetrieve)
 		{
+			int nTuples = PQntuples(res);
+
+			if (m_streaming && streamedResult == resultsRetrieved)
+			{
+				nTuples = (int)m_rowStore->NumRows();
+
+				// Spill file errors are reported along with the result,
+				// by the thread that displays it
+				wxString storeError = m_rowStore->GetErrorAndClear();
+				if (!storeError.IsEmpty())
+					AppendMessage(storeError + wxT("\n"));
+			}
+
 			result = res;
 			insertedOid = PQoidValue(res);
 			if (insertedOid && insertedOid != (Oid) - 1)
 				AppendMessage(wxString::Format(_("query inserted one row with oid %d.\n"), insertedOid));
 			else
 				AppendMessage(wxString::Format(wxPLURAL("query result with %d row will be returned.\n", "query result with %d rows will be returned.\n",
-				                                        PQntuples(result)), PQntuples(result)));
+				                                        nTuples), nTuples));
 			continue;
 		}
 
@@ -730,7 +932,8 @@ void *pgQueryThread::Entry()
 		if (!m_multiQueries || m_cancelled)
 			break;
 
-		wxThread::Sleep(10);
+		// Wait for the next query to be queued (or, the cancellation)
+		WaitForEvents(false, m_currIndex < (((int)m_queries.GetCount()) - 1) ? 0 : -1);
 	}
 	while (true);
 
@@ -0,0 +1,837 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgResultView.cpp - Sorted and filtered view of the rows of a query result
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+
+#include <math.h>
+#include <ctype.h>
+#include <locale.h>
+
+// App headers
+#include "db/pgResultView.h"
+
+// The work done in slices by the workers
+#define RESULTVIEW_TASK_PARSE  1
+#define RESULTVIEW_TASK_SORT   2
+#define RESULTVIEW_TASK_FILTER 3
+
+// Runs below this length are sorted by insertion
+#define RESULTVIEW_INSERTION_SORT 16
+
+// Decimals up to this many significant digits are told apart by their
+// double. Longer ones, i.e. big bigints and numerics, may share one.
+#define RESULTVIEW_DOUBLE_DIGITS 15
+
+
+void *pgResultViewWorker::Entry()
+{
+	view->RunSlice(task, first, last);
+	return NULL;
+}
+
+
+pgResultViewColumn::pgResultViewColumn()
+{
+	typClass = PGTYPCLASS_OTHER;
+	values = NULL;
+	numbers = NULL;
+	isNumber = NULL;
+}
+
+
+pgResultViewColumn::~pgResultViewColumn()
+{
+	if (values)
+		delete[] values;
+	if (numbers)
+		delete[] numbers;
+	if (isNumber)
+		delete[] isNumber;
+}
+
+
+void pgResultViewColumn::Load(pgSet *set, pgRowStore *store, int col, pgTypClass _typClass)
+{
+	long row, nRows = set ? set->NumRows() : store->NumRows();
+
+	typClass = _typClass;
+	values = new const char *[nRows + 1];
+	numbers = new double[nRows + 1];
+	isNumber = new char[nRows + 1];
+
+	if (set)
+	{
+		// The values of a result set stay where they are
+		for (row = 0; row < nRows; row++)
+			values[row] = set->IsNull(row, col) ? NULL : set->GetCharPtr(row, col);
+	}
+	else
+	{
+		long *offsets = new long[nRows + 1];
+
+		store->CopyColumn(col, data, offsets);
+
+		const char *base = (const char *)data.GetData();
+		for (row = 0; row < nRows; row++)
+			values[row] = offsets[row] < 0 ? NULL : base + offsets[row];
+
+		delete[] offsets;
+	}
+}
+
+
+// Runs in the workers, for their slice of the rows
+void pgResultViewColumn::ParseValues(long first, long last)
+{
+	for (long row = first; row < last; row++)
+	{
+		bool parsed = false, isLong = false;
+
+		if (values[row])
+		{
+			if (typClass == PGTYPCLASS_NUMERIC)
+				parsed = ParseNumber(values[row], numbers[row], isLong);
+			else if (typClass == PGTYPCLASS_DATE)
+				parsed = ParseTimestamp(values[row], numbers[row]);
+		}
+		isNumber[row] = parsed ? (isLong ? 2 : 1) : 0;
+	}
+}
+
+
+int pgResultViewColumn::Compare(long a, long b) const
+{
+	const char *va = values[a], *vb = values[b];
+
+	// NULLs sort last, as in PostgreSQL
+	if (!va)
+		return vb ? 1 : 0;
+	if (!vb)
+		return -1;
+
+	if (isNumber[a] && isNumber[b])
+	{
+		if (numbers[a] != numbers[b])
+			return numbers[a] < numbers[b] ? -1 : 1;
+		if (isNumber[a] == 2 || isNumber[b] == 2)
+			return CompareDecimal(va, vb);
+		return 0;
+	}
+
+	// Whatever could be parsed sorts before what couldn't
+	if (!isNumber[a] != !isNumber[b])
+		return isNumber[a] ? -1 : 1;
+
+	return strcmp(va, vb);
+}
+
+
+int pgResultViewColumn::CompareTo(long row, const char *value, double number, bool valueIsNumber, bool valueIsLong) const
+{
+	if (isNumber[row] && valueIsNumber)
+	{
+		if (numbers[row] != number)
+			return numbers[row] < number ? -1 : 1;
+		if (isNumber[row] == 2 || valueIsLong)
+			return CompareDecimal(values[row], value);
+		return 0;
+	}
+
+	if (!isNumber[row] != !valueIsNumber)
+		return isNumber[row] ? -1 : 1;
+
+	return strcmp(values[row], value);
+}
+
+
+// Skip the sign and the leading zeros of a plain decimal (digits with an
+// optional decimal point), and return the number of the digits before
+// the point then, or -1 if the value isn't a plain decimal
+static int ReadDecimal(const char *&p, bool &negative)
+{
+	negative = false;
+	if (*p == '-' || *p == '+')
+		negative = (*p++ == '-');
+
+	while (*p == '0')
+		p++;
+
+	const char *q = p;
+	while (isdigit((unsigned char)*q))
+		q++;
+	int intDigits = q - p;
+
+	if (*q == '.')
+		q++;
+	while (isdigit((unsigned char)*q))
+		q++;
+
+	return *q ? -1 : intDigits;
+}
+
+
+// Compare two plain decimals exactly, by their digits: the double of a
+// decimal with many digits may be shared by its neighbours
+int pgResultViewColumn::CompareDecimal(const char *a, const char *b)
+{
+	bool negA, negB;
+	int intA = ReadDecimal(a, negA), intB = ReadDecimal(b, negB);
+
+	if (intA < 0 || intB < 0)
+		return 0;
+
+	// The magnitudes: first the number of integer digits, then the digits
+	// themselves, the missing fractional ones counting as zeros
+	int cmp = 0;
+	if (intA != intB)
+		cmp = intA < intB ? -1 : 1;
+	else
+	{
+		while (!cmp && (*a || *b))
+		{
+			if (*a == '.')
+				a++;
+			if (*b == '.')
+				b++;
+
+			char da = *a ? *a++ : '0', db = *b ? *b++ : '0';
+			if (da != db)
+				cmp = da < db ? -1 : 1;
+		}
+	}
+
+	// Zero has no sign
+	if (!cmp)
+		return 0;
+	if (negA != negB)
+		return negA ? -1 : 1;
+	return negA ? -cmp : cmp;
+}
+
+
+// Powers of ten held exactly by a double
+static const double exactPowers[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+// strtod(), with the decimal point of PostgreSQL rather than the locale's
+static double StrToDouble(const char *value)
+{
+	const char *point = localeconv()->decimal_point;
+
+	if (!strcmp(point, ".") || !strchr(value, '.'))
+		return strtod(value, NULL);
+
+	wxString str = wxString::FromAscii(value);
+	str.Replace(wxT("."), wxString::FromAscii(point));
+	return strtod(str.ToAscii(), NULL);
+}
+
+
+// Numbers as PostgreSQL prints them, rounded correctly. A decimal with up
+// to RESULTVIEW_DOUBLE_DIGITS significant digits and a small exponent is
+// computed with a single (correctly rounded) operation, the others are
+// left to strtod(). isLong tells, whether it's a plain decimal with more
+// significant digits than that, which then has to be compared by its
+// digits, too.
+bool pgResultViewColumn::ParseNumber(const char *value, double &number, bool &isLong)
+{
+	const char *p = value;
+	bool negative = false;
+
+	if (*p == '-' || *p == '+')
+		negative = (*p++ == '-');
+
+	if (!strcmp(p, "Infinity"))
+	{
+		number = negative ? -HUGE_VAL : HUGE_VAL;
+		return true;
+	}
+	// PostgreSQL sorts NaN above all the other values
+	if (!strcmp(p, "NaN"))
+	{
+		number = HUGE_VAL;
+		return true;
+	}
+
+	double mantissa = 0;
+	int digits = 0, significant = 0, scale = 0;
+	bool hasExponent = false;
+
+	while (isdigit((unsigned char)*p))
+	{
+		if (significant || *p != '0')
+			significant++;
+		mantissa = mantissa * 10 + (*p++ - '0');
+		digits++;
+	}
+	if (*p == '.')
+	{
+		p++;
+		while (isdigit((unsigned char)*p))
+		{
+			if (significant || *p != '0')
+				significant++;
+			mantissa = mantissa * 10 + (*p++ - '0');
+			digits++;
+			scale--;
+		}
+	}
+	if (!digits)
+		return false;
+
+	if (*p == 'e' || *p == 'E')
+	{
+		hasExponent = true;
+
+		bool negativeExp = false;
+		int exponent = 0;
+
+		p++;
+		if (*p == '-' || *p == '+')
+			negativeExp = (*p++ == '-');
+		if (!isdigit((unsigned char)*p))
+			return false;
+		while (isdigit((unsigned char)*p))
+			exponent = exponent * 10 + (*p++ - '0');
+
+		scale += negativeExp ? -exponent : exponent;
+	}
+	if (*p)
+		return false;
+
+	isLong = !hasExponent && significant > RESULTVIEW_DOUBLE_DIGITS;
+
+	// The mantissa is exact then, and so is the power of ten
+	if (significant <= RESULTVIEW_DOUBLE_DIGITS && scale >= -22 && scale <= 22)
+	{
+		if (scale < 0)
+			number = mantissa / exactPowers[-scale];
+		else
+			number = mantissa * exactPowers[scale];
+		if (negative)
+			number = -number;
+	}
+	else
+		number = StrToDouble(value);
+
+	return true;
+}
+
+
+static bool ReadNumber(const char *&p, int minDigits, long &value)
+{
+	int digits = 0;
+
+	value = 0;
+	while (isdigit((unsigned char)*p))
+	{
+		value = value * 10 + (*p++ - '0');
+		digits++;
+	}
+	return digits >= minDigits;
+}
+
+
+// Days since 1970-01-01 of a (proleptic Gregorian) date
+static long DaysFromCivil(long year, long month, long day)
+{
+	year -= month <= 2;
+	long era = (year >= 0 ? year : year - 399) / 400;
+	long yoe = year - era * 400;
+	long doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+	return era * 146097 + doe - 719468;
+}
+
+
+// Dates, times and timestamps in the ISO DateStyle (which our connections
+// use) as seconds, so that different time zones compare correctly.
+bool pgResultViewColumn::ParseTimestamp(const char *value, double &seconds)
+{
+	if (!strcmp(value, "infinity"))
+	{
+		seconds = HUGE_VAL;
+		return true;
+	}
+	if (!strcmp(value, "-infinity"))
+	{
+		seconds = -HUGE_VAL;
+		return true;
+	}
+
+	size_t len = strlen(value);
+	const char *end = value + len;
+	if (len > 3 && !strcmp(end - 3, " BC"))
+		end -= 3;
+
+	const char *p = value, *q = value;
+	long year, month, day, hour, minute, second;
+	bool haveDate = false;
+
+	seconds = 0;
+
+	if (ReadNumber(q, 4, year) && *q == '-')
+	{
+		q++;
+		if (!ReadNumber(q, 2, month) || *q++ != '-' || !ReadNumber(q, 2, day))
+			return false;
+
+		// Year 1 BC is year 0
+		if (end != value + len)
+			year = 1 - year;
+
+		seconds = DaysFromCivil(year, month, day) * 86400.0;
+		haveDate = true;
+
+		p = q;
+		if ((*p == ' ' || *p == 'T') && isdigit((unsigned char)p[1]))
+			p++;
+	}
+
+	q = p;
+	if (ReadNumber(q, 2, hour) && *q == ':')
+	{
+		q++;
+		if (!ReadNumber(q, 2, minute))
+			return false;
+		seconds += hour * 3600.0 + minute * 60.0;
+
+		if (*q == ':')
+		{
+			q++;
+			if (!ReadNumber(q, 2, second))
+				return false;
+			seconds += second;
+
+			if (*q == '.')
+			{
+				double fraction = 0.1;
+
+				q++;
+				while (isdigit((unsigned char)*q))
+				{
+					seconds += (*q++ - '0') * fraction;
+					fraction /= 10;
+				}
+			}
+		}
+
+		// The time zone offset
+		if (*q == '+' || *q == '-')
+		{
+			int sign = (*q++ == '-') ? -1 : 1;
+			long tzHour, tzMinute = 0, tzSecond = 0;
+
+			if (!ReadNumber(q, 2, tzHour))
+				return false;
+			if (*q == ':')
+			{
+				q++;
+				if (!ReadNumber(q, 2, tzMinute))
+					return false;
+				if (*q == ':')
+				{
+					q++;
+					if (!ReadNumber(q, 2, tzSecond))
+						return false;
+				}
+			}
+			seconds -= sign * (tzHour * 3600.0 + tzMinute * 60.0 + tzSecond);
+		}
+		p = q;
+	}
+	else if (!haveDate)
+		return false;
+
+	return p == end;
+}
+
+
+pgResultView::pgResultView()
+{
+	set = NULL;
+	store = NULL;
+	rows = NULL;
+	numRows = 0;
+
+	column = NULL;
+	ascending = true;
+	filterOp = RESULTFILTER_EQUAL;
+	filterNumber = 0;
+	filterIsNumber = false;
+	filterIsLong = false;
+	sortTmp = NULL;
+	matches = NULL;
+	sliceSize = 0;
+}
+
+
+pgResultView::~pgResultView()
+{
+	Reset();
+}
+
+
+void pgResultView::SetSource(pgSet *_set, pgRowStore *_store)
+{
+	Reset();
+	set = _set;
+	store = _store;
+}
+
+
+void pgResultView::Reset()
+{
+	if (rows)
+	{
+		delete[] rows;
+		rows = NULL;
+	}
+	numRows = 0;
+}
+
+
+long pgResultView::SourceRows() const
+{
+	if (set)
+		return set->NumRows();
+	if (store)
+		return store->NumRows();
+	return 0;
+}
+
+
+long pgResultView::NumRows() const
+{
+	return rows ? numRows : SourceRows();
+}
+
+
+// Start with all the rows, in their original order
+void pgResultView::StartView()
+{
+	if (rows)
+		return;
+
+	numRows = SourceRows();
+	rows = new long[numRows + 1];
+	for (long row = 0; row < numRows; row++)
+		rows[row] = row;
+}
+
+
+bool pgResultView::Sort(int col, pgTypClass typClass, bool _ascending)
+{
+	if (!set && !store)
+		return false;
+
+	StartView();
+	if (numRows < 2)
+		return true;
+
+	pgResultViewColumn keys;
+	keys.Load(set, store, col, typClass);
+
+	column = &keys;
+	ascending = _ascending;
+	RunParallel(RESULTVIEW_TASK_PARSE, SourceRows());
+
+	// Sort the slices in parallel, then merge them
+	sortTmp = new long[numRows];
+	RunParallel(RESULTVIEW_TASK_SORT, numRows);
+
+	for (long width = sliceSize; width < numRows; width *= 2)
+	{
+		for (long start = 0; start + width < numRows; start += 2 * width)
+			Merge(rows + start, sortTmp + start, width, wxMin(width, numRows - start - width));
+	}
+
+	delete[] sortTmp;
+	sortTmp = NULL;
+	column = NULL;
+
+	return true;
+}
+
+
+bool pgResultView::Filter(int col, pgTypClass typClass, pgResultFilterOp op, const wxString &value)
+{
+	if (!set && !store)
+		return false;
+
+	StartView();
+
+	pgResultViewColumn keys;
+	keys.Load(set, store, col, typClass);
+
+	column = &keys;
+	RunParallel(RESULTVIEW_TASK_PARSE, SourceRows());
+
+	// Compare to the value, as it's found in the result
+	wxString val = value;
+	if (typClass == PGTYPCLASS_BOOL)
+		val = StrToBool(value) ? wxT("t") : wxT("f");
+
+	filterOp = op;
+	filterValue = val.mb_str(set ? set->GetConversion() : store->GetConversion());
+	if (!filterValue)
+		filterValue = val.mb_str(wxConvUTF8);
+
+	filterIsNumber = false;
+	filterIsLong = false;
+	if (typClass == PGTYPCLASS_NUMERIC)
+		filterIsNumber = pgResultViewColumn::ParseNumber(filterValue, filterNumber, filterIsLong);
+	else if (typClass == PGTYPCLASS_DATE)
+		filterIsNumber = pgResultViewColumn::ParseTimestamp(filterValue, filterNumber);
+
+	matches = new char[numRows + 1];
+	RunParallel(RESULTVIEW_TASK_FILTER, numRows);
+
+	long kept = 0;
+	for (long i = 0; i < numRows; i++)
+	{
+		if (matches[i])
+			rows[kept++] = rows[i];
+	}
+	numRows = kept;
+
+	delete[] matches;
+	matches = NULL;
+	column = NULL;
+
+	return true;
+}
+
+
+bool pgResultView::ParseFilter(const wxString &expr, pgResultFilterOp &op, wxString &value)
+{
+	wxString str = expr.Strip(wxString::both);
+
+	if (str.IsEmpty())
+		return false;
+
+	if (str.CmpNoCase(wxT("IS NULL")) == 0)
+	{
+		op = RESULTFILTER_ISNULL;
+		value = wxEmptyString;
+		return true;
+	}
+	if (str.CmpNoCase(wxT("IS NOT NULL")) == 0)
+	{
+		op = RESULTFILTER_NOTNULL;
+		value = wxEmptyString;
+		return true;
+	}
+
+	// The longer operators first
+	static const struct
+	{
+		const wxChar *text;
+		pgResultFilterOp op;
+	} ops[] =
+	{
+		{ wxT("<>"), RESULTFILTER_NOTEQUAL },
+		{ wxT("!="), RESULTFILTER_NOTEQUAL },
+		{ wxT("<="), RESULTFILTER_LESSEQUAL },
+		{ wxT(">="), RESULTFILTER_GREATEREQUAL },
+		{ wxT("="), RESULTFILTER_EQUAL },
+		{ wxT("<"), RESULTFILTER_LESS },
+		{ wxT(">"), RESULTFILTER_GREATER },
+		{ wxT("~"), RESULTFILTER_CONTAINS }
+	};
+
+	for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+	{
+		if (str.StartsWith(ops[i].text, &value))
+		{
+			op = ops[i].op;
+			value = value.Strip(wxString::leading);
+			return true;
+		}
+	}
+
+	// Just a value
+	op = RESULTFILTER_EQUAL;
+	value = str;
+	return true;
+}
+
+
+// Case insensitive (for ASCII) search of a value
+static bool ContainsText(const char *text, const char *value)
+{
+	size_t len = strlen(value);
+
+	for (; *text; text++)
+	{
+		size_t i = 0;
+		while (i < len && text[i] && tolower((unsigned char)text[i]) == tolower((unsigned char)value[i]))
+			i++;
+		if (i == len)
+			return true;
+	}
+	return len == 0;
+}
+
+
+bool pgResultView::Matches(long row) const
+{
+	const char *value = column->values[row];
+
+	if (filterOp == RESULTFILTER_ISNULL)
+		return value == NULL;
+	if (filterOp == RESULTFILTER_NOTNULL)
+		return value != NULL;
+
+	// As in SQL, NULL doesn't match any comparison
+	if (!value)
+		return false;
+
+	if (filterOp == RESULTFILTER_CONTAINS)
+		return ContainsText(value, filterValue);
+
+	int cmp = column->CompareTo(row, filterValue, filterNumber, filterIsNumber, filterIsLong);
+	switch (filterOp)
+	{
+		case RESULTFILTER_EQUAL:
+			return cmp == 0;
+		case RESULTFILTER_NOTEQUAL:
+			return cmp != 0;
+		case RESULTFILTER_LESS:
+			return cmp < 0;
+		case RESULTFILTER_LESSEQUAL:
+			return cmp <= 0;
+		case RESULTFILTER_GREATER:
+			return cmp > 0;
+		case RESULTFILTER_GREATEREQUAL:
+			return cmp >= 0;
+		default:
+			return false;
+	}
+}
+
+
+// Split the work in slices, and have the workers do all but the first one
+void pgResultView::RunParallel(int task, long count)
+{
+	int numSlices = 1;
+	if (count >= RESULTVIEW_PARALLEL_ROWS)
+		numSlices = wxMin(wxMax(wxThread::GetCPUCount(), 1), RESULTVIEW_MAX_WORKERS);
+
+	sliceSize = wxMax((count + numSlices - 1) / numSlices, 1);
+
+	pgResultViewWorker *workers[RESULTVIEW_MAX_WORKERS];
+	int started = 0;
+
+	for (int slice = 1; slice < numSlices; slice++)
+	{
+		long first = slice * sliceSize, last = wxMin(first + sliceSize, count);
+		if (first >= last)
+			break;
+
+		pgResultViewWorker *worker = new pgResultViewWorker(this, task, first, last);
+		if (worker->Create() != wxTHREAD_NO_ERROR || worker->Run() != wxTHREAD_NO_ERROR)
+		{
+			delete worker;
+			RunSlice(task, first, last);
+		}
+		else
+			workers[started++] = worker;
+	}
+
+	RunSlice(task, 0, wxMin(sliceSize, count));
+
+	for (int i = 0; i < started; i++)
+	{
+		workers[i]->Wait();
+		delete workers[i];
+	}
+}
+
+
+void pgResultView::RunSlice(int task, long first, long last)
+{
+	switch (task)
+	{
+		case RESULTVIEW_TASK_PARSE:
+			column->ParseValues(first, last);
+			break;
+
+		case RESULTVIEW_TASK_SORT:
+			MergeSort(rows + first, sortTmp + first, last - first);
+			break;
+
+		case RESULTVIEW_TASK_FILTER:
+			for (long i = first; i < last; i++)
+				matches[i] = Matches(rows[i]) ? 1 : 0;
+			break;
+	}
+}
+
+
+// A stable sort of the rows, by the values of the column
+void pgResultView::MergeSort(long *data, long *tmp, long count)
+{
+	if (count < RESULTVIEW_INSERTION_SORT)
+	{
+		for (long i = 1; i < count; i++)
+		{
+			long row = data[i], j = i;
+			while (j > 0)
+			{
+				int cmp = column->Compare(data[j - 1], row);
+				if (ascending ? cmp <= 0 : cmp >= 0)
+					break;
+				data[j] = data[j - 1];
+				j--;
+			}
+			data[j] = row;
+		}
+		return;
+	}
+
+	long half = count / 2;
+	MergeSort(data, tmp, half);
+	MergeSort(data + half, tmp + half, count - half);
+	Merge(data, tmp, half, count - half);
+}
+
+
+// Merge two sorted runs, which follow each other in data
+void pgResultView::Merge(long *data, long *tmp, long count1, long count2)
+{
+	long i = 0, j = count1, k = 0, count = count1 + count2;
+
+	memcpy(tmp, data, count * sizeof(long));
+
+	while (i < count1 && j < count)
+	{
+		int cmp = column->Compare(tmp[j], tmp[i]);
+
+		// Take the left one on ties, to keep the sort stable
+		if (ascending ? cmp < 0 : cmp > 0)
+			data[k++] = tmp[j++];
+		else
+			data[k++] = tmp[i++];
+	}
+	while (i < count1)
+		data[k++] = tmp[i++];
+	while (j < count)
+		data[k++] = tmp[j++];
+}
@@ -0,0 +1,425 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgRowStore.cpp - Append-only row store for streamed query results
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/file.h>
+#include <wx/filename.h>
+
+// PostgreSQL headers
+#include <libpq-fe.h>
+
+// App headers
+#include "db/pgRowStore.h"
+#include "utils/sysLogger.h"
+
+
+pgRowStorePage::pgRowStorePage(long _firstRow, int _nCols)
+	: firstRow(_firstRow), numRows(0), nCols(_nCols), spillOffset(-1),
+	  dataSize(0), memSize(0), lastUsed(0)
+{
+	cols = new pgRowStoreColumn[nCols];
+}
+
+
+pgRowStorePage::~pgRowStorePage()
+{
+	Unload();
+}
+
+
+void pgRowStorePage::Unload()
+{
+	if (cols)
+	{
+		delete[] cols;
+		cols = NULL;
+	}
+	memSize = 0;
+}
+
+
+pgRowStore::pgRowStore(wxMBConv &_conv, size_t _memoryCap)
+	: conv(_conv), memoryCap(_memoryCap), memUsed(0), generation(0),
+	  useCounter(0), nRows(0), nCols(0), spillFailed(false)
+{
+}
+
+
+pgRowStore::~pgRowStore()
+{
+	ClearPages();
+	RemoveSpillFile();
+}
+
+
+void pgRowStore::RemoveSpillFile()
+{
+	if (spillFile.IsOpened())
+		spillFile.Close();
+	if (!spillFileName.IsEmpty() && wxFileExists(spillFileName))
+		wxRemoveFile(spillFileName);
+	spillFileName = wxEmptyString;
+}
+
+
+void pgRowStore::ClearPages()
+{
+	WX_CLEAR_ARRAY(pages);
+	memUsed = 0;
+}
+
+
+void pgRowStore::Reset()
+{
+	wxCriticalSectionLocker lock(m_criticalSection);
+
+	ClearPages();
+
+	nRows = 0;
+	nCols = 0;
+	colNames.Empty();
+	colTypes.Empty();
+	colTypeMods.Empty();
+	colTables.Empty();
+
+	RemoveSpillFile();
+	spillFailed = false;
+	errorMsg = wxEmptyString;
+
+	generation++;
+}
+
+
+void pgRowStore::AppendRow(PGresult *res)
+{
+	wxCriticalSectionLocker lock(m_criticalSection);
+
+	if (!res || PQntuples(res) < 1)
+		return;
+
+	if (nCols == 0)
+	{
+		// First row of the result set - save the column information
+		nCols = PQnfields(res);
+		for (int col = 0; col < nCols; col++)
+		{
+			colNames.Add(wxString(PQfname(res, col), conv));
+			colTypes.Add((long)PQftype(res, col));
+			colTypeMods.Add((long)PQfmod(res, col));
+			colTables.Add((long)PQftable(res, col));
+		}
+	}
+
+	if (nCols == 0 || PQnfields(res) != nCols)
+		return;
+
+	pgRowStorePage *page = pages.IsEmpty() ? NULL : pages.Last();
+
+	if (!page || page->numRows >= PGROWSTORE_PAGE_ROWS || page->dataSize >= PGROWSTORE_PAGE_BYTES)
+	{
+		page = new pgRowStorePage(nRows, nCols);
+		pages.Add(page);
+
+		// The offsets of a page are allocated at once, the values grow
+		// with the column. The memory used is what is allocated, not only
+		// what is filled, or the cap would never be reached.
+		for (int col = 0; col < nCols; col++)
+		{
+			page->cols[col].offsets.Alloc(PGROWSTORE_PAGE_ROWS);
+			page->memSize += page->cols[col].data.GetBufSize() + PGROWSTORE_PAGE_ROWS * sizeof(int);
+		}
+		memUsed += page->memSize;
+	}
+
+	size_t added = 0;
+
+	for (int col = 0; col < nCols; col++)
+	{
+		pgRowStoreColumn &column = page->cols[col];
+
+		if (PQgetisnull(res, 0, col))
+			column.offsets.Add(-1);
+		else
+		{
+			// Include the terminating NUL, so the value can be used in place
+			size_t len = PQgetlength(res, 0, col) + 1;
+			size_t needed = column.data.GetDataLen() + len;
+
+			// Grow by doubling, not by the small steps of AppendData()
+			if (needed > column.data.GetBufSize())
+			{
+				size_t bufSize = column.data.GetBufSize();
+				column.data.SetBufSize(wxMax(needed, bufSize * 2));
+				added += column.data.GetBufSize() - bufSize;
+			}
+
+			column.offsets.Add((int)column.data.GetDataLen());
+			column.data.AppendData(PQgetvalue(res, 0, col), len);
+			page->dataSize += len;
+		}
+	}
+
+	page->numRows++;
+	page->memSize += added;
+	page->lastUsed = ++useCounter;
+	memUsed += added;
+	nRows++;
+
+	if (memoryCap > 0 && memUsed > memoryCap)
+		EnforceMemoryCap(page);
+}
+
+
+wxString pgRowStore::GetErrorAndClear()
+{
+	wxCriticalSectionLocker lock(m_criticalSection);
+
+	wxString msg = errorMsg;
+	errorMsg = wxEmptyString;
+	return msg;
+}
+
+
+long pgRowStore::NumRows()
+{
+	wxCriticalSectionLocker lock(m_criticalSection);
+	return nRows;
+}
+
+
+long pgRowStore::NumCols()
+{
+	wxCriticalSectionLocker lock(m_criticalSection);
+	return nCols;
+}
+
+
+wxString pgRowStore::ColName(const int col)
+{
+	wxCriticalSectionLocker lock(m_criticalSection);
+	wxASSERT(col < nCols && col >= 0);
+
+	return colNames[col];
+}
+
+
+OID pgRowStore::ColTypeOid(const int col)
+{
+	wxCriticalSectionLocker lock(m_criticalSection);
+	wxASSERT(col < nCols && col >= 0);
+
+	return (OID)colTypes[col];
+}
+
+
+long pgRowStore::ColTypeMod(const int col)
+{
+	wxCriticalSectionLocker lock(m_criticalSection);
+	wxASSERT(col < nCols && col >= 0);
+
+	return colTypeMods[col];
+}
+
+
+OID pgRowStore::ColTableOid(const int col)
+{
+	wxCriticalSectionLocker lock(m_criticalSection);
+	wxASSERT(col < nCols && col >= 0);
+
+	return (OID)colTables[col];
+}
+
+
+bool pgRowStore::IsNull(const long row, const int col)
+{
+	wxCriticalSectionLocker lock(m_criticalSection);
+
+	return GetCharPtr(row, col) == NULL;
+}
+
+
+wxString pgRowStore::GetVal(const long row, const int col)
+{
+	wxCriticalSectionLocker lock(m_criticalSection);
+
+	const char *val = GetCharPtr(row, col);
+	if (!val)
+		return wxEmptyString;
+
+	return wxString(val, conv);
+}
+
+
+void pgRowStore::CopyColumn(const int col, wxMemoryBuffer &data, long *offsets)
+{
+	wxCriticalSectionLocker lock(m_criticalSection);
+
+	for (long row = 0; row < nRows; row++)
+	{
+		const char *val = GetCharPtr(row, col);
+		if (!val)
+			offsets[row] = -1;
+		else
+		{
+			offsets[row] = (long)data.GetDataLen();
+			data.AppendData((void *)val, strlen(val) + 1);
+		}
+	}
+}
+
+
+// The caller must hold the lock
+const char *pgRowStore::GetCharPtr(const long row, const int col)
+{
+	if (row < 0 || row >= nRows || col < 0 || col >= nCols)
+		return NULL;
+
+	pgRowStorePage *page = FindPage(row);
+	if (!page || (!page->IsLoaded() && !LoadPage(page)))
+		return NULL;
+
+	page->lastUsed = ++useCounter;
+
+	int offset = page->cols[col].offsets[row - page->firstRow];
+	if (offset < 0)
+		return NULL;
+
+	return (const char *)page->cols[col].data.GetData() + offset;
+}
+
+
+pgRowStorePage *pgRowStore::FindPage(const long row)
+{
+	size_t low = 0, high = pages.GetCount();
+
+	// The pages are sorted by their first row
+	while (low < high)
+	{
+		size_t mid = (low + high) / 2;
+		pgRowStorePage *page = pages[mid];
+
+		if (row < page->firstRow)
+			high = mid;
+		else if (row >= page->firstRow + page->numRows)
+			low = mid + 1;
+		else
+			return page;
+	}
+
+	return NULL;
+}
+
+
+// Spill the least recently used pages, until we're under the memory cap
+// again. The page being accessed and the page being filled stay in memory.
+void pgRowStore::EnforceMemoryCap(pgRowStorePage *keep)
+{
+	while (memUsed > memoryCap && !spillFailed)
+	{
+		pgRowStorePage *victim = NULL;
+
+		for (size_t i = 0; i + 1 < pages.GetCount(); i++)
+		{
+			pgRowStorePage *page = pages[i];
+
+			if (page == keep || !page->IsLoaded())
+				continue;
+			if (!victim || page->lastUsed < victim->lastUsed)
+				victim = page;
+		}
+
+		if (!victim)
+			break;
+
+		if (victim->spillOffset < 0 && !SpillPage(victim))
+			break;
+
+		memUsed -= victim->memSize;
+		victim->Unload();
+	}
+}
+
+
+bool pgRowStore::SpillPage(pgRowStorePage *page)
+{
+	if (!spillFile.IsOpened())
+	{
+		spillFileName = wxFileName::CreateTempFileName(wxT("pgadmin_rows"), &spillFile);
+		if (spillFileName.IsEmpty() || !spillFile.IsOpened())
+		{
+			errorMsg = _("Could not create a temporary file for the query result, keeping all the rows in memory.");
+			spillFailed = true;
+			return false;
+		}
+	}
+
+	wxFileOffset offset = spillFile.SeekEnd();
+
+	for (int col = 0; col < page->nCols; col++)
+	{
+		pgRowStoreColumn &column = page->cols[col];
+		size_t dataLen = column.data.GetDataLen();
+
+		if (spillFile.Write(&column.offsets[0], page->numRows * sizeof(int)) != page->numRows * sizeof(int) ||
+		        spillFile.Write(&dataLen, sizeof(dataLen)) != sizeof(dataLen) ||
+		        (dataLen && spillFile.Write(column.data.GetData(), dataLen) != dataLen))
+		{
+			errorMsg = _("Could not write to the temporary file for the query result, keeping all the rows in memory.");
+			spillFailed = true;
+			return false;
+		}
+	}
+
+	page->spillOffset = offset;
+	return true;
+}
+
+
+bool pgRowStore::LoadPage(pgRowStorePage *page)
+{
+	if (page->spillOffset < 0 || !spillFile.IsOpened() ||
+	        spillFile.Seek(page->spillOffset) == wxInvalidOffset)
+		return false;
+
+	pgRowStoreColumn *cols = new pgRowStoreColumn[page->nCols];
+	size_t memSize = 0;
+
+	for (int col = 0; col < page->nCols; col++)
+	{
+		pgRowStoreColumn &column = cols[col];
+		size_t dataLen = 0;
+
+		column.offsets.Alloc(page->numRows);
+		column.offsets.SetCount(page->numRows);
+		if (spillFile.Read(&column.offsets[0], page->numRows * sizeof(int)) != (ssize_t)(page->numRows * sizeof(int)) ||
+		        spillFile.Read(&dataLen, sizeof(dataLen)) != (ssize_t)sizeof(dataLen) ||
+		        (dataLen && spillFile.Read(column.data.GetWriteBuf(dataLen), dataLen) != (ssize_t)dataLen))
+		{
+			errorMsg = _("Could not read the query result back from the temporary file.");
+			delete[] cols;
+			return false;
+		}
+		column.data.UngetWriteBuf(dataLen);
+		memSize += column.data.GetBufSize() + page->numRows * sizeof(int);
+	}
+
+	page->cols = cols;
+	page->memSize = memSize;
+	memUsed += memSize;
+
+	if (memoryCap > 0 && memUsed > memoryCap)
+		EnforceMemoryCap(page);
+
+	return true;
+}
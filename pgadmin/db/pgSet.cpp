@@ -28,6 +28,8 @@ pgSet::pgSet()
 {
 	conn = 0;
 	res = 0;
+	needColQuoting = false;
+	typesCached = false;
 	nCols = 0;
 	nRows = 0;
 	pos = 0;
@@ -37,6 +39,7 @@ pgSet::pgSet(PGresult *newRes, pgConn *newConn, wxMBConv &cnv, bool needColQt)
 	: conv(cnv)
 {
 	needColQuoting = needColQt;
+	typesCached = false;
 
 	conn = newConn;
 	res = newRes;
@@ -60,6 +63,8 @@ pgSet::pgSet(PGresult *newRes, pgConn *newConn, wxMBConv &cnv, bool needColQt)
 
 		nRows = PQntuples(res);
 		MoveFirst();
+
+		BuildColumnIndex();
 	}
 }
 
@@ -85,6 +90,14 @@ long pgSet::ColTypeMod(const int col) const
 	return PQfmod(res, col);
 }
 
+// The table the column comes from, InvalidOid if it isn't a table column
+OID pgSet::ColTableOid(const int col) const
+{
+	wxASSERT(col < nCols && col >= 0);
+
+	return PQftable(res, col);
+}
+
 
 long pgSet::GetInsertedCount() const
 {
@@ -103,15 +116,38 @@ pgTypClass pgSet::ColTypClass(const int col) const
 	if (colClasses[col] != 0)
 		return (pgTypClass)colClasses[col];
 
-	wxString typoid = ExecuteScalar(
-	                      wxT("SELECT CASE WHEN typbasetype=0 THEN oid else typbasetype END AS basetype\n")
-	                      wxT("  FROM pg_type WHERE oid=") + NumToStr(ColTypeOid(col)));
+	CacheColTypes();
+	colClasses[col] = conn->GetTypeClass(ColTypeOid(col));
+
+	return (pgTypClass)colClasses[col];
+}
+
+
+// Have the connection look up the types of all the columns at once,
+// rather than one by one.
+void pgSet::CacheColTypes() const
+{
+	wxArrayLong typoids, typmods;
+
+	if (typesCached)
+		return;
+	typesCached = true;
 
-	switch (StrToLong(typoid))
+	for (int col = 0; col < nCols; col++)
+	{
+		typoids.Add((long)ColTypeOid(col));
+		typmods.Add(ColTypeMod(col));
+	}
+	conn->CacheTypes(typoids, typmods);
+}
+
+
+pgTypClass pgSet::TypClassFromOid(OID typoid)
+{
+	switch (typoid)
 	{
 		case PGOID_TYPE_BOOL:
-			colClasses[col] = PGTYPCLASS_BOOL;
-			break;
+			return PGTYPCLASS_BOOL;
 		case PGOID_TYPE_INT8:
 		case PGOID_TYPE_INT2:
 		case PGOID_TYPE_INT4:
@@ -124,28 +160,22 @@ pgTypClass pgSet::ColTypClass(const int col) const
 		case PGOID_TYPE_MONEY:
 		case PGOID_TYPE_BIT:
 		case PGOID_TYPE_NUMERIC:
-			colClasses[col] = PGTYPCLASS_NUMERIC;
-			break;
+			return PGTYPCLASS_NUMERIC;
 		case PGOID_TYPE_BYTEA:
 		case PGOID_TYPE_CHAR:
 		case PGOID_TYPE_NAME:
 		case PGOID_TYPE_TEXT:
 		case PGOID_TYPE_VARCHAR:
-			colClasses[col] = PGTYPCLASS_STRING;
-			break;
+			return PGTYPCLASS_STRING;
 		case PGOID_TYPE_TIMESTAMP:
 		case PGOID_TYPE_TIMESTAMPTZ:
 		case PGOID_TYPE_TIME:
 		case PGOID_TYPE_TIMETZ:
 		case PGOID_TYPE_INTERVAL:
-			colClasses[col] = PGTYPCLASS_DATE;
-			break;
+			return PGTYPCLASS_DATE;
 		default:
-			colClasses[col] = PGTYPCLASS_OTHER;
-			break;
+			return PGTYPCLASS_OTHER;
 	}
-
-	return (pgTypClass)colClasses[col];
 }
 
 
@@ -156,12 +186,10 @@ wxString pgSet::ColType(const int col) const
 	if (!colTypes[col].IsEmpty())
 		return colTypes[col];
 
-	wxString szSQL, szResult;
-	szSQL.Printf(wxT("SELECT format_type(oid,NULL) as typname FROM pg_type WHERE oid = %d"), (int)ColTypeOid(col));
-	szResult = ExecuteScalar(szSQL);
-	colTypes[col] = szResult;
+	CacheColTypes();
+	colTypes[col] = conn->GetTypeName(ColTypeOid(col));
 
-	return szResult;
+	return colTypes[col];
 }
 
 wxString pgSet::ColFullType(const int col) const
@@ -171,12 +199,10 @@ wxString pgSet::ColFullType(const int col) const
 	if (!colFullTypes[col].IsEmpty())
 		return colFullTypes[col];
 
-	wxString szSQL, szResult;
-	szSQL.Printf(wxT("SELECT format_type(oid,%d) as typname FROM pg_type WHERE oid = %d"), (int)ColTypeMod(col), (int)ColTypeOid(col));
-	szResult = ExecuteScalar(szSQL);
-	colFullTypes[col] = szResult;
+	CacheColTypes();
+	colFullTypes[col] = conn->GetFullTypeName(ColTypeOid(col), ColTypeMod(col));
 
-	return szResult;
+	return colFullTypes[col];
 }
 
 int pgSet::ColScale(const int col) const
@@ -194,18 +220,60 @@ wxString pgSet::ColName(const int col) const
 }
 
 
-int pgSet::ColNumber(const wxString &colname) const
+// The factories look up the columns by name for every row, so
+// don't leave that to the linear scan of PQfnumber().
+void pgSet::BuildColumnIndex()
 {
-	int col;
+	colIndex.clear();
 
-	if (needColQuoting)
+	for (int col = 0; col < nCols; col++)
 	{
-		wxString quotedColName = colname;
-		quotedColName.Replace(wxT("\""), wxT("\"\""));
-		col = PQfnumber(res, (wxT("\"") + quotedColName + wxT("\"")).mb_str(conv));
+		wxString name(PQfname(res, col), conv);
+
+		// PQfnumber() returns the first match for duplicate names
+		if (colIndex.find(name) == colIndex.end())
+			colIndex[name] = col;
 	}
+}
+
+
+int pgSet::FindColumn(const wxString &colname) const
+{
+	pgSetColumnMap::const_iterator it;
+
+	if (needColQuoting)
+		it = colIndex.find(colname);
 	else
-		col = PQfnumber(res, colname.mb_str(conv));
+	{
+		// Same as PQfnumber(), unquoted names are folded to lower case.
+		// Leave the quoted, and non-ASCII names to libpq.
+		wxString folded;
+		folded.Alloc(colname.Length());
+
+		for (size_t i = 0; i < colname.Length(); i++)
+		{
+			wxChar c = colname[i];
+
+			if (c == '"' || c > 127)
+				return PQfnumber(res, colname.mb_str(conv));
+
+			if (c >= 'A' && c <= 'Z')
+				c += 'a' - 'A';
+			folded += c;
+		}
+		it = colIndex.find(folded);
+	}
+
+	if (it == colIndex.end())
+		return -1;
+
+	return it->second;
+}
+
+
+int pgSet::ColNumber(const wxString &colname) const
+{
+	int col = FindColumn(colname);
 
 	if (col < 0)
 	{
@@ -216,15 +284,7 @@ int pgSet::ColNumber(const wxString &colname) const
 
 bool pgSet::HasColumn(const wxString &colname) const
 {
-	if (needColQuoting)
-	{
-		wxString quotedColName = colname;
-		quotedColName.Replace(wxT("\""), wxT("\"\""));
-		return (PQfnumber(res, (wxT("\"") + quotedColName + wxT("\"")).mb_str(conv)) < 0 ? false : true);
-	}
-	else
-		return (PQfnumber(res, colname.mb_str(conv)) < 0 ? false : true);
-
+	return FindColumn(colname) >= 0;
 }
 
 
@@ -386,6 +446,39 @@ OID pgSet::GetOid(const wxString &col) const
 }
 
 
+pgSet *pgSet::CopyRows(const wxArrayLong &rows) const
+{
+	if (!res)
+		return NULL;
+
+	PGresult *copy = PQcopyResult(res, PG_COPYRES_ATTRS);
+	if (!copy)
+		return NULL;
+
+	for (size_t i = 0; i < rows.GetCount(); i++)
+	{
+		long row = rows[i];
+
+		for (int col = 0; col < nCols; col++)
+		{
+			int ok;
+			if (PQgetisnull(res, row, col))
+				ok = PQsetvalue(copy, (int)i, col, NULL, -1);
+			else
+				ok = PQsetvalue(copy, (int)i, col, PQgetvalue(res, row, col), PQgetlength(res, row, col));
+
+			if (!ok)
+			{
+				PQclear(copy);
+				return NULL;
+			}
+		}
+	}
+
+	return new pgSet(copy, conn, conv, needColQuoting);
+}
+
+
 wxString pgSet::ExecuteScalar(const wxString &sql) const
 {
 	return conn->ExecuteScalar(sql);
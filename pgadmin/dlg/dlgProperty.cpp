@@ -893,7 +893,7 @@ bool dlgProperty::apply(const wxString &sql, const wxString &sql2)
 	if (GetDisconnectFirst())
 	{
 		myConn = database->GetServer()->GetConnection();
-		database->Disconnect();
+		database->Disconnect(true);
 	}
 
 	if (!sql.IsEmpty())
@@ -89,6 +89,8 @@ BEGIN_EVENT_TABLE(frmMain, pgFrame)
 #if defined(HAVE_OPENSSL_CRYPTO) || defined(HAVE_GCRYPT)
 	EVT_COMMAND (wxID_ANY, SSH_TUNNEL_ERROR_EVENT, frmMain::OnSSHTunnelEvent)
 #endif
+	EVT_COMMAND (wxID_ANY, CONNMONITOR_STATE_EVENT, frmMain::OnConnMonitor)
+	EVT_TIMER(CTL_POOLTIMER,                frmMain::OnPoolTimer)
 
 END_EVENT_TABLE()
 
@@ -293,6 +295,84 @@ void frmMain::OnCheckAlive(wxCommandEvent &event)
 }
 
 
+// Close the pooled connections, which have been idle too long, and park the
+// sessions of the databases, which haven't been used for a while.
+void frmMain::OnPoolTimer(wxTimerEvent &event)
+{
+	wxTreeItemIdValue foldercookie;
+	wxTreeItemId folderitem = browser->GetFirstChild(browser->GetRootItem(), foldercookie);
+	while (folderitem)
+	{
+		wxCookieType cookie;
+		wxTreeItemId serverItem = browser->GetFirstChild(folderitem, cookie);
+		while (serverItem)
+		{
+			pgServer *server = (pgServer *)browser->GetObject(serverItem);
+			if (server && server->IsCreatedBy(serverFactory) && server->GetConnected() && server->GetConnPool())
+			{
+				wxCookieType cookie2;
+				wxTreeItemId item = browser->GetFirstChild(serverItem, cookie2);
+				while (item)
+				{
+					pgObject *obj = browser->GetObject(item);
+					if (obj && obj->IsCreatedBy(databaseFactory.GetCollectionFactory()))
+					{
+						wxCookieType cookie3;
+						wxTreeItemId dbItem = browser->GetFirstChild(item, cookie3);
+						while (dbItem)
+						{
+							pgDatabase *db = (pgDatabase *)browser->GetObject(dbItem);
+							if (db && db->IsCreatedBy(databaseFactory))
+								db->ParkIdleConnection();
+							dbItem = browser->GetNextChild(item, cookie3);
+						}
+					}
+					item = browser->GetNextChild(serverItem, cookie2);
+				}
+				server->GetConnPool()->Prune();
+			}
+			serverItem = browser->GetNextChild(folderitem, cookie);
+		}
+		folderitem = browser->GetNextChild(browser->GetRootItem(), foldercookie);
+	}
+}
+
+
+// A server stopped or started answering the probes of the monitor. The
+// connections are only checked once they're used again, so nobody gets
+// asked to reconnect to a server they don't work with right now.
+void frmMain::OnConnMonitor(wxCommandEvent &event)
+{
+	wxTreeItemIdValue foldercookie;
+	wxTreeItemId folderitem = browser->GetFirstChild(browser->GetRootItem(), foldercookie);
+	while (folderitem)
+	{
+		wxCookieType cookie;
+		wxTreeItemId serverItem = browser->GetFirstChild(folderitem, cookie);
+		while (serverItem)
+		{
+			pgServer *server = (pgServer *)browser->GetObject(serverItem);
+			if (server && server == event.GetClientData() && server->IsCreatedBy(serverFactory))
+			{
+				if (event.GetInt())
+				{
+					wxLogInfo(wxT("Server %s answers again, after %ld ms"), server->GetName().c_str(), event.GetExtraLong());
+					SetStatusText(wxString::Format(_("Server %s is responding again."), server->GetFullName().c_str()));
+				}
+				else
+				{
+					wxLogInfo(wxT("Server %s doesn't answer"), server->GetName().c_str());
+					SetStatusText(wxString::Format(_("Server %s is not responding."), server->GetFullName().c_str()));
+				}
+				return;
+			}
+			serverItem = browser->GetNextChild(folderitem, cookie);
+		}
+		folderitem = browser->GetNextChild(browser->GetRootItem(), foldercookie);
+	}
+}
+
+
 
 void frmMain::OnPropSelChanged(wxListEvent &event)
 {
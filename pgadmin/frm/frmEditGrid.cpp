@@ -51,6 +51,22 @@
 
 #define CTRLID_LIMITCOMBO       4226
 
+#define CTRLID_ROWCOUNT         4227
+#define CTRLID_ROWCOUNTQUERY    4228
+#define CTRLID_PAGELOADED       4229
+
+// Maximum number of rows deleted by a single DELETE statement
+#define DELETE_BATCH_ROWS       1000
+
+// Tables with more rows (as estimated by the statistics) are read page by
+// page, when all the rows are to be shown
+#define KEYSET_MIN_ROWS         100000
+// Rows per page, and the number of pages kept in memory
+#define KEYSET_PAGE_ROWS        1000
+#define KEYSET_MAX_PAGES        32
+// Pages waiting to be read in the background; older requests are dropped
+#define KEYSET_MAX_QUEUED       4
+
 
 BEGIN_EVENT_TABLE(frmEditGrid, pgFrame)
 	EVT_ERASE_BACKGROUND(       frmEditGrid::OnEraseBackground)
@@ -84,6 +100,10 @@ BEGIN_EVENT_TABLE(frmEditGrid, pgFrame)
 	EVT_GRID_CELL_RIGHT_CLICK(  frmEditGrid::OnCellRightClick)
 	EVT_GRID_LABEL_RIGHT_CLICK( frmEditGrid::OnLabelRightClick)
 	EVT_AUI_PANE_BUTTON(        frmEditGrid::OnAuiUpdate)
+	EVT_IDLE(                   frmEditGrid::OnIdle)
+	EVT_MENU(CTRLID_ROWCOUNT,   frmEditGrid::OnRowCountChanged)
+	EVT_MENU(CTRLID_PAGELOADED, frmEditGrid::OnPageLoaded)
+	EVT_PGQUERYRESULT(CTRLID_ROWCOUNTQUERY, frmEditGrid::OnRowCountComplete)
 END_EVENT_TABLE()
 
 
@@ -99,6 +119,8 @@ frmEditGrid::frmEditGrid(frmMain *form, const wxString &_title, pgConn *_conn, p
 	connection = _conn;
 	mainForm = form;
 	thread = 0;
+	countConnection = 0;
+	countThread = 0;
 	relkind = 0;
 	limit = 0;
 	relid = (Oid)obj->GetOid();
@@ -270,6 +292,7 @@ frmEditGrid::frmEditGrid(frmMain *form, const wxString &_title, pgConn *_conn, p
 	manager.Update();
 
 	autoOrderBy = false;
+	keyAscending = pkAscending;
 	if (obj->GetMetaType() == PGM_TABLE || obj->GetMetaType() == GP_PARTITION)
 	{
 		pgTable *table = (pgTable *)obj;
@@ -295,6 +318,7 @@ frmEditGrid::frmEditGrid(frmMain *form, const wxString &_title, pgConn *_conn, p
 				orderBy += wxT(" DESC");
 			}
 		}
+		keyOrderBy = orderBy;
 	}
 	else if (obj->GetMetaType() == PGM_VIEW)
 	{
@@ -444,7 +468,11 @@ void frmEditGrid::SetLimit(const int rowlimit)
 
 void frmEditGrid::SetStatusTextRows(const int numRows)
 {
-	wxString status = wxString::Format(wxPLURAL("%d row", "%d rows", numRows), numRows);
+	wxString status;
+	if (sqlGrid->GetTable() && sqlGrid->GetTable()->IsRowCountEstimated())
+		status = wxString::Format(wxPLURAL("about %d row", "about %d rows", numRows), numRows);
+	else
+		status = wxString::Format(wxPLURAL("%d row", "%d rows", numRows), numRows);
 	bool showWarn = false;
 
 	if (GetFilter().Trim().Len() > 0) {
@@ -808,8 +836,11 @@ void frmEditGrid::OnCopy(wxCommandEvent &ev)
 		}
 		else if(sqlGrid->GetNumberRows() > 0)
 		{
+			// The rows of the pages not read yet are needed, not their placeholders
+			sqlGrid->GetTable()->SetWaitForPages(true);
 			int copied;
 			copied = sqlGrid->Copy();
+			sqlGrid->GetTable()->SetWaitForPages(false);
 			SetStatusText(wxString::Format(
 			                  wxPLURAL("Data from %d row copied to clipboard.", "Data from %d rows copied to clipboard.", copied),
 			                  copied), EGSTATUSPOS_MSGS);
@@ -1261,33 +1292,34 @@ void frmEditGrid::OnDelete(wxCommandEvent &event)
 
 	sqlGrid->BeginBatch();
 
-	// Sort the grid so we always delete last->first, otherwise we
-	// could end up deleting anything because the array returned by
-	// GetSelectedRows is in the order that rows were selected by
-	// the user.
+	// The array returned by GetSelectedRows is in the order that rows
+	// were selected by the user.
 	delrows.Sort(ArrayCmp);
 
-	// don't care a lot about optimizing here; doing it line by line
-	// just as sqlTable::DeleteRows does
-	bool show_continue_message = true;
-	while (i--)
+	// All the rows are deleted in one transaction, so it's all or nothing.
+	// If that fails, they are deleted one by one (last to first), asking
+	// whether to go on after an error, as the rows may be fine but one.
+	if (!sqlGrid->GetTable()->DeleteRowList(delrows) && i > 1)
 	{
-		if (!sqlGrid->DeleteRows(delrows.Item(i), 1) &&
-		        i > 0 &&
-		        show_continue_message)
+		bool show_continue_message = true;
+		while (i--)
 		{
-			wxMessageDialog msg(this, wxString::Format(wxPLURAL(
-			                        "There was an error deleting the previous record.\nAre you sure you wish to delete the remaining %d row?",
-			                        "There was an error deleting the previous record.\nAre you sure you wish to delete the remaining %d rows?",
-			                        i), i), _("Delete more records ?"), wxYES_NO | wxICON_QUESTION);
-			if (msg.ShowModal() != wxID_YES)
-				break;
-			else
-				show_continue_message = false;
+			if (!sqlGrid->DeleteRows(delrows.Item(i), 1) &&
+			        i > 0 &&
+			        show_continue_message)
+			{
+				wxMessageDialog msg(this, wxString::Format(wxPLURAL(
+				                        "There was an error deleting the previous record.\nAre you sure you wish to delete the remaining %d row?",
+				                        "There was an error deleting the previous record.\nAre you sure you wish to delete the remaining %d rows?",
+				                        i), i), _("Delete more records ?"), wxYES_NO | wxICON_QUESTION);
+				if (msg.ShowModal() != wxID_YES)
+					break;
+				else
+					show_continue_message = false;
+			}
 		}
 	}
 
-
 	sqlGrid->EndBatch();
 
 	SetStatusTextRows(sqlGrid->GetTable()->GetNumberStoredRows());
@@ -1421,6 +1453,18 @@ void frmEditGrid::Go()
 	if (connection->ExecuteScalar(wxT("SELECT count(*) FROM ") + tableName + wxT(" WHERE false")) == wxT(""))
 		return;
 
+	AbortRowCount();
+
+	// Big tables are read page by page, if we can order them by their key
+	long estimatedRows = 0;
+	if (relkind == 'r' && limit <= 0 && rowFilter.IsEmpty() &&
+	        !keyOrderBy.IsEmpty() && orderBy == keyOrderBy)
+	{
+		estimatedRows = StrToLong(connection->ExecuteScalar(
+		                              wxT("SELECT reltuples::bigint FROM pg_class WHERE oid=") + NumToStr(relid) + wxT("::oid")));
+	}
+	bool useKeyset = (estimatedRows >= KEYSET_MIN_ROWS);
+
 	SetStatusText(_(""), EGSTATUSPOS_ROWS);
 	SetStatusText(_("Refreshing data, please wait."), EGSTATUSPOS_MSGS);
 
@@ -1449,6 +1493,15 @@ void frmEditGrid::Go()
 	}
 	if (limit > 0)
 		qry += wxT(" LIMIT ") + wxString::Format(wxT("%i"), limit);
+	else if (useKeyset)
+		qry += wxT(" LIMIT ") + NumToStr((long)KEYSET_PAGE_ROWS);
+
+	// A table read page by page needs the connection, which is going to be busy
+	if (sqlGrid->GetTable() && sqlGrid->GetTable()->IsPaged())
+	{
+		sqlGrid->HideCellEditControl();
+		sqlGrid->SetTable(0);
+	}
 
 	thread = new pgQueryThread(connection, qry);
 	if (thread->Create() != wxTHREAD_NO_ERROR)
@@ -1511,9 +1564,6 @@ void frmEditGrid::Go()
 		return;
 	}
 
-	SetStatusTextRows((int)thread->DataSet()->NumRows());
-	SetStatusText(_("OK"), EGSTATUSPOS_MSGS);
-
 	sqlGrid->BeginBatch();
 
 	// to force the grid to create scrollbars, we make sure the size  so small that scrollbars are needed
@@ -1523,11 +1573,21 @@ void frmEditGrid::Go()
 	// !!! Is it still required?
 	//sqlGrid->SetSize(10, 10);
 
-	sqlGrid->SetTable(new sqlTable(connection, thread, tableName, relid, hasOids, primaryKeyColNumbers, relkind), true);
+	sqlTable *table = new sqlTable(connection, thread, tableName, relid, hasOids, primaryKeyColNumbers, relkind);
+	if (useKeyset)
+		table->SetKeyset(keyOrderBy, keyAscending, estimatedRows, GetEventHandler());
+
+	sqlGrid->SetTable(table, true);
 	sqlGrid->AutoSizeColumns(false);
 
 	sqlGrid->EndBatch();
 
+	SetStatusTextRows(table->GetNumberStoredRows());
+	SetStatusText(_("OK"), EGSTATUSPOS_MSGS);
+
+	if (table->IsRowCountEstimated())
+		StartRowCount();
+
 	toolBar->EnableTool(MNU_REFRESH, true);
 	viewMenu->Enable(MNU_REFRESH, true);
 	toolBar->EnableTool(MNU_OPTIONS, true);
@@ -1566,6 +1626,8 @@ frmEditGrid::~frmEditGrid()
 
 void frmEditGrid::Abort()
 {
+	AbortRowCount();
+
 	if (sqlGrid->GetTable())
 	{
 		sqlGrid->HideCellEditControl();
@@ -1586,6 +1648,98 @@ void frmEditGrid::Abort()
 }
 
 
+// Count the rows of a table read page by page in the background, on a
+// connection of its own, while the rows are shown.
+void frmEditGrid::StartRowCount()
+{
+	countConnection = connection->Duplicate();
+	if (!countConnection || countConnection->GetStatus() != PGCONN_OK)
+	{
+		AbortRowCount();
+		return;
+	}
+
+	countThread = new pgQueryThread(countConnection, wxT("SELECT count(*) FROM ") + tableName, -1, this, CTRLID_ROWCOUNTQUERY);
+	if (countThread->Create() != wxTHREAD_NO_ERROR)
+	{
+		AbortRowCount();
+		return;
+	}
+	countThread->Run();
+}
+
+
+void frmEditGrid::AbortRowCount()
+{
+	if (countThread)
+	{
+		if (countThread->IsRunning())
+		{
+			countThread->CancelExecution();
+			countThread->Wait();
+		}
+		delete countThread;
+		countThread = 0;
+	}
+
+	if (countConnection)
+	{
+		delete countConnection;
+		countConnection = 0;
+	}
+}
+
+
+void frmEditGrid::OnRowCountComplete(pgQueryResultEvent &event)
+{
+	// Results of a count, which has been aborted, may still arrive
+	if (!countThread || event.GetThreadID() != (unsigned long)countThread->GetId())
+		return;
+
+	countThread->Wait();
+
+	long rows = -1;
+	if (countThread->DataValid() && countThread->DataSet()->NumRows() == 1)
+		rows = countThread->DataSet()->GetLong(0);
+
+	AbortRowCount();
+
+	if (rows >= 0 && sqlGrid->GetTable())
+	{
+		sqlGrid->GetTable()->SetExactRowCount(rows);
+		sqlGrid->GetTable()->SyncRowCount();
+		SetStatusTextRows(sqlGrid->GetTable()->GetNumberStoredRows());
+	}
+}
+
+
+void frmEditGrid::OnRowCountChanged(wxCommandEvent &event)
+{
+	if (sqlGrid->GetTable())
+	{
+		sqlGrid->GetTable()->SyncRowCount();
+		SetStatusTextRows(sqlGrid->GetTable()->GetNumberStoredRows());
+	}
+}
+
+
+void frmEditGrid::OnPageLoaded(wxCommandEvent &event)
+{
+	if (sqlGrid->GetTable())
+		sqlGrid->GetTable()->PageLoaded();
+}
+
+
+void frmEditGrid::OnIdle(wxIdleEvent &event)
+{
+	// Read the page the user is likely to scroll to next
+	if (sqlGrid->GetTable() && !thread && !closing)
+		sqlGrid->GetTable()->Prefetch();
+
+	event.Skip();
+}
+
+
 ctlSQLEditGrid::ctlSQLEditGrid(wxFrame *parent, wxWindowID id, const wxPoint &pos, const wxSize &size)
 	: ctlSQLGrid(parent, id, pos, size)
 {
@@ -2327,14 +2481,23 @@ sqlTable::sqlTable(pgConn *conn, pgQueryThread *_thread, const wxString &tabName
 
 
 	dataPool = 0;
-	addPool = new cacheLinePool(500);       // arbitrary initial size
 	lastRow = -1;
 	int i;
-	lineIndex = 0;
+
+	keyset = false;
+	keysetAscending = true;
+	loader = 0;
+	waitForPages = false;
+	pageUseCounter = 0;
+	currentPage = -1;
+	prefetchPage = -1;
+	rowCountExact = true;
 
 	nRows = thread->DataSet()->NumRows();
 	nCols = thread->DataSet()->NumCols();
 
+	addPool = new cacheLinePool(500, nCols);       // arbitrary initial size
+
 	columns = new sqlCellAttr[nCols];
 	savedLine.cols = new wxString[nCols];
 
@@ -2544,12 +2707,8 @@ sqlTable::sqlTable(pgConn *conn, pgQueryThread *_thread, const wxString &tabName
 	}
 
 	if (nRows)
-	{
-		dataPool = new cacheLinePool(nRows);
-		lineIndex = new int[nRows];
-		for (i = 0 ; i < nRows ; i++)
-			lineIndex[i] = i;
-	}
+		dataPool = new cacheLinePool(nRows, nCols);
+	pendingRows = nRows;
 
 	if (canInsert)
 	{
@@ -2561,6 +2720,13 @@ sqlTable::sqlTable(pgConn *conn, pgQueryThread *_thread, const wxString &tabName
 
 sqlTable::~sqlTable()
 {
+	if (loader)
+	{
+		loader->Stop();
+		loader->Wait();
+		delete loader;
+	}
+
 	if (thread)
 		delete thread;
 	if (dataPool)
@@ -2570,8 +2736,9 @@ sqlTable::~sqlTable()
 
 	delete[] columns;
 
-	if (lineIndex)
-		delete[] lineIndex;
+	sqlKeysetPageMap::iterator it;
+	for (it = pages.begin() ; it != pages.end() ; ++it)
+		delete it->second;
 }
 
 
@@ -2733,15 +2900,77 @@ bool sqlTable::CheckInCache(int row)
 	if (row >= nRows - rowsDeleted)
 		return true;
 
-	return dataPool->IsFilled(row);
+	int dataRow = DataRow(row);
+	if (keyset)
+	{
+		sqlKeysetPageMap::iterator it = pages.find(dataRow / KEYSET_PAGE_ROWS);
+		return it != pages.end() && it->second->lines != 0;
+	}
+
+	return dataPool->IsFilled(dataRow);
+}
+
+
+// The row of the dataSet shown in the given row of the grid, i.e. skipping
+// the deleted ones
+int sqlTable::DataRow(int row)
+{
+	// deletedRows[i] - i is the number of rows kept before the i-th deleted row
+	size_t low = 0, high = deletedRows.GetCount();
+	while (low < high)
+	{
+		size_t mid = (low + high) / 2;
+		if (deletedRows.Item(mid) - (int)mid <= row)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return row + (int)low;
 }
 
 
-cacheLine *sqlTable::GetLine(int row)
+cacheLine *sqlTable::GetLine(int row, bool wait)
 {
 	cacheLine *line;
 	if (row < nRows - rowsDeleted)
-		line = dataPool->Get(lineIndex[row]);
+	{
+		int dataRow = DataRow(row);
+		if (keyset)
+		{
+			int pageNo = dataRow / KEYSET_PAGE_ROWS;
+			sqlKeysetPage *page = GetPage(pageNo);
+
+			if (!page->lines)
+			{
+				if (wait || waitForPages)
+				{
+					if (page->loading)
+						FillPage(pageNo, loader->WaitResult(pageNo));
+					if (!page->lines)
+						LoadPage(pageNo);
+				}
+				else if (!page->loading)
+					RequestPage(pageNo);
+			}
+
+			// Remember where the user is heading to, to read the next page in advance
+			if (pageNo != currentPage)
+			{
+				if (currentPage >= 0)
+					prefetchPage = (pageNo > currentPage ? pageNo + 1 : pageNo - 1);
+				currentPage = pageNo;
+			}
+			page->lastUsed = ++pageUseCounter;
+
+			// The rows are shown as placeholders, until the page is there
+			if (!page->lines)
+				return &placeholder;
+
+			line = page->lines->Get(dataRow % KEYSET_PAGE_ROWS);
+		}
+		else
+			line = dataPool->Get(dataRow);
+	}
 	else
 		line = addPool->Get(row - (nRows - rowsDeleted));
 
@@ -2750,13 +2979,15 @@ cacheLine *sqlTable::GetLine(int row)
 
 
 
-wxString sqlTable::MakeKey(cacheLine *line)
+// The positions in columns of the primary key columns, empty if there is
+// no primary key
+wxArrayInt sqlTable::GetKeyColumns()
 {
-	wxString whereClause;
+	wxArrayInt keyCols;
+
 	if (!primaryKeyColNumbers.IsEmpty())
 	{
 		wxStringTokenizer collist(primaryKeyColNumbers, wxT(","));
-		long cn;
 		int offset;
 
 		if (hasOids)
@@ -2766,37 +2997,110 @@ wxString sqlTable::MakeKey(cacheLine *line)
 
 		while (collist.HasMoreTokens())
 		{
-			cn = StrToLong(collist.GetNextToken());
-
 			// Translate the column location to the real location in the actual columns still present
-			cn = colMap[cn - 1];
+			long cn = colMap[StrToLong(collist.GetNextToken()) - 1];
+			keyCols.Add(cn - offset);
+		}
+	}
+	return keyCols;
+}
+
+
+// The value of a key column of the line, quoted and cast to its type.
+// Empty if the line has no value for it.
+wxString sqlTable::MakeKeyValue(cacheLine *line, int col)
+{
+	wxString colval = line->GetCol(col);
+	if (colval.IsEmpty())
+		return wxEmptyString;
+
+	if (colval == wxT("''") && columns[col].typeName == wxT("text"))
+		colval = wxEmptyString;
+
+	wxString keyVal = connection->qtDbString(colval);
+	if (columns[col].typeName != wxT(""))
+	{
+		keyVal += wxT("::");
+		keyVal += columns[col].displayTypeName;
+	}
+	return keyVal;
+}
 
-			wxString colval = line->cols[cn - offset];
-			if (colval.IsEmpty())
-				return wxEmptyString;
 
-			if (colval == wxT("''") && columns[cn - offset].typeName == wxT("text"))
-				colval = wxEmptyString;
+wxString sqlTable::MakeKey(cacheLine *line)
+{
+	wxString whereClause;
+	wxArrayInt keyCols = GetKeyColumns();
+
+	if (!keyCols.IsEmpty())
+	{
+		for (size_t i = 0 ; i < keyCols.GetCount() ; i++)
+		{
+			wxString keyVal = MakeKeyValue(line, keyCols.Item(i));
+			if (keyVal.IsEmpty())
+				return wxEmptyString;
 
 			if (!whereClause.IsEmpty())
 				whereClause += wxT(" AND ");
-			whereClause += qtIdent(columns[cn - offset].name) + wxT(" = ") + connection->qtDbString(colval);
-
-			if (columns[cn - offset].typeName != wxT(""))
-			{
-				whereClause += wxT("::");
-				whereClause += columns[cn - offset].displayTypeName;
-			}
+			whereClause += qtIdent(columns[keyCols.Item(i)].name) + wxT(" = ") + keyVal;
 		}
 	}
 	else if (hasOids)
-		whereClause = wxT("oid = ") + line->cols[0];
+		whereClause = wxT("oid = ") + line->GetCol(0);
 
 	return whereClause;
 }
 
 
 
+// The key columns, for matching a list of keys made by MakeKeyValues()
+wxString sqlTable::MakeKeyColumns()
+{
+	wxString keyCols;
+	wxArrayInt cols = GetKeyColumns();
+
+	if (cols.IsEmpty())
+		return hasOids ? wxT("oid") : wxT("");
+
+	for (size_t i = 0 ; i < cols.GetCount() ; i++)
+	{
+		if (i)
+			keyCols += wxT(", ");
+		keyCols += qtIdent(columns[cols.Item(i)].name);
+	}
+
+	if (cols.GetCount() > 1)
+		return wxT("(") + keyCols + wxT(")");
+	return keyCols;
+}
+
+
+wxString sqlTable::MakeKeyValues(cacheLine *line)
+{
+	wxString keyVals;
+	wxArrayInt cols = GetKeyColumns();
+
+	if (cols.IsEmpty())
+		return hasOids ? line->GetCol(0) : wxT("");
+
+	for (size_t i = 0 ; i < cols.GetCount() ; i++)
+	{
+		wxString keyVal = MakeKeyValue(line, cols.Item(i));
+		if (keyVal.IsEmpty())
+			return wxEmptyString;
+
+		if (i)
+			keyVals += wxT(", ");
+		keyVals += keyVal;
+	}
+
+	if (cols.GetCount() > 1)
+		return wxT("(") + keyVals + wxT(")");
+	return keyVals;
+}
+
+
+
 void sqlTable::UndoLine(int row)
 {
 	if (lastRow >= 0 && row >= 0)
@@ -2806,7 +3110,7 @@ void sqlTable::UndoLine(int row)
 		{
 			int i;
 			for (i = 0 ; i < nCols ; i++)
-				line->cols[i] = savedLine.cols[i];
+				line->SetCol(i, savedLine.cols[i]);
 			ctlMenuToolbar *tb = (ctlMenuToolbar *)((wxFrame *)GetView()->GetParent())->GetToolBar();
 			if (tb)
 			{
@@ -2843,11 +3147,11 @@ bool sqlTable::StoreLine()
 
 			for (i = (hasOids ? 1 : 0) ; i < nCols ; i++)
 			{
-				if (savedLine.cols[i] != line->cols[i])
+				if (savedLine.cols[i] != line->GetCol(i))
 				{
 					if (!valList.IsNull())
 						valList += wxT(", ");
-					valList += qtIdent(columns[i].name) + wxT("=") + columns[i].Quote(connection, line->cols[i]);
+					valList += qtIdent(columns[i].name) + wxT("=") + columns[i].Quote(connection, line->GetCol(i));
 				}
 			}
 
@@ -2869,7 +3173,7 @@ bool sqlTable::StoreLine()
 
 			for (i = 0 ; i < nCols ; i++)
 			{
-				if (!columns[i].readOnly && !line->cols[i].IsEmpty())
+				if (!columns[i].readOnly && !line->GetCol(i).IsEmpty())
 				{
 					if (!colList.IsNull())
 					{
@@ -2878,24 +3182,30 @@ bool sqlTable::StoreLine()
 					}
 					colList += qtIdent(columns[i].name);
 
-					valList += columns[i].Quote(connection, line->cols[i]);
+					valList += columns[i].Quote(connection, line->GetCol(i));
 				}
 			}
 
 			if (!valList.IsEmpty())
 			{
-				pgSet *set = connection->ExecuteSet(
-				                 wxT("INSERT INTO ") + tableName
-				                 + wxT("(") + colList
-				                 + wxT(") VALUES (") + valList
-				                 + wxT(")"));
+				wxString sql = wxT("INSERT INTO ") + tableName
+				               + wxT("(") + colList
+				               + wxT(") VALUES (") + valList
+				               + wxT(")");
+
+				// Get the default values back in the same round trip; views
+				// can only return rows, if their rules do.
+				bool returning = (relkind == 'r');
+				if (returning)
+					sql += wxT(" RETURNING *");
+
+				pgSet *set = connection->ExecuteSet(sql);
 				if (set)
 				{
 					if (set->GetInsertedCount() > 0)
 					{
 						if (hasOids)
-							line->cols[0] = NumToStr((long)set->GetInsertedOid());
-						delete set;
+							line->SetCol(0, NumToStr((long)set->GetInsertedOid()));
 
 						done = true;
 						rowsStored++;
@@ -2904,33 +3214,52 @@ bool sqlTable::StoreLine()
 						if (rowsAdded == rowsStored)
 							GetView()->AppendRows();
 
-						// Read back what we inserted to get default vals
-						wxString key = MakeKey(line);
-
-						if (key.IsEmpty())
+						if (returning && set->NumRows() > 0)
 						{
-							// That's a problem: obviously, the key generated isn't present
-							// because it's serial or default or otherwise generated in the backend
-							// we don't get.
-							// That's why the whole line is declared readonly.
+							for (i = (hasOids ? 1 : 0) ; i < nCols ; i++)
+							{
+								line->SetCol(i, set->GetVal(columns[i].name));
+							}
+							delete set;
 
-							line->readOnly = true;
+							// Without a key, we couldn't update the row later on
+							if (MakeKey(line).IsEmpty())
+								line->readOnly = true;
 						}
 						else
 						{
-							set = connection->ExecuteSet(
-							          wxT("SELECT * FROM ") + tableName +
-							          wxT(" WHERE ") + key);
-							if (set)
+							delete set;
+
+							// Read back what we inserted to get default vals
+							wxString key = MakeKey(line);
+
+							if (key.IsEmpty())
+							{
+								// That's a problem: obviously, the key generated isn't present
+								// because it's serial or default or otherwise generated in the backend
+								// we don't get.
+								// That's why the whole line is declared readonly.
+
+								line->readOnly = true;
+							}
+							else
 							{
-								for (i = (hasOids ? 1 : 0) ; i < nCols ; i++)
+								set = connection->ExecuteSet(
+								          wxT("SELECT * FROM ") + tableName +
+								          wxT(" WHERE ") + key);
+								if (set)
 								{
-									line->cols[i] = set->GetVal(columns[i].name);
+									for (i = (hasOids ? 1 : 0) ; i < nCols ; i++)
+									{
+										line->SetCol(i, set->GetVal(columns[i].name));
+									}
+									delete set;
 								}
-								delete set;
 							}
 						}
 					}
+					else
+						delete set;
 				}
 			}
 		}
@@ -2965,14 +3294,13 @@ void sqlTable::SetValue(int row, int col, const wxString &value)
 		if (lastRow >= 0)
 			StoreLine();
 
-		if (!line->cols) {
-			line->cols = new wxString[nCols];
-			line->nulls = new bool[nCols];
-		}
+		if (!line->IsFilled())
+			line->Alloc(nCols);
+
 		// remember line contents for later reference in update ... where
 		int i;
 		for (i = 0 ; i < nCols ; i++)
-			savedLine.cols[i] = line->cols[i];
+			savedLine.cols[i] = line->GetCol(i);
 		lastRow = row;
 	}
 	ctlMenuToolbar *tb = (ctlMenuToolbar *)((wxFrame *)GetView()->GetParent())->GetToolBar();
@@ -2987,7 +3315,7 @@ void sqlTable::SetValue(int row, int col, const wxString &value)
 	wxMenu *em = ((frmEditGrid *)GetView()->GetParent())->GetEditMenu();
 	if (em)
 		em->Enable(MNU_UNDO, true);
-	line->cols[col] = value;
+	line->SetCol(col, value);
 }
 
 
@@ -2995,15 +3323,10 @@ bool sqlTable::GetIsNull(int row, int col)
 {
 	//wxLogInfo(wxT("sqlTable::GetIsNull(%d, %d)"), row, col);
 	bool isNull = false;
-	cacheLine *line;
-	if (row < nRows - rowsDeleted)
-		line = dataPool->Get(lineIndex[row]);
-	else
-		line = addPool->Get(row - (nRows - rowsDeleted));
+	cacheLine *line = GetLine(row, false);
 
-	if (line && line->nulls) {
-		isNull = line->nulls[col];
-	}
+	if (line)
+		isNull = line->IsNull(col);
 	return isNull;
 }
 
@@ -3011,11 +3334,7 @@ wxString sqlTable::GetValue(int row, int col)
 {
 	//wxLogInfo(wxT("sqlTable::GetValue(%d, %d)"), row, col);
 	wxString val;
-	cacheLine *line;
-	if (row < nRows - rowsDeleted)
-		line = dataPool->Get(lineIndex[row]);
-	else
-		line = addPool->Get(row - (nRows - rowsDeleted));
+	cacheLine *line = GetLine(row, false);
 
 	if (!line)
 	{
@@ -3023,50 +3342,28 @@ wxString sqlTable::GetValue(int row, int col)
 		return val;
 	}
 
-	if (!line->cols)
+	if (!line->IsFilled())
 	{
-		line->cols = new wxString[nCols];
-		line->nulls = new bool[nCols];
-		if (row < nRows - rowsDeleted)
+		if (keyset && row < nRows - rowsDeleted)
+		{
+			// The page has been read, but the row wasn't there (any more)
+			line->Alloc(nCols);
+			line->readOnly = true;
+		}
+		else if (row < nRows - rowsDeleted)
 		{
 			if (!thread)
 			{
+				line->Alloc(nCols);
 				wxLogError(__("Unexpected empty cache line: dataSet already closed."));
 				return val;
 			}
 
-			line->stored = true;
-			if (lineIndex[row] != thread->DataSet()->CurrentPos() - 1)
-				thread->DataSet()->Locate(lineIndex[row] + 1);
+			int dataRow = DataRow(row);
+			if (dataRow != thread->DataSet()->CurrentPos() - 1)
+				thread->DataSet()->Locate(dataRow + 1);
 
-			int i;
-			for (i = 0 ; i < nCols ; i++)
-			{
-				wxString val;
-				bool isNull = false;
-				if (thread->DataSet()->ColType(i) == wxT("bytea"))
-					val = _("<binary data>");
-				else
-				{
-					val = thread->DataSet()->GetVal(i);
-					if (val.IsEmpty())
-					{
-						if (!thread->DataSet()->IsNull(i))
-							val = wxT("''");
-						else
-						{
-							isNull = true;
-							if (settings->GetIndicateNull()) {
-								val = wxT("<NULL>");
-							}
-						}
-					}
-					else if (val == wxT("''"))
-						val = wxT("\\'\\'");
-				}
-				line->cols[i] = val;
-				line->nulls[i] = isNull;
-			}
+			FillLine(line, thread->DataSet());
 			rowsCached++;
 
 			if (rowsCached == nRows)
@@ -3075,17 +3372,55 @@ wxString sqlTable::GetValue(int row, int col)
 				thread = 0;
 			}
 		}
+		else
+			line->Alloc(nCols);
 	}
+
+	val = line->GetCol(col);
 	if (columns[col].type == PGOID_TYPE_BOOL)
 	{
-		if (line->cols[col] != wxEmptyString)
-			line->cols[col] = (StrToBool(line->cols[col]) ? wxT("TRUE") : wxT("FALSE"));
+		if (val != wxEmptyString)
+			val = (StrToBool(val) ? wxT("TRUE") : wxT("FALSE"));
 	}
 
-	val = line->cols[col];
 	return val;
 }
 
+// Copy the current row of the set into the line
+void sqlTable::FillLine(cacheLine *line, pgSet *set)
+{
+	line->stored = true;
+
+	int i;
+	for (i = 0 ; i < nCols ; i++)
+	{
+		wxString val;
+		bool isNull = false;
+		if (set->ColType(i) == wxT("bytea"))
+			val = _("<binary data>");
+		else
+		{
+			val = set->GetVal(i);
+			if (val.IsEmpty())
+			{
+				if (!set->IsNull(i))
+					val = wxT("''");
+				else
+				{
+					isNull = true;
+					if (settings->GetIndicateNull()) {
+						val = wxT("<NULL>");
+					}
+				}
+			}
+			else if (val == wxT("''"))
+				val = wxT("\\'\\'");
+		}
+		line->StoreCol(i, val, isNull);
+	}
+}
+
+
 bool sqlTable::AppendRows(size_t rows)
 {
 	rowsAdded += rows;
@@ -3100,77 +3435,826 @@ bool sqlTable::AppendRows(size_t rows)
 
 bool sqlTable::DeleteRows(size_t pos, size_t rows)
 {
-	size_t i = pos;
-	size_t rowsDone = 0;
+	wxArrayInt rowList;
 
-	while (i < pos + rows)
+	for (size_t i = pos ; i < pos + rows ; i++)
+		rowList.Add(i);
+
+	return DeleteRowList(rowList);
+}
+
+
+// Delete the given rows (in ascending order) from the table, using as few
+// statements as possible within a single transaction.
+bool sqlTable::DeleteRowList(const wxArrayInt &rows)
+{
+	wxArrayInt deleted;
+	wxArrayString keys;
+	size_t i;
+
+	for (i = 0 ; i < rows.GetCount() ; i++)
 	{
-		cacheLine *line = GetLine(pos);
+		int row = rows.Item(i);
+		cacheLine *line = GetLine(row);
 		if (!line)
 			break;
 
-		// If line->cols is null, it probably means we need to force the cacheline to be populated.
-		if (!line->cols)
+		// If the line is empty, it probably means we need to force the cacheline to be populated.
+		if (!line->IsFilled())
 		{
-			GetValue(pos, 0);
-			line = GetLine(pos);
+			GetValue(row, 0);
+			line = GetLine(row);
 		}
 
 		if (line->stored)
 		{
-			wxString key = MakeKey(line);
+			wxString key = MakeKeyValues(line);
 			wxASSERT(!key.IsEmpty());
-			bool done = connection->ExecuteVoid(wxT(
-			                                        "DELETE FROM ") + tableName + wxT(" WHERE ") + key);
-			if (!done)
-				break;
+			if (key.IsEmpty())
+				continue;
 
-			if ((int)pos < nRows - rowsDeleted)
-			{
-				rowsDeleted++;
-				if ((int)pos < nRows - rowsDeleted)
-					memmove(lineIndex + pos, lineIndex + pos + 1, sizeof(*lineIndex) * (nRows - rowsDeleted - pos));
-			}
-			else
-			{
-				rowsAdded--;
-				if (GetLine(pos)->stored)
-					rowsStored--;
-				addPool->Delete(pos - (nRows - rowsDeleted));
-			}
-			rowsDone++;
+			keys.Add(key);
+			deleted.Add(row);
 		}
 		else
 		{
 			// last empty line won't be deleted, just cleared
 			int j;
 			for (j = 0 ; j < nCols ; j++)
-				line->cols[j] = wxT("");
+				line->SetCol(j, wxT(""));
 		}
-		i++;
 	}
 
-	if (rowsDone > 0 && GetView())
+	if (keys.IsEmpty())
+		return false;
+
+	bool ownTransaction = (connection->GetTxStatus() == PGCONN_TXSTATUS_IDLE);
+	bool done = !ownTransaction || connection->ExecuteVoid(wxT("BEGIN"));
+	wxString keyCols = MakeKeyColumns();
+
+	for (size_t start = 0 ; done && start < keys.GetCount() ; start += DELETE_BATCH_ROWS)
 	{
-		wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_DELETED, pos, rowsDone);
-		GetView()->ProcessTableMessage(msg);
-	}
-	return (rowsDone != 0);
-}
+		wxString keyList;
+		for (i = start ; i < keys.GetCount() && i < start + DELETE_BATCH_ROWS ; i++)
+		{
+			if (i > start)
+				keyList += wxT(", ");
+			keyList += keys.Item(i);
+		}
 
+		done = connection->ExecuteVoid(wxT("DELETE FROM ") + tableName +
+		                               wxT(" WHERE ") + keyCols + wxT(" IN (") + keyList + wxT(")"));
+	}
 
-bool sqlTable::Paste()
-{
-	int row, col;
-	int start, pos, len;
-	wxArrayString data;
-	wxString text, quoteChar, colSep;
-	bool inQuotes, inData, skipSerial;
+	if (ownTransaction)
+	{
+		if (done)
+			done = connection->ExecuteVoid(wxT("COMMIT"));
+		else
+			connection->ExecuteVoid(wxT("ROLLBACK"));
+	}
 
-	if (!this)
+	if (!done)
 		return false;
 
-	if (wxTheClipboard->Open())
+	// Remember which rows of the dataset are gone
+	int dataRows = nRows - rowsDeleted;
+	wxArrayInt deletedData;
+	size_t d;
+
+	for (d = 0 ; d < deleted.GetCount() && deleted.Item(d) < dataRows ; d++)
+		deletedData.Add(DataRow(deleted.Item(d)));
+
+	for (i = 0 ; i < deletedData.GetCount() ; i++)
+		deletedRows.Add(deletedData.Item(i));
+	deletedRows.Sort(ArrayCmp);
+	rowsDeleted += d;
+
+	// The remaining ones are lines added in the grid
+	for (i = deleted.GetCount() ; i > d ; i--)
+	{
+		addPool->Delete(deleted.Item(i - 1) - dataRows);
+		rowsAdded--;
+		rowsStored--;
+	}
+
+	// Tell the grid, one range of adjacent rows at a time (last to first)
+	if (GetView())
+	{
+		size_t end = deleted.GetCount();
+		while (end > 0)
+		{
+			size_t start = end - 1;
+			while (start > 0 && deleted.Item(start - 1) == deleted.Item(start) - 1)
+				start--;
+
+			wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_DELETED, deleted.Item(start), end - start);
+			GetView()->ProcessTableMessage(msg);
+
+			end = start;
+		}
+	}
+	return true;
+}
+
+
+void sqlTable::SetKeyset(const wxString &orderBy, bool ascending, long estimatedRows, wxEvtHandler *handler)
+{
+	// All the rows fit in the first page
+	if (!thread || nRows < KEYSET_PAGE_ROWS)
+		return;
+
+	keysetColumns = MakeKeyColumns();
+	if (keysetColumns.IsEmpty())
+		return;
+
+	// The first page has been read already; it tells us where to continue
+	pgSet *set = thread->DataSet();
+	set->MoveFirst();
+	wxString firstKey = MakeKeyValues(set);
+	set->MoveLast();
+	wxString lastKey = MakeKeyValues(set);
+
+	if (firstKey.IsEmpty() || lastKey.IsEmpty())
+		return;
+
+	keyset = true;
+	keysetAscending = ascending;
+	keysetOrder = orderBy;
+	keysetReverseOrder = orderBy;
+	if (ascending)
+	{
+		keysetReverseOrder.Replace(wxT(" ASC,"), wxT(" DESC,"));
+		keysetReverseOrder = keysetReverseOrder.BeforeLast(' ') + wxT(" DESC");
+	}
+	else
+	{
+		keysetReverseOrder.Replace(wxT(" DESC,"), wxT(" ASC,"));
+		keysetReverseOrder = keysetReverseOrder.BeforeLast(' ') + wxT(" ASC");
+	}
+	keysetQuery = wxT("SELECT ");
+	if (hasOids)
+		keysetQuery += wxT("oid, ");
+	keysetQuery += wxT("* FROM ") + tableName;
+
+	sqlKeysetPage *page = GetPage(0);
+	page->firstKey = firstKey;
+	page->lastKey = lastKey;
+	page->slots = page->limit = KEYSET_PAGE_ROWS;
+	page->lines = new cacheLinePool(KEYSET_PAGE_ROWS, nCols);
+	loadedPages.Add(0);
+
+	int i;
+	set->MoveFirst();
+	for (i = 0 ; i < nRows ; i++)
+	{
+		FillLine(page->lines->Get(i), set);
+		set->MoveNext();
+	}
+
+	delete thread;
+	thread = 0;
+	delete dataPool;
+	dataPool = 0;
+
+	// Until we know better, trust the statistics
+	rowCountExact = false;
+	nRows = pendingRows = (int)wxMax(estimatedRows, 2 * KEYSET_PAGE_ROWS);
+
+	placeholder.Alloc(nCols);
+	placeholder.stored = true;
+	placeholder.readOnly = true;
+
+	// The other pages are read on a connection of their own, which is
+	// opened by the loader, not to keep the user waiting for it. If that
+	// doesn't work out, they're read on this one, as they're needed.
+	loader = new sqlPageLoader(connection->Duplicate(wxEmptyString, wxEmptyString, 0, false), handler);
+	if (loader->Create() != wxTHREAD_NO_ERROR || loader->Run() != wxTHREAD_NO_ERROR)
+	{
+		delete loader;
+		loader = 0;
+	}
+}
+
+
+sqlPageLoader::sqlPageLoader(pgConn *_conn, wxEvtHandler *_handler)
+	: wxThread(wxTHREAD_JOINABLE), condition(mutex)
+{
+	conn = _conn;
+	handler = _handler;
+	failed = false;
+	stopping = false;
+}
+
+
+sqlPageLoader::~sqlPageLoader()
+{
+	size_t i;
+	for (i = 0 ; i < readSets.GetCount() ; i++)
+		delete (pgSet *)readSets.Item(i);
+
+	delete conn;
+}
+
+
+void *sqlPageLoader::Entry()
+{
+	bool connected = conn->Connect();
+
+	mutex.Lock();
+	failed = !connected;
+
+	while (!stopping)
+	{
+		if (queuedPages.IsEmpty())
+		{
+			condition.Wait();
+			continue;
+		}
+
+		int pageNo = queuedPages.Item(0);
+		wxString sql = queuedSql.Item(0);
+		queuedPages.RemoveAt(0);
+		queuedSql.RemoveAt(0);
+		mutex.Unlock();
+
+		pgSet *set = 0;
+		if (connected)
+		{
+			set = conn->ExecuteSet(sql, false);
+
+			// If the connection is lost, the pages are read on the grid's
+			// one from now on
+			if (conn->GetStatus() != PGCONN_OK)
+			{
+				connected = false;
+				if (set)
+					delete set;
+				set = 0;
+			}
+
+			// Look up the types now; the set is read on the main thread,
+			// while this one uses the connection
+			int col;
+			for (col = 0 ; set && col < set->NumCols() ; col++)
+				set->ColType(col);
+		}
+
+		mutex.Lock();
+		failed = !connected;
+		readPages.Add(pageNo);
+		readSets.Add(set);
+		condition.Broadcast();
+
+		wxCommandEvent ev(wxEVT_COMMAND_MENU_SELECTED, CTRLID_PAGELOADED);
+		handler->AddPendingEvent(ev);
+	}
+
+	mutex.Unlock();
+	return NULL;
+}
+
+
+void sqlPageLoader::Request(int pageNo, const wxString &sql, wxArrayInt &dropped)
+{
+	wxMutexLocker lock(mutex);
+
+	queuedPages.Insert(pageNo, 0);
+	queuedSql.Insert(wxString(sql.c_str()), 0);
+
+	while (queuedPages.GetCount() > KEYSET_MAX_QUEUED)
+	{
+		dropped.Add(queuedPages.Last());
+		queuedPages.RemoveAt(queuedPages.GetCount() - 1);
+		queuedSql.RemoveAt(queuedSql.GetCount() - 1);
+	}
+
+	condition.Broadcast();
+}
+
+
+bool sqlPageLoader::TakeResult(int &pageNo, pgSet *&set)
+{
+	wxMutexLocker lock(mutex);
+
+	if (readPages.IsEmpty())
+		return false;
+
+	pageNo = readPages.Item(0);
+	set = (pgSet *)readSets.Item(0);
+	readPages.RemoveAt(0);
+	readSets.RemoveAt(0);
+	return true;
+}
+
+
+// Wait for a page, which has been asked for, reading it next
+pgSet *sqlPageLoader::WaitResult(int pageNo)
+{
+	wxMutexLocker lock(mutex);
+
+	int pos = queuedPages.Index(pageNo);
+	if (pos > 0)
+	{
+		wxString sql = queuedSql.Item(pos);
+		queuedPages.RemoveAt(pos);
+		queuedSql.RemoveAt(pos);
+		queuedPages.Insert(pageNo, 0);
+		queuedSql.Insert(sql, 0);
+	}
+
+	while (!stopping)
+	{
+		pos = readPages.Index(pageNo);
+		if (pos != wxNOT_FOUND)
+		{
+			pgSet *set = (pgSet *)readSets.Item(pos);
+			readPages.RemoveAt(pos);
+			readSets.RemoveAt(pos);
+			return set;
+		}
+		condition.Wait();
+	}
+	return 0;
+}
+
+
+bool sqlPageLoader::Failed()
+{
+	wxMutexLocker lock(mutex);
+	return failed;
+}
+
+
+void sqlPageLoader::Stop()
+{
+	mutex.Lock();
+	stopping = true;
+	condition.Broadcast();
+	mutex.Unlock();
+
+	// Don't wait for the page being read
+	conn->CancelExecution();
+}
+
+
+sqlKeysetPage *sqlTable::GetPage(int pageNo)
+{
+	sqlKeysetPageMap::iterator it = pages.find(pageNo);
+	if (it != pages.end())
+		return it->second;
+
+	sqlKeysetPage *page = new sqlKeysetPage();
+	pages[pageNo] = page;
+	return page;
+}
+
+
+// The query reading a page, by the keys of the pages around it. A page,
+// which is closer to the end of the table (or to a page after it) than to
+// a page before it, is read backwards from there, so jumping to the end of
+// a big table doesn't make the server skip over all of it with OFFSET.
+wxString sqlTable::PageQuery(int pageNo)
+{
+	sqlKeysetPage *page = GetPage(pageNo);
+
+	wxString after = keysetAscending ? wxT(" > ") : wxT(" < ");
+	wxString before = keysetAscending ? wxT(" < ") : wxT(" > ");
+	wxString where;
+	long offset = 0;
+
+	int firstRow = pageNo * KEYSET_PAGE_ROWS;
+	page->readRows = pendingRows;
+
+	if (!page->firstKey.IsEmpty())
+	{
+		// Read again a page, which had to make room for others, the same
+		// way it's been read the first time
+		where = keysetColumns + (keysetAscending ? wxT(" >= ") : wxT(" <= ")) + page->firstKey +
+		        wxT(" AND ") + keysetColumns + (keysetAscending ? wxT(" <= ") : wxT(" >= ")) + page->lastKey;
+		page->bounded = true;
+	}
+	else
+	{
+		// The closest pages read before, on both sides
+		int prevNo = -1, nextNo = -1;
+		sqlKeysetPageMap::iterator it;
+		for (it = pages.begin() ; it != pages.end() ; ++it)
+		{
+			if (it->second->lastKey.IsEmpty())
+				continue;
+			if (it->first < pageNo && it->first > prevNo)
+				prevNo = it->first;
+			else if (it->first > pageNo && (nextNo < 0 || it->first < nextNo))
+				nextNo = it->first;
+		}
+
+		int startRow = prevNo >= 0 ? (prevNo + 1) * KEYSET_PAGE_ROWS : 0;
+		long forward = firstRow - startRow - DeletedBetween(startRow, firstRow);
+
+		int endRow = wxMin(firstRow + KEYSET_PAGE_ROWS, pendingRows);
+		int stopRow = nextNo >= 0 ? nextNo * KEYSET_PAGE_ROWS : pendingRows;
+		long backward = stopRow - endRow - DeletedBetween(endRow, stopRow);
+
+		page->bounded = false;
+		page->reversed = (endRow > firstRow && backward < forward);
+
+		if (page->reversed)
+		{
+			if (nextNo >= 0)
+				where = keysetColumns + before + pages[nextNo]->firstKey;
+			offset = backward;
+			page->fromEnd = (nextNo < 0 || pages[nextNo]->fromEnd);
+			page->slots = endRow - firstRow;
+		}
+		else
+		{
+			if (prevNo >= 0)
+				where = keysetColumns + after + pages[prevNo]->lastKey;
+			offset = forward;
+			page->fromEnd = (prevNo >= 0 && pages[prevNo]->fromEnd);
+			page->slots = KEYSET_PAGE_ROWS;
+
+			// Don't run into the next page, if we know where it starts
+			if (!offset && nextNo == pageNo + 1)
+			{
+				if (!where.IsEmpty())
+					where += wxT(" AND ");
+				where += keysetColumns + before + pages[nextNo]->firstKey;
+				page->bounded = true;
+			}
+		}
+		page->limit = page->slots - DeletedBetween(firstRow, firstRow + page->slots);
+	}
+
+	wxString sql = keysetQuery;
+	if (!where.IsEmpty())
+		sql += wxT(" WHERE ") + where;
+	sql += wxT("\n ORDER BY ") + (page->reversed ? keysetReverseOrder : keysetOrder) +
+	       wxT(" LIMIT ") + NumToStr(wxMax(page->limit, 1L));
+	if (offset > 0)
+		sql += wxT(" OFFSET ") + NumToStr(offset);
+
+	return sql;
+}
+
+
+// Put the rows read for a page in their place. If they couldn't be read,
+// the page is left unloaded, so it's read again when it's needed next time.
+bool sqlTable::FillPage(int pageNo, pgSet *set)
+{
+	sqlKeysetPage *page = GetPage(pageNo);
+	page->loading = false;
+
+	if (!set)
+		return false;
+
+	// The end of the table has moved since the page was asked for
+	if (page->fromEnd && page->readRows != pendingRows)
+	{
+		page->firstKey.Empty();
+		page->lastKey.Empty();
+		page->fromEnd = false;
+		delete set;
+		return false;
+	}
+
+	page->lines = new cacheLinePool(KEYSET_PAGE_ROWS, nCols);
+	page->lastUsed = ++pageUseCounter;
+	loadedPages.Add(pageNo);
+	EvictPages(pageNo);
+
+	// Skip the rows deleted since the page was read last time
+	int firstRow = pageNo * KEYSET_PAGE_ROWS;
+	int slot;
+	set->MoveFirst();
+
+	if (page->reversed)
+	{
+		size_t del = deletedRows.GetCount();
+		while (del > 0 && deletedRows.Item(del - 1) >= firstRow + page->slots)
+			del--;
+
+		for (slot = page->slots - 1 ; slot >= 0 && !set->Eof() ; slot--)
+		{
+			if (del > 0 && deletedRows.Item(del - 1) == firstRow + slot)
+			{
+				del--;
+				continue;
+			}
+
+			FillLine(page->lines->Get(slot), set);
+			set->MoveNext();
+		}
+	}
+	else
+	{
+		size_t del = 0;
+		while (del < deletedRows.GetCount() && deletedRows.Item(del) < firstRow)
+			del++;
+
+		for (slot = 0 ; slot < page->slots && !set->Eof() ; slot++)
+		{
+			if (del < deletedRows.GetCount() && deletedRows.Item(del) == firstRow + slot)
+			{
+				del++;
+				continue;
+			}
+
+			FillLine(page->lines->Get(slot), set);
+			set->MoveNext();
+		}
+	}
+
+	int numRows = set->NumRows();
+	if (page->firstKey.IsEmpty() && numRows > 0)
+	{
+		set->MoveFirst();
+		wxString key = MakeKeyValues(set);
+		set->MoveLast();
+		if (page->reversed)
+		{
+			page->lastKey = key;
+			page->firstKey = MakeKeyValues(set);
+		}
+		else
+		{
+			page->firstKey = key;
+			page->lastKey = MakeKeyValues(set);
+		}
+	}
+	delete set;
+
+	// Only reading forwards from the start of the table tells where it ends
+	if (!page->bounded && !page->reversed && !page->fromEnd)
+	{
+		if (numRows < page->limit)
+		{
+			// That's the end of the table; if the page is empty, it ends
+			// somewhere before.
+			if (numRows > 0)
+				SetPendingRows(firstRow + slot, true);
+			else if (pageNo == 0)
+				SetPendingRows(0, true);
+			else if (firstRow < pendingRows)
+				SetPendingRows(firstRow, false);
+		}
+		else if (!rowCountExact && firstRow + 2 * KEYSET_PAGE_ROWS > pendingRows)
+		{
+			// There's more to come than estimated
+			SetPendingRows(firstRow + 2 * KEYSET_PAGE_ROWS, false);
+		}
+	}
+	return true;
+}
+
+
+// Read a page right away, on the connection of the grid
+bool sqlTable::LoadPage(int pageNo)
+{
+	wxString sql = PageQuery(pageNo);
+	return FillPage(pageNo, connection->ExecuteSet(sql));
+}
+
+
+// Read a page in the background; the grid is refreshed, when it's there
+void sqlTable::RequestPage(int pageNo)
+{
+	if (!loader || loader->Failed())
+	{
+		LoadPage(pageNo);
+		return;
+	}
+
+	GetPage(pageNo)->loading = true;
+
+	wxArrayInt dropped;
+	loader->Request(pageNo, PageQuery(pageNo), dropped);
+
+	size_t i;
+	for (i = 0 ; i < dropped.GetCount() ; i++)
+		GetPage(dropped.Item(i))->loading = false;
+}
+
+
+void sqlTable::PageLoaded()
+{
+	if (!loader)
+		return;
+
+	bool arrived = false;
+	int pageNo;
+	pgSet *set;
+	while (loader->TakeResult(pageNo, set))
+	{
+		if (set)
+			arrived = true;
+		FillPage(pageNo, set);
+	}
+
+	// The pages, which couldn't be read, aren't asked for again until
+	// the user gets there, rather than on every refresh
+	if (arrived && GetView())
+		GetView()->ForceRefresh();
+}
+
+
+// The page of the line being edited, which must stay
+int sqlTable::EditedPage()
+{
+	if (lastRow >= 0 && lastRow < nRows - rowsDeleted)
+		return DataRow(lastRow) / KEYSET_PAGE_ROWS;
+	return -1;
+}
+
+
+// The number of rows of the dataSet from from to to (exclusive), which
+// have been deleted
+int sqlTable::DeletedBetween(int from, int to)
+{
+	int count = 0;
+	size_t i;
+	for (i = 0 ; i < deletedRows.GetCount() && deletedRows.Item(i) < to ; i++)
+	{
+		if (deletedRows.Item(i) >= from)
+			count++;
+	}
+	return count;
+}
+
+
+// Drop the least recently used pages, until there are no more than
+// KEYSET_MAX_PAGES in memory
+void sqlTable::EvictPages(int keepPage)
+{
+	int editedPage = EditedPage();
+
+	while (loadedPages.GetCount() > KEYSET_MAX_PAGES)
+	{
+		int victim = -1;
+		size_t i;
+
+		for (i = 0 ; i < loadedPages.GetCount() ; i++)
+		{
+			int pageNo = loadedPages.Item(i);
+			if (pageNo == keepPage || pageNo == editedPage)
+				continue;
+			if (victim < 0 || pages[pageNo]->lastUsed < pages[loadedPages.Item(victim)]->lastUsed)
+				victim = (int)i;
+		}
+
+		if (victim < 0)
+			break;
+
+		sqlKeysetPage *page = pages[loadedPages.Item(victim)];
+		delete page->lines;
+		page->lines = 0;
+		loadedPages.RemoveAt(victim);
+	}
+}
+
+
+// The pages counted from the end of the table are out of place, once the
+// end has moved; they're read again where they are now. The ones being
+// read are dropped, when they arrive.
+void sqlTable::ForgetEndPages()
+{
+	int editedPage = EditedPage();
+
+	sqlKeysetPageMap::iterator it;
+	for (it = pages.begin() ; it != pages.end() ; ++it)
+	{
+		sqlKeysetPage *page = it->second;
+		if (!page->fromEnd || page->loading || it->first == editedPage)
+			continue;
+
+		if (page->lines)
+		{
+			delete page->lines;
+			page->lines = 0;
+			loadedPages.Remove(it->first);
+		}
+		page->firstKey.Empty();
+		page->lastKey.Empty();
+		page->fromEnd = false;
+	}
+}
+
+
+// The key of the current row of the set
+wxString sqlTable::MakeKeyValues(pgSet *set)
+{
+	cacheLine line;
+	line.Alloc(nCols);
+	FillLine(&line, set);
+
+	return MakeKeyValues(&line);
+}
+
+
+void sqlTable::SetPendingRows(int rows, bool exact)
+{
+	if (rows != pendingRows)
+	{
+		pendingRows = rows;
+		ForgetEndPages();
+	}
+	rowCountExact = exact;
+
+	// The grid mustn't change while it's being drawn; it will be told later on
+	if (GetView())
+	{
+		wxCommandEvent ev(wxEVT_COMMAND_MENU_SELECTED, CTRLID_ROWCOUNT);
+		GetView()->GetParent()->GetEventHandler()->AddPendingEvent(ev);
+	}
+}
+
+
+void sqlTable::SetExactRowCount(long rows)
+{
+	// Reaching the end of the table tells better than the count did
+	if (!keyset || rowCountExact)
+		return;
+
+	SetPendingRows((int)rows, true);
+}
+
+
+// Tell the grid about the rows found (or not found) since the last time
+void sqlTable::SyncRowCount()
+{
+	if (pendingRows == nRows || !GetView())
+		return;
+
+	int dataRows = nRows - rowsDeleted;
+
+	if (pendingRows > nRows)
+	{
+		int added = pendingRows - nRows;
+		if (lastRow >= dataRows)
+			lastRow += added;
+		nRows = pendingRows;
+
+		wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_INSERTED, dataRows, added);
+		GetView()->ProcessTableMessage(msg);
+	}
+	else
+	{
+		// Forget the rows beyond the end, including the deleted ones
+		int removed = nRows - pendingRows;
+		while (!deletedRows.IsEmpty() && deletedRows.Last() >= pendingRows)
+		{
+			deletedRows.RemoveAt(deletedRows.GetCount() - 1);
+			rowsDeleted--;
+			removed--;
+		}
+
+		int pos = pendingRows - rowsDeleted;
+		if (lastRow >= dataRows)
+			lastRow -= removed;
+		else if (lastRow >= pos)
+			lastRow = -1;
+		nRows = pendingRows;
+
+		if (removed > 0)
+		{
+			wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_DELETED, pos, removed);
+			GetView()->ProcessTableMessage(msg);
+		}
+	}
+}
+
+
+// Read the page the user is heading to, before it's needed
+void sqlTable::Prefetch()
+{
+	if (!keyset || prefetchPage < 0)
+		return;
+
+	int pageNo = prefetchPage;
+	prefetchPage = -1;
+
+	if (pageNo * KEYSET_PAGE_ROWS >= pendingRows)
+		return;
+
+	sqlKeysetPage *page = GetPage(pageNo);
+	if (!page->lines && !page->loading)
+		RequestPage(pageNo);
+}
+
+
+bool sqlTable::Paste()
+{
+	int row, col;
+	int start, pos, len;
+	wxArrayString data;
+	wxString text, quoteChar, colSep;
+	bool inQuotes, inData, skipSerial;
+
+	if (!this)
+		return false;
+
+	if (wxTheClipboard->Open())
 	{
 		if (wxTheClipboard->IsSupported(wxDF_TEXT))
 		{
@@ -3290,7 +4374,7 @@ wxGridCellAttr *sqlTable::GetAttr(int row, int col, wxGridCellAttr::wxAttrKind
 	else
 		attrDefault =  ( row % 2 ) ? columns[col].attrEven : columns[col].attrOdd;
 
-	cacheLine *line = GetLine(row);
+	cacheLine *line = GetLine(row, false);
 	if (line && line->readOnly)
 	{
 		wxGridCellAttr *attr = new wxGridCellAttr(attrDefault);
@@ -3393,8 +4477,156 @@ sqlCellAttr::~sqlCellAttr()
 }
 
 
-cacheLinePool::cacheLinePool(int initialLines)
+void cacheLine::Alloc(int nCols)
 {
+	cols = new wxString[nCols];
+	nulls = new bool[nCols];
+	memset(nulls, 0, sizeof(bool) * nCols);
+}
+
+
+void cacheLine::Clear()
+{
+	if (cols)
+		delete[] cols;
+	if (nulls)
+		delete[] nulls;
+
+	cols = 0;
+	nulls = 0;
+	filled = false;
+	stored = false;
+	readOnly = false;
+}
+
+
+wxString cacheLine::GetCol(int col) const
+{
+	if (cols)
+		return cols[col];
+	if (!filled || !cells[col].length)
+		return wxEmptyString;
+
+	return wxString(cells[col].value, cells[col].length);
+}
+
+
+bool cacheLine::IsNull(int col) const
+{
+	if (cols)
+		return nulls && nulls[col];
+	if (filled)
+		return cells[col].isNull;
+
+	return false;
+}
+
+
+void cacheLine::SetCol(int col, const wxString &value)
+{
+	// The arena is append-only, so a line to be changed gets its own copy
+	if (!cols)
+	{
+		wxASSERT(slab);
+
+		int nCols = slab->nCols;
+		wxString *values = new wxString[nCols];
+		bool *isNull = new bool[nCols];
+
+		int i;
+		for (i = 0 ; i < nCols ; i++)
+		{
+			values[i] = GetCol(i);
+			isNull[i] = IsNull(i);
+		}
+		cols = values;
+		nulls = isNull;
+	}
+	cols[col] = value;
+}
+
+
+void cacheLine::StoreCol(int col, const wxString &value, bool isNull)
+{
+	if (cols)
+	{
+		cols[col] = value;
+		nulls[col] = isNull;
+		return;
+	}
+
+	wxASSERT(slab);
+
+	cells[col].value = slab->Store(value);
+	cells[col].length = value.Length();
+	cells[col].isNull = isNull;
+	filled = true;
+}
+
+
+cacheLineSlab::cacheLineSlab(int _nCols)
+{
+	nCols = _nCols;
+	used = 0;
+	chunkPos = 0;
+	chunkFree = 0;
+
+	cells = new cacheCell[CACHELINE_SLAB_LINES * nCols];
+
+	int i;
+	for (i = 0 ; i < CACHELINE_SLAB_LINES ; i++)
+	{
+		lines[i].slab = this;
+		lines[i].cells = cells + i * nCols;
+	}
+}
+
+
+cacheLineSlab::~cacheLineSlab()
+{
+	size_t i;
+	for (i = 0 ; i < chunks.GetCount() ; i++)
+		delete[] (wxChar *)chunks.Item(i);
+
+	delete[] cells;
+}
+
+
+const wxChar *cacheLineSlab::Store(const wxString &value)
+{
+	size_t len = value.Length();
+	if (!len)
+		return 0;
+
+	wxChar *dest;
+	if (len > CACHELINE_CHUNK_CHARS / 4)
+	{
+		// Big values get a chunk of their own, not to waste the current one
+		dest = new wxChar[len];
+		chunks.Add(dest);
+	}
+	else
+	{
+		if (len > chunkFree)
+		{
+			chunkPos = new wxChar[CACHELINE_CHUNK_CHARS];
+			chunkFree = CACHELINE_CHUNK_CHARS;
+			chunks.Add(chunkPos);
+		}
+		dest = chunkPos;
+		chunkPos += len;
+		chunkFree -= len;
+	}
+
+	const wxChar *src = value.c_str();
+	memcpy(dest, src, len * sizeof(wxChar));
+	return dest;
+}
+
+
+cacheLinePool::cacheLinePool(int initialLines, int _nCols)
+{
+	nCols = _nCols;
 	ptr = new cacheLine*[initialLines];
 	if (ptr)
 	{
@@ -3413,14 +4645,10 @@ cacheLinePool::cacheLinePool(int initialLines)
 cacheLinePool::~cacheLinePool()
 {
 	if (ptr)
-	{
-		while (anzLines--)
-		{
-			if (ptr[anzLines])
-				delete ptr[anzLines];
-		}
 		delete[] ptr;
-	}
+
+	// The lines belong to the slabs
+	WX_CLEAR_ARRAY(slabs);
 }
 
 
@@ -3429,21 +4657,17 @@ void cacheLinePool::Delete(int lineNo)
 {
 	if (ptr && lineNo >= 0 && lineNo < anzLines)
 	{
-#if 1
 		if (ptr[lineNo])
-			delete ptr[lineNo];
+		{
+			ptr[lineNo]->Clear();
+			freeLines.Add(ptr[lineNo]);
+		}
 
 		if (lineNo < anzLines - 1)
 		{
 			// beware: overlapping copy
 			memmove(ptr + lineNo, ptr + lineNo + 1, sizeof(cacheLine *) * (anzLines - lineNo - 1));
 		}
-#else
-		cacheLine *c;
-		c = ptr[0];
-		ptr[0] = ptr[1];
-		ptr[1] = c;
-#endif
 		ptr[anzLines - 1] = 0;
 	}
 }
@@ -3457,7 +4681,7 @@ cacheLine *cacheLinePool::Get(int lineNo)
 	{
 		cacheLine **old = ptr;
 		int oldAnz = anzLines;
-		anzLines = lineNo + 100;
+		anzLines = wxMax(lineNo + 100, oldAnz * 2);
 		ptr = new cacheLine*[anzLines];
 		if (!ptr)
 		{
@@ -3471,14 +4695,14 @@ cacheLine *cacheLinePool::Get(int lineNo)
 				memcpy(ptr, old, sizeof(cacheLine *)*oldAnz);
 				delete[] old;
 			}
-			memset(ptr + oldAnz, 0, anzLines - oldAnz);
+			memset(ptr + oldAnz, 0, sizeof(cacheLine *) * (anzLines - oldAnz));
 		}
 	}
 
 	if (lineNo < anzLines)
 	{
 		if (!ptr[lineNo])
-			ptr[lineNo] = new cacheLine();
+			ptr[lineNo] = NewLine();
 		return ptr[lineNo];
 	}
 	return 0;
@@ -3487,7 +4711,25 @@ cacheLine *cacheLinePool::Get(int lineNo)
 
 bool cacheLinePool::IsFilled(int lineNo)
 {
-	return (lineNo < anzLines && ptr[lineNo]);
+	return (lineNo < anzLines && ptr[lineNo] && ptr[lineNo]->IsFilled());
+}
+
+
+// Take a line from a slab, rather than allocating each one on its own
+cacheLine *cacheLinePool::NewLine()
+{
+	if (!freeLines.IsEmpty())
+	{
+		cacheLine *line = (cacheLine *)freeLines.Last();
+		freeLines.RemoveAt(freeLines.GetCount() - 1);
+		return line;
+	}
+
+	if (slabs.IsEmpty() || slabs.Last()->used == CACHELINE_SLAB_LINES)
+		slabs.Add(new cacheLineSlab(nCols));
+
+	cacheLineSlab *slab = slabs.Last();
+	return &slab->lines[slab->used++];
 }
 
 
@@ -14,10 +14,13 @@
 // App headers
 #include "pgAdmin3.h"
 #include <wx/file.h>
+#include <wx/progdlg.h>
 #include "frm/frmExport.h"
 #include "utils/sysSettings.h"
 #include "utils/misc.h"
 #include "ctl/ctlSQLResult.h"
+#include "db/pgRowStore.h"
+#include "db/pgResultView.h"
 
 #define txtFilename     CTRL_TEXT("txtFilename")
 #define btnOK           CTRL_BUTTON("wxID_OK")
@@ -31,6 +34,7 @@
 #define chkColnames     CTRL_CHECKBOX("chkColnames")
 #define cbColSeparator  CTRL_COMBOBOX("cbColSeparator")
 #define cbQuoteChar     CTRL_COMBOBOX("cbQuoteChar")
+#define chkUseCopy      CTRL_CHECKBOX("chkUseCopy")
 
 
 BEGIN_EVENT_TABLE(frmExport, pgDialog)
@@ -45,10 +49,34 @@ BEGIN_EVENT_TABLE(frmExport, pgDialog)
 END_EVENT_TABLE()
 
 
+// wxMemoryBuffer only grows by a fixed amount at a time
+static void AppendToBuffer(wxMemoryBuffer &buffer, const char *data, size_t len)
+{
+	size_t used = buffer.GetDataLen();
+
+	if (used + len > buffer.GetBufSize())
+	{
+		buffer.GetWriteBuf(wxMax(buffer.GetBufSize() * 2, used + len));
+		buffer.UngetWriteBuf(used);
+	}
+	buffer.AppendData(data, len);
+}
+
+
+// The separators etc. in the encoding of the file
+static wxCharBuffer ToFileConv(const wxString &str, wxMBConv &conv)
+{
+	wxCharBuffer buf = str.mb_str(conv);
+	if (!buf)
+		buf = str.mb_str(wxConvUTF8);
+	return buf;
+}
+
 
-frmExport::frmExport(wxWindow *p)
+frmExport::frmExport(wxWindow *p, bool _allowCopy)
 {
 	parent = p;
+	allowCopy = _allowCopy;
 
 	SetFont(settings->GetSystemFont());
 	LoadResource(p, wxT("frmExport"));
@@ -79,6 +107,10 @@ frmExport::frmExport(wxWindow *p)
 
 	cbQuoteChar->SetValue(settings->GetExportQuoteChar());
 
+	// COPY is only possible, if we're given the query to run
+	chkUseCopy->SetValue(allowCopy && settings->GetExportUseCopy());
+	chkUseCopy->Enable(allowCopy);
+
 	wxString val;
 	settings->Read(wxT("Export/LastFile"), &val, wxEmptyString);
 	txtFilename->SetValue(val);
@@ -121,6 +153,8 @@ void frmExport::OnOK(wxCommandEvent &ev)
 		settings->SetExportQuoting(0);
 
 	settings->SetExportQuoteChar(cbQuoteChar->GetValue());
+	if (allowCopy)
+		settings->SetExportUseCopy(chkUseCopy->GetValue());
 
 	settings->Write(wxT("Export/LastFile"), txtFilename->GetValue());
 
@@ -133,16 +167,26 @@ void frmExport::OnOK(wxCommandEvent &ev)
 
 
 
-bool frmExport::Export(pgSet *set)
+bool frmExport::Export(pgSet *set, ctlSQLResult *grid)
 {
-	ctlSQLResult *grid = 0;
+	pgRowStore *store = 0;
 	if (!set)
 	{
 		wxLogInfo(wxT("Exporting data from the grid"));
-		grid = (ctlSQLResult *)parent;
+		if (!grid)
+			grid = (ctlSQLResult *)parent;
+
+		set = grid->GetDataSet();
+		if (!set)
+			store = grid->GetRowStore();
+		if (!set && !store)
+			return false;
 	}
 	else
+	{
 		wxLogInfo(wxT("Exporting data from a resultset"));
+		grid = 0;
+	}
 
 	wxFile file(txtFilename->GetValue(), wxFile::write);
 	if (!file.IsOpened())
@@ -155,7 +199,8 @@ bool frmExport::Export(pgSet *set)
 	long skipped = 0;
 	wxWX2MBbuf buf;
 
-	int colCount, rowCount;
+	int colCount;
+	long rowCount;
 
 	if (set)
 	{
@@ -164,10 +209,15 @@ bool frmExport::Export(pgSet *set)
 	}
 	else
 	{
-		colCount = grid->GetNumberCols();
-		rowCount = grid->NumRows();
+		colCount = store->NumCols();
+		rowCount = store->NumRows();
 	}
 
+	// Export what the grid shows
+	pgResultView *view = grid ? grid->GetResultView() : NULL;
+	if (view)
+		rowCount = view->NumRows();
+
 	int col;
 	if (chkColnames->GetValue())
 	{
@@ -178,26 +228,21 @@ bool frmExport::Export(pgSet *set)
 			else
 				line += cbColSeparator->GetValue();
 
+			wxString hdr;
+			if (set)
+				hdr = set->ColName(col);
+			else
+				hdr = store->ColName(col);
+
 			if (rbQuoteStrings->GetValue() || rbQuoteAll->GetValue())
 			{
 				wxString qc = cbQuoteChar->GetValue();
 
-				wxString hdr;
-				if (set)
-					hdr = set->ColName(col);
-				else
-					hdr = grid->OnGetItemText(-1, col + 1).BeforeFirst('\n');
-
 				hdr.Replace(qc, qc + qc);
 				line += qc + hdr + qc;
 			}
 			else
-			{
-				if (set)
-					line += set->ColName(col);
-				else
-					line += grid->OnGetItemText(-1, col + 1).BeforeFirst('\n');
-			}
+				line += hdr;
 		}
 		if (rbCRLF->GetValue())
 			line += wxT("\r\n");
@@ -216,76 +261,182 @@ bool frmExport::Export(pgSet *set)
 		}
 	}
 
+	exportJob job(set, store, rowCount, colCount);
+	job.view = view;
 
-	wxString text;
-	OID typOid;
+	job.colSeparator = cbColSeparator->GetValue();
+	job.quoteChar = cbQuoteChar->GetValue();
+	job.rowSeparator = rbCRLF->GetValue() ? wxT("\r\n") : wxT("\n");
+	if (rbUnicode->GetValue())
+		job.fileConv = &wxConvUTF8;
+	else
+		job.fileConv = &wxConvLibc;
 
-	int row;
-	for (row = 0 ; row < rowCount ; row++)
+	for (col = 0 ; col < colCount ; col++)
 	{
-		for (col = 0 ; col < colCount ; col++)
+		bool needQuote = rbQuoteAll->GetValue();
+
+		if (!needQuote && rbQuoteStrings->GetValue())
 		{
-			if (!col)
-				line = wxEmptyString;
+			// find out if string
+			long typClass;
+			if (grid)
+				typClass = grid->colTypClasses[col];
 			else
-				line += cbColSeparator->GetValue();
+				typClass = set->ColTypClass(col);
 
-			bool needQuote = rbQuoteAll->GetValue();
-
-			if (set)
+			switch (typClass)
 			{
-				text = set->GetVal(col);
-				typOid = set->ColTypClass(col);
-			}
-			else
-			{
-				text = grid->OnGetItemText(row, col + 1);
-				typOid = grid->colTypClasses[col];
+				case PGTYPCLASS_NUMERIC:
+				case PGTYPCLASS_BOOL:
+					break;
+				default:
+					needQuote = true;
+					break;
 			}
+		}
+		job.quoteCols.Add(needQuote && !job.quoteChar.IsEmpty() ? 1 : 0);
+	}
 
-			if (!needQuote && rbQuoteStrings->GetValue())
-			{
-				// find out if string
-				switch (typOid)
-				{
-					case PGTYPCLASS_NUMERIC:
-					case PGTYPCLASS_BOOL:
-						break;
-					default:
-						needQuote = true;
-						break;
-				}
-			}
-			if (needQuote)
+	bool done = job.Run(file, parent, skipped);
+	file.Close();
+
+	if (!done)
+		return false;
+
+	if (skipped)
+		wxLogError(wxPLURAL(
+		               "Data export incomplete.\n\n%d row contained characters that could not be converted to the local charset.\n\nPlease correct the data or try using UTF8 instead.",
+		               "Data export incomplete.\n\n%d rows contained characters that could not be converted to the local charset.\n\nPlease correct the data or try using UTF8 instead.",
+		               skipped), skipped);
+	else
+		wxMessageBox(_("Data export completed successfully."), _("Export data"), wxICON_INFORMATION | wxOK);
+
+	return true;
+}
+
+
+wxString frmExport::StripQuery(const wxString &query)
+{
+	wxString stripped = query;
+
+	stripped.Trim(false);
+	stripped.Trim(true);
+	while (stripped.EndsWith(wxT(";")))
+	{
+		stripped.RemoveLast();
+		stripped.Trim(true);
+	}
+	return stripped;
+}
+
+
+bool frmExport::CanUseCopy(pgConn *conn, const wxString &query)
+{
+	if (!allowCopy || !chkUseCopy->GetValue())
+		return false;
+
+	// COPY only accepts single byte delimiters and quotes
+	wxString separator = cbColSeparator->GetValue();
+	wxString quote = cbQuoteChar->GetValue();
+
+	if (separator.Length() != 1 || (wxChar)separator[0] > 127)
+		return false;
+	if (!rbQuoteNone->GetValue() && (quote.Length() != 1 || (wxChar)quote[0] > 127))
+		return false;
+	if (rbQuoteAll->GetValue() && !conn->BackendMinimumVersion(9, 0))
+		return false;
+
+	// It has to be a single query returning rows
+	wxString stripped = StripQuery(query);
+	if (stripped.Find(';') != wxNOT_FOUND)
+		return false;
+
+	size_t wordlen = 0;
+	while (wordlen < stripped.Length() && wxIsalpha(stripped.GetChar(wordlen)))
+		wordlen++;
+
+	wxString keyword = stripped.Left(wordlen);
+	return keyword.CmpNoCase(wxT("select")) == 0 || keyword.CmpNoCase(wxT("with")) == 0 ||
+	       keyword.CmpNoCase(wxT("values")) == 0 || keyword.CmpNoCase(wxT("table")) == 0;
+}
+
+
+// Have the server run the query and format the rows, which are written to
+// the file as they arrive. The CSV quoting rules of COPY apply, i.e. only
+// the values requiring it are quoted, unless all columns are to be quoted.
+bool frmExport::ExportCopy(pgConn *conn, const wxString &query)
+{
+	wxLogInfo(wxT("Exporting data using COPY"));
+
+	wxFile file(txtFilename->GetValue(), wxFile::write);
+	if (!file.IsOpened())
+	{
+		wxLogError(__("Failed to open file %s."), txtFilename->GetValue().c_str());
+		return false;
+	}
+
+	wxString sql = wxT("COPY (") + StripQuery(query) + wxT(") TO STDOUT WITH CSV");
+	if (chkColnames->GetValue())
+		sql += wxT(" HEADER");
+	sql += wxT(" DELIMITER AS ") + conn->qtDbString(cbColSeparator->GetValue());
+	if (!rbQuoteNone->GetValue())
+		sql += wxT(" QUOTE AS ") + conn->qtDbString(cbQuoteChar->GetValue());
+	if (rbQuoteAll->GetValue())
+		sql += wxT(" FORCE QUOTE *");
+
+	if (!conn->StartCopyOut(sql))
+		return false;
+
+	wxMBConv *fileConv;
+	if (rbUnicode->GetValue())
+		fileConv = &wxConvUTF8;
+	else
+		fileConv = &wxConvLibc;
+
+	exportCopyReader reader(conn, file, fileConv, rbCRLF->GetValue() ? wxT("\r\n") : wxT("\n"));
+
+	// The data must be read in any case, on the UI thread if need be
+	if (reader.Create() != wxTHREAD_NO_ERROR || reader.Run() != wxTHREAD_NO_ERROR)
+		reader.Entry();
+	else
+	{
+		wxProgressDialog progress(_("Export data"), _("Writing data."), 100, parent,
+		                          wxPD_APP_MODAL | wxPD_CAN_ABORT | wxPD_AUTO_HIDE | wxPD_ELAPSED_TIME);
+		bool cancelled = false;
+		long rows = 0;
+
+		while (!reader.WaitDone(100, rows))
+		{
+			if (!cancelled && !progress.Pulse(wxString::Format(wxPLURAL("%ld row written.", "%ld rows written.", rows), rows)))
 			{
-				wxString qc = cbQuoteChar->GetValue();
-				text.Replace(qc, qc + qc);
-				line += qc + text + qc;
+				cancelled = true;
+				reader.Cancel();
 			}
-			else
-				line += text;
 		}
-		if (rbCRLF->GetValue())
-			line += wxT("\r\n");
-		else
-			line += wxT("\n");
+		reader.Wait();
 
-		if (rbUnicode->GetValue())
-			file.Write(line, wxConvUTF8);
-		else
+		if (cancelled)
 		{
-			buf = line.mb_str(wxConvLibc);
-			if (!buf)
-				skipped++;
-			else
-				file.Write(line, wxConvLibc);
+			// Don't complain about the error of the cancelled COPY, but read
+			// it, so that the connection can be used again
+			file.Close();
+			conn->GetCopyFinalStatus(false);
+			return false;
 		}
-
-		if (set)
-			set->MoveNext();
 	}
 	file.Close();
 
+	if (reader.WriteFailed())
+	{
+		wxLogError(_("Failed to write the data to the file."));
+		conn->GetCopyFinalStatus(false);
+		return false;
+	}
+	if (!conn->GetCopyFinalStatus())
+		return false;
+
+	long skipped = reader.GetSkipped();
 	if (skipped)
 		wxLogError(wxPLURAL(
 		               "Data export incomplete.\n\n%d row contained characters that could not be converted to the local charset.\n\nPlease correct the data or try using UTF8 instead.",
@@ -333,3 +484,514 @@ void frmExport::OnBrowseFile(wxCommandEvent &ev)
 		OnChange(ev);
 	}
 }
+
+
+
+//////////////////////////////////////////////////////////////////////////
+// Export engine
+//////////////////////////////////////////////////////////////////////////
+
+exportJob::exportJob(pgSet *_set, pgRowStore *_store, long _rowCount, int _colCount)
+	: condition(mutex)
+{
+	set = _set;
+	store = _store;
+	rowCount = _rowCount;
+	colCount = _colCount;
+	format = EXPORT_FORMAT_TEXT;
+	fileConv = &wxConvUTF8;
+	firstRow = 0;
+	rowList = NULL;
+	view = NULL;
+	displayFormat = NULL;
+	copyRaw = false;
+
+	numChunks = 0;
+	nextChunk = 0;
+	writtenChunks = 0;
+	numSlots = 0;
+	slots = NULL;
+	cancelled = false;
+}
+
+
+exportJob::~exportJob()
+{
+	if (slots)
+		delete[] slots;
+}
+
+
+bool exportJob::Run(wxFile &file, wxWindow *parent, long &skipped)
+{
+	return RunChunks(&file, NULL, parent, skipped);
+}
+
+
+bool exportJob::Run(wxMemoryBuffer &buffer, wxWindow *parent, long &skipped)
+{
+	return RunChunks(NULL, &buffer, parent, skipped);
+}
+
+
+bool exportJob::RunChunks(wxFile *file, wxMemoryBuffer *buffer, wxWindow *parent, long &skipped)
+{
+	// The values of a UTF-8 result set can go to a UTF-8 file as they are
+	copyRaw = set && fileConv == &wxConvUTF8 && &set->GetConversion() == &wxConvUTF8 &&
+	          format != EXPORT_FORMAT_DISPLAY;
+
+	rawRowPrefix = ToFileConv(rowPrefix, *fileConv);
+	rawColSeparator = ToFileConv(colSeparator, *fileConv);
+	rawQuoteChar = ToFileConv(quoteChar, *fileConv);
+	rawRowSeparator = ToFileConv(rowSeparator, *fileConv);
+
+	numChunks = (rowCount + EXPORT_CHUNK_ROWS - 1) / EXPORT_CHUNK_ROWS;
+	nextChunk = 0;
+	writtenChunks = 0;
+	cancelled = false;
+
+	int numWorkers = 0;
+	if (numChunks > 1)
+		numWorkers = wxMin(wxMax(wxThread::GetCPUCount(), 1), EXPORT_MAX_WORKERS);
+
+	// Two chunks per worker: one being formatted, one waiting to be written
+	numSlots = numWorkers ? numWorkers * 2 : 1;
+	slots = new exportChunk[numSlots];
+	for (int i = 0; i < numSlots; i++)
+	{
+		slots[i].chunk = -1;
+		slots[i].skipped = 0;
+		slots[i].ready = false;
+	}
+
+	exportWorker *workers[EXPORT_MAX_WORKERS];
+	int started = 0;
+
+	for (int i = 0; i < numWorkers; i++)
+	{
+		exportWorker *worker = new exportWorker(this);
+		if (worker->Create() != wxTHREAD_NO_ERROR || worker->Run() != wxTHREAD_NO_ERROR)
+		{
+			delete worker;
+			break;
+		}
+		workers[started++] = worker;
+	}
+
+	wxProgressDialog *progress = NULL;
+	if (numChunks > 1)
+		progress = new wxProgressDialog(file ? _("Export data") : _("Copy data"),
+		                                file ? _("Writing data.") : _("Copying data."), (int)numChunks, parent,
+		                                wxPD_APP_MODAL | wxPD_CAN_ABORT | wxPD_AUTO_HIDE | wxPD_ELAPSED_TIME | wxPD_REMAINING_TIME);
+
+	bool ok = true;
+	for (long chunk = 0; chunk < numChunks && ok; chunk++)
+	{
+		exportChunk *slot = &slots[chunk % numSlots];
+
+		if (!started)
+		{
+			slot->chunk = chunk;
+			FormatChunk(chunk);
+		}
+		else
+		{
+			mutex.Lock();
+			while (!(slot->ready && slot->chunk == chunk))
+			{
+				condition.WaitTimeout(100);
+
+				// Keep the progress dialog alive, without blocking the workers
+				mutex.Unlock();
+				if (progress && !progress->Update((int)chunk))
+					ok = false;
+				mutex.Lock();
+
+				if (!ok)
+					break;
+			}
+			mutex.Unlock();
+
+			if (!ok)
+				break;
+		}
+
+		ok = WriteChunk(file, buffer, slot);
+		skipped += slot->skipped;
+
+		mutex.Lock();
+		slot->ready = false;
+		slot->chunk = -1;
+		writtenChunks++;
+		condition.Broadcast();
+		mutex.Unlock();
+
+		if (ok && progress && !progress->Update((int)chunk + 1))
+			ok = false;
+	}
+
+	// Stop the workers
+	mutex.Lock();
+	cancelled = true;
+	condition.Broadcast();
+	mutex.Unlock();
+
+	for (int i = 0; i < started; i++)
+	{
+		workers[i]->Wait();
+		delete workers[i];
+	}
+
+	if (progress)
+		delete progress;
+
+	return ok;
+}
+
+
+bool exportJob::WriteChunk(wxFile *file, wxMemoryBuffer *buffer, exportChunk *slot)
+{
+	size_t len = slot->data.GetDataLen();
+
+	if (!len)
+		return true;
+
+	if (buffer)
+	{
+		// Make room for all the chunks at once, judging by the first one
+		if (!buffer->GetDataLen())
+		{
+			buffer->GetWriteBuf(len * numChunks + 1);
+			buffer->UngetWriteBuf(0);
+		}
+		AppendToBuffer(*buffer, (const char *)slot->data.GetData(), len);
+		return true;
+	}
+
+	if (file->Write(slot->data.GetData(), len) != len)
+	{
+		wxLogError(_("Failed to write the data to the file."));
+		return false;
+	}
+	return true;
+}
+
+
+bool exportJob::ClaimChunk(long &chunk)
+{
+	wxMutexLocker lock(mutex);
+
+	// Don't get too far ahead of the UI thread writing the file
+	while (!cancelled && nextChunk < numChunks && nextChunk - writtenChunks >= numSlots)
+		condition.Wait();
+
+	if (cancelled || nextChunk >= numChunks)
+		return false;
+
+	chunk = nextChunk++;
+	slots[chunk % numSlots].chunk = chunk;
+	slots[chunk % numSlots].ready = false;
+
+	return true;
+}
+
+
+void exportJob::ChunkDone(long chunk)
+{
+	wxMutexLocker lock(mutex);
+
+	slots[chunk % numSlots].ready = true;
+	condition.Broadcast();
+}
+
+
+void exportJob::FormatChunk(long chunk)
+{
+	exportChunk *out = &slots[chunk % numSlots];
+	long first = chunk * EXPORT_CHUNK_ROWS;
+	long last = wxMin(first + EXPORT_CHUNK_ROWS, rowCount);
+
+	// Reuse the memory of the previous chunk in this slot
+	out->data.SetDataLen(0);
+	out->skipped = 0;
+
+	for (long i = first ; i < last ; i++)
+	{
+		long row = rowList ? rowList->Item(i) : firstRow + i;
+
+		if (view)
+			row = view->SourceRow(row);
+		FormatRow(row, out);
+	}
+}
+
+
+// Runs in a worker thread: only use the shared strings read-only.
+void exportJob::FormatRow(long row, exportChunk *out)
+{
+	size_t rowStart = out->data.GetDataLen();
+	const char *colSep = rawColSeparator.data();
+	size_t colSepLen = strlen(colSep);
+
+	AppendToBuffer(out->data, rawRowPrefix.data(), strlen(rawRowPrefix.data()));
+
+	for (int col = 0 ; col < colCount ; col++)
+	{
+		int sourceCol = columns.IsEmpty() ? col : columns.Item(col);
+		const char *value = NULL;
+		wxCharBuffer converted;
+		bool isNull = set ? set->IsNull(row, sourceCol) : store->IsNull(row, sourceCol);
+
+		if (isNull && format != EXPORT_FORMAT_DISPLAY)
+			value = NULL;
+		else if (copyRaw)
+			value = set->GetCharPtr(row, sourceCol);
+		else
+		{
+			wxString text;
+			if (isNull)
+				text = wxEmptyString;
+			else if (set)
+				text = wxString(set->GetCharPtr(row, sourceCol), set->GetConversion());
+			else
+				text = store->GetVal(row, sourceCol);
+
+			if (format == EXPORT_FORMAT_DISPLAY)
+				text = sqlResultTable::FormatText(text, isNull, (pgTypClass)typClasses.Item(col), *displayFormat);
+
+			// Leave out the rows, which can't be written in the file's encoding
+			converted = text.mb_str(*fileConv);
+			if (!converted)
+			{
+				out->data.SetDataLen(rowStart);
+				out->skipped++;
+				return;
+			}
+			value = converted.data();
+		}
+
+		if (col)
+			AppendToBuffer(out->data, colSep, colSepLen);
+		AppendValue(out->data, value, col);
+	}
+	AppendToBuffer(out->data, rawRowSeparator.data(), strlen(rawRowSeparator.data()));
+}
+
+
+// Add a value (NULL for NULL) of the given column, as the format wants it
+void exportJob::AppendValue(wxMemoryBuffer &data, const char *value, int col)
+{
+	const char *pos;
+
+	if (format == EXPORT_FORMAT_INSERT)
+	{
+		if (!value)
+			AppendToBuffer(data, "NULL", 4);
+		// NaN and Infinity are numbers, which need the quotes too
+		else if (quoteCols[col] || value[strspn(value, "0123456789+-.eE")])
+		{
+			AppendToBuffer(data, "'", 1);
+			while ((pos = strchr(value, '\'')) != NULL)
+			{
+				AppendToBuffer(data, value, pos - value + 1);
+				AppendToBuffer(data, "'", 1);
+				value = pos + 1;
+			}
+			AppendToBuffer(data, value, strlen(value));
+			AppendToBuffer(data, "'", 1);
+		}
+		else
+			AppendToBuffer(data, value, strlen(value));
+		return;
+	}
+
+	if (format == EXPORT_FORMAT_COPY)
+	{
+		if (!value)
+		{
+			AppendToBuffer(data, "\\N", 2);
+			return;
+		}
+
+		// Escape what has a meaning in the text format of COPY
+		for (pos = value ; *pos ; pos++)
+		{
+			const char *escape = NULL;
+			switch (*pos)
+			{
+				case '\\':
+					escape = "\\\\";
+					break;
+				case '\t':
+					escape = "\\t";
+					break;
+				case '\n':
+					escape = "\\n";
+					break;
+				case '\r':
+					escape = "\\r";
+					break;
+			}
+			if (escape)
+			{
+				AppendToBuffer(data, value, pos - value);
+				AppendToBuffer(data, escape, 2);
+				value = pos + 1;
+			}
+		}
+		AppendToBuffer(data, value, pos - value);
+		return;
+	}
+
+	// The text format shows NULLs as empty values
+	if (!value)
+		value = "";
+
+	if (quoteCols[col])
+	{
+		const char *quote = rawQuoteChar.data();
+		size_t quoteLen = strlen(quote);
+
+		// Double the quote chars within the value, unless it's copied as
+		// it's shown
+		AppendToBuffer(data, quote, quoteLen);
+		while (format != EXPORT_FORMAT_DISPLAY && (pos = strstr(value, quote)) != NULL)
+		{
+			AppendToBuffer(data, value, pos - value + quoteLen);
+			AppendToBuffer(data, quote, quoteLen);
+			value = pos + quoteLen;
+		}
+		AppendToBuffer(data, value, strlen(value));
+		AppendToBuffer(data, quote, quoteLen);
+	}
+	else
+		AppendToBuffer(data, value, strlen(value));
+}
+
+
+void *exportWorker::Entry()
+{
+	long chunk;
+
+	while (job->ClaimChunk(chunk))
+	{
+		job->FormatChunk(chunk);
+		job->ChunkDone(chunk);
+	}
+	return NULL;
+}
+
+
+exportCopyReader::exportCopyReader(pgConn *_conn, wxFile &_file, wxMBConv *_fileConv, const wxString &_rowSeparator)
+	: wxThread(wxTHREAD_JOINABLE), file(_file), condition(mutex)
+{
+	conn = _conn;
+	fileConv = _fileConv;
+	rowSeparator = _rowSeparator;
+	rawRowSeparator = rowSeparator.mb_str(*fileConv);
+	rows = 0;
+	skipped = 0;
+	done = false;
+	cancelled = false;
+	writeFailed = false;
+}
+
+
+void *exportCopyReader::Entry()
+{
+	// No need to convert UTF-8 to UTF-8
+	bool convert = fileConv != conn->GetConv() || fileConv != &wxConvUTF8;
+	bool writing = true;
+
+	while (true)
+	{
+		char *buffer = NULL;
+		int len = conn->GetCopyData(&buffer, true);
+
+		// Done, failed, or the connection is lost
+		if (len < 0)
+			break;
+
+		mutex.Lock();
+		writing = !cancelled && !writeFailed;
+		mutex.Unlock();
+
+		if (writing)
+		{
+			// Each row ends with a newline, use the row separator instead
+			if (buffer[len - 1] == '\n')
+				len--;
+
+			if (!convert)
+			{
+				AppendToBuffer(data, buffer, len);
+				AppendToBuffer(data, rawRowSeparator.data(), strlen(rawRowSeparator.data()));
+			}
+			else
+			{
+				wxString line(buffer, *conn->GetConv(), len);
+				line += rowSeparator;
+
+				wxCharBuffer buf = line.mb_str(*fileConv);
+				if (!buf)
+					skipped++;
+				else
+					AppendToBuffer(data, buf.data(), strlen(buf.data()));
+			}
+		}
+		PQfreemem(buffer);
+
+		if (writing && data.GetDataLen() >= EXPORT_BUFFER_SIZE && !Flush())
+			conn->CancelExecution();
+
+		mutex.Lock();
+		rows++;
+		mutex.Unlock();
+	}
+
+	if (writing)
+		Flush();
+
+	mutex.Lock();
+	done = true;
+	condition.Broadcast();
+	mutex.Unlock();
+
+	return NULL;
+}
+
+
+bool exportCopyReader::Flush()
+{
+	bool ok = !data.GetDataLen() || file.Write(data.GetData(), data.GetDataLen()) == data.GetDataLen();
+	data.SetDataLen(0);
+
+	if (!ok)
+	{
+		wxMutexLocker lock(mutex);
+		writeFailed = true;
+	}
+	return ok;
+}
+
+
+bool exportCopyReader::WaitDone(int timeout, long &_rows)
+{
+	wxMutexLocker lock(mutex);
+
+	if (!done)
+		condition.WaitTimeout(timeout);
+
+	_rows = rows;
+	return done;
+}
+
+
+void exportCopyReader::Cancel()
+{
+	{
+		wxMutexLocker lock(mutex);
+		cancelled = true;
+	}
+	conn->CancelExecution();
+}
@@ -136,6 +136,20 @@ frmMain::frmMain(const wxString &title)
 	denyCollapseItem = wxTreeItemId();
 	currentObject = 0;
 
+	// Start checking the servers in the background, before any of them
+	// is connected
+	connMonitor = new pgConnMonitor(this);
+	if (connMonitor->Create() != wxTHREAD_NO_ERROR || connMonitor->Run() != wxTHREAD_NO_ERROR)
+	{
+		wxLogInfo(wxT("Could not start the connection monitor"));
+		delete connMonitor;
+		connMonitor = NULL;
+	}
+
+	// Park the idle sessions of the databases in the pools every now and then
+	poolTimer = new wxTimer(this, CTL_POOLTIMER);
+	poolTimer->Start(CONNMONITOR_INTERVAL * 1000);
+
 	appearanceFactory->SetIcons(this);
 
 	// notify wxAUI which frame to use
@@ -249,9 +263,23 @@ frmMain::~frmMain()
 	settings->Write(wxT("frmMain/Perspective-") + wxString(FRMMAIN_PERSPECTIVE_VER), manager.SavePerspective());
 	manager.UnInit();
 
+	if (poolTimer)
+	{
+		poolTimer->Stop();
+		delete poolTimer;
+		poolTimer = NULL;
+	}
+
 	// Clear the treeview
 	browser->DeleteAllItems();
 
+	if (connMonitor)
+	{
+		connMonitor->Stop();
+		delete connMonitor;
+		connMonitor = NULL;
+	}
+
 	if (treeContextMenu)
 		delete treeContextMenu;
 
@@ -593,6 +621,12 @@ void frmMain::Refresh(pgObject *data)
 		// refresh information about the object
 		data->SetDirty();
 
+		// The objects of a table are read from the catalog again, not
+		// from the catalog snapshot of its schema
+		pgTable *table = data->GetTable();
+		if (table && table->GetSchema())
+			table->GetSchema()->InvalidateCatalogSnapshot(table->GetOid());
+
 		pgObject *newData = data->Refresh(browser, currentItem);
 		done = !data->GetConnection() || data->GetConnection()->GetStatus() == PGCONN_OK;
 
@@ -845,9 +879,53 @@ bool frmMain::CheckAlive()
 	bool userInformed = false;
 	bool closeIt = false;
 
+	// Check the connections of the servers, which answered their last
+	// probe, and of their databases, all at once in a thread. A server
+	// which didn't answer is left alone until it answers again, rather
+	// than waiting for its connection to time out.
+	pgConnCheck check;
 	wxTreeItemIdValue foldercookie;
 	wxTreeItemId folderitem = browser->GetFirstChild(browser->GetRootItem(), foldercookie);
 	while (folderitem)
+	{
+		wxCookieType cookie;
+		wxTreeItemId serverItem = browser->GetFirstChild(folderitem, cookie);
+		while (serverItem)
+		{
+			pgServer *server = (pgServer *)browser->GetObject(serverItem);
+			if (server && server->IsCreatedBy(serverFactory) && server->connection() &&
+			        (!connMonitor || connMonitor->IsAlive(server)))
+			{
+				check.Add(server->connection());
+
+				wxCookieType cookie2;
+				wxTreeItemId item = browser->GetFirstChild(serverItem, cookie2);
+				while (item)
+				{
+					pgObject *obj = browser->GetObject(item);
+					if (obj && obj->IsCreatedBy(databaseFactory.GetCollectionFactory()))
+					{
+						wxCookieType cookie3;
+						wxTreeItemId dbItem = browser->GetFirstChild(item, cookie3);
+						while (dbItem)
+						{
+							pgDatabase *db = (pgDatabase *)browser->GetObject(dbItem);
+							if (db && db->IsCreatedBy(databaseFactory) && db->GetConnection())
+								check.Add(db->GetConnection());
+							dbItem = browser->GetNextChild(item, cookie3);
+						}
+					}
+					item = browser->GetNextChild(serverItem, cookie2);
+				}
+			}
+			serverItem = browser->GetNextChild(folderitem, cookie);
+		}
+		folderitem = browser->GetNextChild(browser->GetRootItem(), foldercookie);
+	}
+	check.CheckAll();
+
+	folderitem = browser->GetFirstChild(browser->GetRootItem(), foldercookie);
+	while (folderitem)
 	{
 		if (browser->ItemHasChildren(folderitem))
 		{
@@ -857,10 +935,17 @@ bool frmMain::CheckAlive()
 			{
 				pgServer *server = (pgServer *)browser->GetObject(serverItem);
 
-				if (server && server->IsCreatedBy(serverFactory) && server->connection())
+				// The connections have been checked above. A server, which
+				// didn't answer the last probe, is only handled as lost once
+				// its connection has been found so.
+				if (server && server->IsCreatedBy(serverFactory) && server->connection() &&
+				        (!connMonitor || connMonitor->IsAlive(server)))
 				{
-					if (server->connection()->IsAlive())
+					if (server->connection()->GetStatus() == PGCONN_OK)
 					{
+						if (server->GetConnPool())
+							server->GetConnPool()->Prune();
+
 						wxCookieType cookie2;
 						wxTreeItemId item = browser->GetFirstChild(serverItem, cookie2);
 						while (item)
@@ -878,7 +963,7 @@ bool frmMain::CheckAlive()
 										pgConn *conn = db->GetConnection();
 										if (conn)
 										{
-											if (!conn->IsAlive() && (conn->GetStatus() == PGCONN_BROKEN || conn->GetStatus() == PGCONN_BAD))
+											if (conn->GetStatus() == PGCONN_BROKEN || conn->GetStatus() == PGCONN_BAD)
 											{
 												conn->Close();
 												if (!userInformed)
@@ -969,8 +1054,13 @@ bool frmMain::CheckAlive()
 									browser->DeleteChildren(serverItem);
 								}
 								else
+								{
+									if (connMonitor)
+										connMonitor->Watch(server, server->connection(), server->GetSSHTunnel());
+
 									// Indicate things are back to normal
 									userInformed = false;
+								}
 							}
 						}
 					}
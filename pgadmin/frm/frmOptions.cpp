@@ -72,6 +72,8 @@
 #define radLoglevel                 CTRL_RADIOBOX("radLoglevel")
 #define txtMaxRows                  CTRL_TEXT("txtMaxRows")
 #define txtMaxColSize               CTRL_TEXT("txtMaxColSize")
+#define chkStreamResults            CTRL_CHECKBOX("chkStreamResults")
+#define txtStreamMemoryCap          CTRL_TEXT("txtStreamMemoryCap")
 #define pickerFont                  CTRL_FONTPICKER("pickerFont")
 #define chkUnicodeFile              CTRL_CHECKBOX("chkUnicodeFile")
 #define chkWriteBOM                 CTRL_CHECKBOX("chkWriteBOM")
@@ -280,6 +282,7 @@ frmOptions::frmOptions(frmMain *parent)
 	wxTextValidator numval(wxFILTER_NUMERIC);
 	txtMaxRows->SetValidator(numval);
 	txtMaxColSize->SetValidator(numval);
+	txtStreamMemoryCap->SetValidator(numval);
 	txtAutoRowCount->SetValidator(numval);
 	txtIndent->SetValidator(numval);
 	txtHistoryMaxQueries->SetValidator(numval);
@@ -312,6 +315,8 @@ frmOptions::frmOptions(frmMain *parent)
 	chkDoubleClickProperties->SetValue(settings->GetDoubleClickProperties());
 	txtDecimalMark->SetValue(settings->GetDecimalMark());
 	chkColumnNames->SetValue(settings->GetColumnNames());
+	chkStreamResults->SetValue(settings->GetStreamResults());
+	txtStreamMemoryCap->SetValue(NumToStr(settings->GetStreamMemoryCap()));
 	chkShowNotices->SetValue(settings->GetShowNotices());
 
 	txtPgHelpPath->SetValue(settings->GetPgHelpPath());
@@ -679,6 +684,8 @@ void frmOptions::OnOK(wxCommandEvent &ev)
 	settings->SetIndicateNull(chkIndicateNull->GetValue());
 	settings->SetDecimalMark(txtDecimalMark->GetValue());
 	settings->SetColumnNames(chkColumnNames->GetValue());
+	settings->SetStreamResults(chkStreamResults->GetValue());
+	settings->SetStreamMemoryCap(StrToLong(txtStreamMemoryCap->GetValue()));
 	settings->SetThousandsSeparator(txtThousandsSeparator->GetValue());
 	settings->SetAutoRollback(chkAutoRollback->GetValue());
 	settings->SetAutoCommit(chkAutoCommit->GetValue());
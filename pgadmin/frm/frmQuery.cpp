@@ -3057,7 +3057,7 @@ void frmQuery::execQuery(const wxString &query, int resultToRetrieve, bool singl
 
 	if (toFile)
 	{
-		qi->toFileExportForm = new frmExport(this);
+		qi->toFileExportForm = new frmExport(this, true);
 		if (qi->toFileExportForm->ShowModal() != wxID_OK)
 		{
 			delete qi;
@@ -3088,6 +3088,25 @@ void frmQuery::execQuery(const wxString &query, int resultToRetrieve, bool singl
 	if (!queryMenu->IsChecked(MNU_AUTOCOMMIT) && conn->GetTxStatus() == PQTRANS_IDLE && !isBeginNotRequired(query))
 		conn->ExecuteVoid(wxT("BEGIN;"));
 
+	// With COPY, the rows go straight from the server to the file
+	if (qi->toFileExportForm && qi->toFileExportForm->CanUseCopy(conn, query))
+	{
+		SetStatusText(_("Writing data."), STATUSPOS_MSGS);
+		bool done = qi->toFileExportForm->ExportCopy(conn, query);
+
+		timer.Stop();
+		elapsedQuery = wxGetLocalTimeMillis() - startTimeQuery;
+		SetStatusText(elapsedQuery.ToString() + wxT(" ms"), STATUSPOS_SECS);
+		if (done)
+			SetStatusText(_("Data written to file."), STATUSPOS_MSGS);
+		else
+			SetStatusText(_("Data export aborted."), STATUSPOS_MSGS);
+
+		delete qi;
+		completeQuery(done, false, false);
+		return;
+	}
+
 	if (sqlResult->Execute(query, resultToRetrieve, this, QUERY_COMPLETE, qi) >= 0)
 	{
 		// Return and wait for the result
@@ -3671,6 +3690,13 @@ void frmQuery::OnTimer(wxTimerEvent &event)
 		msgHistory->AppendText(str + wxT("\n"));
 	}
 
+	// Show how many rows have been streamed in so far
+	if (sqlResult->IsStreaming() && sqlResult->RunStatus() == CTLSQL_RUNNING)
+	{
+		long rows = sqlResult->NumRows();
+		SetStatusText(wxString::Format(wxPLURAL("%ld row.", "%ld rows.", rows), rows), STATUSPOS_ROWS);
+	}
+
 	// Increase the granularity for longer running queries
 	if (elapsedQuery > 200 && timer.GetInterval() == 10 && timer.IsRunning())
 	{
@@ -926,8 +926,8 @@ void frmReport::XmlAddSectionTableFromGrid(const int section, ctlSQLResult *grid
 	}
 	sectionTableHeader[section - 1] = data;
 
-	// Build the rows
-	int rows = grid->NumRows();
+	// Build the rows, as shown in the grid
+	int rows = grid->GetNumberRows();
 
 	for (int y = 0; y < rows; y++)
 	{
@@ -34,7 +34,9 @@
 #include "schema/pgUser.h"
 #include "ctl/ctlMenuToolbar.h"
 #include "ctl/ctlAuiNotebook.h"
+#include "ctl/lockGraphCanvas.h"
 #include "utils/csvfiles.h"
+#include "utils/lockGraph.h"
 
 // Icons
 #include "images/clip_copy.pngc"
@@ -79,6 +81,8 @@ BEGIN_EVENT_TABLE(frmStatus, pgFrame)
 	EVT_MENU(MNU_ROLLBACK,                        frmStatus::OnRollback)
 	EVT_COMBOBOX(CTL_LOGCBO,                      frmStatus::OnLoadLogfile)
 	EVT_BUTTON(CTL_ROTATEBTN,                     frmStatus::OnRotateLogfile)
+	EVT_CHOICE(CTL_LOGLEVELCBO,                   frmStatus::OnLogFilter)
+	EVT_TEXT(CTL_LOGFILTER,                       frmStatus::OnLogFilter)
 
 	EVT_TIMER(TIMER_REFRESHUI_ID,                 frmStatus::OnRefreshUITimer)
 
@@ -88,6 +92,8 @@ BEGIN_EVENT_TABLE(frmStatus, pgFrame)
 	EVT_LIST_COL_CLICK(CTL_STATUSLIST,            frmStatus::OnSortStatusGrid)
 	EVT_LIST_COL_RIGHT_CLICK(CTL_STATUSLIST,      frmStatus::OnRightClickStatusGrid)
 	EVT_LIST_COL_END_DRAG(CTL_STATUSLIST,         frmStatus::OnChgColSizeStatusGrid)
+	EVT_COMMAND_SCROLL(CTL_HISTORYSLIDER,         frmStatus::OnHistoryScroll)
+	EVT_BUTTON(CTL_HISTORYBTN,                    frmStatus::OnHistoryReport)
 
 	EVT_TIMER(TIMER_LOCKS_ID,                     frmStatus::OnRefreshLocksTimer)
 	EVT_LIST_ITEM_SELECTED(CTL_LOCKLIST,          frmStatus::OnSelLockItem)
@@ -95,6 +101,7 @@ BEGIN_EVENT_TABLE(frmStatus, pgFrame)
 	EVT_LIST_COL_CLICK(CTL_LOCKLIST,              frmStatus::OnSortLockGrid)
 	EVT_LIST_COL_RIGHT_CLICK(CTL_LOCKLIST,        frmStatus::OnRightClickLockGrid)
 	EVT_LIST_COL_END_DRAG(CTL_LOCKLIST,           frmStatus::OnChgColSizeLockGrid)
+	EVT_CHECKBOX(CTL_LOCKGRAPHCHK,                frmStatus::OnLockGraphToggle)
 
 	EVT_TIMER(TIMER_XACT_ID,                      frmStatus::OnRefreshXactTimer)
 	EVT_LIST_ITEM_SELECTED(CTL_XACTLIST,          frmStatus::OnSelXactItem)
@@ -189,8 +196,15 @@ frmStatus::frmStatus(frmMain *form, const wxString &_title, pgConn *conn) : pgFr
 	xactTimer = 0;
 	logTimer = 0;
 
+	history = NULL;
+	historyFrame = -1;
+
+	lockWaits = NULL;
+	lockCanvas = NULL;
+
 	logHasTimestamp = false;
 	logFormatKnown = false;
+	logChunkSize = LOG_CHUNK_MIN;
 
 	// Only superusers can set these parameters...
 	pgUser *user = new pgUser(connection->GetUser());
@@ -416,8 +430,12 @@ frmStatus::~frmStatus()
 	// For each current page, save the slider's position and delete the timer
 	settings->WriteInt(wxT("frmStatus/RefreshStatusRate"), statusRate);
 	delete statusTimer;
+	if (history)
+		delete history;
 	settings->WriteInt(wxT("frmStatus/RefreshLockRate"), locksRate);
 	delete locksTimer;
+	if (lockWaits)
+		delete lockWaits;
 	if (viewMenu->IsEnabled(MNU_XACTPAGE))
 	{
 		settings->WriteInt(wxT("frmStatus/RefreshXactRate"), xactRate);
@@ -538,7 +556,7 @@ void frmStatus::AddStatusPane()
 	wxPanel *pnlActivity = new wxPanel(this);
 
 	// Create flex grid
-	wxFlexGridSizer *grdActivity = new wxFlexGridSizer(1, 1, 5, 5);
+	wxFlexGridSizer *grdActivity = new wxFlexGridSizer(2, 1, 5, 5);
 	grdActivity->AddGrowableCol(0);
 	grdActivity->AddGrowableRow(0);
 
@@ -555,6 +573,19 @@ void frmStatus::AddStatusPane()
 #endif
 	grdActivity->Add(lstStatus, 0, wxGROW, 3);
 
+	// Add the timeline of the recorded activity
+	wxBoxSizer *historyActivity = new wxBoxSizer(wxHORIZONTAL);
+	historyActivity->Add(new wxStaticText(pnlActivity, wxID_ANY, _("History:")), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+	sldHistory = new wxSlider(pnlActivity, CTL_HISTORYSLIDER, 0, 0, 1);
+	sldHistory->Enable(false);
+	historyActivity->Add(sldHistory, 1, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+	stHistoryTime = new wxStaticText(pnlActivity, wxID_ANY, _("Live"), wxDefaultPosition, wxSize(150, -1));
+	historyActivity->Add(stHistoryTime, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+	btnHistoryReport = new wxButton(pnlActivity, CTL_HISTORYBTN, _("Report..."));
+	btnHistoryReport->Enable(false);
+	historyActivity->Add(btnHistoryReport, 0, wxALIGN_CENTER_VERTICAL);
+	grdActivity->Add(historyActivity, 0, wxGROW | wxALL, 3);
+
 	// Add the panel to the notebook
 	manager.AddPane(pnlActivity,
 	                wxAuiPaneInfo().
@@ -624,6 +655,9 @@ void frmStatus::AddStatusPane()
 	// Build image list
 	statusList->SetImageList(listimages, wxIMAGE_LIST_SMALL);
 
+	// Record the refreshes; "Blocked by" and "Query" are the last columns
+	history = new statusHistory(statusList->GetColumnCount() - 2, statusList->GetColumnCount() - 1);
+
 	// Read statusRate configuration
 	settings->Read(wxT("frmStatus/RefreshStatusRate"), &statusRate, 10);
 
@@ -642,9 +676,19 @@ void frmStatus::AddLockPane()
 	wxPanel *pnlLock = new wxPanel(this);
 
 	// Create flex grid
-	wxFlexGridSizer *grdLock = new wxFlexGridSizer(1, 1, 5, 5);
+	wxFlexGridSizer *grdLock = new wxFlexGridSizer(2, 1, 5, 5);
 	grdLock->AddGrowableCol(0);
-	grdLock->AddGrowableRow(0);
+	grdLock->AddGrowableRow(1);
+
+	// Add the switch between the list and the wait-for graph, which needs
+	// the virtual transactions of 8.3 to tell who waits for whom
+	wxBoxSizer *graphLock = new wxBoxSizer(wxHORIZONTAL);
+	chkLockGraph = new wxCheckBox(pnlLock, CTL_LOCKGRAPHCHK, _("Wait-for graph"));
+	chkLockGraph->Enable(locks_connection->BackendMinimumVersion(8, 3));
+	graphLock->Add(chkLockGraph, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+	stLockGraph = new wxStaticText(pnlLock, wxID_ANY, wxEmptyString);
+	graphLock->Add(stLockGraph, 1, wxALIGN_CENTER_VERTICAL);
+	grdLock->Add(graphLock, 0, wxGROW | wxALL, 3);
 
 	// Add the list control
 #ifdef __WXMAC__
@@ -657,7 +701,13 @@ void frmStatus::AddLockPane()
 #ifdef __WXMAC__
 	wxSystemOptions::SetOption(wxT("mac.listctrl.always_use_generic"), false);
 #endif
-	grdLock->Add(lstLocks, 0, wxGROW, 3);
+	wxBoxSizer *viewLock = new wxBoxSizer(wxVERTICAL);
+	viewLock->Add(lstLocks, 1, wxGROW);
+
+	lockCanvas = new LockGraphCanvas(pnlLock);
+	lockCanvas->Hide();
+	viewLock->Add(lockCanvas, 1, wxGROW);
+	grdLock->Add(viewLock, 0, wxGROW, 3);
 
 	// Add the panel to the notebook
 	manager.AddPane(pnlLock,
@@ -720,6 +770,8 @@ void frmStatus::AddLockPane()
 	lockSortColumn = 1;
 	lockSortOrder = wxT("ASC");
 
+	lockWaits = new lockGraph();
+
 	// Create the timer
 	locksTimer = new wxTimer(this, TIMER_LOCKS_ID);
 }
@@ -834,9 +886,25 @@ void frmStatus::AddLogPane()
 	wxPanel *pnlLog = new wxPanel(this);
 
 	// Create flex grid
-	wxFlexGridSizer *grdLog = new wxFlexGridSizer(1, 1, 5, 5);
+	wxFlexGridSizer *grdLog = new wxFlexGridSizer(2, 1, 5, 5);
 	grdLog->AddGrowableCol(0);
-	grdLog->AddGrowableRow(0);
+	grdLog->AddGrowableRow(1);
+
+	// Add the filters
+	wxBoxSizer *filterLog = new wxBoxSizer(wxHORIZONTAL);
+	cbLogLevel = new wxChoice(pnlLog, CTL_LOGLEVELCBO);
+	cbLogLevel->Append(_("All levels"));
+	cbLogLevel->Append(_("LOG and above"));
+	cbLogLevel->Append(_("NOTICE and above"));
+	cbLogLevel->Append(_("WARNING and above"));
+	cbLogLevel->Append(_("ERROR and above"));
+	cbLogLevel->Append(_("FATAL and above"));
+	cbLogLevel->SetSelection(0);
+	filterLog->Add(cbLogLevel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+	filterLog->Add(new wxStaticText(pnlLog, wxID_ANY, _("Find:")), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+	txtLogFilter = new wxTextCtrl(pnlLog, CTL_LOGFILTER, wxEmptyString, wxDefaultPosition, wxSize(200, -1));
+	filterLog->Add(txtLogFilter, 0, wxALIGN_CENTER_VERTICAL);
+	grdLog->Add(filterLog, 0, wxALL, 3);
 
 	// Add the list control
 #ifdef __WXMAC__
@@ -844,7 +912,7 @@ void frmStatus::AddLogPane()
 	// Disable sort on Mac.
 	wxSystemOptions::SetOption(wxT("mac.listctrl.always_use_generic"), true);
 #endif
-	wxListCtrl *lstLog = new wxListCtrl(pnlLog, CTL_LOGLIST, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxSUNKEN_BORDER);
+	ctlLogList *lstLog = new ctlLogList(pnlLog, CTL_LOGLIST, wxDefaultPosition, wxDefaultSize, wxSUNKEN_BORDER);
 	// Now switch back
 #ifdef __WXMAC__
 	wxSystemOptions::SetOption(wxT("mac.listctrl.always_use_generic"), false);
@@ -863,7 +931,7 @@ void frmStatus::AddLogPane()
 	grdLog->Fit(pnlLog);
 
 	// Add the log list
-	logList = (ctlListView *)lstLog;
+	logList = lstLog;
 
 	// We don't need this report (but we need the pane)
 	// if server release is less than 8.0 or if server has no adminpack
@@ -891,7 +959,8 @@ void frmStatus::AddLogPane()
 		if (!connection->HasFeature(FEATURE_FILEREAD, true))
 		{
 			logList->InsertColumn(logList->GetColumnCount(), _("Message"), wxLIST_FORMAT_LEFT, 800);
-			logList->InsertItem(logList->GetItemCount(), _("Logs are not available for this server."), -1);
+			logList->AddRow(_("Logs are not available for this server."));
+			logList->Flush();
 			logList->Enable(false);
 			logTimer = NULL;
 			// We're done
@@ -931,6 +1000,7 @@ void frmStatus::AddLogPane()
 		logList->AddColumn(_("Cmd number"), 48);
 		logList->AddColumn(_("Dbname"), 48);
 		logList->AddColumn(_("Segment"), 45);
+		logList->SetLevelColumn(1);
 	}
 	else    // Non-GPDB or non-CSV format log
 	{
@@ -938,7 +1008,10 @@ void frmStatus::AddLogPane()
 			logList->AddColumn(_("Timestamp"), 100);
 
 		if (logFormatKnown)
+		{
+			logList->SetLevelColumn(logList->GetColumnCount());
 			logList->AddColumn(_("Level"), 35);
+		}
 
 		logList->AddColumn(_("Log entry"), 800);
 	}
@@ -1219,7 +1292,10 @@ void frmStatus::OnHighlightStatus(wxCommandEvent &event)
 {
 	wxTimerEvent evt;
 
-	OnRefreshStatusTimer(evt);
+	if (historyFrame >= 0)
+		ShowHistoryFrame();
+	else
+		OnRefreshStatusTimer(evt);
 }
 
 
@@ -1336,7 +1412,6 @@ void frmStatus::OnRefreshStatusTimer(wxTimerEvent &event)
 
 	wxCriticalSectionLocker lock(gs_critsect);
 
-	long row = 0;
 	wxString q = wxT("SELECT ");
 
 	// PID
@@ -1390,12 +1465,8 @@ void frmStatus::OnRefreshStatusTimer(wxTimerEvent &event)
 	if (connection->BackendMinimumVersion(9, 4))
 		q += wxT("backend_xid::text, backend_xmin::text, ");
 
-	// Blocked by...
-	q +=   wxT("(SELECT min(l1.pid) FROM pg_locks l1 WHERE GRANTED AND (")
-	       wxT("relation IN (SELECT relation FROM pg_locks l2 WHERE l2.pid=") + pidcol + wxT(" AND NOT granted)")
-	       wxT(" OR ")
-	       wxT("transactionid IN (SELECT transactionid FROM pg_locks l3 WHERE l3.pid=") + pidcol + wxT(" AND NOT granted)")
-	       wxT(")) AS blockedby,\n");
+	// Blocked by... (joined below)
+	q += wxT("b.blockedby,\n");
 
 	// Query
 	q += querycol + wxT(" AS query,\n");
@@ -1415,112 +1486,96 @@ void frmStatus::OnRefreshStatusTimer(wxTimerEvent &event)
 	}
 	q += wxT("AS slowquery\n");
 
-	// And the rest of the query...
-	q += wxT("FROM pg_stat_activity p ")
+	// And the rest of the query... The blockers of all the waiting backends
+	// are found in one pass over pg_locks, not in one per backend.
+	q += wxT("FROM pg_stat_activity p\n")
+	     wxT("LEFT JOIN (SELECT w.pid, min(h.pid) AS blockedby\n")
+	     wxT("             FROM pg_locks w\n")
+	     wxT("             JOIN pg_locks h ON h.granted AND h.pid <> w.pid\n")
+	     wxT("              AND (h.relation = w.relation OR h.transactionid = w.transactionid)\n")
+	     wxT("            WHERE NOT w.granted\n")
+	     wxT("            GROUP BY w.pid) b ON b.pid = ") + pidcol + wxT("\n")
 	     wxT("ORDER BY ") + NumToStr((long)statusSortColumn) + wxT(" ") + statusSortOrder;
 
 	pgSet *dataSet1 = connection->ExecuteSet(q);
 	if (dataSet1)
 	{
 		statusBar->SetStatusText(_("Refreshing status list."));
-		statusList->Freeze();
 
-		// Clear the queries array content
-		queries.Clear();
+		statusHistoryRows rows;
 
 		while (!dataSet1->Eof())
 		{
 			pid = dataSet1->GetLong(wxT("pid"));
 
-			// Update the UI
 			if (pid != backend_pid)
 			{
-				// Add the query content to the queries array
-				queries.Add(dataSet1->GetVal(wxT("query")));
-
-				if (row >= statusList->GetItemCount())
-				{
-					statusList->InsertItem(row, NumToStr(pid), -1);
-					row = statusList->GetItemCount() - 1;
-				}
-				else
-				{
-					statusList->SetItem(row, 0, NumToStr(pid));
-				}
+				statusHistoryRow *row = new statusHistoryRow();
+				row->pid = pid;
 
 				wxString qry = dataSet1->GetVal(wxT("query"));
 
-				int colpos = 1;
+				row->cols.Add(NumToStr(pid));
 				if (connection->BackendMinimumVersion(8, 5))
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("application_name")));
-				statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("datname")));
-				statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("usename")));
+					row->cols.Add(dataSet1->GetVal(wxT("application_name")));
+				row->cols.Add(dataSet1->GetVal(wxT("datname")));
+				row->cols.Add(dataSet1->GetVal(wxT("usename")));
 
 				if (connection->BackendMinimumVersion(8, 1))
 				{
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("client")));
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("backend_start")));
+					row->cols.Add(dataSet1->GetVal(wxT("client")));
+					row->cols.Add(dataSet1->GetVal(wxT("backend_start")));
 				}
 				if (connection->BackendMinimumVersion(7, 4))
 				{
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("query_start")));
+					row->cols.Add(dataSet1->GetVal(wxT("query_start")));
 				}
 
 				if (connection->BackendMinimumVersion(8, 3))
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("xact_start")));
+					row->cols.Add(dataSet1->GetVal(wxT("xact_start")));
 
 				if (connection->BackendMinimumVersion(9, 2))
 				{
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("state")));
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("state_change")));
+					row->cols.Add(dataSet1->GetVal(wxT("state")));
+					row->cols.Add(dataSet1->GetVal(wxT("state_change")));
 				}
 
 				if (connection->BackendMinimumVersion(9, 4))
 				{
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("backend_xid")));
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("backend_xmin")));
+					row->cols.Add(dataSet1->GetVal(wxT("backend_xid")));
+					row->cols.Add(dataSet1->GetVal(wxT("backend_xmin")));
 				}
 
-				statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("blockedby")));
-				statusList->SetItem(row, colpos, qry);
+				row->cols.Add(dataSet1->GetVal(wxT("blockedby")));
+				row->cols.Add(qry);
 
-				// Colorize the new line
-				if (viewMenu->IsChecked(MNU_HIGHLIGHTSTATUS))
+				// How to colorize the line
+				row->state = STATUSROW_ACTIVE;
+				if (qry == wxT("<IDLE>") || qry == wxT("<IDLE> in transaction0"))
+					row->state = STATUSROW_IDLE;
+				if (connection->BackendMinimumVersion(9, 2))
 				{
-					statusList->SetItemBackgroundColour(row,
-					                                    wxColour(settings->GetActiveProcessColour()));
-					if (qry == wxT("<IDLE>") || qry == wxT("<IDLE> in transaction0"))
-						statusList->SetItemBackgroundColour(row,
-						                                    wxColour(settings->GetIdleProcessColour()));
-					if (connection->BackendMinimumVersion(9, 2))
-					{
-						if (dataSet1->GetVal(wxT("state")) != wxT("active"))
-							statusList->SetItemBackgroundColour(row,
-							                                    wxColour(settings->GetIdleProcessColour()));
-					}
-
-					if (dataSet1->GetVal(wxT("blockedby")).Length() > 0)
-						statusList->SetItemBackgroundColour(row,
-						                                    wxColour(settings->GetBlockedProcessColour()));
-					if (dataSet1->GetBool(wxT("slowquery")))
-						statusList->SetItemBackgroundColour(row,
-						                                    wxColour(settings->GetSlowProcessColour()));
+					if (dataSet1->GetVal(wxT("state")) != wxT("active"))
+						row->state = STATUSROW_IDLE;
 				}
-				else
-					statusList->SetItemBackgroundColour(row, *wxWHITE);
 
-				row++;
+				if (dataSet1->GetVal(wxT("blockedby")).Length() > 0)
+					row->state = STATUSROW_BLOCKED;
+				if (dataSet1->GetBool(wxT("slowquery")))
+					row->state = STATUSROW_SLOW;
+
+				rows.Add(row);
 			}
 			dataSet1->MoveNext();
 		}
 		delete dataSet1;
 
-		while (row < statusList->GetItemCount())
-			statusList->DeleteItem(row);
+		// Keep the moment looked at in the history on the list
+		history->Record(rows);
+		if (historyFrame < 0)
+			ShowStatusRows(rows);
+		UpdateHistorySlider();
 
-		statusList->Thaw();
-		wxListEvent ev;
-		OnSelStatusItem(ev);
 		statusBar->SetStatusText(_("Done."));
 	}
 	else
@@ -1528,6 +1583,199 @@ void frmStatus::OnRefreshStatusTimer(wxTimerEvent &event)
 }
 
 
+void frmStatus::ShowStatusRows(const statusHistoryRows &rows)
+{
+	// Only rows, which come or go, have the list repainted as a whole
+	bool frozen = false;
+	long row;
+
+	// Clear the queries array content
+	queries.Clear();
+
+	for (row = 0; row < (long)rows.GetCount(); row++)
+	{
+		const statusHistoryRow &status = rows[row];
+
+		// Add the query content to the queries array
+		queries.Add(status.cols.Last());
+
+		if (row >= statusList->GetItemCount())
+		{
+			if (!frozen)
+			{
+				statusList->Freeze();
+				frozen = true;
+			}
+			statusList->InsertItem(row, status.cols.Item(0), -1);
+		}
+
+		for (size_t col = 0; col < status.cols.GetCount(); col++)
+			statusList->UpdateItem(row, col, status.cols.Item(col));
+
+		// Colorize the line
+		wxColour colour = *wxWHITE;
+		if (viewMenu->IsChecked(MNU_HIGHLIGHTSTATUS))
+		{
+			switch (status.state)
+			{
+				case STATUSROW_IDLE:
+					colour = wxColour(settings->GetIdleProcessColour());
+					break;
+				case STATUSROW_BLOCKED:
+					colour = wxColour(settings->GetBlockedProcessColour());
+					break;
+				case STATUSROW_SLOW:
+					colour = wxColour(settings->GetSlowProcessColour());
+					break;
+				default:
+					colour = wxColour(settings->GetActiveProcessColour());
+					break;
+			}
+		}
+		statusList->UpdateItemBackgroundColour(row, colour);
+	}
+
+	while (row < statusList->GetItemCount())
+	{
+		if (!frozen)
+		{
+			statusList->Freeze();
+			frozen = true;
+		}
+		statusList->DeleteItem(row);
+	}
+
+	if (frozen)
+		statusList->Thaw();
+	wxListEvent ev;
+	OnSelStatusItem(ev);
+}
+
+
+void frmStatus::ShowHistoryFrame()
+{
+	statusHistoryRows rows;
+
+	if (!history->GetFrame(historyFrame, rows))
+		return;
+
+	ShowStatusRows(rows);
+	stHistoryTime->SetLabel(DateToStr(history->GetFrameTime(historyFrame)));
+}
+
+
+void frmStatus::UpdateHistorySlider()
+{
+	long count = history->GetFrameCount();
+
+	btnHistoryReport->Enable(count > 0);
+	if (count < 2)
+	{
+		sldHistory->Enable(false);
+		return;
+	}
+
+	sldHistory->Enable(true);
+	sldHistory->SetRange(0, count - 1);
+
+	if (historyFrame < 0)
+		sldHistory->SetValue(count - 1);
+	else
+	{
+		// The frame looked at may have been dropped from the history
+		if (historyFrame < history->GetFirstFrame())
+		{
+			historyFrame = history->GetFirstFrame();
+			ShowHistoryFrame();
+		}
+		sldHistory->SetValue(historyFrame - history->GetFirstFrame());
+	}
+}
+
+
+void frmStatus::OnHistoryScroll(wxScrollEvent &event)
+{
+	long count = history->GetFrameCount();
+	long pos = sldHistory->GetValue();
+
+	if (!count)
+		return;
+
+	if (pos >= count - 1)
+	{
+		// Back to the live activity, starting with the last refresh
+		historyFrame = history->GetFirstFrame() + count - 1;
+		ShowHistoryFrame();
+		historyFrame = -1;
+		stHistoryTime->SetLabel(_("Live"));
+	}
+	else
+	{
+		historyFrame = history->GetFirstFrame() + pos;
+		ShowHistoryFrame();
+	}
+}
+
+
+void frmStatus::OnHistoryReport(wxCommandEvent &event)
+{
+	statusHistoryWaits waits;
+	statusHistoryBlockers blockers;
+	size_t i;
+
+	{
+		wxBusyCursor wait;
+		if (!history->Aggregate(waits, blockers, HISTORY_REPORT_ROWS))
+		{
+			wxLogError(_("Could not read the recorded activity."));
+			return;
+		}
+	}
+
+	wxDialog dlg(this, wxID_ANY, _("Activity history"), wxDefaultPosition, wxSize(700, 500), wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER);
+	wxBoxSizer *sizer = new wxBoxSizer(wxVERTICAL);
+
+	wxString since;
+	if (history->GetFrameCount() > 0)
+		since = DateToStr(history->GetFrameTime(history->GetFirstFrame()));
+
+	sizer->Add(new wxStaticText(&dlg, wxID_ANY, wxString::Format(_("Top waiting queries since %s"), since.c_str())), 0, wxALL, 5);
+	ctlListView *lstWaits = new ctlListView(&dlg, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxSUNKEN_BORDER);
+	lstWaits->AddColumn(_("Waited (s)"), 50);
+	lstWaits->AddColumn(_("Most waiting"), 50);
+	lstWaits->AddColumn(_("Query"), 300);
+	for (i = 0; i < waits.GetCount(); i++)
+	{
+		long pos = lstWaits->InsertItem(i, wxString::Format(wxT("%.1f"), waits[i].seconds));
+		lstWaits->SetItem(pos, 1, NumToStr(waits[i].maxWaiting));
+		lstWaits->SetItem(pos, 2, waits[i].query);
+	}
+	sizer->Add(lstWaits, 1, wxEXPAND | wxLEFT | wxRIGHT, 5);
+
+	sizer->Add(new wxStaticText(&dlg, wxID_ANY, _("Longest blockers")), 0, wxALL, 5);
+	ctlListView *lstBlockers = new ctlListView(&dlg, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxSUNKEN_BORDER);
+	lstBlockers->AddColumn(_("PID"), 35);
+	lstBlockers->AddColumn(_("Since"), 80);
+	lstBlockers->AddColumn(_("Blocking (s)"), 50);
+	lstBlockers->AddColumn(_("Most waiting"), 50);
+	lstBlockers->AddColumn(_("Query"), 300);
+	for (i = 0; i < blockers.GetCount(); i++)
+	{
+		wxDateTime start((time_t)(blockers[i].start / 1000).ToLong());
+		long pos = lstBlockers->InsertItem(i, NumToStr(blockers[i].pid));
+		lstBlockers->SetItem(pos, 1, DateToStr(start));
+		lstBlockers->SetItem(pos, 2, wxString::Format(wxT("%.1f"), blockers[i].seconds));
+		lstBlockers->SetItem(pos, 3, NumToStr(blockers[i].maxWaiting));
+		lstBlockers->SetItem(pos, 4, blockers[i].query);
+	}
+	sizer->Add(lstBlockers, 1, wxEXPAND | wxLEFT | wxRIGHT, 5);
+
+	sizer->Add(dlg.CreateButtonSizer(wxOK), 0, wxEXPAND | wxALL, 5);
+	dlg.SetSizer(sizer);
+	dlg.ShowModal();
+}
+
+
 void frmStatus::OnRefreshLocksTimer(wxTimerEvent &event)
 {
 	long pid = 0;
@@ -1556,20 +1804,32 @@ void frmStatus::OnRefreshLocksTimer(wxTimerEvent &event)
 		lockSortColumn = 1;
 	}
 
+	if (chkLockGraph->GetValue())
+	{
+		if (!RefreshLockGraph())
+			checkConnection();
+		return;
+	}
+
 	long row = 0;
 	wxString sql;
 	if (locks_connection->BackendMinimumVersion(8, 3))
 	{
-		sql = wxT("SELECT pg_stat_get_backend_pid(svrid) AS pid, ")
-		      wxT("(SELECT datname FROM pg_database WHERE oid = pgl.database) AS dbname, ")
+		// Join the backends once, rather than looking each one up for every lock
+		wxString pidcol = locks_connection->BackendMinimumVersion(9, 2) ? wxT("pid") : wxT("procpid");
+		wxString querycol = locks_connection->BackendMinimumVersion(9, 2) ? wxT("query") : wxT("current_query");
+
+		sql = wxT("SELECT pgl.pid, ")
+		      wxT("pgd.datname AS dbname, ")
 		      wxT("coalesce(pgc.relname, pgl.relation::text) AS class, ")
-		      wxT("pg_get_userbyid(pg_stat_get_backend_userid(svrid)) as user, ")
+		      wxT("p.usename as user, ")
 		      wxT("pgl.virtualxid::text, pgl.virtualtransaction::text AS transaction, pgl.mode, pgl.granted, ")
-		      wxT("date_trunc('second', pg_stat_get_backend_activity_start(svrid)) AS query_start, ")
-		      wxT("pg_stat_get_backend_activity(svrid) AS query ")
-		      wxT("FROM pg_stat_get_backend_idset() svrid, pg_locks pgl ")
+		      wxT("date_trunc('second', p.query_start) AS query_start, ")
+		      wxT("p.") + querycol + wxT(" AS query ")
+		      wxT("FROM pg_locks pgl ")
+		      wxT("JOIN pg_stat_activity p ON p.") + pidcol + wxT(" = pgl.pid ")
+		      wxT("LEFT JOIN pg_database pgd ON pgl.database=pgd.oid ")
 		      wxT("LEFT JOIN pg_class pgc ON pgl.relation=pgc.oid ")
-		      wxT("WHERE pgl.pid = pg_stat_get_backend_pid(svrid) ")
 		      wxT("ORDER BY ") + NumToStr((long)lockSortColumn) + wxT(" ") + lockSortOrder;
 	}
 	else if (locks_connection->BackendMinimumVersion(7, 4))
@@ -1604,7 +1864,9 @@ void frmStatus::OnRefreshLocksTimer(wxTimerEvent &event)
 	if (dataSet2)
 	{
 		statusBar->SetStatusText(_("Refreshing locks list."));
-		lockList->Freeze();
+
+		// Only rows, which come or go, have the list repainted as a whole
+		bool frozen = false;
 
 		while (!dataSet2->Eof())
 		{
@@ -1614,38 +1876,43 @@ void frmStatus::OnRefreshLocksTimer(wxTimerEvent &event)
 			{
 				if (row >= lockList->GetItemCount())
 				{
+					if (!frozen)
+					{
+						lockList->Freeze();
+						frozen = true;
+					}
 					lockList->InsertItem(row, NumToStr(pid), -1);
 					row = lockList->GetItemCount() - 1;
 				}
 				else
 				{
-					lockList->SetItem(row, 0, NumToStr(pid));
+					lockList->UpdateItem(row, 0, NumToStr(pid));
 				}
 
 				int colpos = 1;
-				lockList->SetItem(row, colpos++, dataSet2->GetVal(wxT("dbname")));
-				lockList->SetItem(row, colpos++, dataSet2->GetVal(wxT("class")));
-				lockList->SetItem(row, colpos++, dataSet2->GetVal(wxT("user")));
+				lockList->UpdateItem(row, colpos++, dataSet2->GetVal(wxT("dbname")));
+				lockList->UpdateItem(row, colpos++, dataSet2->GetVal(wxT("class")));
+				lockList->UpdateItem(row, colpos++, dataSet2->GetVal(wxT("user")));
 				if (locks_connection->BackendMinimumVersion(8, 3))
-					lockList->SetItem(row, colpos++, dataSet2->GetVal(wxT("virtualxid")));
-				lockList->SetItem(row, colpos++, dataSet2->GetVal(wxT("transaction")));
-				lockList->SetItem(row, colpos++, dataSet2->GetVal(wxT("mode")));
+					lockList->UpdateItem(row, colpos++, dataSet2->GetVal(wxT("virtualxid")));
+				lockList->UpdateItem(row, colpos++, dataSet2->GetVal(wxT("transaction")));
+				lockList->UpdateItem(row, colpos++, dataSet2->GetVal(wxT("mode")));
 
 				if (dataSet2->GetVal(wxT("granted")) == wxT("t"))
-					lockList->SetItem(row, colpos++, _("Yes"));
+					lockList->UpdateItem(row, colpos++, _("Yes"));
 				else
-					lockList->SetItem(row, colpos++, _("No"));
+					lockList->UpdateItem(row, colpos++, _("No"));
 
 				wxString qry = dataSet2->GetVal(wxT("query"));
 
 				if (locks_connection->BackendMinimumVersion(7, 4))
 				{
 					if (qry.IsEmpty() || qry == wxT("<IDLE>"))
-						lockList->SetItem(row, colpos++, wxEmptyString);
+						lockList->UpdateItem(row, colpos++, wxEmptyString);
 					else
-						lockList->SetItem(row, colpos++, dataSet2->GetVal(wxT("query_start")));
+						lockList->UpdateItem(row, colpos++, dataSet2->GetVal(wxT("query_start")));
 				}
-				lockList->SetItem(row, colpos++, qry.Left(250));
+				lockList->UpdateItem(row, colpos++, qry.Left(250));
 
 				row++;
 			}
@@ -1655,9 +1922,17 @@ void frmStatus::OnRefreshLocksTimer(wxTimerEvent &event)
 		delete dataSet2;
 
 		while (row < lockList->GetItemCount())
+		{
+			if (!frozen)
+			{
+				lockList->Freeze();
+				frozen = true;
+			}
 			lockList->DeleteItem(row);
+		}
 
-		lockList->Thaw();
+		if (frozen)
+			lockList->Thaw();
 		wxListEvent ev;
 		OnSelLockItem(ev);
 		statusBar->SetStatusText(_("Done."));
@@ -1667,6 +1942,91 @@ void frmStatus::OnRefreshLocksTimer(wxTimerEvent &event)
 }
 
 
+// Read the locks in one snapshot, and draw who waits for whom
+bool frmStatus::RefreshLockGraph()
+{
+	wxString pidcol = locks_connection->BackendMinimumVersion(9, 2) ? wxT("pid") : wxT("procpid");
+	wxString querycol = locks_connection->BackendMinimumVersion(9, 2) ? wxT("query") : wxT("current_query");
+
+	// Locks are on the same object when all of its identifying columns match
+	wxString sql = wxT("SELECT l.pid, l.mode, l.granted, ")
+	               wxT("l.locktype || ':' || coalesce(l.database::text, '') || ':' || coalesce(l.relation::text, '') || ':' || ")
+	               wxT("coalesce(l.page::text, '') || ':' || coalesce(l.tuple::text, '') || ':' || coalesce(l.virtualxid, '') || ':' || ")
+	               wxT("coalesce(l.transactionid::text, '') || ':' || coalesce(l.classid::text, '') || ':' || ")
+	               wxT("coalesce(l.objid::text, '') || ':' || coalesce(l.objsubid::text, '') AS object, ")
+	               wxT("l.locktype || ' ' || coalesce(c.relname, l.relation::text, l.virtualxid, l.transactionid::text, l.objid::text, '') AS name ")
+	               wxT("FROM pg_locks l ")
+	               wxT("LEFT JOIN pg_class c ON c.oid = l.relation ")
+	               wxT("AND l.database = (SELECT oid FROM pg_database WHERE datname = current_database()) ")
+	               wxT("WHERE l.pid IS NOT NULL AND l.pid <> pg_backend_pid()");
+
+	pgSet *set = locks_connection->ExecuteSet(sql);
+	if (!set)
+		return false;
+
+	statusBar->SetStatusText(_("Refreshing wait-for graph."));
+
+	lockWaits->Clear();
+	while (!set->Eof())
+	{
+		lockWaits->AddLock(set->GetLong(wxT("pid")), set->GetVal(wxT("object")), set->GetVal(wxT("name")),
+		                   set->GetVal(wxT("mode")), set->GetBool(wxT("granted")));
+		set->MoveNext();
+	}
+	delete set;
+
+	lockWaits->Build();
+
+	// The queries are only needed for the labels, when someone waits
+	LockGraphQueryMap queries;
+	if (lockWaits->GetNodeCount() > 0)
+	{
+		set = locks_connection->ExecuteSet(wxT("SELECT ") + pidcol + wxT(" AS pid, substr(") + querycol + wxT(", 1, 100) AS query FROM pg_stat_activity"));
+		if (!set)
+			return false;
+
+		while (!set->Eof())
+		{
+			long pid = set->GetLong(wxT("pid"));
+			if (lockWaits->FindNode(pid) >= 0)
+				queries[pid] = set->GetVal(wxT("query"));
+			set->MoveNext();
+		}
+		delete set;
+	}
+
+	lockCanvas->SetGraph(*lockWaits, queries);
+
+	wxString summary = wxString::Format(_("%ld waiting, %ld root blockers, %ld deadlock cycles"),
+	                                    lockWaits->GetWaitingCount(), lockWaits->GetRootCount(), lockWaits->GetCycleCount());
+	if (lockWaits->GetNodeCount() > LOCKGRAPH_MAX_SHAPES)
+		summary += wxT(" ") + wxString::Format(_("(showing %d of %d backends)"), LOCKGRAPH_MAX_SHAPES, (int)lockWaits->GetNodeCount());
+	stLockGraph->SetLabel(summary);
+
+	statusBar->SetStatusText(_("Done."));
+	return true;
+}
+
+
+void frmStatus::OnLockGraphToggle(wxCommandEvent &event)
+{
+	bool graph = chkLockGraph->GetValue();
+
+	lockList->Show(!graph);
+	lockCanvas->Show(graph);
+	if (graph)
+		lockList->DeleteAllItems();
+	else
+	{
+		lockCanvas->Clear();
+		stLockGraph->SetLabel(wxEmptyString);
+	}
+	lockCanvas->GetParent()->Layout();
+
+	wxTimerEvent evt;
+	OnRefreshLocksTimer(evt);
+}
+
 void frmStatus::OnRefreshXactTimer(wxTimerEvent &event)
 {
 	if (! viewMenu->IsEnabled(MNU_XACTPAGE) || ! viewMenu->IsChecked(MNU_XACTPAGE) || !xactTimer)
@@ -1707,7 +2067,9 @@ void frmStatus::OnRefreshXactTimer(wxTimerEvent &event)
 	if (dataSet3)
 	{
 		statusBar->SetStatusText(_("Refreshing transactions list."));
-		xactList->Freeze();
+
+		// Only rows, which come or go, have the list repainted as a whole
+		bool frozen = false;
 
 		while (!dataSet3->Eof())
 		{
@@ -1715,19 +2077,24 @@ void frmStatus::OnRefreshXactTimer(wxTimerEvent &event)
 
 			if (row >= xactList->GetItemCount())
 			{
+				if (!frozen)
+				{
+					xactList->Freeze();
+					frozen = true;
+				}
 				xactList->InsertItem(row, NumToStr(xid), -1);
 				row = xactList->GetItemCount() - 1;
 			}
 			else
 			{
-				xactList->SetItem(row, 0, NumToStr(xid));
+				xactList->UpdateItem(row, 0, NumToStr(xid));
 			}
 
 			int colpos = 1;
-			xactList->SetItem(row, colpos++, dataSet3->GetVal(wxT("gid")));
-			xactList->SetItem(row, colpos++, dataSet3->GetVal(wxT("prepared")));
-			xactList->SetItem(row, colpos++, dataSet3->GetVal(wxT("owner")));
-			xactList->SetItem(row, colpos++, dataSet3->GetVal(wxT("database")));
+			xactList->UpdateItem(row, colpos++, dataSet3->GetVal(wxT("gid")));
+			xactList->UpdateItem(row, colpos++, dataSet3->GetVal(wxT("prepared")));
+			xactList->UpdateItem(row, colpos++, dataSet3->GetVal(wxT("owner")));
+			xactList->UpdateItem(row, colpos++, dataSet3->GetVal(wxT("database")));
 
 			row++;
 			dataSet3->MoveNext();
@@ -1735,9 +2102,17 @@ void frmStatus::OnRefreshXactTimer(wxTimerEvent &event)
 		delete dataSet3;
 
 		while (row < xactList->GetItemCount())
+		{
+			if (!frozen)
+			{
+				xactList->Freeze();
+				frozen = true;
+			}
 			xactList->DeleteItem(row);
+		}
 
-		xactList->Thaw();
+		if (frozen)
+			xactList->Thaw();
 		wxListEvent ev;
 		OnSelXactItem(ev);
 		statusBar->SetStatusText(_("Done."));
@@ -1794,7 +2169,7 @@ void frmStatus::OnRefreshLogTimer(wxTimerEvent &event)
 		}
 		if (fillLogfileCombo())
 		{
-			savedPartialLine.Clear();
+			logCsvParser.Reset();
 			cbLogfiles->SetSelection(0);
 			wxCommandEvent ev;
 			OnLoadLogfile(ev);
@@ -1804,9 +2179,10 @@ void frmStatus::OnRefreshLogTimer(wxTimerEvent &event)
 		{
 			logDirectory = wxT("-");
 			if (connection->BackendMinimumVersion(8, 3))
-				logList->AppendItem(-1, wxString(_("logging_collector not enabled or log_filename misconfigured")));
+				logList->AddRow(_("logging_collector not enabled or log_filename misconfigured"));
 			else
-				logList->AppendItem(-1, wxString(_("redirect_stderr not enabled or log_filename misconfigured")));
+				logList->AddRow(_("redirect_stderr not enabled or log_filename misconfigured"));
+			logList->Flush();
 			cbLogfiles->Disable();
 			btnRotateLog->Disable();
 		}
@@ -1871,6 +2247,7 @@ void frmStatus::OnRefreshLogTimer(wxTimerEvent &event)
 
 				pos++;
 			}
+			logList->Flush();
 		}
 	}
 }
@@ -1936,19 +2313,17 @@ void frmStatus::addLogFile(const wxString &filename, const wxDateTime timestamp,
 
 	if (skipFirst)
 	{
+		// Only show the tail of a big logfile
 		long maxServerLogSize = settings->GetMaxServerLogSize();
 
-		if (!logfileLength && maxServerLogSize && logfileLength > maxServerLogSize)
-		{
-			long maxServerLogSize = settings->GetMaxServerLogSize();
-			len = read - maxServerLogSize;
-		}
+		if (!read && maxServerLogSize && len > maxServerLogSize)
+			read = len - maxServerLogSize;
 		else
 			skipFirst = false;
 	}
 
-	// If GPDB 3.3 and later, log is normally in CSV format.  Let's get a whole log line before calling addLogLine,
-	// so we can do things smarter.
+	// If GPDB 3.3 and later, log is normally in CSV format.  The records are
+	// split by logCsvParser, which keeps a partial record for the next read.
 
 	// PostgreSQL can log in CSV format, as well as regular format.  Normally, we'd only see
 	// the regular format logs here, because pg_logdir_ls only returns those.  But if pg_logdir_ls is
@@ -1956,19 +2331,16 @@ void frmStatus::addLogFile(const wxString &filename, const wxDateTime timestamp,
 
 	bool csv_log_format = filename.Right(4) == wxT(".csv");
 
-	if (csv_log_format && savedPartialLine.length() > 0)
-	{
-		if (read == 0)  // Starting at beginning of log file
-			savedPartialLine.clear();
-		else
-			line = savedPartialLine;
-	}
+	if (csv_log_format && read == 0)  // Starting at beginning of log file
+		logCsvParser.Reset();
 
 	while (len > read)
 	{
 		statusBar->SetStatusText(_("Reading log from server..."));
+
+		wxLongLong started = wxGetLocalTimeMillis();
 		pgSet *set = connection->ExecuteSet(wxT("SELECT pg_file_read(") +
-		                                    connection->qtDbString(filename) + wxT(", ") + NumToStr(read) + wxT(", 50000)"));
+		                                    connection->qtDbString(filename) + wxT(", ") + NumToStr(read) + wxT(", ") + NumToStr(logChunkSize) + wxT(")"));
 		if (!set)
 		{
 			connection->IsAlive();
@@ -1982,13 +2354,40 @@ void frmStatus::addLogFile(const wxString &filename, const wxDateTime timestamp,
 			break;
 		}
 
-		read += strlen(raw);
+		// Read bigger pieces of a big logfile, as long as the server keeps up
+		size_t rawLen = strlen(raw);
+		long took = (wxGetLocalTimeMillis() - started).GetLo();
+		if (took < LOG_CHUNK_TIME / 2 && (long)rawLen >= logChunkSize && logChunkSize < LOG_CHUNK_MAX)
+			logChunkSize = wxMin(logChunkSize * 2, LOG_CHUNK_MAX);
+		else if (took > LOG_CHUNK_TIME * 2 && logChunkSize > LOG_CHUNK_MIN)
+			logChunkSize = wxMax(logChunkSize / 2, LOG_CHUNK_MIN);
+
+		// Decode the piece once. A character cut off at its end is read
+		// again with the next piece.
+		size_t complete = rawLen;
+		if (len > read + (long)rawLen)
+		{
+			size_t lead = rawLen;
+			while (lead > 0 && rawLen - lead < 4 && (raw[lead - 1] & 0xC0) == 0x80)
+				lead--;
+			if (lead > 0 && (raw[lead - 1] & 0x80))
+			{
+				unsigned char c = raw[lead - 1];
+				size_t needed = (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 1;
+				if (rawLen - lead + 1 < needed)
+					complete = lead - 1;
+			}
+		}
 
-		wxString str;
-		if (wxString(wxString(raw, wxConvLibc).wx_str(), wxConvUTF8).Len() > 0)
-			str = line + wxString(wxString(raw, wxConvLibc).wx_str(), wxConvUTF8);
-		else
-			str = line + wxTextBuffer::Translate(wxString(raw, set->GetConversion()), wxTextFileType_Unix);
+		wxString str = wxString(raw, wxConvUTF8, complete);
+		if (str.IsEmpty())
+		{
+			complete = rawLen;
+			str = wxString(raw, wxConvLibc, complete);
+			if (str.IsEmpty())
+				str = wxTextBuffer::Translate(wxString(raw, set->GetConversion()), wxTextFileType_Unix);
+		}
+		read += complete;
 
 		delete set;
 
@@ -2003,75 +2402,35 @@ void frmStatus::addLogFile(const wxString &filename, const wxDateTime timestamp,
 		{
 			// This will work for any DB using CSV format logs
 
-			if (logHasTimestamp)
+			if (skipFirst)
 			{
-				// Right now, csv format logs from GPDB and PostgreSQL always start with a timestamp, so we count on that.
-
-				// And the only reason we need to do that is to make sure we are in sync.
-
-				// Bad things happen if we start in the middle of a
-				// double-quoted string, as we would never find a correct line terminator!
-
-				// In CSV logs, the first field must be a Timestamp, so must start with "2009" or "201" or "202" (at least for the next 20 years).
-				if (str.length() > 4 && str.Left(4) != wxT("2009") && str.Left(3) != wxT("201") && str.Left(3) != wxT("202"))
-				{
-					wxLogNotice(wxT("Log line does not start with timestamp: %s \n"), str.Mid(0, 100).c_str());
-					// Something isn't right, as we are not at the beginning of a csv log record.
-					// We should never get here, but if we do, try to handle it in a smart way.
-					str = str.Mid(str.Find(wxT("\n20")) + 1); // Try to re-sync.
-				}
+				// Right now, csv format logs from GPDB and PostgreSQL always start with a timestamp,
+				// so a record starts at a line starting with one. Bad things happen if we start in
+				// the middle of a double-quoted string, as we would never find a correct line terminator!
+				int pos = str.Find(wxT("\n20"));
+				if (pos < 0)
+					continue;
+				str = str.Mid(pos + 1);
+				skipFirst = false;
 			}
 
-			CSVLineTokenizer tk(str);
-
-			logList->Freeze();
-
-			while (tk.HasMoreLines())
-			{
-				line.Clear();
-
-				bool partial;
-				str = tk.GetNextLine(partial);
-				if (partial)
-				{
-					line = str; // Start of a log line, but not complete.  Loop back, Read more data.
-					break;
-				}
-
-				// Some extra debug checking, assuming csv logs line start with timestamps.
-				// Not really necessary, but it is good for debugging if something isn't right.
-				if (logHasTimestamp)
-				{
-					// The first field must be a Timestamp, so must start with "2009" or "201" or "202" (at least for the next 20 years).
-					// This is just an extra check to make sure we haven't gotten out of sync with the log.
-					if (str.length() > 5 && str.Left(4) != wxT("2009") && str.Left(3) != wxT("201") && str.Left(3) != wxT("202"))
-					{
-						// BUG:  We are out of sync on the log
-						wxLogNotice(wxT("Log line does not start with timestamp: %s\n"), str.c_str());
-					}
-					else if (str.length() < 20)
-					{
-						// BUG:  We are out of sync on the log, or the log is garbled
-						wxLogNotice(wxT("Log line too short: %s\n"), str.c_str());
-					}
-				}
-
-				// Looks like we have a good complete CSV log record.
-				addLogLine(str.Trim(), true, true);
-			}
+			logCsvParser.SetInput(str);
 
-			logList->Thaw();
+			wxArrayString fields;
+			while (logCsvParser.GetNextRecord(fields))
+				addLogRecord(fields);
 		}
 		else
 		{
 			// Non-csv format log file
 
+			str = line + str;
+			line.Clear();
+
 			bool hasCr = (str.Right(1) == wxT("\n"));
 
 			wxStringTokenizer tk(str, wxT("\n"));
 
-			logList->Freeze();
-
 			while (tk.HasMoreTokens())
 			{
 				str = tk.GetNextToken();
@@ -2087,32 +2446,215 @@ void frmStatus::addLogFile(const wxString &filename, const wxDateTime timestamp,
 				else
 					line = str;
 			}
+		}
+
+		logList->Flush();
+	}
+
+	// We finished reading to the end of the log file, but may still have some data left.
+	// A partial CSV record is kept by logCsvParser for the next read of the data file.
+	if (!line.IsEmpty())
+	{
+		addLogLine(line.Trim());
+		logList->Flush();
+	}
+}
+
+
+// The next field of a CSV log record, or an empty string past the last one
+static wxString NextField(const wxArrayString &fields, size_t &field)
+{
+	if (field >= fields.GetCount())
+		return wxEmptyString;
+	return fields.Item(field++);
+}
+
+
+// Add a record of a CSV format log (GPDB 3.3 and later, or Postgres if only csv log enabled)
+void frmStatus::addLogRecord(const wxArrayString &fields)
+{
+	size_t field = 0;
+	wxString logTime = NextField(fields, field);
+
+	if (logHasTimestamp && (logTime.Length() < 20 || logTime[0] != wxT('2') || logTime[1] != wxT('0')))
+	{
+		// Record too short or does not start with an expected timestamp...
+		// Must be garbage, or we are out of sync in our CSV handling.
+		// We shouldn't ever get here.
+		wxLogNotice(wxT("Log line does not start with timestamp: %s\n"), logTime.Mid(0, 100).c_str());
 
-			logList->Thaw();
+		wxString str = logTime;
+		while (field < fields.GetCount())
+			str += wxT(",") + NextField(fields, field);
+
+		logList->AddRow();
+		logList->SetLastItem(2, str);
+		return;
+	}
+
+	bool gpdb = connection->GetIsGreenplum();
+
+	// Get the fields from the CSV log.
+	wxString logUser = NextField(fields, field);
+	wxString logDatabase = NextField(fields, field);
+	wxString logPid = NextField(fields, field);
+
+	wxString logSession;
+	wxString logCmdcount;
+	wxString logSegment;
+
+	if (gpdb)
+	{
+		wxString logThread =  NextField(fields, field);        // GPDB specific
+		wxString logHost = NextField(fields, field);
+		wxString logPort = NextField(fields, field);           // GPDB (Postgres puts port with Host)
+		wxString logSessiontime = NextField(fields, field);
+		wxString logTransaction = NextField(fields, field);
+		logSession = NextField(fields, field);
+		logCmdcount = NextField(fields, field);
+		logSegment = NextField(fields, field);
+		wxString logSlice = NextField(fields, field);
+		wxString logDistxact = NextField(fields, field);
+		wxString logLocalxact = NextField(fields, field);
+		wxString logSubxact = NextField(fields, field);
+	}
+	else
+	{
+		wxString logHost = NextField(fields, field);       // Postgres puts port with Hostname
+		logSession = NextField(fields, field);
+		wxString logLineNumber = NextField(fields, field);
+		wxString logPsDisplay = NextField(fields, field);
+		wxString logSessiontime = NextField(fields, field);
+		wxString logVXid = NextField(fields, field);
+		wxString logTransaction = NextField(fields, field);
+	}
+
+	wxString logSeverity = NextField(fields, field);
+	wxString logState = NextField(fields, field);
+	wxString logMessage = NextField(fields, field);
+	wxString logDetail = NextField(fields, field);
+	wxString logHint = NextField(fields, field);
+	wxString logQuery = NextField(fields, field);
+	wxString logQuerypos = NextField(fields, field);
+	wxString logContext = NextField(fields, field);
+	wxString logDebug = NextField(fields, field);
+	wxString logCursorpos = NextField(fields, field);
+
+	wxString logStack;
+	if (gpdb)
+	{
+		wxString logFunction = NextField(fields, field);       // GPDB.  Postgres puts func, file, and line together
+		wxString logFile = NextField(fields, field);
+		wxString logLine = NextField(fields, field);
+		logStack = NextField(fields, field);                   // GPDB only.
+	}
+	else
+		wxString logFuncFileLine = NextField(fields, field);
+
+	logList->AddRow(logTime);      // Insert timestamp (with time zone)
+
+	logList->SetLastItem(1, logSeverity);
+
+	// Display the logMessage, breaking it into lines
+	wxStringTokenizer lm(logMessage, wxT("\n"));
+	logList->SetLastItem(2, lm.GetNextToken());
+
+	logList->SetLastItem(3, logSession);
+	logList->SetLastItem(4, logCmdcount);
+	logList->SetLastItem(5, logDatabase);
+	if ((!gpdb) || (logSegment.length() > 0 && logSegment != wxT("seg-1")))
+	{
+		logList->SetLastItem(6, logSegment);
+	}
+	else
+	{
+		// If we are reading the masterDB log only, the logSegment won't
+		// have anything useful in it.  Look in the logMessage, and see if the
+		// segment info exists in there.  It will always be at the end.
+		if (logMessage.length() > 0 && logMessage[logMessage.length() - 1] == wxT(')'))
+		{
+			int segpos = -1;
+			segpos = logMessage.Find(wxT("(seg"));
+			if (segpos <= 0)
+				segpos = logMessage.Find(wxT("(mir"));
+			if (segpos > 0)
+			{
+				logSegment = logMessage.Mid(segpos + 1);
+				if (logSegment.Find(wxT(' ')) > 0)
+					logSegment = logSegment.Mid(0, logSegment.Find(wxT(' ')));
+				logList->SetLastItem(6, logSegment);
+			}
 		}
 	}
 
-	savedPartialLine.clear();
+	// The rest of the lines from the logMessage
+	while (lm.HasMoreTokens())
+	{
+		logList->AddRow();
+		logList->SetLastItem(2, lm.GetNextToken());
+	}
 
-	if (!line.IsEmpty())
+	// Add the detail
+	wxStringTokenizer ld(logDetail, wxT("\n"));
+	while (ld.HasMoreTokens())
 	{
-		// We finished reading to the end of the log file, but still have some data left
-		if (csv_log_format)
+		logList->AddRow();
+		logList->SetLastItem(2, ld.GetNextToken());
+	}
+
+	// And the hint
+	wxStringTokenizer lh(logHint, wxT("\n"));
+	while (lh.HasMoreTokens())
+	{
+		logList->AddRow();
+		logList->SetLastItem(2, lh.GetNextToken());
+	}
+
+	if (logDebug.length() > 0)
+	{
+		wxString logState3 = logState.Mid(0, 3);
+		if (logState3 == wxT("426") || logState3 == wxT("22P") || logState3 == wxT("427")
+		        || logState3 == wxT("42P") || logState3 == wxT("458")
+		        || logMessage.Mid(0, 9) == wxT("duration:") || logSeverity == wxT("FATAL") || logSeverity == wxT("PANIC"))
 		{
-			savedPartialLine = line;    // Save partial log line for next read of the data file.
-			line.Clear();
+			// If not redundant, add the statement from the debug_string
+			wxStringTokenizer lh(logDebug, wxT("\n"));
+			if (lh.HasMoreTokens())
+			{
+				logList->AddRow();
+				logList->SetLastItem(2, wxT("statement: ") + lh.GetNextToken());
+			}
+			while (lh.HasMoreTokens())
+			{
+				logList->AddRow();
+				logList->SetLastItem(2, lh.GetNextToken());
+			}
 		}
-		else
-			addLogLine(line.Trim());
 	}
 
+	if (gpdb)
+		if (logSeverity == wxT("PANIC") ||
+		        (logSeverity == wxT("FATAL") && logState != wxT("57P03") && logState != wxT("53300")))
+		{
+			// If this is a severe error, add the stack trace.
+			wxStringTokenizer ls(logStack, wxT("\n"));
+			if (ls.HasMoreTokens())
+			{
+				logList->AddRow();
+				logList->SetLastItem(1, wxT("STACK"));
+				logList->SetLastItem(2, ls.GetNextToken());
+			}
+			while (ls.HasMoreTokens())
+			{
+				logList->AddRow();
+				logList->SetLastItem(2, ls.GetNextToken());
+			}
+		}
 }
 
 
-void frmStatus::addLogLine(const wxString &str, bool formatted, bool csv_log_format)
+void frmStatus::addLogLine(const wxString &str, bool formatted)
 {
-	int row = logList->GetItemCount();
-
 	int idxTimeStampCol = -1, idxLevelCol = -1;
 	int idxLogEntryCol = 0;
 
@@ -2132,216 +2674,30 @@ void frmStatus::addLogLine(const wxString &str, bool formatted, bool csv_log_for
 	}
 
 	if (!logFormatKnown)
-		logList->AppendItem(-1, str);
-	else if ((!csv_log_format) && str.Find(':') < 0)
+		logList->AddRow(str);
+	else if (str.Find(':') < 0)
 	{
 		// Must be a continuation of a previous line.
-		logList->InsertItem(row, wxEmptyString, -1);
-		logList->SetItem(row, idxLogEntryCol, str);
+		logList->AddRow();
+		logList->SetLastItem(idxLogEntryCol, str);
 	}
 	else if (!formatted)
 	{
 		// Not from a log, from pgAdmin itself.
 		if (logHasTimestamp)
 		{
-			logList->InsertItem(row, wxEmptyString, -1);
-			logList->SetItem(row, idxLevelCol, str.BeforeFirst(':'));
+			logList->AddRow();
+			logList->SetLastItem(idxLevelCol, str.BeforeFirst(':'));
 		}
 		else
 		{
-			logList->InsertItem(row, str.BeforeFirst(':'), -1);
+			logList->AddRow(str.BeforeFirst(':'));
 		}
-		logList->SetItem(row, idxLogEntryCol, str.AfterFirst(':'));
+		logList->SetLastItem(idxLogEntryCol, str.AfterFirst(':'));
 	}
 	else // formatted log
 	{
-		if (csv_log_format)
-		{
-			// Log is in CSV format (GPDB 3.3 and later, or Postgres if only csv log enabled)
-			// In this case, we are always supposed to have a complete log line in csv format in str when called.
-
-			if (logHasTimestamp && (str.Length() < 20 || (logHasTimestamp && (str[0] != wxT('2') || str[1] != wxT('0')))))
-			{
-				// Log line too short or does not start with an expected timestamp...
-				// Must be a continuation of the previous line or garbage,
-				// or we are out of sync in our CSV handling.
-				// We shouldn't ever get here.
-				logList->InsertItem(row, wxEmptyString, -1);
-				logList->SetItem(row, 2, str);
-			}
-			else
-			{
-				CSVTokenizer tk(str);
-
-				bool gpdb = connection->GetIsGreenplum();
-
-				// Get the fields from the CSV log.
-				wxString logTime = tk.GetNextToken();
-				wxString logUser = tk.GetNextToken();
-				wxString logDatabase = tk.GetNextToken();
-				wxString logPid = tk.GetNextToken();
-
-				wxString logSession;
-				wxString logCmdcount;
-				wxString logSegment;
-
-				if (gpdb)
-				{
-					wxString logThread =  tk.GetNextToken();        // GPDB specific
-					wxString logHost = tk.GetNextToken();
-					wxString logPort = tk.GetNextToken();           // GPDB (Postgres puts port with Host)
-					wxString logSessiontime = tk.GetNextToken();
-					wxString logTransaction = tk.GetNextToken();
-					logSession = tk.GetNextToken();
-					logCmdcount = tk.GetNextToken();
-					logSegment = tk.GetNextToken();
-					wxString logSlice = tk.GetNextToken();
-					wxString logDistxact = tk.GetNextToken();
-					wxString logLocalxact = tk.GetNextToken();
-					wxString logSubxact = tk.GetNextToken();
-				}
-				else
-				{
-					wxString logHost = tk.GetNextToken();       // Postgres puts port with Hostname
-					logSession = tk.GetNextToken();
-					wxString logLineNumber = tk.GetNextToken();
-					wxString logPsDisplay = tk.GetNextToken();
-					wxString logSessiontime = tk.GetNextToken();
-					wxString logVXid = tk.GetNextToken();
-					wxString logTransaction = tk.GetNextToken();
-				}
-
-				wxString logSeverity = tk.GetNextToken();
-				wxString logState = tk.GetNextToken();
-				wxString logMessage = tk.GetNextToken();
-				wxString logDetail = tk.GetNextToken();
-				wxString logHint = tk.GetNextToken();
-				wxString logQuery = tk.GetNextToken();
-				wxString logQuerypos = tk.GetNextToken();
-				wxString logContext = tk.GetNextToken();
-				wxString logDebug = tk.GetNextToken();
-				wxString logCursorpos = tk.GetNextToken();
-
-				wxString logStack;
-				if (gpdb)
-				{
-					wxString logFunction = tk.GetNextToken();       // GPDB.  Postgres puts func, file, and line together
-					wxString logFile = tk.GetNextToken();
-					wxString logLine = tk.GetNextToken();
-					logStack = tk.GetNextToken();                   // GPDB only.
-				}
-				else
-					wxString logFuncFileLine = tk.GetNextToken();
-
-				logList->InsertItem(row, logTime, -1);      // Insert timestamp (with time zone)
-
-				logList->SetItem(row, 1, logSeverity);
-
-				// Display the logMessage, breaking it into lines
-				wxStringTokenizer lm(logMessage, wxT("\n"));
-				logList->SetItem(row, 2, lm.GetNextToken());
-
-				logList->SetItem(row, 3, logSession);
-				logList->SetItem(row, 4, logCmdcount);
-				logList->SetItem(row, 5, logDatabase);
-				if ((!gpdb) || (logSegment.length() > 0 && logSegment != wxT("seg-1")))
-				{
-					logList->SetItem(row, 6, logSegment);
-				}
-				else
-				{
-					// If we are reading the masterDB log only, the logSegment won't
-					// have anything useful in it.  Look in the logMessage, and see if the
-					// segment info exists in there.  It will always be at the end.
-					if (logMessage.length() > 0 && logMessage[logMessage.length() - 1] == wxT(')'))
-					{
-						int segpos = -1;
-						segpos = logMessage.Find(wxT("(seg"));
-						if (segpos <= 0)
-							segpos = logMessage.Find(wxT("(mir"));
-						if (segpos > 0)
-						{
-							logSegment = logMessage.Mid(segpos + 1);
-							if (logSegment.Find(wxT(' ')) > 0)
-								logSegment = logSegment.Mid(0, logSegment.Find(wxT(' ')));
-							logList->SetItem(row, 6, logSegment);
-						}
-					}
-				}
-
-				// The rest of the lines from the logMessage
-				while (lm.HasMoreTokens())
-				{
-					int controw = logList->GetItemCount();
-					logList->InsertItem(controw, wxEmptyString, -1);
-					logList->SetItem(controw, 2, lm.GetNextToken());
-				}
-
-				// Add the detail
-				wxStringTokenizer ld(logDetail, wxT("\n"));
-				while (ld.HasMoreTokens())
-				{
-					int controw = logList->GetItemCount();
-					logList->InsertItem(controw, wxEmptyString, -1);
-					logList->SetItem(controw, 2, ld.GetNextToken());
-				}
-
-				// And the hint
-				wxStringTokenizer lh(logHint, wxT("\n"));
-				while (lh.HasMoreTokens())
-				{
-					int controw = logList->GetItemCount();
-					logList->InsertItem(controw, wxEmptyString, -1);
-					logList->SetItem(controw, 2, lh.GetNextToken());
-				}
-
-				if (logDebug.length() > 0)
-				{
-					wxString logState3 = logState.Mid(0, 3);
-					if (logState3 == wxT("426") || logState3 == wxT("22P") || logState3 == wxT("427")
-					        || logState3 == wxT("42P") || logState3 == wxT("458")
-					        || logMessage.Mid(0, 9) == wxT("duration:") || logSeverity == wxT("FATAL") || logSeverity == wxT("PANIC"))
-					{
-						// If not redundant, add the statement from the debug_string
-						wxStringTokenizer lh(logDebug, wxT("\n"));
-						if (lh.HasMoreTokens())
-						{
-							int controw = logList->GetItemCount();
-							logList->InsertItem(controw, wxEmptyString, -1);
-							logList->SetItem(controw, 2, wxT("statement: ") + lh.GetNextToken());
-						}
-						while (lh.HasMoreTokens())
-						{
-							int controw = logList->GetItemCount();
-							logList->InsertItem(controw, wxEmptyString, -1);
-							logList->SetItem(controw, 2, lh.GetNextToken());
-						}
-					}
-				}
-
-				if (gpdb)
-					if (logSeverity == wxT("PANIC") ||
-					        (logSeverity == wxT("FATAL") && logState != wxT("57P03") && logState != wxT("53300")))
-					{
-						// If this is a severe error, add the stack trace.
-						wxStringTokenizer ls(logStack, wxT("\n"));
-						if (ls.HasMoreTokens())
-						{
-							int controw = logList->GetItemCount();
-							logList->InsertItem(controw, wxEmptyString, -1);
-							logList->SetItem(controw, 1, wxT("STACK"));
-							logList->SetItem(controw, 2, ls.GetNextToken());
-						}
-						while (ls.HasMoreTokens())
-						{
-							int controw = logList->GetItemCount();
-							logList->InsertItem(controw, wxEmptyString, -1);
-							logList->SetItem(controw, 2, ls.GetNextToken());
-						}
-					}
-			}
-		}
-		else if (connection->GetIsGreenplum())
+		if (connection->GetIsGreenplum())
 		{
 			// Greenplum 3.2 and before.  log_line_prefix =  "%m|%u|%d|%p|%I|%X|:-"
 
@@ -2364,21 +2720,21 @@ void frmStatus::addLogLine(const wxString &str, bool formatted, bool csv_log_for
 			{
 				// No Timestamp?  Must be a continuation of a previous line?
 				// Not sure if it is possible to get here.
-				logList->InsertItem(row, wxEmptyString, -1);
-				logList->SetItem(row, 2, rest);
+				logList->AddRow();
+				logList->SetLastItem(2, rest);
 			}
 			else if (logSeverity.Length() > 1)
 			{
 				// Normal case:  Start of a new log record.
-				logList->InsertItem(row, ts, -1);
-				logList->SetItem(row, 1, logSeverity);
-				logList->SetItem(row, 2, rest);
+				logList->AddRow(ts);
+				logList->SetLastItem(1, logSeverity);
+				logList->SetLastItem(2, rest);
 			}
 			else
 			{
 				// Continuation of previous line
-				logList->InsertItem(row, wxEmptyString, -1);
-				logList->SetItem(row, 2, rest);
+				logList->AddRow();
+				logList->SetLastItem(2, rest);
 			}
 		}
 		else
@@ -2395,15 +2751,15 @@ void frmStatus::addLogLine(const wxString &str, bool formatted, bool csv_log_for
 					wxString ts = str.Mid(logFmtPos, str.Length() - rest.Length() - logFmtPos - 1);
 
 					int pos = ts.Find(logFormat.c_str()[logFmtPos + 2], true);
-					logList->InsertItem(row, ts.Left(pos), -1);
-					logList->SetItem(row, idxLevelCol, ts.Mid(pos + logFormat.Length() - logFmtPos - 2));
-					logList->SetItem(row, idxLogEntryCol, rest.Mid(2));
+					logList->AddRow(ts.Left(pos));
+					logList->SetLastItem(idxLevelCol, ts.Mid(pos + logFormat.Length() - logFmtPos - 2));
+					logList->SetLastItem(idxLogEntryCol, rest.Mid(2));
 				}
 				else
 				{
-					logList->InsertItem(row, wxEmptyString, -1);
-					logList->SetItem(row, idxLevelCol, str.BeforeFirst(':'));
-					logList->SetItem(row, idxLogEntryCol, str.AfterFirst(':').Mid(2));
+					logList->AddRow();
+					logList->SetLastItem(idxLevelCol, str.BeforeFirst(':'));
+					logList->SetLastItem(idxLogEntryCol, str.AfterFirst(':').Mid(2));
 				}
 			}
 			else
@@ -2416,11 +2772,11 @@ void frmStatus::addLogLine(const wxString &str, bool formatted, bool csv_log_for
 				int pos = rest.Find(':');
 
 				if (pos < 0)
-					logList->InsertItem(row, rest, -1);
+					logList->AddRow(rest);
 				else
 				{
-					logList->InsertItem(row, rest.BeforeFirst(':'), -1);
-					logList->SetItem(row, idxLogEntryCol, rest.AfterFirst(':').Mid(2));
+					logList->AddRow(rest.BeforeFirst(':'));
+					logList->SetLastItem(idxLogEntryCol, rest.AfterFirst(':').Mid(2));
 				}
 			}
 		}
@@ -2497,7 +2853,8 @@ void frmStatus::OnLoadLogfile(wxCommandEvent &event)
 
 		if (ts != NULL && (!logfileTimestamp.IsValid() || *ts != logfileTimestamp))
 		{
-			logList->DeleteAllItems();
+			logList->ClearRows();
+			logCsvParser.Reset();
 			addLogFile(ts, true);
 		}
 	}
@@ -2511,6 +2868,12 @@ void frmStatus::OnRotateLogfile(wxCommandEvent &event)
 }
 
 
+void frmStatus::OnLogFilter(wxCommandEvent &event)
+{
+	logList->SetFilter(cbLogLevel->GetSelection(), txtLogFilter->GetValue());
+}
+
+
 void frmStatus::OnCancelBtn(wxCommandEvent &event)
 {
 	switch(currentPane)
@@ -31,6 +31,10 @@ public:
 
 	void AddColumn(const wxString &text, int size = wxLIST_AUTOSIZE_USEHEADER, int format = wxLIST_FORMAT_LEFT);
 
+	// Change an item only if it's different, so unchanged rows aren't repainted
+	void UpdateItem(long row, long col, const wxString &text);
+	void UpdateItemBackgroundColour(long row, const wxColour &colour);
+
 	long AppendItem(int icon, const wxString &val, const wxString &val2 = wxString(), const wxString &val3 = wxString(), const wxString &val4 = wxString());
 	long AppendItem(const wxString &val, const wxString &val2 = wxString(), const wxString &val3 = wxString())
 	{
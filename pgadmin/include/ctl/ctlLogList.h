@@ -0,0 +1,110 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// ctlLogList.h - virtual listview control showing the tail of a server log
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef CTLLOGLIST_H
+#define CTLLOGLIST_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+
+#include "ctl/ctlListView.h"
+
+// Columns kept for each row of the log
+#define LOGLIST_COLUMNS 7
+
+// Memory (bytes) the rows may take; the oldest rows are dropped beyond it
+#define LOGLIST_MEMORY_BUDGET (32 * 1024 * 1024)
+
+// The severity levels a log can be filtered by
+enum
+{
+	LOGLEVEL_UNKNOWN = -1,
+	LOGLEVEL_DEBUG = 0,
+	LOGLEVEL_LOG,
+	LOGLEVEL_NOTICE,
+	LOGLEVEL_WARNING,
+	LOGLEVEL_ERROR,
+	LOGLEVEL_FATAL,
+	LOGLEVEL_PANIC
+};
+
+class ctlLogRow
+{
+public:
+	ctlLogRow() : record(0), level(LOGLEVEL_UNKNOWN) {}
+	size_t GetSize() const;
+
+	wxString cols[LOGLIST_COLUMNS];
+	long record;    // The number of the first row of the record
+	int level;      // The level of the record
+};
+
+// The rows are kept in a ring buffer, which drops the oldest rows when the
+// memory budget is used up. A row with a level in the level column starts
+// a new record; the rows following it without one (the details, hints and
+// continued lines) belong to that record. Filters keep or drop whole
+// records, and are applied to the rows, not to the widget, which only
+// shows the (numbers of the) rows, which are left.
+class ctlLogList : public ctlListView
+{
+public:
+	ctlLogList(wxWindow *p, int id, wxPoint pos, wxSize siz, long attr = 0);
+	~ctlLogList();
+
+	void SetLevelColumn(int col)
+	{
+		levelColumn = col;
+	}
+
+	// Add a row, the other columns of which are set with SetLastItem()
+	void AddRow(const wxString &text = wxEmptyString);
+	void SetLastItem(int col, const wxString &text);
+
+	// Show the rows added
+	void Flush();
+	void ClearRows();
+
+	// Show the records of minLevel or above, containing text, only
+	void SetFilter(int minLevel, const wxString &text);
+
+	static int GetLevel(const wxString &severity);
+
+	wxString OnGetItemText(long item, long col) const;
+
+private:
+	ctlLogRow *GetRow(long number) const
+	{
+		return rows[(head + number - firstNumber) % capacity];
+	}
+	bool IsFiltered() const
+	{
+		return filterLevel > LOGLEVEL_DEBUG || !filterText.IsEmpty();
+	}
+	void DropOldest();
+	void FilterRows();
+	bool RowMatches(ctlLogRow *row) const;
+
+	ctlLogRow **rows;
+	long capacity, head, count;
+	long firstNumber;       // The number of the oldest row kept
+	size_t usedBytes;
+
+	int levelColumn;
+
+	int filterLevel;
+	wxString filterText;    // lower case
+	wxArrayLong shown;      // The numbers of the rows shown, when filtered
+	size_t shownStart;      // Entries before this one have been dropped
+	long filteredUpTo;      // The rows before this one have been filtered
+};
+
+#endif
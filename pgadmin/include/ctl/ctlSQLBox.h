@@ -35,6 +35,7 @@ struct TextToFind
 };
 
 class sysProcess;
+class pgCompletionCache;
 
 // Class declarations
 class ctlSQLBox : public wxStyledTextCtrl
@@ -91,6 +92,7 @@ private:
 
 	dlgFindReplace *m_dlgFindReplace;
 	pgConn *m_database;
+	pgCompletionCache *m_completionCache;
 	bool m_autoIndent, m_autocompDisabled;
 
 	friend class QueryPrintout;
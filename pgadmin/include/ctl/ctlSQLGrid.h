@@ -29,7 +29,7 @@ public:
 	{
 		return false;
 	}
-	int Copy();
+	virtual int Copy();
 
 	virtual bool CheckRowPresent(int row)
 	{
@@ -41,12 +41,18 @@ public:
 
 	void AutoSizeColumn(int col, bool setAsMin = false, bool doLimit = true);
 	void AutoSizeColumns(bool setAsMin);
+	// Size the columns by the given widths of their cells (0, if not known)
+	// and their labels
+	void SetColumnSizes(const wxArrayInt &cellSizes);
 
 	WX_DECLARE_STRING_HASH_MAP( int, ColKeySizeHashMap );
 
 	DECLARE_DYNAMIC_CLASS(ctlSQLGrid)
 	DECLARE_EVENT_TABLE()
 
+protected:
+	void AppendColumnHeader(wxString &str, wxArrayInt columns);
+
 private:
 	void OnCopy(wxCommandEvent &event);
 	void OnMouseWheel(wxMouseEvent &event);
@@ -54,7 +60,6 @@ private:
 	wxString GetColumnName(int colNum);
 	wxString GetColKeyValue(int col);
 	void AppendColumnHeader(wxString &str, int start, int end);
-	void AppendColumnHeader(wxString &str, wxArrayInt columns);
 
 	// Stores sizes of colums explicitly resized by user
 	ColKeySizeHashMap colSizes;
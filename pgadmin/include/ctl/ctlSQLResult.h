@@ -17,11 +17,27 @@
 
 #include "db/pgSet.h"
 #include "db/pgConn.h"
+#include "db/pgRowStore.h"
+#include "db/pgResultView.h"
 #include "ctlSQLGrid.h"
 #include "frm/frmExport.h"
 
 #define CTLSQL_RUNNING 100  // must be greater than ExecStatusType PGRES_xxx values
 
+// Interval (ms) to show the rows, which have been streamed in so far
+#define CTLSQL_STREAM_INTERVAL 250
+
+// The formatted cells are cached in blocks of rows and columns
+#define CTLSQL_CACHE_BLOCK_ROWS 32
+#define CTLSQL_CACHE_BLOCK_COLS 16
+#define CTLSQL_CACHE_MAX_BLOCKS 128
+
+// The columns are sized by the values of this many rows, spread over the result
+#define CTLSQL_SIZE_SAMPLES 1000
+#define CTLSQL_SIZE_HEAD_ROWS 200
+
+class sqlResultSizer;
+
 class ctlSQLResult : public ctlSQLGrid
 {
 public:
@@ -45,6 +61,12 @@ public:
 		return NumRows() > 0 && colNames.GetCount() > 0;
 	}
 
+	// Copy the selected cells to the clipboard, in one of the EXPORT_FORMAT_xxx.
+	// Copy() copies them as they're shown.
+	int Copy();
+	int CopyAs(int format);
+	wxString GetCopyTable(const wxArrayInt &cols);
+
 	wxString OnGetItemText(long item, long col) const;
 	bool IsColText(int col);
 	bool hasRowNumber()
@@ -67,17 +89,77 @@ public:
 	void SetMaxRows(int rows);
 	void ResultsFinished();
 	void OnGridSelect(wxGridRangeSelectEvent &event);
+	void OnStreamTimer(wxTimerEvent &event);
+	void OnSizingDone(wxCommandEvent &event);
+	void OnLabelRightClick(wxGridEvent &event);
+	void OnSortColumn(wxCommandEvent &event);
+	void OnFilterColumn(wxCommandEvent &event);
+	void OnResetView(wxCommandEvent &event);
+	void OnCopyAs(wxCommandEvent &event);
+
+	// Are the rows being (or, have been) streamed in the row store?
+	bool IsStreaming() const;
+
+	// Where the rows shown in the grid come from
+	pgSet *GetDataSet() const;
+	pgRowStore *GetRowStore() const;
+
+	// The order and the filter of the rows shown, if they have been changed
+	pgResultView *GetResultView()
+	{
+		return resultView.IsActive() ? &resultView : NULL;
+	}
 
 	wxArrayString colNames;
 	wxArrayString colTypes;
 	wxArrayLong colTypClasses;
 
 private:
+	void PublishStreamedRows();
+	void ClearStreamedRows();
+	void ShowView(long oldRows);
+	void StartSizing(const wxArrayLong &typClasses);
+	void StopSizing();
+
 	pgQueryThread *thread;
 	pgConn *conn;
 	bool rowcountSuppressed;
+
+	pgRowStore *rowStore;
+	wxTimer *streamTimer;
+	long publishedRows, publishedCols;
+	unsigned long publishedGeneration;
+
+	pgResultView resultView;
+	int viewCol;
+	wxString lastFilter;
+
+	sqlResultSizer *sizer;
 };
 
+// The settings, by which the values are shown
+class sqlResultFormat
+{
+public:
+	void Load();
+
+	bool indicateNull;
+	wxString decimalMark, thousandsSeparator;
+	long maxColSize;
+};
+
+// A block of formatted cells of the result grid
+class sqlResultCacheBlock
+{
+public:
+	wxArrayString values;
+	wxArrayInt nulls;
+	int numRows, numCols;
+	unsigned long lastUsed;
+};
+
+WX_DECLARE_HASH_MAP(wxLongLong_t, sqlResultCacheBlock *, wxIntegerHash, wxIntegerEqual, sqlResultCacheMap);
+
 class sqlResultTable : public wxGridTableBase
 {
 public:
@@ -100,6 +182,25 @@ public:
 	void SetThread(pgQueryThread *t)
 	{
 		thread = t;
+		ClearCache();
+	}
+	void SetRowStore(pgRowStore *s)
+	{
+		rowStore = s;
+		ClearCache();
+	}
+	void SetView(pgResultView *v)
+	{
+		view = v;
+		ClearCache();
+	}
+	// The number of streamed rows/columns, the grid has been told about
+	void SetStreamedSize(long rows, long cols)
+	{
+		if (rows < streamedRows || cols != streamedCols)
+			ClearCache();
+		streamedRows = rows;
+		streamedCols = cols;
 	}
 	bool DeleteRows(size_t pos = 0, size_t numRows = 1)
 	{
@@ -111,8 +212,26 @@ public:
 	}
 	wxGridCellAttr *GetAttr(int row, int col, wxGridCellAttr::wxAttrKind kind);
 
+	// Safe to use in other threads, if the format isn't changed meanwhile
+	static wxString FormatText(const wxString &value, bool isNull, pgTypClass typClass, const sqlResultFormat &format);
+
 private:
+	bool IsStreaming();
+	pgTypClass ColTypClass(int col);
+	wxString FormatValue(int row, int col, bool &isNull);
+
+	void ClearCache();
+	sqlResultCacheBlock *GetCacheBlock(int row, int col);
+
 	pgQueryThread *thread;
+	pgRowStore *rowStore;
+	pgResultView *view;
+	long streamedRows, streamedCols;
+
+	sqlResultCacheMap cellCache;
+	unsigned long cacheUseCounter, cacheFormatGeneration;
+	bool cacheStreaming, cacheDataValid;
+	sqlResultFormat format;
 
 	wxColour colourOdd;
 	wxColour colourOddNull;
@@ -124,4 +243,53 @@ private:
 	wxGridCellAttr *attrEvenNull;
 };
 
+// The widths of the characters of a font, so that the width of a text can
+// be told without a device context (i.e. in another thread)
+class sqlResultGlyphWidths
+{
+public:
+	// The widths are measured once per font
+	static sqlResultGlyphWidths *Get(wxWindow *window, const wxFont &font);
+
+	int GetWidth(const wxString &text) const;
+
+private:
+	int widths[256];
+	int wideWidth, otherWidth;
+};
+
+WX_DECLARE_STRING_HASH_MAP(sqlResultGlyphWidths *, sqlResultGlyphWidthsMap);
+
+// Estimates the widths of the cells of each column from a sample of the rows,
+// while the grid is already shown.
+class sqlResultSizer : public wxThread
+{
+public:
+	sqlResultSizer(wxEvtHandler *handler, pgSet *set, pgRowStore *store, long nRows,
+	               const wxArrayLong &typClasses, const sqlResultGlyphWidths *glyphs);
+	virtual void *Entry();
+
+	void Cancel()
+	{
+		cancelled = true;
+	}
+	bool IsDone() const
+	{
+		return done;
+	}
+
+	wxArrayInt cellSizes;
+
+private:
+	wxEvtHandler *handler;
+	pgSet *set;
+	pgRowStore *store;
+	long nRows;
+	wxArrayLong typClasses;
+	const sqlResultGlyphWidths *glyphs;
+	sqlResultFormat format;
+
+	volatile bool cancelled, done;
+};
+
 #endif
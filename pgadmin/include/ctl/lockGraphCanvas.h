@@ -0,0 +1,56 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// lockGraphCanvas.h - Lock wait-for graph Canvas
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef LOCKGRAPHCANVAS_H
+#define LOCKGRAPHCANVAS_H
+
+#include <ogl/ogl.h>
+
+#include "utils/lockGraph.h"
+
+// Backends drawn at most; the root blockers, which block most, come first
+#define LOCKGRAPH_MAX_SHAPES 300
+
+class LockGraphShape : public wxRectangleShape
+{
+public:
+	LockGraphShape(long _pid);
+
+	long pid;
+	int layer, slot;
+	bool seen;
+};
+
+WX_DECLARE_HASH_MAP(long, LockGraphShape *, wxIntegerHash, wxIntegerEqual, LockGraphShapeMap);
+WX_DECLARE_HASH_MAP(long, wxString, wxIntegerHash, wxIntegerEqual, LockGraphQueryMap);
+
+// The root blockers are drawn on the left, and every backend waiting one
+// column to the right of the one it waits for. Backends stay where they are
+// between refreshes, as long as they stay in their column; new ones are
+// added below the others.
+class LockGraphCanvas : public wxShapeCanvas
+{
+public:
+	LockGraphCanvas(wxWindow *parent);
+	~LockGraphCanvas();
+
+	void SetGraph(const lockGraph &graph, const LockGraphQueryMap &queries);
+	void Clear();
+
+private:
+	void RemoveLines();
+	void PackLayer(int layer);
+
+	LockGraphShapeMap shapes;
+	wxList lines;
+};
+
+#endif
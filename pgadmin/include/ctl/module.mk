@@ -16,6 +16,7 @@ pgadmin3_SOURCES += \
 	include/ctl/ctlColourPicker.h \
 	include/ctl/ctlComboBox.h \
 	include/ctl/ctlListView.h \
+	include/ctl/ctlLogList.h \
 	include/ctl/ctlMenuToolbar.h \
 	include/ctl/ctlDefaultSecurityPanel.h \
 	include/ctl/ctlSeclabelPanel.h \
@@ -26,6 +27,7 @@ pgadmin3_SOURCES += \
 	include/ctl/ctlProgressStatusBar.h \
 	include/ctl/ctlTree.h \
 	include/ctl/explainCanvas.h \
+	include/ctl/lockGraphCanvas.h \
 	include/ctl/timespin.h \
 	include/ctl/wxgridsel.h \
 	include/ctl/xh_calb.h \
@@ -10,9 +10,14 @@
 #######################################################################
 
 pgadmin3_SOURCES += \
+	  include/db/pgCompletionCache.h \
 	  include/db/pgConn.h \
+	  include/db/pgConnMonitor.h \
+	  include/db/pgConnPool.h \
 	  include/db/pgQueryThread.h \
 	  include/db/pgQueryResultEvent.h \
+	  include/db/pgResultView.h \
+	  include/db/pgRowStore.h \
 	  include/db/pgSet.h
 
 EXTRA_DIST += \
@@ -0,0 +1,117 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgCompletionCache.h - Names of a database for the autocompletion
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef PGCOMPLETIONCACHE_H
+#define PGCOMPLETIONCACHE_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <wx/hashmap.h>
+
+#include "db/pgConn.h"
+
+// Interval (s) at which the catalog is checked for changes, while completing
+#define COMPLETION_CHECK_INTERVAL 10
+
+// The kinds of names, which are kept
+enum
+{
+	COMPLETION_TABLE = 0,
+	COMPLETION_VIEW,
+	COMPLETION_SEQUENCE,
+	COMPLETION_INDEX,
+	COMPLETION_FUNCTION,
+	COMPLETION_KINDS
+};
+
+WX_DECLARE_STRING_HASH_MAP(wxArrayString *, pgCompletionColumnsMap);
+
+// A snapshot of the names, quoted as identifiers and sorted
+class pgCompletionNames
+{
+public:
+	~pgCompletionNames();
+
+	wxArrayString visible[COMPLETION_KINDS];    // name
+	wxArrayString qualified[COMPLETION_KINDS];  // schema.name
+	wxArrayString schemas;
+	pgCompletionColumnsMap columns;             // by (visible) relation
+};
+
+class pgCompletionCache;
+
+// Detached: a loader, which is still connecting or reading when the cache
+// is released, isn't waited for, but deletes the cache once it's done
+class pgCompletionLoader : public wxThread
+{
+public:
+	pgCompletionLoader(pgCompletionCache *_cache) : wxThread(wxTHREAD_DETACHED), cache(_cache) {}
+	virtual void *Entry();
+
+private:
+	pgCompletionCache *cache;
+};
+
+WX_DECLARE_STRING_HASH_MAP(pgCompletionCache *, pgCompletionCacheMap);
+
+// The names of the schemas, relations, functions and columns of a database,
+// shared by all the SQL boxes connected to it. They're read in the background
+// on a connection of its own, and read again whenever the catalog has been
+// changed, so the completion doesn't need to wait for the server.
+class pgCompletionCache
+{
+public:
+	// Every SQL box using a database holds on to its cache
+	static pgCompletionCache *Acquire(pgConn *conn);
+	static pgCompletionCache *Find(pgConn *conn);
+	void Release();
+
+	// The names of the given kind (as in tab-complete.c: a set of relkinds,
+	// "f" for functions, "n" for schemas or "a" for the columns of the
+	// relation addon), which start with text. Returns false, if these
+	// aren't known (yet); once they are, no matches means there are none.
+	// The first call starts the background load on a duplicate of from.
+	bool Complete(pgConn *from, const char *kind, const wxString &text, const wxString &addon, wxArrayString &matches);
+
+	// Called by the loader
+	void Run();
+	void LoaderDone();
+
+private:
+	pgCompletionCache(const wxString &key);
+	~pgCompletionCache();
+
+	static wxString GetKey(pgConn *conn);
+	static void AddMatches(const wxArrayString &names, const wxString &text, wxArrayString &matches, const wxChar *suffix = wxT(""));
+
+	bool StartLoader(pgConn *from);
+	wxString ReadSignature();
+	pgCompletionNames *ReadNames();
+	wxArrayString *ReadColumns(const wxString &relation);
+
+	static pgCompletionCacheMap caches;
+
+	wxString key;
+	int refCount;
+	pgConn *conn;
+	bool loaderStarted, failed;
+
+	wxMutex mutex;
+	wxCondition condition;
+	pgCompletionNames *names;
+	wxString signature;
+	wxArrayString pendingColumns;
+	bool checkRequested, stopping, connectFailed, loaderRunning;
+	wxLongLong lastCheck;
+};
+
+#endif
@@ -21,6 +21,8 @@
 // App headers
 #include "pgSet.h"
 
+class pgConnPool;
+
 // status enums
 enum
 {
@@ -82,6 +84,16 @@ typedef struct pgError
 	void SetError(PGresult *_res = NULL, wxMBConv *_conv = NULL);
 } pgError;
 
+// Cached information on a data type
+typedef struct pgTypeInfo
+{
+	pgTypClass typClass;
+	wxString name;
+} pgTypeInfo;
+
+WX_DECLARE_HASH_MAP(OID, pgTypeInfo, wxIntegerHash, wxIntegerEqual, pgTypeInfoMap);
+WX_DECLARE_STRING_HASH_MAP(wxString, pgTypeNameMap);
+
 class pgConn
 {
 public:
@@ -90,7 +102,7 @@ public:
 	       int port = 5432, const wxString &rolename = wxT(""), int sslmode = 0, OID oid = 0,
 	       const wxString &applicationname = wxT("pgAdmin"),
 	       const wxString &sslcert = wxT(""), const wxString &sslkey = wxT(""), const wxString &sslrootcert = wxT(""), const wxString &sslcrl = wxT(""),
-	       const bool sslcompression = true);
+	       const bool sslcompression = true, const bool connect = true);
 	~pgConn();
 
 	bool IsSuperuser();
@@ -112,7 +124,7 @@ public:
 	bool GetIsGreenplum();
 	wxString EncryptPassword(const wxString &user, const wxString &password);
 	wxString qtDbString(const wxString &value);
-	pgConn *Duplicate(const wxString &_appName = wxT(""));
+	pgConn *Duplicate(const wxString &_appName = wxT(""), const wxString &_database = wxT(""), OID _oid = 0, bool connect = true);
 
 	static void ExamineLibpqVersion();
 	static double GetLibpqVersion()
@@ -126,12 +138,34 @@ public:
 	}
 
 	void Close();
+	bool Connect();
 	bool Reconnect();
+
+	// An idle session can be parked in the pool of its server, which lends
+	// it to others meanwhile. It's taken back (or connected again) as soon
+	// as the connection is used, so the pgConn stays valid all the time.
+	bool Park(pgConnPool *pool);
+	bool IsParked() const
+	{
+		return parkedIn != NULL;
+	}
+	time_t GetLastUsed() const
+	{
+		return lastUsed;
+	}
+
+	// Discard the state of the session, before it's lent to somebody else
+	bool ResetSession();
 	bool ExecuteVoid(const wxString &sql, bool reportError = true);
 	wxString ExecuteScalar(const wxString &sql, bool reportError = true);
 	pgSet *ExecuteSet(const wxString &sql, bool reportError = true);
 	void CancelExecution(void);
 
+	// Server side prepared statements; the parameters are passed as text,
+	// $1 being params[0]
+	bool Prepare(const wxString &name, const wxString &sql, int nParams, bool reportError = true);
+	pgSet *ExecutePrepared(const wxString &name, const wxArrayString &params, bool reportError = true);
+
 	wxString GetHostAddr() const
 	{
 		return save_hostaddr;
@@ -245,6 +279,7 @@ public:
 	bool IsSSLconnected();
 	PGconn *connection()
 	{
+		Use();
 		return conn;
 	}
 	void Notice(const char *msg);
@@ -253,13 +288,21 @@ public:
 
 	void Reset();
 
-	bool StartCopy(const wxString query);
+	bool StartCopy(const wxString query, bool reportError = true);
 	bool PutCopyData(const char *data, long count);
 	bool EndPutCopy(const wxString errormsg);
-	bool GetCopyFinalStatus(void);
+	bool GetCopyFinalStatus(bool reportError = true);
+	bool StartCopyOut(const wxString query);
+	int GetCopyData(char **buffer, bool wait = false);
 
 	bool TableHasColumn(wxString schemaname, wxString tblname, const wxString &colname);
 
+	// Data type information, shared by all the result sets of the connection
+	void CacheTypes(const wxArrayLong &typoids, const wxArrayLong &typmods);
+	pgTypClass GetTypeClass(OID typoid);
+	wxString GetTypeName(OID typoid);
+	wxString GetFullTypeName(OID typoid, long typmod);
+
 protected:
 	PGconn   *conn;
 	PGcancel *m_cancelConn;
@@ -271,6 +314,7 @@ protected:
 	void SetLastResultError(PGresult *res, const wxString &msg = wxEmptyString);
 	void SetConnCancel(void);
 	void ResetConnCancel(void);
+	pgSet *MakeSet(PGresult *qryRes, bool reportError);
 	pgError lastResultError;
 
 	wxMBConv *conv;
@@ -284,13 +328,28 @@ protected:
 	static double libpqVersion;
 
 	friend class pgQueryThread;
+	friend class pgConnMonitor;
+	friend class pgConnCheck;
+	friend class pgConnPool;
+	friend class pgCompletionCache;
 
 private:
 	bool DoConnect();
 	bool Initialize();
 
+	bool Use();
+	void Unpark();
+	void SwapSession(pgConn *other);
+
+	pgConnPool *parkedIn;
+	time_t lastUsed;
+	int threadUsers;
+
 	wxString qtString(const wxString &value);
 
+	void InitTypeCache();
+	static wxString TypeModKey(OID typoid, long typmod);
+
 	bool features[32];
 	int minorVersion, majorVersion, patchVersion;
 	bool isEdb;
@@ -304,6 +363,9 @@ private:
 	int save_port, save_sslmode;
 	bool save_sslcompression;
 	OID save_oid;
+
+	pgTypeInfoMap typeInfo;
+	pgTypeNameMap fullTypeNames;
 };
 
 #endif
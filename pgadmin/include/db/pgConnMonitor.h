@@ -0,0 +1,127 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgConnMonitor.h - Background checks whether the servers can be reached
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef PGCONNMONITOR_H
+#define PGCONNMONITOR_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <wx/dynarray.h>
+
+#include "db/pgConn.h"
+
+// Interval (s) between the probes of the servers
+#define CONNMONITOR_INTERVAL 30
+
+// Time (ms) a server has to accept a connection to its port
+#define CONNMONITOR_TIMEOUT 5000
+
+// Posted to the handler, whenever a server stops or starts answering. The
+// client data is the key it's watched by, the int tells whether it's
+// answering, the extra long is the time the socket took to connect (ms).
+BEGIN_DECLARE_EVENT_TYPES()
+extern const wxEventType CONNMONITOR_STATE_EVENT;
+END_DECLARE_EVENT_TYPES()
+
+// What the probes found out about a server
+class pgConnMonitorStats
+{
+public:
+	pgConnMonitorStats() : alive(true), probes(0), failures(0), lastLatency(-1), minLatency(-1), maxLatency(-1), totalLatency(0) {}
+
+	long GetAvgLatency() const
+	{
+		return probes > failures ? (long)(totalLatency / (probes - failures)) : -1;
+	}
+
+	bool alive;
+	long probes, failures;
+	long lastLatency, minLatency, maxLatency;   // ms, of the answered ones
+	double totalLatency;
+};
+
+class pgConnMonitorTarget
+{
+public:
+	void *key;
+	wxString connstr;
+	bool utf;
+	bool handshake;
+	pgConnMonitorStats stats;
+};
+WX_DECLARE_OBJARRAY(pgConnMonitorTarget, pgConnMonitorTargets);
+
+// The port of each of the servers watched is connected to every now and
+// then, all of them at once and without blocking, so a server behind a
+// dead network link costs CONNMONITOR_TIMEOUT at most, and only to this
+// thread. No session is started: a probe doesn't log in. The UI learns
+// about it from the events, and doesn't need to wait for its own
+// connection to time out to find out.
+class pgConnMonitor : public wxThread
+{
+public:
+	pgConnMonitor(wxEvtHandler *_handler);
+
+	// Watch the server conn has just been connected to, until it's unwatched.
+	// With handshake, the server has to answer the startup packet, rather
+	// than only accept the connection (i.e. behind an SSH tunnel).
+	void Watch(void *key, pgConn *conn, bool handshake = false);
+	void Unwatch(void *key);
+
+	// Whether the server answered the last probe (true, if not known)
+	bool IsAlive(void *key);
+	bool GetStats(void *key, pgConnMonitorStats &stats);
+
+	// End the thread, and wait for it
+	void Stop();
+
+	virtual void *Entry();
+
+private:
+	int FindTarget(void *key);
+	void ProbeAll(pgConnMonitorTargets &probes);
+
+	wxEvtHandler *handler;
+	pgConnMonitorTargets targets;
+	wxMutex mutex;
+	wxCondition wakeup;
+	bool stopping;
+};
+
+// Sends "SELECT 1" on the connections added, all at once and without
+// blocking, and gives them CONNMONITOR_TIMEOUT to answer. A connection,
+// which fails or doesn't answer in time, is closed and marked broken, as
+// pgConn::IsAlive() does. The checks run in a thread of their own, so a
+// server, which went away since it was last probed, doesn't freeze the UI
+// until the TCP timeout.
+class pgConnCheck : public wxThread
+{
+public:
+	pgConnCheck() : wxThread(wxTHREAD_JOINABLE) {}
+
+	void Add(pgConn *conn)
+	{
+		if (conns.Index(conn) == wxNOT_FOUND)
+			conns.Add(conn);
+	}
+
+	// Run the checks, and wait for them while the UI is kept painted. The
+	// connections mustn't be used meanwhile.
+	void CheckAll();
+
+	virtual void *Entry();
+
+private:
+	wxArrayPtrVoid conns;
+};
+
+#endif
@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgConnPool.h - Idle connections of a server, lent out again
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef PGCONNPOOL_H
+#define PGCONNPOOL_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <wx/dynarray.h>
+
+#include "db/pgConn.h"
+
+// Connections idle longer than this (s) are checked before they're lent
+#define CONNPOOL_CHECK_AGE 30
+
+// Connections idle longer than this (s) are closed
+#define CONNPOOL_MAX_IDLE_TIME 300
+
+// Idle connections kept per server; the ones idle longest are closed first
+#define CONNPOOL_MAX_IDLE 4
+
+// The browser's connections to a database park their session in the pool,
+// once they've been unused this long (s)
+#define CONNPOOL_PARK_TIME 60
+
+class pgConnPoolEntry
+{
+public:
+	pgConn *conn;
+	wxString database;
+	time_t since;
+};
+WX_DECLARE_OBJARRAY(pgConnPoolEntry, pgConnPoolEntries);
+
+// Rather than connecting and disconnecting for every look at a database,
+// the browser borrows a connection from the pool of its server, and
+// gives it back when done. A connected database, which isn't being looked
+// at, parks its session here (pgConn::Park()), so it's lent to others and
+// eventually closed, rather than keeping a backend busy. Sessions given
+// back are rolled back and reset with DISCARD ALL; the ones, which can't
+// be (before 8.3), are closed.
+class pgConnPool
+{
+public:
+	pgConnPool(pgConn *_templ, const wxString &_applicationname);
+	~pgConnPool();
+
+	// A connection to the database (the template's if empty), which
+	// belongs to the caller until it's returned. Returns NULL, if the
+	// server can't be reached; the error has been logged then.
+	pgConn *Borrow(const wxString &database = wxEmptyString, OID oid = 0);
+	void Return(pgConn *conn);
+
+	// Close the idle connections to the database, e.g. before it's dropped
+	void Close(const wxString &database);
+
+	// Close the connections, which have been idle too long
+	void Prune();
+
+	// The connections, whose session is parked here
+	void AddParked(pgConn *conn);
+	void RemoveParked(pgConn *conn);
+
+private:
+	void CloseEntry(size_t i);
+
+	pgConn *templ;
+	wxString applicationname;
+
+	pgConnPoolEntries idle;
+	wxArrayPtrVoid parked;
+	wxMutex mutex;
+};
+
+#endif
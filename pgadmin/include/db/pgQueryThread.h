@@ -18,6 +18,7 @@
 
 // Forward declaration
 class pgSet;
+class pgRowStore;
 class pgQueryThread;
 class pgBatchQuery;
 
@@ -186,6 +187,17 @@ public:
 
 	void SetEventOnCancellation(bool eventOnCancelled);
 
+	// Stream the rows into the given store (using the libpq single-row
+	// mode, if available), instead of collecting them in the result-set
+	void SetRowStore(pgRowStore *_store)
+	{
+		m_rowStore = _store;
+	}
+	bool IsStreaming() const
+	{
+		return m_streaming;
+	}
+
 	void AddQuery(
 	    const wxString &_qry, pgParamsArray *_params = NULL,
 	    long _eventId = 0, void *_data = NULL, bool _useCallable = false,
@@ -232,10 +244,7 @@ public:
 		return (_idx >= 0 && _idx > m_currIndex ? -1L : m_queries[_idx]->m_insertedOid);
 	}
 
-	inline void CancelExecution()
-	{
-		m_cancelled = true;
-	}
+	void CancelExecution();
 
 	inline size_t GetNumberQueries()
 	{
@@ -258,6 +267,12 @@ private:
 	int Execute();
 	int RaiseEvent(int _retval = 0);
 
+	// Block until the backend socket is ready, the thread is woken up or
+	// the timeout (in milliseconds, -1 for none) expires
+	void WaitForEvents(bool _waitForBackend, long _timeout = -1);
+	void WakeUp();
+	void InitWakeUp();
+
 	// Queries to be exectued
 	pgBatchQueryArray  m_queries;
 	// Current running query index
@@ -284,6 +299,12 @@ private:
 	PQnoticeProcessor  m_processor;
 	// Notice Handler
 	void              *m_noticeHandler;
+	// Self-pipe to wake up the thread waiting on the backend socket
+	int                m_wakeupPipe[2];
+	// Store for the streamed rows (if any)
+	pgRowStore        *m_rowStore;
+	// Are the rows of the current query being streamed in the store?
+	bool               m_streaming;
 
 };
 
@@ -0,0 +1,142 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgResultView.h - Sorted and filtered view of the rows of a query result
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef PGRESULTVIEW_H
+#define PGRESULTVIEW_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/thread.h>
+
+#include "db/pgSet.h"
+#include "db/pgRowStore.h"
+
+// Sort and filter bigger results in worker threads
+#define RESULTVIEW_PARALLEL_ROWS 50000
+#define RESULTVIEW_MAX_WORKERS 8
+
+typedef enum
+{
+	RESULTFILTER_EQUAL = 1,
+	RESULTFILTER_NOTEQUAL,
+	RESULTFILTER_LESS,
+	RESULTFILTER_LESSEQUAL,
+	RESULTFILTER_GREATER,
+	RESULTFILTER_GREATEREQUAL,
+	RESULTFILTER_CONTAINS,
+	RESULTFILTER_ISNULL,
+	RESULTFILTER_NOTNULL
+} pgResultFilterOp;
+
+// The values of one column, prepared to be compared quickly. Numbers and
+// (ISO formatted) timestamps are compared by their value, the rest by the
+// bytes of the text.
+class pgResultViewColumn
+{
+public:
+	pgResultViewColumn();
+	~pgResultViewColumn();
+
+	void Load(pgSet *set, pgRowStore *store, int col, pgTypClass typClass);
+	void ParseValues(long first, long last);
+
+	int Compare(long a, long b) const;
+	int CompareTo(long row, const char *value, double number, bool isNumber, bool isLong) const;
+
+	static bool ParseNumber(const char *value, double &number, bool &isLong);
+	static bool ParseTimestamp(const char *value, double &seconds);
+
+	pgTypClass typClass;
+	const char **values;  // NULL for NULL values
+	double *numbers;
+	char *isNumber;       // 1 if parsed, 2 for a decimal longer than a double
+
+private:
+	static int CompareDecimal(const char *a, const char *b);
+
+	wxMemoryBuffer data;  // The values of a row store
+};
+
+class pgResultView
+{
+public:
+	pgResultView();
+	~pgResultView();
+
+	// The result to look at. This drops the sort order and the filters.
+	void SetSource(pgSet *set, pgRowStore *store);
+	void Reset();
+
+	// Is the result sorted or filtered?
+	bool IsActive() const
+	{
+		return rows != NULL;
+	}
+	long NumRows() const;
+	long SourceRow(long row) const
+	{
+		return rows ? rows[row] : row;
+	}
+
+	// The sort is stable: sorting by one column, then by another one sorts
+	// by both of them.
+	bool Sort(int col, pgTypClass typClass, bool ascending);
+
+	// Keep the rows, for which "col op value" is true, only
+	bool Filter(int col, pgTypClass typClass, pgResultFilterOp op, const wxString &value);
+
+	// Split a filter like ">= 42" or "~text" into the operator and the value
+	static bool ParseFilter(const wxString &expr, pgResultFilterOp &op, wxString &value);
+
+	// Called by the workers
+	void RunSlice(int task, long first, long last);
+
+private:
+	long SourceRows() const;
+	void StartView();
+	void RunParallel(int task, long count);
+	void MergeSort(long *data, long *tmp, long count);
+	void Merge(long *data, long *tmp, long count1, long count2);
+	bool Matches(long row) const;
+
+	pgSet *set;
+	pgRowStore *store;
+
+	long *rows;  // The source rows, in the order they're shown
+	long numRows;
+
+	// The state of the running sort or filter
+	pgResultViewColumn *column;
+	bool ascending;
+	pgResultFilterOp filterOp;
+	wxCharBuffer filterValue;
+	double filterNumber;
+	bool filterIsNumber;
+	bool filterIsLong;
+	long *sortTmp;
+	char *matches;
+	long sliceSize;
+};
+
+class pgResultViewWorker : public wxThread
+{
+public:
+	pgResultViewWorker(pgResultView *_view, int _task, long _first, long _last)
+		: wxThread(wxTHREAD_JOINABLE), view(_view), task(_task), first(_first), last(_last) {}
+	virtual void *Entry();
+
+private:
+	pgResultView *view;
+	int task;
+	long first, last;
+};
+
+#endif
@@ -0,0 +1,141 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgRowStore.h - Append-only row store for streamed query results
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef PGROWSTORE_H
+#define PGROWSTORE_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/file.h>
+
+// PostgreSQL headers
+#include <libpq-fe.h>
+
+#include "utils/misc.h"
+
+// Number of rows per page
+#define PGROWSTORE_PAGE_ROWS   4096
+// Start a new page, once the values of the current one grow beyond this size
+#define PGROWSTORE_PAGE_BYTES  (1024 * 1024)
+
+// All the values of one column of a page, stored back to back (NUL
+// terminated). offsets point to the beginning of each value (-1 for NULL).
+class pgRowStoreColumn
+{
+public:
+	wxMemoryBuffer data;
+	wxArrayInt     offsets;
+};
+
+class pgRowStorePage
+{
+public:
+	pgRowStorePage(long _firstRow, int _nCols);
+	~pgRowStorePage();
+
+	bool IsLoaded() const
+	{
+		return cols != NULL;
+	}
+	void Unload();
+
+	long              firstRow;
+	long              numRows;
+	int               nCols;
+	pgRowStoreColumn *cols;        // NULL, when the page is spilled to disk
+	wxFileOffset      spillOffset; // -1, if never written to the spill file
+	size_t            dataSize;    // Bytes of the values appended
+	size_t            memSize;     // Bytes allocated, while loaded
+	unsigned long     lastUsed;
+};
+
+WX_DEFINE_ARRAY_PTR(pgRowStorePage *, pgRowStorePageArray);
+
+// A columnar, append-only store for the rows of a result, which is being
+// retrieved in the single-row mode. The query thread appends the rows, while
+// the UI thread reads them. Once the memory used goes beyond the given
+// cap, the least recently used pages are spilled to a temporary file.
+class pgRowStore
+{
+public:
+	pgRowStore(wxMBConv &_conv, size_t _memoryCap = 0);
+	~pgRowStore();
+
+	// Discard all the rows (and the columns), i.e. for the next result set
+	void Reset();
+
+	// Copy the (only) row of a PGRES_SINGLE_TUPLE result
+	void AppendRow(PGresult *res);
+
+	long NumRows();
+	long NumCols();
+	wxString ColName(const int col);
+	OID ColTypeOid(const int col);
+	long ColTypeMod(const int col);
+	OID ColTableOid(const int col);
+
+	bool IsNull(const long row, const int col);
+	wxString GetVal(const long row, const int col);
+
+	// Copy the raw (NUL terminated) values of a column, i.e. to sort the
+	// rows by them. offsets gets the start of each value, -1 for NULL.
+	void CopyColumn(const int col, wxMemoryBuffer &data, long *offsets);
+
+	wxMBConv &GetConversion() const
+	{
+		return conv;
+	}
+
+	// Incremented on every Reset()
+	unsigned long GetGeneration()
+	{
+		return generation;
+	}
+	size_t GetMemoryUsed()
+	{
+		return memUsed;
+	}
+
+	// The error met while spilling or reloading the rows, if any. The store
+	// may be filled by the query thread, which must not log it itself.
+	wxString GetErrorAndClear();
+
+private:
+	pgRowStorePage *FindPage(const long row);
+	const char *GetCharPtr(const long row, const int col);
+	bool LoadPage(pgRowStorePage *page);
+	bool SpillPage(pgRowStorePage *page);
+	void EnforceMemoryCap(pgRowStorePage *keep);
+	void ClearPages();
+	void RemoveSpillFile();
+
+	wxMBConv          &conv;
+	size_t             memoryCap;
+	size_t             memUsed;
+	unsigned long      generation;
+	unsigned long      useCounter;
+
+	long               nRows, nCols;
+	wxArrayString      colNames;
+	wxArrayLong        colTypes, colTypeMods, colTables;
+
+	pgRowStorePageArray pages;
+
+	wxString           spillFileName;
+	wxFile             spillFile;
+	bool               spillFailed;
+	wxString           errorMsg;
+
+	// The query thread and the UI thread access the store simultaneously
+	wxCriticalSection  m_criticalSection;
+};
+
+#endif
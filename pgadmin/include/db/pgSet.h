@@ -15,6 +15,7 @@
 // wxWindows headers
 #include <wx/wx.h>
 #include <wx/datetime.h>
+#include <wx/hashmap.h>
 
 // PostgreSQL headers
 #include <libpq-fe.h>
@@ -32,6 +33,9 @@ typedef enum
 
 class pgConn;
 
+// Column name to column number
+WX_DECLARE_STRING_HASH_MAP(int, pgSetColumnMap);
+
 // Class declarations
 class pgSet
 {
@@ -84,10 +88,14 @@ public:
 	wxString ColName(const int col) const;
 	OID ColTypeOid(const int col) const;
 	long ColTypeMod(const int col) const;
+	OID ColTableOid(const int col) const;
 	wxString ColType(const int col) const;
 	wxString ColFullType(const int col) const;
 	pgTypClass ColTypClass(const int col) const;
 
+	// Type class of a (base) type, without looking at the catalog
+	static pgTypClass TypClassFromOid(OID typoid);
+
 	OID GetInsertedOid() const
 	{
 		return PQoidValue(res);
@@ -126,6 +134,19 @@ public:
 	char *GetCharPtr(const int col) const;
 	char *GetCharPtr(const wxString &col) const;
 
+	// Any row, without moving the current position (i.e. for other threads)
+	char *GetCharPtr(const long row, const int col) const
+	{
+		return PQgetvalue(res, row, col);
+	}
+	bool IsNull(const long row, const int col) const
+	{
+		return (PQgetisnull(res, row, col) != 0);
+	}
+
+	// A new set with a copy of some of the rows (0-based, in the given order)
+	pgSet *CopyRows(const wxArrayLong &rows) const;
+
 	wxMBConv &GetConversion() const
 	{
 		return conv;
@@ -149,6 +170,14 @@ protected:
 	bool needColQuoting;
 	mutable wxArrayString colTypes, colFullTypes;
 	wxArrayInt colClasses;
+
+private:
+	void BuildColumnIndex();
+	void CacheColTypes() const;
+	int FindColumn(const wxString &colname) const;
+
+	pgSetColumnMap colIndex;
+	mutable bool typesCached;
 };
 
 
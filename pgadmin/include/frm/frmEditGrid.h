@@ -14,12 +14,14 @@
 
 #include <wx/grid.h>
 #include <wx/stc/stc.h>
+#include <wx/thread.h>
 // wxAUI
 #include <wx/aui/aui.h>
 
 #define CTL_EDITGRID 357
 #include "dlg/dlgClasses.h"
 #include "ctl/ctlSQLGrid.h"
+#include "db/pgQueryResultEvent.h"
 
 //
 // This number MUST be incremented if changing any of the default perspectives
@@ -46,12 +48,27 @@ enum
 #define EGSTATUSPOS_COUNT 3
 
 
+// A value of a line, stored in the arena of its pool
+class cacheCell
+{
+public:
+	const wxChar *value;
+	int length;
+	bool isNull;
+};
+
+class cacheLineSlab;
+
 class cacheLine
 {
 public:
 	cacheLine()
 	{
 		cols = 0;
+		nulls = 0;
+		cells = 0;
+		slab = 0;
+		filled = false;
 		stored = false;
 		readOnly = false;
 	}
@@ -61,16 +78,58 @@ public:
 		if (nulls) delete[] nulls;
 	}
 
+	bool IsFilled() const
+	{
+		return cols || filled;
+	}
+	void Alloc(int nCols);
+	void Clear();
+
+	wxString GetCol(int col) const;
+	bool IsNull(int col) const;
+	void SetCol(int col, const wxString &value);
+	void StoreCol(int col, const wxString &value, bool isNull);
+
+	// The values read from the database stay in the arena of the pool (cells),
+	// until the line is changed; then they're copied to cols.
 	wxString *cols;
 	bool *nulls;
-	bool stored, readOnly;
+	cacheCell *cells;
+	cacheLineSlab *slab;
+	bool filled, stored, readOnly;
+};
+
+
+#define CACHELINE_SLAB_LINES  256
+#define CACHELINE_CHUNK_CHARS 16384
+
+// A block of lines of a pool, with the cells of all of them, and the arena
+// the values are stored in back to back.
+class cacheLineSlab
+{
+public:
+	cacheLineSlab(int _nCols);
+	~cacheLineSlab();
+
+	const wxChar *Store(const wxString &value);
+
+	cacheLine lines[CACHELINE_SLAB_LINES];
+	cacheCell *cells;
+	int nCols, used;
+
+private:
+	wxArrayPtrVoid chunks;
+	wxChar *chunkPos;
+	size_t chunkFree;
 };
 
+WX_DEFINE_ARRAY_PTR(cacheLineSlab *, cacheLineSlabArray);
+
 
 class cacheLinePool
 {
 public:
-	cacheLinePool(int initialLines);
+	cacheLinePool(int initialLines, int _nCols);
 	~cacheLinePool();
 	cacheLine *operator[] (int line)
 	{
@@ -81,8 +140,13 @@ public:
 	void Delete(int lineNo);
 
 private:
+	cacheLine *NewLine();
+
 	cacheLine **ptr;
 	int anzLines;
+	int nCols;
+	cacheLineSlabArray slabs;
+	wxArrayPtrVoid freeLines;
 };
 
 
@@ -152,6 +216,77 @@ public:
 };
 
 
+// A page of rows of a table, which is too big to be read at once. The rows
+// are fetched by their primary key (keyset pagination), so the page keeps
+// the keys of its first and last row, to be able to read it again.
+class sqlKeysetPage
+{
+public:
+	sqlKeysetPage()
+	{
+		lines = 0;
+		lastUsed = 0;
+		loading = false;
+		reversed = false;
+		fromEnd = false;
+		bounded = false;
+		slots = 0;
+		limit = 0;
+		readRows = 0;
+	}
+	~sqlKeysetPage()
+	{
+		if (lines) delete lines;
+	}
+
+	cacheLinePool *lines;   // 0, if the page isn't loaded
+	wxString firstKey, lastKey;
+	unsigned long lastUsed;
+	bool loading;           // it's being read in the background
+
+	// How the page is read
+	bool reversed;          // backwards, from its last row
+	bool fromEnd;           // its place is counted from the end of the table
+	bool bounded;           // by the keys of its own or of the next page
+	int slots;              // rows of the grid it holds
+	long limit;             // rows asked for
+	int readRows;           // the rows of the table, when it was asked for
+};
+
+WX_DECLARE_HASH_MAP(int, sqlKeysetPage *, wxIntegerHash, wxIntegerEqual, sqlKeysetPageMap);
+
+
+// Reads the pages of a table in the background, on a connection of its
+// own, and tells the frame when one is there. The page asked for last is
+// read first, as it's the one the user is looking at.
+class sqlPageLoader : public wxThread
+{
+public:
+	sqlPageLoader(pgConn *_conn, wxEvtHandler *_handler);
+	~sqlPageLoader();
+	virtual void *Entry();
+
+	// The requests, which were too old to be kept, are returned in dropped
+	void Request(int pageNo, const wxString &sql, wxArrayInt &dropped);
+	// A page read, with its rows, or 0 if reading it failed
+	bool TakeResult(int &pageNo, pgSet *&set);
+	pgSet *WaitResult(int pageNo);
+	bool Failed();
+	void Stop();
+
+private:
+	pgConn *conn;
+	wxEvtHandler *handler;
+
+	wxMutex mutex;
+	wxCondition condition;
+	wxArrayInt queuedPages, readPages;
+	wxArrayString queuedSql;
+	wxArrayPtrVoid readSets;
+	bool failed, stopping;
+};
+
+
 class sqlTable;
 
 class ctlSQLEditGrid : public ctlSQLGrid
@@ -201,6 +336,7 @@ public:
 	}
 	bool AppendRows(size_t rows);
 	bool DeleteRows(size_t pos, size_t rows);
+	bool DeleteRowList(const wxArrayInt &rows);
 	int  LastRow()
 	{
 		return lastRow;
@@ -216,6 +352,30 @@ public:
 
 	bool Paste();
 
+	// Read the rows page by page as they're shown, ordered by the given key
+	// ordering, instead of reading all of them at once. The pages are read
+	// in the background; handler is told, when one is there.
+	void SetKeyset(const wxString &orderBy, bool ascending, long estimatedRows, wxEvtHandler *handler);
+	bool IsPaged()
+	{
+		return keyset;
+	}
+	bool IsRowCountEstimated()
+	{
+		return keyset && !rowCountExact;
+	}
+	void SetExactRowCount(long rows);
+	void SyncRowCount();
+	void Prefetch();
+	void PageLoaded();
+
+	// Wait for the pages to be read, instead of showing placeholders,
+	// while all the rows are needed (e.g. to copy them)
+	void SetWaitForPages(bool wait)
+	{
+		waitForPages = wait;
+	}
+
 private:
 	pgQueryThread *thread;
 	pgConn *connection;
@@ -225,15 +385,33 @@ private:
 	OID relid;
 	wxString primaryKeyColNumbers;
 
-	cacheLine *GetLine(int row);
+	cacheLine *GetLine(int row, bool wait = true);
+	int DataRow(int row);
+	void FillLine(cacheLine *line, pgSet *set);
+	wxArrayInt GetKeyColumns();
+	wxString MakeKeyValue(cacheLine *line, int col);
 	wxString MakeKey(cacheLine *line);
+	wxString MakeKeyColumns();
+	wxString MakeKeyValues(cacheLine *line);
 	void SetNumberEditor(int col, int len);
 
+	sqlKeysetPage *GetPage(int pageNo);
+	wxString PageQuery(int pageNo);
+	bool FillPage(int pageNo, pgSet *set);
+	bool LoadPage(int pageNo);
+	void RequestPage(int pageNo);
+	void EvictPages(int keepPage);
+	void ForgetEndPages();
+	int EditedPage();
+	int DeletedBetween(int from, int to);
+	wxString MakeKeyValues(pgSet *set);
+	void SetPendingRows(int rows, bool exact);
+
 	cacheLinePool *dataPool, *addPool;
 	cacheLine savedLine;
 	int lastRow;
 
-	int *lineIndex;     // reindex of lines in dataSet to handle deleted rows
+	wxArrayInt deletedRows; // rows of the dataSet deleted, in ascending order
 
 	int nCols;          // columns from dataSet
 	int nRows;          // rows initially returned by dataSet
@@ -245,6 +423,19 @@ private:
 
 	wxArrayInt colMap;
 
+	bool keyset;            // the rows are read page by page
+	wxString keysetQuery, keysetOrder, keysetReverseOrder, keysetColumns;
+	bool keysetAscending;
+	sqlPageLoader *loader;
+	cacheLine placeholder;  // shown for the rows of the pages being read
+	bool waitForPages;
+	sqlKeysetPageMap pages;
+	wxArrayInt loadedPages;
+	unsigned long pageUseCounter;
+	int currentPage, prefetchPage;
+	int pendingRows;        // rows of the dataSet, which the grid hasn't been told about yet
+	bool rowCountExact;
+
 	friend class ctlSQLEditGrid;
 };
 
@@ -322,6 +513,12 @@ private:
 	void OnToggleToolBar(wxCommandEvent &event);
 	void OnAuiUpdate(wxAuiManagerEvent &event);
 	void OnDefaultView(wxCommandEvent &event);
+	void OnIdle(wxIdleEvent &event);
+	void OnRowCountChanged(wxCommandEvent &event);
+	void OnPageLoaded(wxCommandEvent &event);
+	void OnRowCountComplete(pgQueryResultEvent &event);
+	void StartRowCount();
+	void AbortRowCount();
 
 	wxAuiManager manager;
 	ctlSQLEditGrid *sqlGrid;
@@ -329,6 +526,8 @@ private:
 	frmMain *mainForm;
 	pgConn *connection;
 	pgQueryThread *thread;
+	pgConn *countConnection;
+	pgQueryThread *countThread;
 	wxMenu *fileMenu, *editMenu, *viewMenu, *toolsMenu, *helpMenu;
 	ctlMenuToolbar *toolBar;
 	wxComboBox *cbLimit;
@@ -341,6 +540,8 @@ private:
 	wxString primaryKeyColNumbers;
 	wxString orderBy;
 	bool autoOrderBy;
+	wxString keyOrderBy;
+	bool keyAscending;
 	wxString rowFilter;
 	int limit;
 	sqlCell *editorCell;
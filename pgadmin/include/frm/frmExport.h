@@ -15,19 +15,169 @@
 
 class ctlSQLResult;
 class pgSet;
+class pgConn;
+class pgRowStore;
+class pgResultView;
+class sqlResultFormat;
+
+#include <wx/thread.h>
+#include <wx/file.h>
 
 #include "dlg/dlgClasses.h"
 
+// Number of rows formatted at a time by an export worker
+#define EXPORT_CHUNK_ROWS   4096
+// Maximum number of export worker threads
+#define EXPORT_MAX_WORKERS  8
+
+// How the values are written
+enum
+{
+	EXPORT_FORMAT_TEXT = 0,  // Separated, and (maybe) quoted
+	EXPORT_FORMAT_INSERT,    // As INSERT statements
+	EXPORT_FORMAT_COPY,      // As the data of COPY ... FROM stdin
+	EXPORT_FORMAT_DISPLAY    // Separated, as shown in the result grid
+};
+// Amount of COPY data collected, before writing it to the file
+#define EXPORT_BUFFER_SIZE  (1024 * 1024)
+
+// A chunk of rows, formatted for the file
+class exportChunk
+{
+public:
+	wxMemoryBuffer data;
+	long chunk;         // -1, if not claimed by a worker
+	long skipped;
+	bool ready;
+};
+
+// The rows to export and how to format them. The UI thread writes the
+// chunks to the file (or, the buffer) in order, while the workers format
+// the next ones.
+class exportJob
+{
+public:
+	exportJob(pgSet *_set, pgRowStore *_store, long _rowCount, int _colCount);
+	~exportJob();
+
+	bool Run(wxFile &file, wxWindow *parent, long &skipped);
+	bool Run(wxMemoryBuffer &buffer, wxWindow *parent, long &skipped);
+
+	// Called by the workers
+	bool ClaimChunk(long &chunk);
+	void FormatChunk(long chunk);
+	void ChunkDone(long chunk);
+
+	int format;
+	wxArrayInt quoteCols;
+	wxString rowPrefix, colSeparator, quoteChar, rowSeparator;
+	wxMBConv *fileConv;
+
+	// The columns to export (all, if empty), and the rows: rowCount rows
+	// from firstRow on, or the ones in rowList
+	wxArrayInt columns;
+	long firstRow;
+	const wxArrayInt *rowList;
+
+	// The rows as sorted and filtered in the grid, if they are
+	pgResultView *view;
+
+	// How the grid shows the values, and the type classes of the columns,
+	// for EXPORT_FORMAT_DISPLAY
+	const sqlResultFormat *displayFormat;
+	wxArrayLong typClasses;
+
+private:
+	bool RunChunks(wxFile *file, wxMemoryBuffer *buffer, wxWindow *parent, long &skipped);
+	void FormatRow(long row, exportChunk *out);
+	void AppendValue(wxMemoryBuffer &data, const char *value, int col);
+	bool WriteChunk(wxFile *file, wxMemoryBuffer *buffer, exportChunk *slot);
+
+	pgSet *set;
+	pgRowStore *store;
+	long rowCount;
+	int colCount;
+
+	// The values can be copied as they are (UTF-8 to UTF-8)
+	bool copyRaw;
+	wxCharBuffer rawRowPrefix, rawColSeparator, rawQuoteChar, rawRowSeparator;
+
+	wxMutex mutex;
+	wxCondition condition;
+	long numChunks, nextChunk, writtenChunks;
+	int numSlots;
+	exportChunk *slots;
+	bool cancelled;
+};
+
+class exportWorker : public wxThread
+{
+public:
+	exportWorker(exportJob *_job) : wxThread(wxTHREAD_JOINABLE), job(_job) {}
+	virtual void *Entry();
+
+private:
+	exportJob *job;
+};
+
+// Reads the data of a COPY ... TO STDOUT and writes it to the file, while
+// the UI thread keeps the progress dialog alive. The connection is only
+// used by the reader, until it's done.
+class exportCopyReader : public wxThread
+{
+public:
+	exportCopyReader(pgConn *_conn, wxFile &_file, wxMBConv *_fileConv, const wxString &_rowSeparator);
+	virtual void *Entry();
+
+	// Wait up to timeout ms for the end of the data, false if it's still
+	// coming. rows gets the number of rows read so far.
+	bool WaitDone(int timeout, long &rows);
+
+	// Stop writing to the file, and have the server end the COPY
+	void Cancel();
+
+	bool WriteFailed() const
+	{
+		return writeFailed;
+	}
+	long GetSkipped() const
+	{
+		return skipped;
+	}
+
+private:
+	bool Flush();
+
+	pgConn *conn;
+	wxFile &file;
+	wxMBConv *fileConv;
+	wxString rowSeparator;
+	wxCharBuffer rawRowSeparator;
+	wxMemoryBuffer data;
+
+	wxMutex mutex;
+	wxCondition condition;
+	long rows, skipped;
+	bool done, cancelled, writeFailed;
+};
+
 // Class declarations
 class frmExport : public pgDialog
 {
 public:
-	frmExport(wxWindow *parent);
+	frmExport(wxWindow *parent, bool allowCopy = false);
 	~frmExport();
 
-	bool Export(pgSet *set);
+	// Without a result set, the rows are taken from the grid
+	bool Export(pgSet *set, ctlSQLResult *grid = 0);
+
+	// Can the query be exported by the server, with COPY?
+	bool CanUseCopy(pgConn *conn, const wxString &query);
+	bool ExportCopy(pgConn *conn, const wxString &query);
 
 private:
+	wxString StripQuery(const wxString &query);
+
 	void OnChange(wxCommandEvent &ev);
 	void OnHelp(wxCommandEvent &ev);
 	void OnOK(wxCommandEvent &ev);
@@ -35,6 +185,7 @@ private:
 	void OnBrowseFile(wxCommandEvent &ev);
 
 	wxWindow *parent;
+	bool allowCopy;
 
 	DECLARE_EVENT_TABLE()
 };
@@ -22,6 +22,7 @@
 #include <wx/aui/aui.h>
 
 #include "frm/frmQuery.h"
+#include "db/pgConnMonitor.h"
 #include "dlg/dlgClasses.h"
 #include "utils/factory.h"
 
@@ -107,6 +108,10 @@ public:
 		currentObject = data;
 	}
 	bool CheckAlive();
+	pgConnMonitor *GetConnMonitor()
+	{
+		return connMonitor;
+	}
 
 	void execSelChange(wxTreeItemId item, bool currentNode);
 	void Refresh(pgObject *data);
@@ -188,6 +193,8 @@ private:
 	       *treeContextMenu, *newContextMenu, *slonyMenu, *scriptingMenu, *viewDataMenu,
 	       *objectBrowserMenu;
 	pgServerCollection *serversObj;
+	pgConnMonitor *connMonitor;
+	wxTimer *poolTimer;
 
 	pluginUtilityFactory *lastPluginUtility;
 	int pluginUtilityCount;
@@ -249,6 +256,8 @@ private:
 	void OnCopy(wxCommandEvent &ev);
 
 	void OnCheckAlive(wxCommandEvent &event);
+	void OnConnMonitor(wxCommandEvent &event);
+	void OnPoolTimer(wxTimerEvent &event);
 
 	void OnPositionStc(wxStyledTextEvent &event);
 
@@ -283,7 +292,8 @@ enum
 	CTL_STATVIEW,
 	CTL_DEPVIEW,
 	CTL_REFVIEW,
-	CTL_SQLPANE
+	CTL_SQLPANE,
+	CTL_POOLTIMER
 };
 
 class contentsFactory : public actionFactory
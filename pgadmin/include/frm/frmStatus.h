@@ -25,6 +25,12 @@
 #include "dlg/dlgClasses.h"
 #include "utils/factory.h"
 #include "ctl/ctlAuiNotebook.h"
+#include "ctl/ctlLogList.h"
+#include "utils/csvfiles.h"
+#include "utils/statusHistory.h"
+
+class lockGraph;
+class LockGraphCanvas;
 
 enum
 {
@@ -40,6 +46,11 @@ enum
 	CTL_LOCKLIST,
 	CTL_XACTLIST,
 	CTL_LOGLIST,
+	CTL_LOGLEVELCBO,
+	CTL_LOGFILTER,
+	CTL_HISTORYSLIDER,
+	CTL_HISTORYBTN,
+	CTL_LOCKGRAPHCHK,
 	MNU_STATUSPAGE,
 	MNU_LOCKPAGE,
 	MNU_XACTPAGE,
@@ -66,6 +77,16 @@ enum
 };
 
 
+// Size (bytes) of the pieces the logfile is read in. They grow while the
+// reads take less than LOG_CHUNK_TIME (ms), and shrink when they take longer.
+#define LOG_CHUNK_MIN 50000
+#define LOG_CHUNK_MAX 4000000
+#define LOG_CHUNK_TIME 500
+
+// Entries shown in each list of the activity history report
+#define HISTORY_REPORT_ROWS 50
+
+
 //
 // This number MUST be incremented if changing any of the default perspectives
 //
@@ -107,7 +128,8 @@ private:
 	wxDateTime logfileTimestamp, latestTimestamp;
 	wxString logDirectory, logfileName;
 
-	wxString savedPartialLine;
+	CSVRecordParser logCsvParser;
+	long logChunkSize;
 
 	bool showCurrent, isCurrent;
 
@@ -128,7 +150,14 @@ private:
 	wxComboBox    *cbRate;
 	wxComboBox    *cbLogfiles;
 	wxButton      *btnRotateLog;
+	wxChoice      *cbLogLevel;
+	wxTextCtrl    *txtLogFilter;
 	ctlComboBoxFix *cbDatabase;
+	wxSlider      *sldHistory;
+	wxStaticText  *stHistoryTime;
+	wxButton      *btnHistoryReport;
+	wxCheckBox    *chkLockGraph;
+	wxStaticText  *stLockGraph;
 
 	wxTimer *refreshUITimer;
 	wxTimer *statusTimer, *locksTimer, *xactTimer, *logTimer;
@@ -137,7 +166,8 @@ private:
 	ctlListView   *statusList;
 	ctlListView   *lockList;
 	ctlListView   *xactList;
-	ctlListView   *logList;
+	ctlLogList    *logList;
+	LockGraphCanvas *lockCanvas;
 
 	wxMenu        *actionMenu;
 	wxMenu        *statusPopupMenu;
@@ -146,6 +176,13 @@ private:
 
 	wxArrayString queries;
 
+	// The recorded activity, and the frame of it shown (-1: the live one)
+	statusHistory *history;
+	long historyFrame;
+
+	// The wait-for graph of the last locks snapshot
+	lockGraph *lockWaits;
+
 	int statusColWidth[12], lockColWidth[10], xactColWidth[5];
 
 	int cboToRate();
@@ -198,6 +235,15 @@ private:
 
 	void OnRateChange(wxCommandEvent &event);
 
+	void ShowStatusRows(const statusHistoryRows &rows);
+	void ShowHistoryFrame();
+	void UpdateHistorySlider();
+	void OnHistoryScroll(wxScrollEvent &event);
+	void OnHistoryReport(wxCommandEvent &event);
+
+	bool RefreshLockGraph();
+	void OnLockGraphToggle(wxCommandEvent &event);
+
 	void OnPaneClose(wxAuiManagerEvent &evt);
 
 	void OnClose(wxCloseEvent &event);
@@ -214,6 +260,7 @@ private:
 	void OnSelLogItem(wxListEvent &event);
 	void OnLoadLogfile(wxCommandEvent &event);
 	void OnRotateLogfile(wxCommandEvent &event);
+	void OnLogFilter(wxCommandEvent &event);
 	void OnCommit(wxCommandEvent &event);
 	void OnRollback(wxCommandEvent &event);
 
@@ -224,7 +271,8 @@ private:
 
 	void addLogFile(wxDateTime *dt, bool skipFirst);
 	void addLogFile(const wxString &filename, const wxDateTime timestamp, long len, long &read, bool skipFirst);
-	void addLogLine(const wxString &str, bool formatted = true, bool csv_log_format = false);
+	void addLogLine(const wxString &str, bool formatted = true);
+	void addLogRecord(const wxArrayString &fields);
 
 	void checkConnection();
 
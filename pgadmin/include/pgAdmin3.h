@@ -24,6 +24,7 @@
 #endif
 
 #include "utils/misc.h"
+#if !defined(PGSCLI)
 #include <ctl/ctlTree.h>
 #include "ctl/ctlSQLBox.h"
 #include "ctl/ctlListView.h"
@@ -31,14 +32,17 @@
 #include <ctl/ctlCheckTreeView.h>
 #include <ctl/ctlColourPicker.h>
 #include "dlg/dlgClasses.h"
+#endif // PGSCLI
 #include "db/pgConn.h"
 #include "db/pgSet.h"
+#if !defined(PGSCLI)
 #include "utils/factory.h"
 
 #include "precomp.h"
 
 // App headers
 #include "utils/sysSettings.h"
+#endif // PGSCLI
 
 #ifdef __WXMSW__
 #else
@@ -79,6 +83,7 @@ const wxString SERVER_MAX_VERSION_T = wxT("9.4");
 #define strincmp _strincmp
 #endif
 
+#if !defined(PGSCLI)
 extern wxPathList path;                 // The search path
 extern wxString loadPath;               // Where the program is loaded from
 extern wxString docPath;                // Where docs are stored
@@ -114,6 +119,7 @@ extern wxString edbRestoreExecutable;
 extern wxString gpBackupExecutable;
 extern wxString gpBackupAllExecutable;
 extern wxString gpRestoreExecutable;
+#endif // PGSCLI
 
 //
 // Support for additional functions included in the EnterpriseDB
@@ -152,6 +158,7 @@ extern PQSENDQUERYPREPAREDOUT PQiSendQueryPreparedOut;
 // Simple hash map used as an ad-hoc data cache
 WX_DECLARE_STRING_HASH_MAP(wxString, cacheMap);
 
+#if !defined(PGSCLI)
 // Class declarations
 class pgAdmin3 : public wxApp
 {
@@ -250,6 +257,7 @@ private:
 };
 
 extern pgAppearanceFactory *appearanceFactory;
+#endif // PGSCLI
 
 
 #endif // PGADMIN3_H
@@ -22,6 +22,15 @@ protected:
 	wxString m_name;
 	const pgsExpression *m_var;
 
+private:
+
+	/** Where the variable is in the symbol table, see pgsIdent. */
+	mutable pgsOperand *m_slot;
+
+	mutable const pgsVarMap *m_slot_vars;
+
+	pgsOperand &slot(pgsVarMap &vars) const;
+
 public:
 
 	pgsAssign(const wxString &name, const pgsExpression *var);
@@ -38,6 +47,12 @@ public:
 
 	virtual pgsOperand eval(pgsVarMap &vars) const;
 
+	virtual void compile(pgsCompiler &c) const;
+
+	virtual void compile_exec(pgsCompiler &c) const;
+
+	virtual void exec(pgsVarMap &vars) const;
+
 };
 
 #endif /*PGSASSIGN_H_*/
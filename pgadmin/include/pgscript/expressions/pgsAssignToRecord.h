@@ -14,6 +14,8 @@
 #include "pgscript/pgScript.h"
 #include "pgscript/expressions/pgsAssign.h"
 
+class pgsRecord;
+
 class pgsAssignToRecord : public pgsAssign
 {
 
@@ -39,6 +41,16 @@ public:
 
 	virtual pgsOperand eval(pgsVarMap &vars) const;
 
+	virtual void exec(pgsVarMap &vars) const;
+
+	virtual void compile(pgsCompiler &c) const;
+
+	virtual void compile_exec(pgsCompiler &c) const;
+
+	/** Stores var into rec at line and column. */
+	void assign(pgsRecord &rec, const pgsVariable &var,
+	            const pgsVariable &line, const pgsVariable &column) const;
+
 };
 
 #endif /*PGSASSIGNTORECORD_H_*/
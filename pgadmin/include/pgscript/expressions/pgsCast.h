@@ -41,6 +41,11 @@ public:
 
 	virtual pgsOperand eval(pgsVarMap &vars) const;
 
+	virtual void compile(pgsCompiler &c) const;
+
+	/** var cast to cast_type, a token of the parser. */
+	static pgsOperand cast(const int &cast_type, const pgsVariable &var);
+
 };
 
 #endif /*PGSCAST_H_*/
@@ -37,6 +37,11 @@ public:
 
 	virtual pgsOperand eval(pgsVarMap &vars) const;
 
+	virtual void compile(pgsCompiler &c) const;
+
+	/** Number of columns of var, which is 0 if it is not defined. */
+	static pgsOperand count(const pgsVariable *var);
+
 };
 
 #endif /*PGSCOLUMNS_H_*/
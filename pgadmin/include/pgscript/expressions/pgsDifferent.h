@@ -33,6 +33,8 @@ public:
 
 	virtual pgsOperand eval(pgsVarMap &vars) const;
 
+	virtual void compile(pgsCompiler &c) const;
+
 };
 
 #endif /*PGSDIFFERENT_H_*/
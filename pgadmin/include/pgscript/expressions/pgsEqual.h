@@ -38,6 +38,8 @@ public:
 
 	virtual pgsOperand eval(pgsVarMap &vars) const;
 
+	virtual void compile(pgsCompiler &c) const;
+
 };
 
 #endif /*PGSEQUAL_H_*/
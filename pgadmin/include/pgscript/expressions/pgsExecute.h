@@ -13,6 +13,7 @@
 
 #include "pgscript/pgScript.h"
 #include "pgscript/expressions/pgsExpression.h"
+#include "pgscript/utilities/pgsBulkCopy.h"
 
 class pgsOutputStream;
 class pgsThread;
@@ -28,6 +29,30 @@ private:
 
 	pgsThread *m_app;
 
+	/** The query cut at its variables: m_parts[0], the value of m_vars[0],
+	 * m_parts[1], and so on. The escaped characters have been unescaped. */
+	wxArrayString m_parts;
+
+	wxArrayString m_vars;
+
+	/** For each variable, whether it is a whole string literal ('@var'),
+	 * which is passed as a parameter when the query is prepared. */
+	wxArrayInt m_bound;
+
+	/** Is the query a single SELECT, INSERT, UPDATE, DELETE, VALUES or WITH,
+	 * whose variables are all bound? */
+	bool m_preparable;
+
+	/** The query, if it loads generated rows with COPY. */
+	pgsBulkCopy m_bulk;
+
+	void parse();
+
+	/** Writes message to the output, indented after prefix. */
+	void output(const wxString &prefix, const wxString &message) const;
+
+	pgsOperand eval_bulk(pgsVarMap &vars) const;
+
 public:
 
 	pgsExecute(const wxString &query, pgsOutputStream *cout = 0,
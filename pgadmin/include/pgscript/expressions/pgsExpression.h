@@ -14,6 +14,7 @@
 #include "pgscript/pgScript.h"
 #include "pgscript/utilities/pgsCopiedPtr.h"
 
+class pgsCompiler;
 class pgsProgram;
 class pgsVariable;
 
@@ -43,6 +44,23 @@ public:
 
 	virtual pgsOperand eval(pgsVarMap &vars) const = 0;
 
+	/** Evaluates the expression for its effects only, when the result
+	 * is not used (in a statement). */
+	virtual void exec(pgsVarMap &vars) const;
+
+	/** Emits the instructions which push the value of the expression.
+	 * By default the expression is evaluated as a tree. */
+	virtual void compile(pgsCompiler &c) const;
+
+	/** Emits the instructions of exec(), which leave nothing on the
+	 * stack. */
+	virtual void compile_exec(pgsCompiler &c) const;
+
+	/** Emits the instructions of a condition, which jump when it is
+	 * when_true. The jumps to patch are added to jumps. */
+	virtual void compile_jump(pgsCompiler &c, wxArrayInt &jumps,
+	                          bool when_true) const;
+
 };
 
 #endif /*PGSEXPRESSION_H_*/
@@ -21,6 +21,15 @@ protected:
 
 	wxString m_name;
 
+private:
+
+	/** Where the variable is in the symbol table, once it has been found
+	 * there: it is not looked up by its name every time then. */
+	mutable pgsOperand *m_slot;
+
+	/** The symbol table m_slot belongs to. */
+	mutable const pgsVarMap *m_slot_vars;
+
 public:
 
 	pgsIdent(const wxString &name);
@@ -37,6 +46,8 @@ public:
 
 	virtual pgsOperand eval(pgsVarMap &vars) const;
 
+	virtual void compile(pgsCompiler &c) const;
+
 public:
 
 	static const wxString m_now;
@@ -14,6 +14,8 @@
 #include "pgscript/pgScript.h"
 #include "pgscript/expressions/pgsIdent.h"
 
+class pgsRecord;
+
 class pgsIdentRecord : public pgsIdent
 {
 
@@ -39,6 +41,18 @@ public:
 
 	virtual pgsOperand eval(pgsVarMap &vars) const;
 
+	virtual void compile(pgsCompiler &c) const;
+
+	/** Element of rec at line and column, or the whole line if column is
+	 * NULL. It is an empty string if there is no such element. */
+	static pgsOperand get(const pgsRecord &rec, const pgsVariable &line,
+	                      const pgsVariable *column);
+
+	/** Emits the instructions reading name[line][column], column being
+	 * optional. */
+	static void compile_get(pgsCompiler &c, const wxString &name,
+	                        const pgsExpression *line, const pgsExpression *column);
+
 };
 
 #endif /*PGSIDENTRECORD_H_*/
@@ -33,6 +33,11 @@ public:
 
 	virtual pgsOperand eval(pgsVarMap &vars) const;
 
+	virtual void compile(pgsCompiler &c) const;
+
+	virtual void compile_jump(pgsCompiler &c, wxArrayInt &jumps,
+	                          bool when_true) const;
+
 };
 
 #endif /*PGSOR_H_*/
@@ -14,6 +14,8 @@
 #include "pgscript/pgScript.h"
 #include "pgscript/expressions/pgsExpression.h"
 
+class pgsRecord;
+
 class pgsRemoveLine : public pgsExpression
 {
 
@@ -38,6 +40,13 @@ public:
 
 	virtual pgsOperand eval(pgsVarMap &vars) const;
 
+	virtual void compile(pgsCompiler &c) const;
+
+	virtual void compile_exec(pgsCompiler &c) const;
+
+	/** Removes line from rec. */
+	void remove(pgsRecord &rec, const pgsVariable &line) const;
+
 };
 
 #endif /*PGSREMOVELINE_H_*/
@@ -42,6 +42,8 @@ public:
 
 	virtual pgsDateGen *clone();
 
+	virtual pgsDateGen *reseed(const long &offset);
+
 	/* pgsDateGen & operator =(const pgsDateGen & that); */
 
 	/* pgsDateGen(const pgsDateGen & that); */
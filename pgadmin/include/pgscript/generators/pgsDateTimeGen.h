@@ -42,6 +42,8 @@ public:
 
 	virtual pgsDateTimeGen *clone();
 
+	virtual pgsDateTimeGen *reseed(const long &offset);
+
 	/* pgsDateTimeGen & operator =(const pgsDateTimeGen & that); */
 
 	/* pgsDateTimeGen(const pgsDateTimeGen & that); */
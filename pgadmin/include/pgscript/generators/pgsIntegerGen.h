@@ -107,6 +107,8 @@ public:
 
 	virtual pgsIntegerGen *clone();
 
+	virtual pgsIntegerGen *reseed(const long &offset);
+
 	/* pgsIntegerGen & operator =(const pgsIntegerGen & that); */
 
 	/* pgsIntegerGen(const pgsIntegerGen & that); */
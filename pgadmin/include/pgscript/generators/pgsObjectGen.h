@@ -23,6 +23,9 @@ protected:
 
 	pgsObjectGen(const long &seed = wxDateTime::GetTimeNow());
 
+	/** The seed, offset (never 0). */
+	long offset_seed(const long &offset) const;
+
 	/* pgsObjectGen & operator =(const pgsObjectGen & that); */
 
 	/* pgsObjectGen(const pgsObjectGen & that); */
@@ -35,6 +38,16 @@ public:
 
 	virtual pgsObjectGen *clone() = 0;
 
+	/** A generator with the same parameters, whose seed is offset: it
+	 * draws values of its own, e.g. in another thread. 0 if there can't be
+	 * such a generator, e.g. for a sequence, whose values must all be drawn
+	 * from the same generator. */
+	virtual pgsObjectGen *reseed(const long &offset);
+
+	/** Does random() query the database? It can't be called then while the
+	 * connection is busy with something else, e.g. a COPY. */
+	virtual bool uses_connection() const;
+
 };
 
 #endif /*PGSOBJECTGEN_H_*/
@@ -48,6 +48,8 @@ public:
 
 	virtual pgsRealGen *clone();
 
+	virtual pgsRealGen *reseed(const long &offset);
+
 	/* pgsRealGen & operator =(const pgsRealGen & that); */
 
 	/* pgsRealGen(const pgsRealGen & that); */
@@ -41,6 +41,8 @@ public:
 
 	virtual wxString random();
 
+	virtual bool uses_connection() const;
+
 	virtual ~pgsReferenceGen();
 
 	virtual pgsReferenceGen *clone();
@@ -81,6 +81,8 @@ public:
 
 	virtual pgsRegexGen *clone();
 
+	virtual pgsRegexGen *reseed(const long &offset);
+
 	/* pgsRegexGen & operator =(const pgsRegexGen & that); */
 
 	/* pgsRegexGen(const pgsRegexGen & that); */
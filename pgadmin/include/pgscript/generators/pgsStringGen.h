@@ -41,6 +41,8 @@ public:
 
 	virtual pgsStringGen *clone();
 
+	virtual pgsStringGen *reseed(const long &offset);
+
 	/* pgsStringGen & operator =(const pgsStringGen & that); */
 
 	/* pgsStringGen(const pgsStringGen & that); */
@@ -42,6 +42,8 @@ public:
 
 	virtual pgsTimeGen *clone();
 
+	virtual pgsTimeGen *reseed(const long &offset);
+
 	/* pgsTimeGen & operator =(const pgsTimeGen & that); */
 
 	/* pgsTimeGen(const pgsTimeGen & that); */
@@ -77,6 +77,14 @@ public:
 
 	virtual pgsOperand eval(pgsVarMap &vars) const;
 
+	/** Does drawing a value query the database? */
+	bool uses_connection() const;
+
+	/** A generator with the same parameters, whose seed is offset, or 0 if
+	 * there can't be one (see pgsObjectGen::reseed). It belongs to the
+	 * caller. */
+	pgsObjectGen *reseed(const long &offset) const;
+
 protected:
 
 	pgsOperand operand() const;
@@ -23,6 +23,11 @@ class pgsString;
  * number otherwise it is a string. The difference between a string stored
  * in this object and a string stored in pgsString is that a string in pgsNumber
  * cannot be concatenated with another one in pgsPlus.
+ *
+ * Integers fitting in 64 bits are also held as such, and computed natively;
+ * the other numbers (reals, bigger integers and overflows) are computed with
+ * MAPM. Computed integers are converted to a string only when their value()
+ * is needed, i.e. when they are printed or put in a query.
  */
 class pgsNumber : public pgsVariable
 {
@@ -59,12 +64,21 @@ public:
 
 protected:
 
+	/** The number as it was given, empty if it has been computed. */
 	wxString m_data;
 
+	/** Is the number an integer held in m_int? */
+	bool m_native;
+
+	wxLongLong_t m_int;
+
 public:
 
 	explicit pgsNumber(const wxString &data, const bool &is_real = pgsInt);
 
+	/** An integer, which has been computed. */
+	explicit pgsNumber(const wxLongLong_t &data);
+
 	virtual ~pgsNumber();
 
 	virtual pgsVariable *clone() const;
@@ -85,6 +99,26 @@ public:
 
 	static pgsTypes num_type(const wxString &num);
 
+private:
+
+	enum pgsArithOp
+	{
+		pgsOPlus, pgsOMinus, pgsOTimes, pgsOOver, pgsOModulo
+	};
+
+	/** Computes this op rhs, rhs being a number. */
+	pgsOperand arith(const pgsVariable &rhs, const pgsArithOp &op) const;
+
+	/** Computes a op b natively, unless it overflows. */
+	static bool native_arith(const pgsArithOp &op, const wxLongLong_t &a,
+	                         const wxLongLong_t &b, wxLongLong_t &result);
+
+	/** Compares this and rhs (-1, 0 or 1), rhs being a number. */
+	int compare(const pgsVariable &rhs) const;
+
+	/** The number for MAPM. */
+	MAPM mapm() const;
+
 public:
 
 	virtual pgsNumber number() const;
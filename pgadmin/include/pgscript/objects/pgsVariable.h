@@ -111,6 +111,9 @@ public:
 
 	virtual pgsOperand eval(pgsVarMap &vars) const = 0;
 
+	/** A variable of the tree is a constant, which is pushed as it is. */
+	virtual void compile(pgsCompiler &c) const;
+
 public:
 
 	bool is_number() const;
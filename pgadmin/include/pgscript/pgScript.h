@@ -33,6 +33,7 @@ const wxString PGSOUTEXCEPTION(wxT("[EXCEPTION] "));
 const wxString PGSOUTQUERY    (wxT("[QUERY    ] "));
 const wxString PGSOUTWARNING  (wxT("[WARNING  ] "));
 const wxString PGSOUTERROR    (wxT("[ERROR    ] "));
+const wxString PGSOUTBENCH    (wxT("[BENCH    ] "));
 
 /*** LOGGING ***/
 
@@ -14,6 +14,8 @@
 #include "pgscript/pgScript.h"
 #include "pgscript/utilities/pgsThread.h"
 
+class pgsBench;
+
 class pgsApplication
 {
 
@@ -50,6 +52,12 @@ private:
 	/** Location of the last error if there was one. */
 	int m_last_error_line;
 
+	/** Where the statements executed are measured, if they are. */
+	pgsBench *m_bench;
+
+	/** Whether the scripts are compiled to bytecode before they are run. */
+	bool m_compiled;
+
 public:
 
 	/** Creates an application and creates a connection. */
@@ -91,6 +99,17 @@ public:
 	/** Deletes everything in the symbol table. */
 	void ClearSymbols();
 
+	/** Defines a variable in the symbol table, for the next runs. */
+	void SetSymbol(const wxString &name, const pgsOperand &value);
+
+	/** Measures the statements executed by the next runs into bench, or
+	 * stops measuring them if it is NULL. bench is not deleted. */
+	void SetBench(pgsBench *bench);
+
+	/** Runs the next scripts compiled to bytecode (the default), or by
+	 * walking their tree if compiled is false. */
+	void SetCompiled(bool compiled);
+
 #if !defined(PGSCLI)
 	/** Used in pgAdmin integration for sending an event to the caller when the
 	 * thread is finishing its task. */
@@ -29,6 +29,8 @@ public:
 
 	virtual void eval(pgsVarMap &vars) const;
 
+	virtual void compile(pgsCompiler &c) const;
+
 private:
 
 	pgsAssertStmt(const pgsAssertStmt &that);
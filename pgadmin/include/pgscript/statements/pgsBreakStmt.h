@@ -25,6 +25,8 @@ public:
 
 	virtual void eval(pgsVarMap &vars) const;
 
+	virtual void compile(pgsCompiler &c) const;
+
 private:
 
 	pgsBreakStmt(const pgsBreakStmt &that);
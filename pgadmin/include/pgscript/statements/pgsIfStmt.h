@@ -32,6 +32,8 @@ public:
 
 	virtual void eval(pgsVarMap &vars) const;
 
+	virtual void compile(pgsCompiler &c) const;
+
 private:
 
 	pgsIfStmt(const pgsIfStmt &that);
@@ -32,6 +32,8 @@ public:
 
 	virtual void eval(pgsVarMap &vars) const;
 
+	virtual void compile(pgsCompiler &c) const;
+
 private:
 
 	pgsPrintStmt(const pgsPrintStmt &that);
@@ -17,6 +17,7 @@
 #include <wx/thread.h>
 
 class pgsStmtList;
+class pgsThread;
 
 class pgsProgram
 {
@@ -25,9 +26,18 @@ private:
 
 	pgsVarMap &m_vars;
 
+	pgsOutputStream &m_cout;
+
+	pgsThread *m_app;
+
+	/** Whether the program is compiled to bytecode, rather than evaluated
+	 * by walking its tree. */
+	bool m_compiled;
+
 public:
 
-	pgsProgram(pgsVarMap &vars);
+	pgsProgram(pgsVarMap &vars, pgsOutputStream &cout, pgsThread *app = 0,
+	           bool compiled = true);
 
 	~pgsProgram();
 
@@ -14,6 +14,7 @@
 #include "pgscript/pgScript.h"
 #include "pgscript/objects/pgsVariable.h"
 
+class pgsCompiler;
 class pgsThread;
 
 class pgsStmt
@@ -39,6 +40,10 @@ public:
 
 	virtual void eval(pgsVarMap &vars) const = 0;
 
+	/** Emits the instructions of the statement. By default it is run as
+	 * a tree. */
+	virtual void compile(pgsCompiler &c) const;
+
 private:
 
 	pgsStmt(const pgsStmt &that);
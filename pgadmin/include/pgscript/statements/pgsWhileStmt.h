@@ -31,6 +31,8 @@ public:
 
 	virtual void eval(pgsVarMap &vars) const;
 
+	virtual void compile(pgsCompiler &c) const;
+
 private:
 
 	pgsWhileStmt(const pgsWhileStmt &that);
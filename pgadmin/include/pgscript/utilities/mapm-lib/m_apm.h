@@ -68,6 +68,21 @@ typedef M_APM_struct *M_APM;
     "MAPM Library Version 4.9.5  Copyright (C) 1999-2007, Michael C. Ring"
 #define MAPM_LIB_SHORT_VERSION "4.9.5"
 
+/*
+ *	pgScript: the working storage of the library is kept per thread,
+ *	where the compiler supports it, so that several threads can compute
+ *	at once (see pgsBulkCopy). MAPM_THREAD_LOCAL is left undefined when
+ *	it doesn't: only one thread at a time may use the library then.
+ *	The constants (MM_Zero, ...) stay shared: they're set by the first
+ *	m_apm_init(), and the ones extended by the logarithms and the
+ *	trigonometric functions must only be used by one thread at a time.
+ */
+#if defined(_MSC_VER)
+#define MAPM_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) && !defined(__APPLE__)
+#define MAPM_THREAD_LOCAL __thread
+#endif
+
 
 /*
  *	convienient predefined constants
@@ -99,6 +114,7 @@ extern	M_APM	MM_LOG_3_BASE_E;
 extern	M_APM	m_apm_init(void);
 extern	void	m_apm_free(M_APM);
 extern	void	m_apm_free_all_mem(void);
+extern	void	m_apm_free_thread_mem(void);
 extern	void	m_apm_trim_mem_usage(void);
 extern	char	*m_apm_lib_version(char *);
 extern	char	*m_apm_lib_short_version(char *);
@@ -384,13 +400,19 @@ public:
 		m_apm_set_long(val(), l);
 		return *this;
 	}
+	/* MM_One isn't wrapped into a MAPM: its reference count would be
+	   updated by several threads at once. */
 	MAPM operator++() /* Prefix increment operator */
 	{
-		return *this = *this + MM_One;
+		MAPM ret;
+		m_apm_add(ret.val(), cval(), MM_One);
+		return *this = ret;
 	}
 	MAPM operator--() /* Prefix decrement operator */
 	{
-		return *this = *this - MM_One;
+		MAPM ret;
+		m_apm_subtract(ret.val(), cval(), MM_One);
+		return *this = ret;
 	}
 	const MAPM operator++(int)  /* Postfix increment operator */
 	{
@@ -42,6 +42,16 @@
 #include <math.h>
 #include "m_apm.h"
 
+/*
+ *	the working storage of each module (see MAPM_THREAD_LOCAL)
+ */
+
+#ifdef MAPM_THREAD_LOCAL
+#define M_THREAD_LOCAL MAPM_THREAD_LOCAL
+#else
+#define M_THREAD_LOCAL
+#endif
+
 /*
  *   this supports older (and maybe newer?) Borland compilers.
  *   these Borland compilers define __MSDOS__
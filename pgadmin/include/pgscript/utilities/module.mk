@@ -11,9 +11,14 @@
 
 pgadmin3_SOURCES += \
 	include/pgscript/utilities/pgsAlloc.h \
+	include/pgscript/utilities/pgsBench.h \
+	include/pgscript/utilities/pgsBulkCopy.h \
+	include/pgscript/utilities/pgsCode.h \
+	include/pgscript/utilities/pgsCompiler.h \
 	include/pgscript/utilities/pgsContext.h \
 	include/pgscript/utilities/pgsCopiedPtr.h \
 	include/pgscript/utilities/pgsDriver.h \
+	include/pgscript/utilities/pgsMachine.h \
 	include/pgscript/utilities/pgsMapm.h \
 	include/pgscript/utilities/pgsScanner.h \
 	include/pgscript/utilities/pgsSharedPtr.h \
@@ -0,0 +1,89 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgScript - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef PGSBENCH_H_
+#define PGSBENCH_H_
+
+#include "pgscript/pgScript.h"
+
+#include <wx/hashmap.h>
+
+/** Buckets of the latency histograms: bucket i counts the executions which
+ * took from 2^i to 2^(i+1) microseconds. */
+#define PGS_BENCH_BUCKETS 32
+
+/** Statements measured apart, the next ones are counted together. */
+#define PGS_BENCH_MAX_STMTS 1000
+
+/** Measures of the executions of a statement. */
+class pgsBenchStmt
+{
+
+public:
+
+	wxLongLong_t count;
+
+	wxLongLong_t rows;
+
+	/** Latencies, in microseconds. */
+	wxLongLong_t total, min, max;
+
+	wxLongLong_t buckets[PGS_BENCH_BUCKETS];
+
+	pgsBenchStmt();
+
+	void add(const wxLongLong_t &usec, const wxLongLong_t &nb_rows);
+
+	void merge(const pgsBenchStmt &that);
+
+};
+
+WX_DECLARE_STRING_HASH_MAP(pgsBenchStmt, pgsBenchMap);
+
+/** Latencies of the statements executed by scripts, and the rows they
+ * returned or affected, by statement. A statement is the query, whose
+ * variables passed as parameters are left out ($1, ...): the executions
+ * of an INSERT in a loop are the same statement. */
+class pgsBench
+{
+
+private:
+
+	pgsBenchMap m_stmts;
+
+	/** The statements, in the order they were first executed. */
+	wxArrayString m_order;
+
+public:
+
+	pgsBench();
+
+	/** A monotonic clock in microseconds, to measure latencies with. */
+	static wxLongLong_t now();
+
+	/** Measures an execution of stmt. */
+	void add(const wxString &stmt, const wxLongLong_t &usec,
+	         const wxLongLong_t &rows);
+
+	/** Adds the measures of that to these. */
+	void merge(const pgsBench &that);
+
+	/** The measures as text, to be loaded by another process. */
+	wxString save() const;
+
+	/** Adds measures saved by save(). */
+	bool load(const wxString &data);
+
+	/** Writes the histograms, and the throughput over elapsed microseconds. */
+	void report(pgsOutputStream &out, const wxLongLong_t &elapsed) const;
+
+};
+
+#endif /*PGSBENCH_H_*/
@@ -0,0 +1,53 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgScript - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef PGSBULKCOPY_H_
+#define PGSBULKCOPY_H_
+
+#include "pgscript/pgScript.h"
+#include "pgscript/expressions/pgsExpression.h"
+
+class pgsThread;
+
+/** Bulk load of generated rows:
+ *   COPY table [(column, ...)] FROM @var [, @var ...] ROWS count
+ * where count is a number or a variable. Each row gets a value of each of
+ * the variables, which are usually generators, and the rows are streamed
+ * to the server with COPY FROM STDIN rather than inserted one by one. */
+class pgsBulkCopy
+{
+
+private:
+
+	/** COPY table [(column, ...)] FROM STDIN. */
+	wxString m_copy;
+
+	/** The variables giving the columns. */
+	wxArrayString m_vars;
+
+	/** Number of rows, or the variable holding it. */
+	wxString m_rows;
+
+public:
+
+	pgsBulkCopy();
+
+	/** Is query a bulk load? It is remembered if so. */
+	bool parse(const wxString &query);
+
+	bool is_valid() const;
+
+	/** Loads the rows on the connection of app. Returns the number of rows
+	 * loaded, or -1 if the load failed: error tells why then. */
+	wxLongLong_t run(pgsVarMap &vars, pgsThread *app, wxString &error) const;
+
+};
+
+#endif /*PGSBULKCOPY_H_*/
@@ -0,0 +1,146 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgScript - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef PGSCODE_H_
+#define PGSCODE_H_
+
+#include "pgscript/pgScript.h"
+#include "pgscript/objects/pgsVariable.h"
+
+class pgsStmt;
+
+/** Instructions of pgsMachine, which works on a stack of operands. a and b
+ * are the arguments of the instruction; the target of a jump is always a. */
+enum pgsOpCode
+{
+	PGS_OP_CONST,         /**< Pushes constant a. */
+	PGS_OP_LOAD,          /**< Pushes variable a. */
+	PGS_OP_STORE,         /**< Pops into variable a. */
+	PGS_OP_POP,           /**< Drops the top of the stack. */
+	PGS_OP_EVAL,          /**< Pushes the value of expression a, evaluated as a tree. */
+	PGS_OP_EXEC,          /**< Runs statement a as a tree. */
+	PGS_OP_PLUS,          /**< Binary operators: pop rhs and lhs, push the result. */
+	PGS_OP_MINUS,
+	PGS_OP_TIMES,
+	PGS_OP_OVER,
+	PGS_OP_MODULO,
+	PGS_OP_EQUAL,
+	PGS_OP_ALMOST_EQUAL,
+	PGS_OP_DIFFERENT,
+	PGS_OP_GREATER,
+	PGS_OP_LOWER,
+	PGS_OP_GREATER_EQUAL,
+	PGS_OP_LOWER_EQUAL,
+	PGS_OP_NOT,           /**< Unary operators: replace the top of the stack. */
+	PGS_OP_TRIM,
+	PGS_OP_CAST,          /**< Casts to type a, a token of the parser. */
+	PGS_OP_LINES,         /**< Pushes the number of lines of variable a. */
+	PGS_OP_COLUMNS,       /**< Pushes the number of columns of variable a. */
+	PGS_OP_RECORD_CHECK,  /**< Fails if variable a is not a record. */
+	PGS_OP_RECORD_LINE,   /**< Pops a line, pushes it from record a. */
+	PGS_OP_RECORD_GET,    /**< Pops a column and a line, pushes the value from record a. */
+	PGS_OP_RECORD_SET,    /**< Pops a column, a line and a value into record a, for expression b. */
+	PGS_OP_RECORD_REMOVE, /**< Pops a line to remove from record a, for expression b. */
+	PGS_OP_JUMP,          /**< Goes on at a. */
+	PGS_OP_JUMP_TRUE,     /**< Pops, goes on at a if it is true. */
+	PGS_OP_JUMP_FALSE,    /**< Pops, goes on at a if it is false. */
+	PGS_OP_JUMP_NOT_RECORD, /**< Goes on at a if variable b is not a record. */
+	PGS_OP_LOOP,          /**< Goes back to a, unless the script is interrupted. */
+	PGS_OP_NEXT,          /**< Ends a statement: checks for interruption. */
+	PGS_OP_PRINT,         /**< Pops and prints. */
+	PGS_OP_ASSERT,        /**< Pops, fails on expression a if it is false. */
+	PGS_OP_HALT           /**< Ends the program. */
+};
+
+class pgsInstr
+{
+
+public:
+
+	pgsOpCode op;
+
+	int a, b;
+
+	/** Line of the statement, the error messages refer to. */
+	int line;
+
+};
+
+/** A program compiled by pgsCompiler: a flat array of instructions, whose
+ * variables are resolved to slots. The constants and the nodes still
+ * evaluated as trees belong to the parse tree, which must outlive the
+ * code. */
+class pgsCode
+{
+
+	friend class pgsCompiler;
+
+private:
+
+	pgsInstr *m_instrs;
+
+	int m_count;
+
+	int m_size;
+
+	/** Highest number of operands on the stack. */
+	int m_depth;
+
+	/** Names of the variables, by slot. */
+	wxArrayString m_slots;
+
+	wxArrayPtrVoid m_consts;
+
+	wxArrayPtrVoid m_exprs;
+
+	wxArrayPtrVoid m_stmts;
+
+	/** The constants made by the compiler, rather than found in the tree. */
+	wxArrayPtrVoid m_owned;
+
+public:
+
+	pgsCode();
+
+	~pgsCode();
+
+	const pgsInstr *instrs() const;
+
+	int count() const;
+
+	int depth() const;
+
+	int count_slots() const;
+
+	const wxString &slot_name(const int &slot) const;
+
+	const pgsVariable *constant(const int &i) const;
+
+	const pgsExpression *expr(const int &i) const;
+
+	const pgsStmt *stmt(const int &i) const;
+
+	/** Writes the instructions into the log, at the debug level. */
+	void dump() const;
+
+	/** Change of the number of operands on the stack by an instruction. */
+	static int effect(const pgsOpCode &op);
+
+	static const wxChar *op_name(const pgsOpCode &op);
+
+private:
+
+	pgsCode(const pgsCode &that);
+
+	pgsCode &operator=(const pgsCode &that);
+
+};
+
+#endif /*PGSCODE_H_*/
@@ -0,0 +1,136 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgScript - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef PGSCOMPILER_H_
+#define PGSCOMPILER_H_
+
+#include "pgscript/pgScript.h"
+#include "pgscript/utilities/pgsCode.h"
+
+#include <wx/hashmap.h>
+
+WX_DECLARE_STRING_HASH_MAP(int, pgsSlotMap);
+
+/** Compiles a parse tree into a pgsCode. The statements and expressions
+ * emit their own instructions (pgsStmt::compile() and
+ * pgsExpression::compile()) through the methods of the compiler, which
+ * keeps track of the slots, the operands on the stack and the jumps to
+ * patch. */
+class pgsCompiler
+{
+
+private:
+
+	pgsCode &m_code;
+
+	/** Slot of each variable. */
+	pgsSlotMap m_slot_map;
+
+	/** Line of the statement being compiled. */
+	int m_line;
+
+	/** Number of operands on the stack at this point of the code. */
+	int m_depth;
+
+	/** Jumps of the BREAK and CONTINUE statements, which are patched at the
+	 * end of their loop. */
+	wxArrayInt m_breaks;
+
+	wxArrayInt m_continues;
+
+	/** Number of jumps in m_breaks and m_continues when each enclosing
+	 * loop began, the innermost last. */
+	wxArrayInt m_loop_breaks;
+
+	wxArrayInt m_loop_continues;
+
+	int m_true;
+
+	int m_false;
+
+	int m_zero;
+
+	int m_empty;
+
+public:
+
+	pgsCompiler(pgsCode &code);
+
+	~pgsCompiler();
+
+	/** Compiles the program stmt into the code. */
+	void compile(const pgsStmt &stmt);
+
+	/** Appends an instruction, and returns its address. */
+	int emit(const pgsOpCode &op, const int &a = 0, const int &b = 0);
+
+	/** Address of the next instruction. */
+	int here() const;
+
+	/** Makes the jump at address go to the next instruction. */
+	void patch(const int &address);
+
+	void patch(const wxArrayInt &addresses);
+
+	/** Slot of the variable name. */
+	int slot(const wxString &name);
+
+	/** Index of a constant, an expression or a statement of the tree. */
+	int constant(const pgsVariable *var);
+
+	int expr(const pgsExpression *expr);
+
+	int stmt(const pgsStmt *stmt);
+
+	/** Constants 1, 0 (true, false and zero) and the empty string. */
+	int true_constant() const;
+
+	int false_constant() const;
+
+	int zero_constant() const;
+
+	int empty_constant() const;
+
+	int line() const;
+
+	void line(const int &line);
+
+	int depth() const;
+
+	/** Sets the number of operands on the stack, where code paths meet. */
+	void depth(const int &depth);
+
+	/** Compiles expr into the push of 1 or 0, as the logical operators
+	 * evaluate to. */
+	void compile_truth(const pgsExpression &expr);
+
+	/** The loops: the BREAK and CONTINUE statements in between jump to
+	 * the end of the loop and to continue_target. */
+	void begin_loop();
+
+	bool in_loop() const;
+
+	void add_break(const int &address);
+
+	void add_continue(const int &address);
+
+	void end_loop(const int &continue_target);
+
+private:
+
+	int own(pgsVariable *var);
+
+	pgsCompiler(const pgsCompiler &that);
+
+	pgsCompiler &operator=(const pgsCompiler &that);
+
+};
+
+#endif /*PGSCOMPILER_H_*/
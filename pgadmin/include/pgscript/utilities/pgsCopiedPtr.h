@@ -51,6 +51,19 @@ public:
 		return (*this);
 	}
 
+	void swap(pgsCopiedPtr &that)
+	{
+		std::swap(p, that.p);
+	}
+
+	/** Gives up the pointer, which then belongs to the caller. */
+	T *release()
+	{
+		T *q = p;
+		p = 0;
+		return q;
+	}
+
 	T &operator *()
 	{
 		return *p;
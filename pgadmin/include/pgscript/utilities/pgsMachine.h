@@ -0,0 +1,111 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgScript - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef PGSMACHINE_H_
+#define PGSMACHINE_H_
+
+#include "pgscript/pgScript.h"
+#include "pgscript/utilities/pgsCode.h"
+
+class pgsRecord;
+class pgsThread;
+
+/** An operand on the stack of pgsMachine. The variables and the constants
+ * are not copied onto the stack: they are borrowed, and only the results
+ * of the operations belong to the stack. */
+class pgsStackItem
+{
+
+public:
+
+	const pgsVariable *var;
+
+	bool owned;
+
+};
+
+/** Runs a pgsCode on the symbol table: the instructions are dispatched in
+ * a loop, rather than evaluated by walking the parse tree. */
+class pgsMachine
+{
+
+private:
+
+	const pgsCode &m_code;
+
+	pgsVarMap &m_vars;
+
+	pgsOutputStream &m_cout;
+
+	pgsThread *m_app;
+
+	/** Entries of the symbol table by slot, 0 until the variable has been
+	 * found there. The entries don't move while the script is running. */
+	pgsOperand **m_slots;
+
+	pgsStackItem *m_stack;
+
+	/** Number of operands on the stack. */
+	int m_top;
+
+	/** Address of the instruction being executed. */
+	int m_pc;
+
+public:
+
+	pgsMachine(const pgsCode &code, pgsVarMap &vars, pgsOutputStream &cout,
+	           pgsThread *app = 0);
+
+	~pgsMachine();
+
+	/** Runs the code. Errors are written to the output, on the line of
+	 * the statement they occurred in, and thrown again. */
+	void run();
+
+private:
+
+	void execute();
+
+	/** The variable of slot, or 0 if it is not defined. */
+	pgsOperand *find(const int &slot);
+
+	/** The entry of slot, created if the variable is not defined. */
+	pgsOperand &bind(const int &slot);
+
+	/** The record of slot, or 0 if the variable is not a record. */
+	pgsRecord *record(const int &slot);
+
+	/** The i-th operand from the top of the stack. */
+	const pgsVariable &top(const int &i = 0) const;
+
+	void push(const pgsVariable *var, const bool &owned);
+
+	/** Pushes value, which then belongs to the stack. */
+	void push(pgsOperand &value);
+
+	/** Pops the top of the stack into value. */
+	void pop(pgsOperand &value);
+
+	/** Drops the nb operands on top of the stack. */
+	void drop(const int &nb = 1);
+
+	/** Copies the operands borrowed from var, which is about to change. */
+	void detach(const pgsVariable *var);
+
+	/** Copies all the borrowed operands. */
+	void detach();
+
+	pgsMachine(const pgsMachine &that);
+
+	pgsMachine &operator=(const pgsMachine &that);
+
+};
+
+#endif /*PGSMACHINE_H_*/
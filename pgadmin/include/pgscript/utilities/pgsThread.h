@@ -15,11 +15,18 @@
 #include "pgscript/objects/pgsVariable.h"
 
 #include <wx/thread.h>
+#include <wx/hashmap.h>
 
 class pgConn;
+class pgSet;
 class pgsApplication;
+class pgsBench;
 class pgsStmtList;
 
+/** Number of the prepared statement of each query: 0 if it has been executed
+ * only once yet, -1 if it can't be prepared. */
+WX_DECLARE_STRING_HASH_MAP(int, pgsPreparedMap);
+
 class pgsThread : public wxThread
 {
 
@@ -49,6 +56,24 @@ private:
 	/** Location of the last error if there was one otherwise -1 */
 	int m_last_error_line;
 
+	/** Queries executed so far, and their prepared statements. */
+	pgsPreparedMap m_prepared;
+
+	/** Number of the last statement prepared. */
+	int m_last_prepared;
+
+	/** Run of the scripts, to tell their prepared statements apart. */
+	int m_run;
+
+	/** Set when the script has been asked to stop. */
+	volatile bool m_cancelled;
+
+	/** Where to measure the statements executed, if they are. */
+	pgsBench *m_bench;
+
+	/** Whether the script is compiled to bytecode before it is run. */
+	bool m_compiled;
+
 public:
 
 	/** Parses a file with the provided encoding. */
@@ -81,8 +106,41 @@ public:
 	/** Get the position (line) of the last error. */
 	int last_error_line() const;
 
+	/** Executes stmt on the connection. A query, which is executed more
+	 * than once, is prepared the second time if preparable is set: query
+	 * is then stmt with its string literals replaced by the parameters.
+	 * The result is never NULL, its status is the one of the connection. */
+	pgSet *execute(const wxString &stmt, const wxString &query,
+	               const wxArrayString &params, bool preparable);
+
+	/** Cancels the query being executed, and the ones to come. */
+	void cancel();
+
+	/** Has the script been asked to stop? */
+	bool cancelled() const;
+
+	/** Measures the statements executed into bench, unless it is NULL. */
+	void bench(pgsBench *bench);
+
+	/** Runs the script compiled to bytecode if compiled is set, otherwise
+	 * by walking its tree. */
+	void compiled(bool compiled);
+
+	/** Measures an execution of stmt, if the statements are measured. */
+	void measure(const wxString &stmt, const wxLongLong_t &usec,
+	             const wxLongLong_t &rows);
+
 private:
 
+	/** Prepares query, and returns the number of the statement. */
+	int prepare(const wxString &query, int nParams);
+
+	/** Name of the prepared statement number. */
+	wxString prepared_name(int number) const;
+
+	/** Deallocates the prepared statements, when the script is done. */
+	void deallocate();
+
 	pgsThread(const pgsThread &that);
 
 	pgsThread &operator=(const pgsThread &that);
@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgCatalogSnapshot.h - Catalog rows of all the tables of a schema
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef PGCATALOGSNAPSHOT_H
+#define PGCATALOGSNAPSHOT_H
+
+#include <wx/wx.h>
+#include <wx/hashmap.h>
+
+// App headers
+#include "db/pgSet.h"
+
+class pgDatabase;
+
+// Time (s) after which the rows of a snapshot aren't handed out anymore
+#define CATALOG_SNAPSHOT_LIFETIME 300
+
+WX_DECLARE_HASH_MAP(OID, wxArrayLong *, wxIntegerHash, wxIntegerEqual, pgCatalogRowsMap);
+WX_DECLARE_HASH_MAP(OID, bool, wxIntegerHash, wxIntegerEqual, pgCatalogRelationMap);
+
+// The result of one schema wide query, with its rows grouped by relation
+class pgCatalogSnapshotSet
+{
+public:
+	pgCatalogSnapshotSet(pgSet *_set) : set(_set) {}
+	~pgCatalogSnapshotSet();
+
+	pgSet *set;
+	pgCatalogRowsMap rows;
+	pgCatalogRelationMap served;
+};
+
+WX_DECLARE_STRING_HASH_MAP(pgCatalogSnapshotSet *, pgCatalogSnapshotSetMap);
+
+// The object browser lists the columns, indexes, constraints etc. of a table
+// with one query per kind of object. When the tables of a schema are listed,
+// a snapshot is started, which reads those for all the tables of the schema
+// with a single query per kind, the first time one of them is needed.
+class pgCatalogSnapshot
+{
+public:
+	pgCatalogSnapshot(pgDatabase *db, OID schemaOid);
+	~pgCatalogSnapshot();
+
+	void AddRelation(OID relid);
+	void Invalidate(OID relid);
+	bool HasRelation(OID relid);
+
+	// Restricts the relation column of a query to the relations of the snapshot
+	wxString GetRelationFilter() const;
+
+	// The rows of the schema wide query, which belong to the relation.
+	// Each relation is served once, after that (or if the query failed)
+	// NULL is returned and the caller has to read the catalog itself.
+	pgSet *GetRelationSet(const wxString &query, const wxString &relColumn, OID relid);
+
+private:
+	void Clear();
+	pgCatalogSnapshotSet *LoadSet(const wxString &query, const wxString &relColumn);
+
+	pgDatabase *database;
+	OID schemaOid;
+	wxLongLong created;
+
+	pgCatalogRelationMap relations;
+	pgCatalogSnapshotSetMap sets;
+};
+
+#endif
@@ -232,8 +232,9 @@ public:
 	}
 	pgConn *connection();
 	int Connect();
-	void Disconnect();
+	void Disconnect(bool closePooled = false);
 	void CheckAlive();
+	void ParkIdleConnection();
 	void AppendSchemaChange(const wxString &sql);
 	wxString GetSchemaChanges()
 	{
@@ -14,6 +14,7 @@
 
 #include "pgDatabase.h"
 
+class pgCatalogSnapshot;
 
 enum
 {
@@ -61,6 +62,7 @@ class pgSchemaBase : public pgDatabaseObject
 {
 public:
 	pgSchemaBase(pgaFactory &factory, const wxString &newName = wxT(""));
+	~pgSchemaBase();
 
 	wxString GetPrefix() const
 	{
@@ -168,10 +170,19 @@ public:
 		return true;
 	}
 
+	// Start a new snapshot of the catalog rows of the tables in the schema
+	pgCatalogSnapshot *NewCatalogSnapshot();
+	void InvalidateCatalogSnapshot(OID relid);
+
+	// Read the catalog rows of a relation, with the query select + relation
+	// condition + rest. Listings may get them from the catalog snapshot.
+	pgSet *ExecuteRelationSet(const wxString &select, const wxString &rest, const wxString &relColumn, OID relid, bool fromSnapshot);
+
 protected:
 	wxString m_defPrivsOnTables, m_defPrivsOnSeqs, m_defPrivsOnFuncs, m_defPrivsOnTypes;
 
 private:
+	pgCatalogSnapshot *catalogSnapshot;
 	long schemaTyp;
 	bool createPrivilege;
 };
@@ -13,6 +13,7 @@
 #define PGSERVER_H
 
 #include "db/pgConn.h"
+#include "db/pgConnPool.h"
 #include "pgCollection.h"
 
 class frmMain;
@@ -216,6 +217,12 @@ public:
 
 	pgConn *CreateConn(wxString dbName = wxEmptyString, OID oid = 0, wxString applicationname = wxEmptyString);
 
+	// The connections the browser borrows, while connected
+	pgConnPool *GetConnPool()
+	{
+		return connPool;
+	}
+
 	wxString GetLastDatabase() const
 	{
 		return lastDatabase;
@@ -532,6 +539,7 @@ private:
 	wxString passwordFilename();
 
 	pgConn *conn;
+	pgConnPool *connPool;
 	long serverIndex;
 	bool connected, passwordValid, autovacuumRunning;
 	wxString service, hostaddr, database, username, password, rolename, ver, error;
@@ -50,4 +50,43 @@ protected:
 	const wxString m_string;        // the string we tokenize into lines
 	size_t   m_pos;                 // the current position in m_string
 };
+
+// Splits a CSV stream, which is read in pieces, into records of fields. The
+// state is kept from one piece to the next, so records (and quoted fields)
+// may span them; every character is looked at once only.
+class CSVRecordParser : public wxObject
+{
+public:
+	CSVRecordParser() { Reset(); }
+
+	// Forget the partial record, before starting on another stream
+	void Reset();
+
+	// The next piece of the stream
+	void SetInput(const wxString &str);
+
+	// Get the next complete record of the piece. Returns false if there is
+	// none; the rest of the piece is kept as a partial record then.
+	bool GetNextRecord(wxArrayString &fields);
+
+	bool HasPartialRecord() const
+	{
+		return m_state != CSV_FIELD_START || !m_fields.IsEmpty();
+	}
+
+protected:
+	enum
+	{
+		CSV_FIELD_START,
+		CSV_UNQUOTED,
+		CSV_QUOTED,
+		CSV_QUOTE               // a quote in a quoted field: doubled or closing
+	};
+
+	wxString m_input;
+	size_t   m_pos;                 // the current position in m_input
+	int      m_state;
+	wxString m_field;               // the field read so far
+	wxArrayString m_fields;         // the fields of the record read so far
+};
 #endif
@@ -0,0 +1,118 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// lockGraph.h - Wait-for graph of the backends of a server
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef LOCKGRAPH_H
+#define LOCKGRAPH_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/dynarray.h>
+#include <wx/hashmap.h>
+
+// A lockable object, and the backends holding it or waiting for it
+class lockGraphObject
+{
+public:
+	wxString name;
+	wxArrayLong holders;    // pid, mode
+	wxArrayLong waiters;    // pid, mode
+};
+WX_DECLARE_OBJARRAY(lockGraphObject, lockGraphObjects);
+
+// A backend waiting for another one, or being waited for
+class lockGraphNode
+{
+public:
+	lockGraphNode() : pid(0), component(-1), inCycle(false), layer(-1), next(-1), blocked(0) {}
+
+	long pid;
+	wxArrayInt waitsFor;    // The nodes it's waiting for
+	wxArrayInt blocks;      // The nodes waiting for it
+	wxString waitingOn;     // The mode and the object it's waiting for
+	int component;          // Its strongly connected component
+	bool inCycle;           // Part of a deadlock
+	int layer;              // Steps to its root blocker
+	int next;               // The node it waits for on the way there
+	long blocked;           // Root blockers: backends waiting for it
+};
+WX_DECLARE_OBJARRAY(lockGraphNode, lockGraphNodes);
+
+WX_DECLARE_STRING_HASH_MAP(int, lockGraphObjectMap);
+WX_DECLARE_HASH_MAP(long, int, wxIntegerHash, wxIntegerEqual, lockGraphPidMap);
+
+// The locks of a pg_locks snapshot are added one by one, then the graph is
+// built: a backend waits for the others holding a conflicting lock on the
+// object it asked for. Root blockers are the backends, which others wait
+// for, while they aren't waiting themselves; backends waiting for each
+// other in a cycle are deadlocked, and a cycle nobody in it can get out of
+// counts as a root blocker, too.
+class lockGraph
+{
+public:
+	lockGraph();
+
+	void Clear();
+	void AddLock(long pid, const wxString &object, const wxString &name, const wxString &mode, bool granted);
+	void Build();
+
+	size_t GetNodeCount() const
+	{
+		return nodes.GetCount();
+	}
+	const lockGraphNode &GetNode(size_t i) const
+	{
+		return nodes[i];
+	}
+	int FindNode(long pid) const;
+
+	// The nodes, root blockers first (the ones blocking most first), then
+	// the ones waiting for them, step by step
+	const wxArrayInt &GetOrder() const
+	{
+		return order;
+	}
+
+	// The pids from a node to its root blocker
+	wxArrayLong GetChain(int node) const;
+
+	long GetRootCount() const
+	{
+		return roots;
+	}
+	long GetCycleCount() const
+	{
+		return cycles;
+	}
+	long GetWaitingCount() const
+	{
+		return waiting;
+	}
+
+	static int GetLockMode(const wxString &mode);
+	static bool Conflicts(int mode1, int mode2);
+
+private:
+	int AddNode(long pid);
+	void AddEdges();
+	void FindComponents();
+	void FindRoots();
+
+	lockGraphObjects objects;
+	lockGraphObjectMap objectIndex;
+
+	lockGraphNodes nodes;
+	lockGraphPidMap nodeIndex;
+	wxArrayInt order;
+
+	long roots, cycles, waiting;
+};
+
+#endif
@@ -18,6 +18,8 @@ pgadmin3_SOURCES += \
 	include/utils/pgDefs.h \
 	include/utils/pgconfig.h \
 	include/utils/registry.h \
+	include/utils/lockGraph.h \
+	include/utils/statusHistory.h \
 	include/utils/sysLogger.h \
 	include/utils/sysProcess.h \
 	include/utils/sysSettings.h \
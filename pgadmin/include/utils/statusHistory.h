@@ -0,0 +1,154 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// statusHistory.h - Recorded activity of the Server Status window
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef STATUSHISTORY_H
+#define STATUSHISTORY_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/file.h>
+#include <wx/dynarray.h>
+#include <wx/hashmap.h>
+
+// Size (bytes) of the ring file the refreshes are recorded in
+#define HISTORY_FILE_SIZE (64 * 1024 * 1024)
+
+// Every so many frames, one holds all of the rows, not only the changes
+#define HISTORY_KEY_INTERVAL 30
+
+// Memory (bytes) the texts of the recorded queries may take
+#define HISTORY_QUERY_BUDGET (8 * 1024 * 1024)
+
+// How a backend is shown in the activity list
+enum
+{
+	STATUSROW_ACTIVE = 0,
+	STATUSROW_IDLE,
+	STATUSROW_BLOCKED,
+	STATUSROW_SLOW
+};
+
+// A backend, with the columns as shown in the activity list
+class statusHistoryRow
+{
+public:
+	statusHistoryRow() : pid(0), state(STATUSROW_ACTIVE) {}
+
+	long pid;
+	int state;
+	wxArrayString cols;
+};
+WX_DECLARE_OBJARRAY(statusHistoryRow, statusHistoryRows);
+
+class statusHistoryFrame
+{
+public:
+	wxLongLong time;        // ms
+	wxFileOffset offset;
+	size_t size;
+	bool key;               // Holds all the rows, not only the changes
+};
+WX_DECLARE_OBJARRAY(statusHistoryFrame, statusHistoryFrames);
+
+class statusHistoryQuery
+{
+public:
+	wxString text;
+	long lastFrame;         // The last frame, which wrote its hash
+};
+WX_DECLARE_HASH_MAP(wxUint32, statusHistoryQuery, wxIntegerHash, wxIntegerEqual, statusHistoryQueryMap);
+WX_DECLARE_HASH_MAP(long, size_t, wxIntegerHash, wxIntegerEqual, statusHistoryPidMap);
+
+// A query, for which backends have been waiting
+class statusHistoryWait
+{
+public:
+	wxString query;
+	double seconds;         // All the backends together
+	long maxWaiting;        // Backends waiting at once
+};
+WX_DECLARE_OBJARRAY(statusHistoryWait, statusHistoryWaits);
+
+// A backend, which has been blocking others without a break
+class statusHistoryBlocker
+{
+public:
+	long pid;
+	wxLongLong start;       // ms
+	double seconds;
+	long maxWaiting;
+	wxString query;
+};
+WX_DECLARE_OBJARRAY(statusHistoryBlocker, statusHistoryBlockers);
+
+// The refreshes of the activity list are recorded in a temporary file,
+// which is used as a ring: the oldest frames get overwritten once it's full.
+// A key frame holds all the rows, the frames following it only the columns,
+// which have changed since the frame before. Queries are written as a hash
+// of their text, which is kept in memory, and the "blocked by" column as
+// the edges of the lock graph. The frames are indexed in memory, too.
+class statusHistory
+{
+public:
+	statusHistory(int blockedCol, int queryCol);
+	~statusHistory();
+
+	bool Record(const statusHistoryRows &rows);
+
+	// Frames are numbered from the first one recorded on; the oldest ones
+	// get dropped as the file fills up.
+	long GetFirstFrame() const
+	{
+		return firstFrame;
+	}
+	long GetFrameCount() const
+	{
+		return frames.GetCount();
+	}
+	wxDateTime GetFrameTime(long number) const;
+	bool GetFrame(long number, statusHistoryRows &rows);
+
+	// The queries waited for most and the longest blockers, at most
+	// maxEntries of each
+	bool Aggregate(statusHistoryWaits &waits, statusHistoryBlockers &blockers, size_t maxEntries);
+
+private:
+	bool Open();
+	void DropFrame();
+	void DropFrames(wxFileOffset offset, size_t size);
+	void PruneQueries();
+
+	void EncodeFrame(const statusHistoryRows &rows, bool key, long number, wxMemoryBuffer &buf);
+	bool ReadFrame(long index, wxMemoryBuffer &buf);
+	bool DecodeFrame(const wxMemoryBuffer &buf, const statusHistoryRows &prev, statusHistoryRows &rows, wxArrayLong *edges = NULL);
+	wxUint32 AddQuery(const wxString &query, long number);
+
+	int blockedCol, queryCol;
+
+	wxString fileName;
+	wxFile file;
+	bool failed;
+	wxFileOffset writePos;
+
+	statusHistoryFrames frames;
+	long firstFrame;
+	long sinceKey;
+	statusHistoryRows lastRows;
+
+	statusHistoryQueryMap queries;
+	size_t queryBytes;
+
+	// The frame replayed last, to go on from when scrubbing forward
+	long replayFrame;
+	statusHistoryRows replayRows;
+};
+
+#endif
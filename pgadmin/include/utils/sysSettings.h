@@ -248,6 +248,16 @@ public:
 	{
 		WriteBool(wxT("Export/WriteBOM"), newval);
 	}
+	bool GetExportUseCopy() const
+	{
+		bool b;
+		Read(wxT("Export/UseCopy"), &b, false);
+		return b;
+	}
+	void SetExportUseCopy(const bool newval)
+	{
+		WriteBool(wxT("Export/UseCopy"), newval);
+	}
 
 	// Explain options
 	bool GetExplainVerbose() const
@@ -353,6 +363,7 @@ public:
 	void SetIndicateNull(const bool newval)
 	{
 		WriteBool(wxT("frmQuery/IndicateNull"), newval);
+		resultFormatGeneration++;
 	}
 	wxString GetThousandsSeparator() const
 	{
@@ -363,6 +374,7 @@ public:
 	void SetThousandsSeparator(const wxString &newval)
 	{
 		Write(wxT("frmQuery/ThousandsSeparator"), newval);
+		resultFormatGeneration++;
 	}
 	bool GetAutoRollback() const
 	{
@@ -393,6 +405,7 @@ public:
 	void SetDecimalMark(const wxString &newval)
 	{
 		Write(wxT("DecimalMark"), newval);
+		resultFormatGeneration++;
 	}
 	bool GetColumnNames() const
 	{
@@ -691,6 +704,27 @@ public:
 	void SetMaxColSize(const long newval)
 	{
 		WriteLong(wxT("frmQuery/MaxColSize"), newval);
+		resultFormatGeneration++;
+	}
+	bool GetStreamResults() const
+	{
+		bool b;
+		Read(wxT("frmQuery/StreamResults"), &b, false);
+		return b;
+	}
+	void SetStreamResults(const bool newval)
+	{
+		WriteBool(wxT("frmQuery/StreamResults"), newval);
+	}
+	long GetStreamMemoryCap() const
+	{
+		long l;
+		Read(wxT("frmQuery/StreamMemoryCap"), &l, 256L);
+		return l;
+	}
+	void SetStreamMemoryCap(const long newval)
+	{
+		WriteLong(wxT("frmQuery/StreamMemoryCap"), newval);
 	}
 	bool GetAskSaveConfirmation() const
 	{
@@ -814,6 +848,12 @@ public:
 	};
 	static wxString GetConfigFile(configFileName cfgname);
 
+	// Changes, whenever an option affecting the display of query results is set
+	unsigned long GetResultFormatGeneration() const
+	{
+		return resultFormatGeneration;
+	}
+
 private:
 	static const wxString &getDefaultElementColor(int index)
 	{
@@ -830,6 +870,7 @@ private:
 	bool moveLongValue(const wxChar *oldKey, const wxChar *newKey, int index = -1);
 
 	wxFileConfig *defaultSettings;
+	unsigned long resultFormatGeneration;
 };
 
 #endif
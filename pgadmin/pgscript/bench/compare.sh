@@ -0,0 +1,51 @@
+#!/bin/sh
+
+#######################################################################
+#
+# pgAdmin III - PostgreSQL Tools
+# Copyright (C) 2002 - 2014, The pgAdmin Development Team
+# This software is released under the PostgreSQL Licence
+#
+# compare.sh - Runs the pgScript benchmarks compiled to bytecode and by
+#              walking their tree (-T), and prints the total of each run
+#
+#######################################################################
+
+# The pgscript program, built with --enable-pgscript-cli
+PGSCRIPT=${PGSCRIPT:-pgscript}
+
+# Runs of each script in each mode
+RUNS=${RUNS:-3}
+
+# Connection options are given on the command line, as to pgscript:
+#   compare.sh -h localhost -d test
+# The scripts can be chosen with SCRIPTS.
+
+THISDIR=`dirname $0`
+SCRIPTS=${SCRIPTS:-`ls $THISDIR/*.pgs`}
+
+for SCRIPT in $SCRIPTS
+do
+	for MODE in compiled tree
+	do
+		if [ "$MODE" = "tree" ]; then
+			FLAGS="-T"
+		else
+			FLAGS=""
+		fi
+
+		RUN=1
+		while [ $RUN -le $RUNS ]
+		do
+			# The last line of the report gives the time of the whole run
+			REPORT=`$PGSCRIPT -q -b $FLAGS "$@" "$SCRIPT"`
+			if [ $? -ne 0 ]; then
+				echo "`basename $SCRIPT`: could not be run" >&2
+				exit 1
+			fi
+			TOTAL=`echo "$REPORT" | tail -n 1`
+			printf "%-16s %-8s %s\n" "`basename $SCRIPT`" "$MODE" "$TOTAL"
+			RUN=`expr $RUN + 1`
+		done
+	done
+done
@@ -9,7 +9,7 @@
 #
 #######################################################################
 
-pgadmin3_SOURCES += \
+TMP_pgscript += \
 	pgscript/exceptions/pgsArithmeticException.cpp \
 	pgscript/exceptions/pgsAssertException.cpp \
 	pgscript/exceptions/pgsBreakException.cpp \
@@ -9,7 +9,7 @@
 #
 #######################################################################
 
-pgadmin3_SOURCES += \
+TMP_pgscript += \
 	pgscript/expressions/pgsAnd.cpp \
 	pgscript/expressions/pgsAssign.cpp \
 	pgscript/expressions/pgsAssignToRecord.cpp \
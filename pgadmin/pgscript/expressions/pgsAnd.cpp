@@ -12,6 +12,7 @@
 #include "pgscript/expressions/pgsAnd.h"
 
 #include "pgscript/objects/pgsNumber.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsAnd::pgsAnd(const pgsExpression *left, const pgsExpression *right) :
 	pgsOperation(left, right)
@@ -55,3 +56,26 @@ pgsOperand pgsAnd::eval(pgsVarMap &vars) const
 	return pnew pgsNumber(wxString() << (m_left->eval(vars)->pgs_is_true()
 	                                     && m_right->eval(vars)->pgs_is_true()), pgsInt);
 }
+
+void pgsAnd::compile(pgsCompiler &c) const
+{
+	c.compile_truth(*this);
+}
+
+void pgsAnd::compile_jump(pgsCompiler &c, wxArrayInt &jumps,
+                          bool when_true) const
+{
+	// The right operand is not evaluated when the left one is false
+	if (when_true)
+	{
+		wxArrayInt no;
+		m_left->compile_jump(c, no, false);
+		m_right->compile_jump(c, jumps, true);
+		c.patch(no);
+	}
+	else
+	{
+		m_left->compile_jump(c, jumps, false);
+		m_right->compile_jump(c, jumps, false);
+	}
+}
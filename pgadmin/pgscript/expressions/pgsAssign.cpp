@@ -12,9 +12,10 @@
 #include "pgscript/expressions/pgsAssign.h"
 
 #include "pgscript/objects/pgsVariable.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsAssign::pgsAssign(const wxString &name, const pgsExpression *var) :
-	pgsExpression(), m_name(name), m_var(var)
+	pgsExpression(), m_name(name), m_var(var), m_slot(0), m_slot_vars(0)
 {
 
 }
@@ -30,7 +31,7 @@ pgsExpression *pgsAssign::clone() const
 }
 
 pgsAssign::pgsAssign(const pgsAssign &that) :
-	pgsExpression(that), m_name(that.m_name)
+	pgsExpression(that), m_name(that.m_name), m_slot(0), m_slot_vars(0)
 {
 	m_var = that.m_var->clone();
 }
@@ -41,6 +42,8 @@ pgsAssign &pgsAssign::operator =(const pgsAssign &that)
 	{
 		pgsExpression::operator=(that);
 		m_name = that.m_name;
+		m_slot = 0;
+		m_slot_vars = 0;
 		pdelete(m_var);
 		m_var = that.m_var->clone();
 	}
@@ -52,8 +55,38 @@ wxString pgsAssign::value() const
 	return wxString() << wxT("SET ") << m_name << wxT(" = ") << m_var->value();
 }
 
+pgsOperand &pgsAssign::slot(pgsVarMap &vars) const
+{
+	if (m_slot == 0 || m_slot_vars != &vars)
+	{
+		m_slot = &vars[m_name];
+		m_slot_vars = &vars;
+	}
+	return *m_slot;
+}
+
 pgsOperand pgsAssign::eval(pgsVarMap &vars) const
 {
-	vars[m_name] = m_var->eval(vars);
-	return vars[m_name];
+	exec(vars);
+	return slot(vars);
+}
+
+void pgsAssign::exec(pgsVarMap &vars) const
+{
+	// Evaluated before the variable is created, it may be used there.
+	// The result is stored as it is rather than copied.
+	pgsOperand value(m_var->eval(vars));
+	slot(vars).swap(value);
+}
+
+void pgsAssign::compile(pgsCompiler &c) const
+{
+	compile_exec(c);
+	c.emit(PGS_OP_LOAD, c.slot(m_name));
+}
+
+void pgsAssign::compile_exec(pgsCompiler &c) const
+{
+	m_var->compile(c);
+	c.emit(PGS_OP_STORE, c.slot(m_name));
 }
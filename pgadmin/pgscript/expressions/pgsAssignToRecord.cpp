@@ -14,6 +14,7 @@
 #include "pgscript/exceptions/pgsParameterException.h"
 #include "pgscript/expressions/pgsIdentRecord.h"
 #include "pgscript/objects/pgsRecord.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsAssignToRecord::pgsAssignToRecord(const wxString &name, const pgsExpression *line,
                                      const pgsExpression *column, const pgsExpression *var) :
@@ -62,77 +63,88 @@ wxString pgsAssignToRecord::value() const
 
 pgsOperand pgsAssignToRecord::eval(pgsVarMap &vars) const
 {
-	if (vars.find(m_name) != vars.end() && vars[m_name]->is_record())
+	exec(vars);
+	return pgsIdentRecord(m_name, m_line->clone(), m_column->clone()).eval(vars);
+}
+
+void pgsAssignToRecord::exec(pgsVarMap &vars) const
+{
+	if (vars.find(m_name) == vars.end() || !vars[m_name]->is_record())
 	{
-		// Get the operand as a record
-		pgsRecord &rec = dynamic_cast<pgsRecord &>(*vars[m_name]);
+		throw pgsParameterException(wxString() << m_name << wxT(" is not a record"));
+	}
 
-		// Get the value to assign
-		pgsOperand var(m_var->eval(vars));
+	// Get the value to assign and evaluate parameters
+	pgsOperand var(m_var->eval(vars));
+	pgsOperand line(m_line->eval(vars));
+	pgsOperand column(m_column->eval(vars));
+
+	assign(dynamic_cast<pgsRecord &>(*vars[m_name]), *var, *line, *column);
+}
 
-		if (!var->is_record())
+void pgsAssignToRecord::compile(pgsCompiler &c) const
+{
+	compile_exec(c);
+	pgsIdentRecord::compile_get(c, m_name, m_line, m_column);
+}
+
+void pgsAssignToRecord::compile_exec(pgsCompiler &c) const
+{
+	int slot = c.slot(m_name);
+	c.emit(PGS_OP_RECORD_CHECK, slot);
+	m_var->compile(c);
+	m_line->compile(c);
+	m_column->compile(c);
+	c.emit(PGS_OP_RECORD_SET, slot, c.expr(this));
+}
+
+void pgsAssignToRecord::assign(pgsRecord &rec, const pgsVariable &var,
+                               const pgsVariable &line, const pgsVariable &column) const
+{
+	if (var.is_record())
+	{
+		throw pgsParameterException(wxString() << wxT("Cannot assign a record")
+		                            << wxT(" into a record: right member is a record"));
+	}
+
+	if (!line.is_integer())
+	{
+		throw pgsParameterException(wxString() << line.value()
+		                            << wxT(" is not a valid line number"));
+	}
+
+	long aux_line;
+	line.value().ToLong(&aux_line);
+	bool success = false;
+
+	if (column.is_integer())
+	{
+		long aux_column;
+		column.value().ToLong(&aux_column);
+		if (aux_column < rec.count_columns())
 		{
-			// Evaluate parameters
-			pgsOperand line(m_line->eval(vars));
-			pgsOperand column(m_column->eval(vars));
-			if (line->is_integer())
-			{
-				long aux_line;
-				line->value().ToLong(&aux_line);
-
-				if (column->is_integer() || column->is_string())
-				{
-					bool success = false;
-
-					if (column->is_integer())
-					{
-						long aux_column;
-						column->value().ToLong(&aux_column);
-						if (aux_column < rec.count_columns())
-						{
-							success = rec.insert(aux_line, aux_column, var);
-						}
-					}
-					else if (column->is_string())
-					{
-						USHORT aux_column = rec.get_column(column->value());
-						if (aux_column < rec.count_columns())
-						{
-							success = rec.insert(aux_line, aux_column, var);
-						}
-					}
-
-					if (success == false)
-					{
-						throw pgsParameterException(wxString() << wxT("An error ")
-						                            << wxT("occurred in record affectation: ") << value()
-						                            << wxT("\n") << wxT("One possible reason is a ")
-						                            << wxT("column index out of range"));
-					}
-				}
-
-				else
-				{
-					throw pgsParameterException(wxString() << column->value()
-					                            << wxT(" is not a valid column number/name"));
-				}
-			}
-			else
-			{
-				throw pgsParameterException(wxString() << line->value()
-				                            << wxT(" is not a valid line number"));
-			}
+			success = rec.insert(aux_line, aux_column, var.clone());
 		}
-		else
+	}
+	else if (column.is_string())
+	{
+		USHORT aux_column = rec.get_column(column.value());
+		if (aux_column < rec.count_columns())
 		{
-			throw pgsParameterException(wxString() << wxT("Cannot assign a record")
-			                            << wxT(" into a record: right member is a record"));
+			success = rec.insert(aux_line, aux_column, var.clone());
 		}
 	}
 	else
 	{
-		throw pgsParameterException(wxString() << m_name << wxT(" is not a record"));
+		throw pgsParameterException(wxString() << column.value()
+		                            << wxT(" is not a valid column number/name"));
 	}
 
-	return pgsIdentRecord(m_name, m_line->clone(), m_column->clone()).eval(vars);
+	if (success == false)
+	{
+		throw pgsParameterException(wxString() << wxT("An error ")
+		                            << wxT("occurred in record affectation: ") << value()
+		                            << wxT("\n") << wxT("One possible reason is a ")
+		                            << wxT("column index out of range"));
+	}
 }
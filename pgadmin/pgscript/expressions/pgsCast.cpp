@@ -13,6 +13,7 @@
 
 #include "pgscript/exceptions/pgsParameterException.h"
 #include "pgscript/objects/pgsNumber.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 #include "pgscript/parser.tab.hh"
 typedef pgscript::pgsParser::token token;
@@ -80,21 +81,32 @@ wxString pgsCast::value() const
 pgsOperand pgsCast::eval(pgsVarMap &vars) const
 {
 	pgsOperand var = m_var->eval(vars);
+	return cast(m_cast_type, *var);
+}
+
+void pgsCast::compile(pgsCompiler &c) const
+{
+	m_var->compile(c);
+	c.emit(PGS_OP_CAST, m_cast_type);
+}
+
+pgsOperand pgsCast::cast(const int &cast_type, const pgsVariable &var)
+{
 	MAPM num;
 
-	switch (m_cast_type)
+	switch (cast_type)
 	{
 		case token::PGS_INTEGER:
-			num = pgsMapm::pgs_str_mapm(var->number().value());
+			num = pgsMapm::pgs_str_mapm(var.number().value());
 			num = pgsMapm::pgs_mapm_round(num);
 			return pnew pgsNumber(pgsMapm::pgs_mapm_str(num, true), pgsInt);
 		case token::PGS_REAL:
-			return pnew pgsNumber(var->number().value(), pgsReal);
+			return pnew pgsNumber(var.number().value(), pgsReal);
 		case token::PGS_RECORD:
-			return var->record().clone();
+			return var.record().clone();
 		case token::PGS_STRING:
-			return var->string().clone();
+			return var.string().clone();
 		default:
-			return var->clone();
+			return var.clone();
 	}
 }
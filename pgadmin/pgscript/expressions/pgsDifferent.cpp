@@ -12,6 +12,7 @@
 #include "pgscript/expressions/pgsDifferent.h"
 
 #include "pgscript/objects/pgsVariable.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsDifferent::pgsDifferent(const pgsExpression *left, const pgsExpression *right) :
 	pgsOperation(left, right)
@@ -58,3 +59,10 @@ pgsOperand pgsDifferent::eval(pgsVarMap &vars) const
 	// Return the result
 	return (*left != *right);
 }
+
+void pgsDifferent::compile(pgsCompiler &c) const
+{
+	m_left->compile(c);
+	m_right->compile(c);
+	c.emit(PGS_OP_DIFFERENT);
+}
@@ -12,6 +12,7 @@
 #include "pgscript/expressions/pgsEqual.h"
 
 #include "pgscript/objects/pgsVariable.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsEqual::pgsEqual(const pgsExpression *left, const pgsExpression *right,
                    bool case_sensitive) :
@@ -63,3 +64,10 @@ pgsOperand pgsEqual::eval(pgsVarMap &vars) const
 	// Return the result
 	return (m_case_sensitive ? (*left == *right) : (*left &= *right));
 }
+
+void pgsEqual::compile(pgsCompiler &c) const
+{
+	m_left->compile(c);
+	m_right->compile(c);
+	c.emit(m_case_sensitive ? PGS_OP_EQUAL : PGS_OP_ALMOST_EQUAL);
+}
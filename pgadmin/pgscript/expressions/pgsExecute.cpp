@@ -11,20 +11,43 @@
 #include "pgAdmin3.h"
 #include "pgscript/expressions/pgsExecute.h"
 
-#include <wx/regex.h>
 #include "db/pgConn.h"
-#include "db/pgQueryThread.h"
 #include "pgscript/objects/pgsNumber.h"
 #include "pgscript/objects/pgsRecord.h"
 #include "pgscript/objects/pgsString.h"
+#include "pgscript/utilities/pgsBench.h"
 #include "pgscript/utilities/pgsUtilities.h"
 #include "pgscript/utilities/pgsThread.h"
 
+// Collects the notices raised by the query, for the output
+static void pgsNoticeProcessor(void *arg, const char *message)
+{
+	wxString str(message, wxConvUTF8);
+
+	wxLogNotice(wxT("%s"), str.Trim().c_str());
+	*(wxString *)arg << str << wxT("\n");
+}
+
+// Characters of the name of a variable, after the @
+static bool is_var_char(wxChar c)
+{
+	return (c >= wxT('a') && c <= wxT('z')) || (c >= wxT('A') && c <= wxT('Z'))
+	       || (c >= wxT('0') && c <= wxT('9')) || c == wxT('_') || c == wxT('#')
+	       || c == wxT('@');
+}
+
+static bool is_ident_char(wxChar c)
+{
+	return wxIsalnum(c) || c == wxT('_') || c == wxT('$');
+}
+
 pgsExecute::pgsExecute(const wxString &query, pgsOutputStream *cout,
                        pgsThread *app) :
-	pgsExpression(), m_query(query), m_cout(cout), m_app(app)
+	pgsExpression(), m_query(query), m_cout(cout), m_app(app),
+	m_preparable(false)
 {
-
+	parse();
+	m_bulk.parse(m_query);
 }
 
 pgsExecute::~pgsExecute()
@@ -45,6 +68,11 @@ pgsExecute &pgsExecute::operator=(const pgsExecute &that)
 		m_query = that.m_query;
 		m_app = that.m_app;
 		m_query = that.m_query;
+		m_parts = that.m_parts;
+		m_vars = that.m_vars;
+		m_bound = that.m_bound;
+		m_preparable = that.m_preparable;
+		m_bulk = that.m_bulk;
 	}
 	return (*this);
 }
@@ -54,177 +82,370 @@ wxString pgsExecute::value() const
 	return m_query;
 }
 
+void pgsExecute::parse()
+{
+	// The variables are replaced wherever they are (@var, not preceded by a
+	// backslash), but only the ones making a whole string literal can be
+	// passed as parameters: the literals, quoted identifiers, dollar quotes
+	// and comments have to be told apart for that
+	enum { sql, literal, quoted_ident, dollar, line_comment, block_comment } state = sql;
+	wxString part, tag;
+	size_t len = m_query.Length(), opened = 0, i;
+	bool plain = false, escapes = false, textual = false, single = true;
+	int depth = 0;
+
+	for (i = 0; i < len; i++)
+	{
+		wxChar c = m_query[i];
+		wxChar prev = i > 0 ? m_query[i - 1] : wxT('\0');
+		wxChar next = i + 1 < len ? m_query[i + 1] : wxT('\0');
+
+		// Backslash followed by @ or backslash
+		if (c == wxT('\\') && (next == wxT('@') || next == wxT('\\')))
+		{
+			part += next;
+			i++;
+			continue;
+		}
+
+		if (c == wxT('@') && i > 0 && prev != wxT('\\') && is_var_char(next))
+		{
+			size_t end = i + 1;
+			while (end < len && is_var_char(m_query[end]))
+				end++;
+
+			bool bound = state == literal && plain && opened + 1 == i
+			             && end < len && m_query[end] == wxT('\'')
+			             && (end + 1 == len || m_query[end + 1] != wxT('\''));
+
+			m_vars.Add(m_query.Mid(i, end - i));
+			m_bound.Add(bound ? 1 : 0);
+
+			if (bound)
+			{
+				// The quotes go with the value
+				part.RemoveLast();
+				state = sql;
+				i = end;
+			}
+			else
+			{
+				textual = true;
+				i = end - 1;
+			}
+
+			m_parts.Add(part);
+			part.Clear();
+			continue;
+		}
+
+		switch (state)
+		{
+			case sql:
+				if (c == wxT('\''))
+				{
+					// Not E'', B'', X'', N'' or U&''
+					state = literal;
+					opened = i;
+					escapes = (prev == wxT('E') || prev == wxT('e'));
+					plain = !is_ident_char(prev) && prev != wxT('&');
+				}
+				else if (c == wxT('"'))
+					state = quoted_ident;
+				else if (c == wxT('-') && next == wxT('-'))
+					state = line_comment;
+				else if (c == wxT('/') && next == wxT('*'))
+				{
+					state = block_comment;
+					depth = 1;
+					part << c << next;
+					i++;
+					continue;
+				}
+				else if (c == wxT('$') && !is_ident_char(prev) && !wxIsdigit(next))
+				{
+					size_t end = i + 1;
+					while (end < len && is_ident_char(m_query[end]) && m_query[end] != wxT('$'))
+						end++;
+					if (end < len && m_query[end] == wxT('$'))
+					{
+						tag = m_query.Mid(i, end - i + 1);
+						state = dollar;
+						part << tag;
+						i = end;
+						continue;
+					}
+				}
+				else if (c == wxT(';') && !m_query.Mid(i + 1).Strip(wxString::both).IsEmpty())
+					single = false;
+				break;
+
+			case literal:
+				if (escapes && c == wxT('\\') && i + 1 < len)
+				{
+					part << c << next;
+					i++;
+					continue;
+				}
+				if (c == wxT('\''))
+				{
+					if (next == wxT('\''))
+					{
+						part << c << next;
+						i++;
+						continue;
+					}
+					state = sql;
+				}
+				break;
+
+			case quoted_ident:
+				if (c == wxT('"'))
+					state = sql;
+				break;
+
+			case dollar:
+				if (c == wxT('$') && m_query.Mid(i, tag.Length()) == tag)
+				{
+					part << tag;
+					i += tag.Length() - 1;
+					state = sql;
+					continue;
+				}
+				break;
+
+			case line_comment:
+				if (c == wxT('\n'))
+					state = sql;
+				break;
+
+			case block_comment:
+				if ((c == wxT('/') && next == wxT('*')) || (c == wxT('*') && next == wxT('/')))
+				{
+					depth += (c == wxT('/')) ? 1 : -1;
+					if (depth == 0)
+						state = sql;
+					part << c << next;
+					i++;
+					continue;
+				}
+				break;
+		}
+
+		part += c;
+	}
+	m_parts.Add(part);
+
+	// Only the statements, which can be prepared
+	wxString start = m_query.Strip(wxString::leading), keyword;
+	while (start.StartsWith(wxT("(")))
+		start = start.Mid(1).Strip(wxString::leading);
+	for (i = 0; i < start.Length() && wxIsalpha(start[i]); i++)
+		keyword += start[i];
+	keyword.MakeUpper();
+
+	m_preparable = single && !textual && state == sql
+	               && (keyword == wxT("SELECT") || keyword == wxT("INSERT")
+	                   || keyword == wxT("UPDATE") || keyword == wxT("DELETE")
+	                   || keyword == wxT("VALUES") || keyword == wxT("WITH"));
+}
+
+void pgsExecute::output(const wxString &prefix, const wxString &message) const
+{
+	if (m_cout == 0)
+		return;
+
+	m_app->LockOutput();
+
+	(*m_cout) << prefix;
+	wxString text(message);
+	while (text.Replace(wxT("\n\n"), wxT("\n")) > 0)
+		;
+	text.Replace(wxT("\n"), wxT("\n") + generate_spaces(prefix.Length()));
+	(*m_cout) << text << wxT("\n");
+
+	m_app->UnlockOutput();
+}
+
+pgsOperand pgsExecute::eval_bulk(pgsVarMap &vars) const
+{
+	wxLongLong_t start = pgsBench::now();
+	wxString error;
+	wxLongLong_t rows = m_bulk.run(vars, m_app, error);
+	wxLongLong_t usec = pgsBench::now() - start;
+
+	m_app->measure(m_query, usec, rows > 0 ? rows : 0);
+
+	if (rows < 0)
+	{
+		output(PGSOUTWARNING, m_query + wxT("\n") + error.Strip(wxString::both));
+		return pnew pgsRecord(1);
+	}
+
+	long elapsed = (long)(usec / 1000);
+	wxString message = wxString::Format(_("%s rows copied in %ld ms"),
+	                                    wxLongLong(rows).ToString().c_str(), elapsed);
+	if (elapsed > 0)
+		message << wxString::Format(_(" (%s rows/s)"),
+		                            wxLongLong(rows * 1000 / elapsed).ToString().c_str());
+	output(PGSOUTQUERY, m_query + wxT("\n") + message);
+
+	pgsRecord *rec = pnew pgsRecord(1);
+	rec->insert(0, 0, pnew pgsNumber(rows));
+	return rec;
+}
+
 pgsOperand pgsExecute::eval(pgsVarMap &vars) const
 {
-	// Copy statement locally
-	wxString stmt(m_query);
+	if (m_bulk.is_valid() && m_app != 0 && m_app->connection() != 0
+	        && !m_app->TestDestroy() && !m_app->cancelled())
+	{
+		return eval_bulk(vars);
+	}
 
-	// Build regular expressions
-	wxRegEx identifier(wxT("([^\\])(@[a-zA-Z0-9_#@]+)"));
-	wxRegEx escaped(wxT("\\\\(@|\\\\)")); // Backslash followed by @ or backslash
-	wxASSERT(identifier.IsValid() && escaped.IsValid());
+	// Replace variables in statement, and in the query to prepare, whose
+	// string literals made of a variable are parameters instead
+	wxString stmt(m_parts[0]), query(m_parts[0]);
+	wxArrayString params;
 
-	// Replace variables in statement
-	while (identifier.Matches(stmt))
+	for (size_t i = 0; i < m_vars.GetCount(); i++)
 	{
-		wxString var = identifier.GetMatch(stmt, 2);
-		wxString chr = identifier.GetMatch(stmt, 1);
+		const wxString &var = m_vars[i];
+		wxString value;
+
+		// Unknown variables are left as they are
 		if (vars.find(var) != vars.end())
+			value = vars[var]->eval(vars)->value();
+		else
+			value = var;
+
+		if (m_bound[i])
 		{
-			wxString res = vars[var]->eval(vars)->value();
-			identifier.ReplaceFirst(&stmt, chr + pgsUtilities::escape_quotes(res));
+			params.Add(value);
+			query << wxT("$") << (int)params.GetCount();
+			value.Replace(wxT("'"), wxT("''"));
+			stmt << wxT("'") << value << wxT("'");
 		}
 		else
 		{
-			identifier.ReplaceFirst(&stmt, chr + wxT("\\\\") + var);
+			value.Replace(wxT("'"), wxT("''"));
+			stmt << value;
+			query << value;
 		}
+
+		stmt << m_parts[i + 1];
+		query << m_parts[i + 1];
 	}
-	escaped.ReplaceAll(&stmt, wxT("\\1"));
 
 	// Perform operations only if we have a valid connection
-	if (m_app != 0 && m_app->connection() != 0 && !m_app->TestDestroy())
+	if (m_app == 0 || m_app->connection() == 0 || m_app->TestDestroy()
+	        || m_app->cancelled())
 	{
-		pgQueryThread thread(m_app->connection(), stmt);
+		// This must return a record whatever happens
+		return pnew pgsRecord(1);
+	}
+
+	// The query is executed right here, on the connection of the script
+	pgConn *conn = m_app->connection();
+	wxString messages;
+
+	wxLongLong_t start = pgsBench::now();
+
+	conn->RegisterNoticeProcessor(pgsNoticeProcessor, &messages);
+	pgSet *set = m_app->execute(stmt, query, params, m_preparable);
+	conn->RegisterNoticeProcessor(0, 0);
 
-		if (thread.Create() == wxTHREAD_NO_ERROR)
+	int status = conn->GetLastResultStatus();
+
+	// The rows returned, or the ones inserted, updated or deleted
+	long rows = (status == PGRES_TUPLES_OK) ? set->NumRows() : set->GetInsertedCount();
+	m_app->measure(query, pgsBench::now() - start, rows > 0 ? rows : 0);
+	pgsRecord *rec = 0;
+
+	if (conn->GetStatus() != PGCONN_OK
+	        || (status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK))
+	{
+		output(PGSOUTWARNING, stmt + wxT("\n") + (messages + conn->GetLastError())
+		       .Strip(wxString::both));
+
+		rec = pnew pgsRecord(1);
+	}
+	else if (m_app->TestDestroy() || m_app->cancelled())
+	{
+		rec = pnew pgsRecord(1);
+	}
+	else
+	{
+		if (m_cout != 0)
 		{
-			if (thread.Run() == wxTHREAD_NO_ERROR)
+			int nTuples = (int)set->NumRows();
+			OID insertedOid = set->GetInsertedOid();
+			if (insertedOid)
+				messages << wxString::Format(_("query inserted one row with oid %d.\n"), (int)insertedOid);
+			else
+				messages << wxString::Format(wxPLURAL("query result with %d row will be returned.\n", "query result with %d rows will be returned.\n",
+				                                      nTuples), nTuples);
+
+			output(PGSOUTQUERY, stmt + wxT("\n") + messages.Strip(wxString::both));
+		}
+
+		if (status == PGRES_TUPLES_OK)
+		{
+			set->MoveFirst();
+			rec = pnew pgsRecord(set->NumCols());
+			wxArrayLong columns_int; // List of columns that contain integers
+			wxArrayLong columns_real; // List of columns that contain reals
+			for (long i = 0; i < set->NumCols(); i++)
 			{
-				while (true)
+				rec->set_column_name(i, set->ColName(i));
+				wxString col_type = set->ColType(i);
+				if (!col_type.CmpNoCase(wxT("bigint"))
+				        || !col_type.CmpNoCase(wxT("smallint"))
+				        || !col_type.CmpNoCase(wxT("integer")))
 				{
-					if (m_app->TestDestroy()) // wxThread::TestDestroy()
-					{
-						thread.Delete();
-						break;
-					}
-					else if (thread.IsRunning())
-					{
-						m_app->Yield();
-						m_app->Sleep(20);
-					}
-					else
-					{
-						thread.Wait();
-						break;
-					}
+					columns_int.Add(i);
 				}
-
-				if (thread.ReturnCode() != PGRES_COMMAND_OK
-				        && thread.ReturnCode() != PGRES_TUPLES_OK)
+				else if (!col_type.CmpNoCase(wxT("real"))
+				         || !col_type.CmpNoCase(wxT("double precision"))
+				         || !col_type.CmpNoCase(wxT("money"))
+				         || !col_type.CmpNoCase(wxT("numeric")))
 				{
-					if (m_cout != 0)
-					{
-						m_app->LockOutput();
-
-						(*m_cout) << PGSOUTWARNING;
-						wxString message(stmt + wxT("\n") + thread
-						                 .GetMessagesAndClear().Strip(wxString::both));
-						wxRegEx multilf(wxT("(\n)+"));
-						multilf.ReplaceAll(&message, wxT("\n"));
-						message.Replace(wxT("\n"), wxT("\n")
-						                + generate_spaces(PGSOUTWARNING.Length()));
-						(*m_cout) << message << wxT("\n");
-
-						m_app->UnlockOutput();
-					}
+					columns_real.Add(i);
 				}
-				else if (!m_app->TestDestroy())
+			}
+			size_t line = 0;
+			while (!set->Eof())
+			{
+				for (long i = 0; i < set->NumCols(); i++)
 				{
-					if (m_cout != 0)
+					wxString value = set->GetVal(i);
+
+					if (columns_int.Index(i) != wxNOT_FOUND
+					        && pgsNumber::num_type(value) == pgsNumber::pgsTInt)
 					{
-						m_app->LockOutput();
-
-						(*m_cout) << PGSOUTQUERY;
-						wxString message(thread.GetMessagesAndClear()
-						                 .Strip(wxString::both));
-						if (!message.IsEmpty())
-							message = stmt + wxT("\n") + message;
-						else
-							message = stmt;
-						wxRegEx multilf(wxT("(\n)+"));
-						multilf.ReplaceAll(&message, wxT("\n"));
-						message.Replace(wxT("\n"), wxT("\n")
-						                + generate_spaces(PGSOUTQUERY.Length()));
-						(*m_cout) << message << wxT("\n");
-
-						m_app->UnlockOutput();
+						rec->insert(line, i, pnew pgsNumber(value, pgsInt));
 					}
-
-					pgsRecord *rec = 0;
-
-					if (thread.DataValid())
+					else if (columns_real.Index(i) != wxNOT_FOUND
+					         && pgsNumber::num_type(value) == pgsNumber::pgsTReal)
 					{
-						pgSet *set = thread.DataSet();
-						set->MoveFirst();
-						rec = pnew pgsRecord(set->NumCols());
-						wxArrayLong columns_int; // List of columns that contain integers
-						wxArrayLong columns_real; // List of columns that contain reals
-						for (long i = 0; i < set->NumCols(); i++)
-						{
-							rec->set_column_name(i, set->ColName(i));
-							wxString col_type = set->ColType(i);
-							if (!col_type.CmpNoCase(wxT("bigint"))
-							        || !col_type.CmpNoCase(wxT("smallint"))
-							        || !col_type.CmpNoCase(wxT("integer")))
-							{
-								columns_int.Add(i);
-							}
-							else if (!col_type.CmpNoCase(wxT("real"))
-							         || !col_type.CmpNoCase(wxT("double precision"))
-							         || !col_type.CmpNoCase(wxT("money"))
-							         || !col_type.CmpNoCase(wxT("numeric")))
-							{
-								columns_real.Add(i);
-							}
-						}
-						size_t line = 0;
-						while (!set->Eof())
-						{
-							for (long i = 0; i < set->NumCols(); i++)
-							{
-								wxString value = set->GetVal(i);
-
-								if (columns_int.Index(i) != wxNOT_FOUND
-								        && pgsNumber::num_type(value) == pgsNumber::pgsTInt)
-								{
-									rec->insert(line, i, pnew pgsNumber(value, pgsInt));
-								}
-								else if (columns_real.Index(i) != wxNOT_FOUND
-								         && pgsNumber::num_type(value) == pgsNumber::pgsTReal)
-								{
-									rec->insert(line, i, pnew pgsNumber(value, pgsReal));
-								}
-								else
-								{
-									rec->insert(line, i, pnew pgsString(value));
-								}
-							}
-							set->MoveNext();
-							++line;
-						}
+						rec->insert(line, i, pnew pgsNumber(value, pgsReal));
 					}
 					else
 					{
-						rec = pnew pgsRecord(1);
-						rec->insert(0, 0, pnew pgsNumber(wxT("1")));
+						rec->insert(line, i, pnew pgsString(value));
 					}
-
-					return rec;
 				}
-			}
-			else
-			{
-				wxLogError(wxT("PGSCRIPT: Cannot run query thread for the query:\n%s"),
-				           m_query.c_str());
+				set->MoveNext();
+				++line;
 			}
 		}
 		else
 		{
-			wxLogError(wxT("PGSCRIPT: Cannot create query thread for the query:\n%s"),
-			           m_query.c_str());
+			rec = pnew pgsRecord(1);
+			rec->insert(0, 0, pnew pgsNumber(wxT("1")));
 		}
 	}
 
-	// This must return a record whatever happens
-	return pnew pgsRecord(1);
+	delete set;
+	return rec;
 }
@@ -11,6 +11,7 @@
 #include "pgAdmin3.h"
 #include "pgscript/expressions/pgsExpression.h"
 #include "pgscript/objects/pgsVariable.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsExpression::pgsExpression()
 {
@@ -21,3 +22,26 @@ pgsExpression::~pgsExpression()
 {
 
 }
+
+void pgsExpression::exec(pgsVarMap &vars) const
+{
+	eval(vars);
+}
+
+void pgsExpression::compile(pgsCompiler &c) const
+{
+	c.emit(PGS_OP_EVAL, c.expr(this));
+}
+
+void pgsExpression::compile_exec(pgsCompiler &c) const
+{
+	compile(c);
+	c.emit(PGS_OP_POP);
+}
+
+void pgsExpression::compile_jump(pgsCompiler &c, wxArrayInt &jumps,
+                                 bool when_true) const
+{
+	compile(c);
+	jumps.Add(c.emit(when_true ? PGS_OP_JUMP_TRUE : PGS_OP_JUMP_FALSE));
+}
@@ -12,6 +12,7 @@
 #include "pgscript/expressions/pgsGreater.h"
 
 #include "pgscript/objects/pgsVariable.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsGreater::pgsGreater(const pgsExpression *left, const pgsExpression *right) :
 	pgsOperation(left, right)
@@ -58,3 +59,10 @@ pgsOperand pgsGreater::eval(pgsVarMap &vars) const
 	// Return the result
 	return (*left > *right);
 }
+
+void pgsGreater::compile(pgsCompiler &c) const
+{
+	m_left->compile(c);
+	m_right->compile(c);
+	c.emit(PGS_OP_GREATER);
+}
@@ -14,11 +14,12 @@
 #include <wx/datetime.h>
 #include "pgscript/objects/pgsNumber.h"
 #include "pgscript/objects/pgsString.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 const wxString pgsIdent::m_now = wxT("@NOW");
 
 pgsIdent::pgsIdent(const wxString &name) :
-	pgsExpression(), m_name(name)
+	pgsExpression(), m_name(name), m_slot(0), m_slot_vars(0)
 {
 
 }
@@ -40,9 +41,19 @@ wxString pgsIdent::value() const
 
 pgsOperand pgsIdent::eval(pgsVarMap &vars) const
 {
-	if (vars.find(m_name) != vars.end())
+	// The entries of the symbol table stay where they are, until the
+	// table is cleared, which is not done while a script is running
+	if (m_slot != 0 && m_slot_vars == &vars)
 	{
-		return vars[m_name];
+		return *m_slot;
+	}
+
+	pgsVarMap::iterator it = vars.find(m_name);
+	if (it != vars.end())
+	{
+		m_slot = &it->second;
+		m_slot_vars = &vars;
+		return *m_slot;
 	}
 	else if (m_name == m_now)
 	{
@@ -54,3 +65,8 @@ pgsOperand pgsIdent::eval(pgsVarMap &vars) const
 		return pnew pgsString(wxT(""));
 	}
 }
+
+void pgsIdent::compile(pgsCompiler &c) const
+{
+	c.emit(PGS_OP_LOAD, c.slot(m_name));
+}
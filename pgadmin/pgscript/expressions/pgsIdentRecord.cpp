@@ -13,6 +13,7 @@
 
 #include "pgscript/objects/pgsRecord.h"
 #include "pgscript/objects/pgsString.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsIdentRecord::pgsIdentRecord(const wxString &name, const pgsExpression *line,
                                const pgsExpression *column) :
@@ -71,33 +72,76 @@ pgsOperand pgsIdentRecord::eval(pgsVarMap &vars) const
 		// Get the operand as a record
 		const pgsRecord &rec = dynamic_cast<const pgsRecord &>(*vars[m_name]);
 
-		// Evaluate parameters
+		// Evaluate parameters, the column only for a valid line
 		pgsOperand line(m_line->eval(vars));
-		if (line->is_integer())
+		if (m_column != 0 && line->is_integer())
 		{
-			long aux_line;
-			line->value().ToLong(&aux_line);
+			pgsOperand column(m_column->eval(vars));
+			return get(rec, *line, column.get());
+		}
+		return get(rec, *line, 0);
+	}
+
+	return pnew pgsString(wxT(""));
+}
+
+void pgsIdentRecord::compile(pgsCompiler &c) const
+{
+	compile_get(c, m_name, m_line, m_column);
+}
+
+pgsOperand pgsIdentRecord::get(const pgsRecord &rec, const pgsVariable &line,
+                               const pgsVariable *column)
+{
+	if (line.is_integer())
+	{
+		long aux_line;
+		line.value().ToLong(&aux_line);
 
-			if (m_column != 0)
+		if (column != 0)
+		{
+			if (column->is_integer())
 			{
-				pgsOperand column(m_column->eval(vars));
-				if (column->is_integer())
-				{
-					long aux_column;
-					column->value().ToLong(&aux_column);
-					return rec.get(aux_line, aux_column);
-				}
-				else if (column->is_string())
-				{
-					return rec.get(aux_line, rec.get_column(column->value()));
-				}
+				long aux_column;
+				column->value().ToLong(&aux_column);
+				return rec.get(aux_line, aux_column);
 			}
-			else
+			else if (column->is_string())
 			{
-				return rec.get_line(aux_line);
+				return rec.get(aux_line, rec.get_column(column->value()));
 			}
 		}
+		else
+		{
+			return rec.get_line(aux_line);
+		}
 	}
 
 	return pnew pgsString(wxT(""));
 }
+
+void pgsIdentRecord::compile_get(pgsCompiler &c, const wxString &name,
+                                 const pgsExpression *line, const pgsExpression *column)
+{
+	int slot = c.slot(name);
+	int depth = c.depth();
+
+	// An empty string if the variable is not a record
+	int skip = c.emit(PGS_OP_JUMP_NOT_RECORD, 0, slot);
+	line->compile(c);
+	if (column != 0)
+	{
+		column->compile(c);
+		c.emit(PGS_OP_RECORD_GET, slot);
+	}
+	else
+	{
+		c.emit(PGS_OP_RECORD_LINE, slot);
+	}
+	int end = c.emit(PGS_OP_JUMP);
+
+	c.patch(skip);
+	c.depth(depth);
+	c.emit(PGS_OP_CONST, c.empty_constant());
+	c.patch(end);
+}
@@ -13,6 +13,7 @@
 
 #include "pgscript/objects/pgsNumber.h"
 #include "pgscript/objects/pgsRecord.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsLines::pgsLines(const wxString &name) :
 	pgsExpression(), m_name(name)
@@ -37,11 +38,22 @@ wxString pgsLines::value() const
 
 pgsOperand pgsLines::eval(pgsVarMap &vars) const
 {
-	if (vars.find(m_name) != vars.end())
+	pgsVarMap::iterator it = vars.find(m_name);
+	return count(it != vars.end() ? it->second.get() : 0);
+}
+
+void pgsLines::compile(pgsCompiler &c) const
+{
+	c.emit(PGS_OP_LINES, c.slot(m_name));
+}
+
+pgsOperand pgsLines::count(const pgsVariable *var)
+{
+	if (var != 0)
 	{
-		if (vars[m_name]->is_record())
+		if (var->is_record())
 		{
-			const pgsRecord &rec = dynamic_cast<const pgsRecord &>(*vars[m_name]);
+			const pgsRecord &rec = dynamic_cast<const pgsRecord &>(*var);
 			return pnew pgsNumber(wxString() << rec.count_lines(), pgsInt);
 		}
 		else
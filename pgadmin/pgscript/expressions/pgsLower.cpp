@@ -12,6 +12,7 @@
 #include "pgscript/expressions/pgsLower.h"
 
 #include "pgscript/objects/pgsVariable.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsLower::pgsLower(const pgsExpression *left, const pgsExpression *right) :
 	pgsOperation(left, right)
@@ -58,3 +59,10 @@ pgsOperand pgsLower::eval(pgsVarMap &vars) const
 	// Return the result
 	return (*left < *right);
 }
+
+void pgsLower::compile(pgsCompiler &c) const
+{
+	m_left->compile(c);
+	m_right->compile(c);
+	c.emit(PGS_OP_LOWER);
+}
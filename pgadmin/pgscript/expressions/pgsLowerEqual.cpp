@@ -13,6 +13,7 @@
 #include "pgscript/objects/pgsRecord.h"
 
 #include "pgscript/objects/pgsVariable.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsLowerEqual::pgsLowerEqual(const pgsExpression *left, const pgsExpression *right) :
 	pgsOperation(left, right)
@@ -59,3 +60,10 @@ pgsOperand pgsLowerEqual::eval(pgsVarMap &vars) const
 	// Return the result
 	return (*left <= *right);
 }
+
+void pgsLowerEqual::compile(pgsCompiler &c) const
+{
+	m_left->compile(c);
+	m_right->compile(c);
+	c.emit(PGS_OP_LOWER_EQUAL);
+}
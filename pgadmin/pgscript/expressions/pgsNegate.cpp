@@ -12,6 +12,7 @@
 #include "pgscript/expressions/pgsNegate.h"
 
 #include "pgscript/objects/pgsNumber.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsNegate::pgsNegate(const pgsExpression *left) :
 	pgsOperation(left, 0)
@@ -58,3 +59,10 @@ pgsOperand pgsNegate::eval(pgsVarMap &vars) const
 	// Return the result
 	return (*left - *right);
 }
+
+void pgsNegate::compile(pgsCompiler &c) const
+{
+	c.emit(PGS_OP_CONST, c.zero_constant());
+	m_left->compile(c);
+	c.emit(PGS_OP_MINUS);
+}
@@ -12,6 +12,7 @@
 #include "pgscript/expressions/pgsNot.h"
 
 #include "pgscript/objects/pgsVariable.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsNot::pgsNot(const pgsExpression *left) :
 	pgsOperation(left, 0)
@@ -57,3 +58,15 @@ pgsOperand pgsNot::eval(pgsVarMap &vars) const
 	// Return the result
 	return (!(*left));
 }
+
+void pgsNot::compile(pgsCompiler &c) const
+{
+	m_left->compile(c);
+	c.emit(PGS_OP_NOT);
+}
+
+void pgsNot::compile_jump(pgsCompiler &c, wxArrayInt &jumps,
+                          bool when_true) const
+{
+	m_left->compile_jump(c, jumps, !when_true);
+}
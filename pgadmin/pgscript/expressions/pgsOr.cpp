@@ -12,6 +12,7 @@
 #include "pgscript/expressions/pgsOr.h"
 
 #include "pgscript/objects/pgsNumber.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsOr::pgsOr(const pgsExpression *left, const pgsExpression *right) :
 	pgsOperation(left, right)
@@ -54,3 +55,26 @@ pgsOperand pgsOr::eval(pgsVarMap &vars) const
 	return pnew pgsNumber(wxString() << (m_left->eval(vars)->pgs_is_true()
 	                                     || m_right->eval(vars)->pgs_is_true()), pgsInt);
 }
+
+void pgsOr::compile(pgsCompiler &c) const
+{
+	c.compile_truth(*this);
+}
+
+void pgsOr::compile_jump(pgsCompiler &c, wxArrayInt &jumps,
+                         bool when_true) const
+{
+	// The right operand is not evaluated when the left one is true
+	if (when_true)
+	{
+		m_left->compile_jump(c, jumps, true);
+		m_right->compile_jump(c, jumps, true);
+	}
+	else
+	{
+		wxArrayInt yes;
+		m_left->compile_jump(c, yes, true);
+		m_right->compile_jump(c, jumps, false);
+		c.patch(yes);
+	}
+}
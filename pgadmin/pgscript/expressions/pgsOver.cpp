@@ -12,6 +12,7 @@
 #include "pgscript/expressions/pgsOver.h"
 
 #include "pgscript/objects/pgsVariable.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsOver::pgsOver(const pgsExpression *left, const pgsExpression *right) :
 	pgsOperation(left, right)
@@ -58,3 +59,10 @@ pgsOperand pgsOver::eval(pgsVarMap &vars) const
 	// Return the result
 	return (*left / *right);
 }
+
+void pgsOver::compile(pgsCompiler &c) const
+{
+	m_left->compile(c);
+	m_right->compile(c);
+	c.emit(PGS_OP_OVER);
+}
@@ -12,6 +12,7 @@
 #include "pgscript/expressions/pgsParenthesis.h"
 
 #include "pgscript/objects/pgsVariable.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsParenthesis::pgsParenthesis(const pgsExpression *left) :
 	pgsOperation(left, 0)
@@ -57,3 +58,14 @@ pgsOperand pgsParenthesis::eval(pgsVarMap &vars) const
 	// Return the result
 	return left;
 }
+
+void pgsParenthesis::compile(pgsCompiler &c) const
+{
+	m_left->compile(c);
+}
+
+void pgsParenthesis::compile_jump(pgsCompiler &c, wxArrayInt &jumps,
+                                  bool when_true) const
+{
+	m_left->compile_jump(c, jumps, when_true);
+}
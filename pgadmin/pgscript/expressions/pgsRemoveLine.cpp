@@ -14,6 +14,7 @@
 #include "pgscript/exceptions/pgsParameterException.h"
 #include "pgscript/objects/pgsRecord.h"
 #include "pgscript/objects/pgsString.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsRemoveLine::pgsRemoveLine(const wxString &rec, const pgsExpression *line) :
 	pgsExpression(), m_rec(rec), m_line(line)
@@ -59,26 +60,9 @@ pgsOperand pgsRemoveLine::eval(pgsVarMap &vars) const
 {
 	if (vars.find(m_rec) != vars.end() && vars[m_rec]->is_record())
 	{
-		pgsRecord &rec = dynamic_cast<pgsRecord &>(*vars[m_rec]);
-
 		// Evaluate parameter
 		pgsOperand line(m_line->eval(vars));
-		if (line->is_integer())
-		{
-			long aux_line;
-			line->value().ToLong(&aux_line);
-
-			if (!rec.remove_line(aux_line))
-			{
-				throw pgsParameterException(wxString() << wxT("an error ")
-				                            << wxT("occurred while executing ") << value());
-			}
-		}
-		else
-		{
-			throw pgsParameterException(wxString() << line->value()
-			                            << wxT(" is not a valid line number"));
-		}
+		remove(dynamic_cast<pgsRecord &>(*vars[m_rec]), *line);
 
 		return vars[m_rec];
 	}
@@ -87,3 +71,37 @@ pgsOperand pgsRemoveLine::eval(pgsVarMap &vars) const
 		throw pgsParameterException(wxString() << m_rec << wxT(" is not a record"));
 	}
 }
+
+void pgsRemoveLine::compile(pgsCompiler &c) const
+{
+	compile_exec(c);
+	c.emit(PGS_OP_LOAD, c.slot(m_rec));
+}
+
+void pgsRemoveLine::compile_exec(pgsCompiler &c) const
+{
+	int slot = c.slot(m_rec);
+	c.emit(PGS_OP_RECORD_CHECK, slot);
+	m_line->compile(c);
+	c.emit(PGS_OP_RECORD_REMOVE, slot, c.expr(this));
+}
+
+void pgsRemoveLine::remove(pgsRecord &rec, const pgsVariable &line) const
+{
+	if (line.is_integer())
+	{
+		long aux_line;
+		line.value().ToLong(&aux_line);
+
+		if (!rec.remove_line(aux_line))
+		{
+			throw pgsParameterException(wxString() << wxT("an error ")
+			                            << wxT("occurred while executing ") << value());
+		}
+	}
+	else
+	{
+		throw pgsParameterException(wxString() << line.value()
+		                            << wxT(" is not a valid line number"));
+	}
+}
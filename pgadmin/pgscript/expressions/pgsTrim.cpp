@@ -12,6 +12,7 @@
 #include "pgscript/expressions/pgsTrim.h"
 
 #include "pgscript/objects/pgsString.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsTrim::pgsTrim(const pgsExpression *exp) :
 	pgsExpression(), m_exp(exp)
@@ -55,3 +56,9 @@ pgsOperand pgsTrim::eval(pgsVarMap &vars) const
 {
 	return pnew pgsString(m_exp->eval(vars)->value().Strip(wxString::both));
 }
+
+void pgsTrim::compile(pgsCompiler &c) const
+{
+	m_exp->compile(c);
+	c.emit(PGS_OP_TRIM);
+}
@@ -9,7 +9,7 @@
 #
 #######################################################################
 
-pgadmin3_SOURCES += \
+TMP_pgscript += \
 	pgscript/generators/pgsDateGen.cpp \
 	pgscript/generators/pgsDateTimeGen.cpp \
 	pgscript/generators/pgsDictionaryGen.cpp \
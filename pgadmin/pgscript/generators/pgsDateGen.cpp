@@ -45,3 +45,14 @@ pgsDateGen *pgsDateGen::clone()
 {
 	return pnew pgsDateGen(*this);
 }
+
+pgsDateGen *pgsDateGen::reseed(const long &offset)
+{
+	if (is_sequence())
+		return 0;
+
+	pgsDateGen *gen = pnew pgsDateGen(*this);
+	gen->m_seed = offset_seed(offset);
+	gen->m_randomizer = pgsRandomizer(m_randomizer->reseed(offset));
+	return gen;
+}
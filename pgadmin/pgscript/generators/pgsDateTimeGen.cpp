@@ -60,3 +60,14 @@ pgsDateTimeGen *pgsDateTimeGen::clone()
 {
 	return pnew pgsDateTimeGen(*this);
 }
+
+pgsDateTimeGen *pgsDateTimeGen::reseed(const long &offset)
+{
+	if (is_sequence())
+		return 0;
+
+	pgsDateTimeGen *gen = pnew pgsDateTimeGen(*this);
+	gen->m_seed = offset_seed(offset);
+	gen->m_randomizer = pgsRandomizer(m_randomizer->reseed(offset));
+	return gen;
+}
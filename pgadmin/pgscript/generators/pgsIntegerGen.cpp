@@ -172,3 +172,11 @@ pgsIntegerGen *pgsIntegerGen::clone()
 {
 	return pnew pgsIntegerGen(*this);
 }
+
+pgsIntegerGen *pgsIntegerGen::reseed(const long &offset)
+{
+	if (is_sequence())
+		return 0;
+
+	return pnew pgsIntegerGen(m_min, m_max, false, offset_seed(offset));
+}
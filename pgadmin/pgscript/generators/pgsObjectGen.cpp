@@ -21,3 +21,19 @@ pgsObjectGen::~pgsObjectGen()
 {
 
 }
+
+long pgsObjectGen::offset_seed(const long &offset) const
+{
+	long seed = m_seed + offset;
+	return seed == 0 ? 1 : seed;
+}
+
+pgsObjectGen *pgsObjectGen::reseed(const long &offset)
+{
+	return 0;
+}
+
+bool pgsObjectGen::uses_connection() const
+{
+	return false;
+}
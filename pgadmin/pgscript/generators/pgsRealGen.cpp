@@ -46,3 +46,14 @@ pgsRealGen *pgsRealGen::clone()
 {
 	return pnew pgsRealGen(*this);
 }
+
+pgsRealGen *pgsRealGen::reseed(const long &offset)
+{
+	if (is_sequence())
+		return 0;
+
+	pgsRealGen *gen = pnew pgsRealGen(*this);
+	gen->m_seed = offset_seed(offset);
+	gen->m_randomizer = pgsRandomizer(pnew pgsIntegerGen::pgsNormalIntGen(m_int_max, gen->m_seed));
+	return gen;
+}
@@ -65,6 +65,11 @@ wxString pgsReferenceGen::random()
 	return dynamic_cast<const pgsRecord &>(*result).get(0, 0)->value();
 }
 
+bool pgsReferenceGen::uses_connection() const
+{
+	return true;
+}
+
 pgsReferenceGen::~pgsReferenceGen()
 {
 
@@ -307,3 +307,15 @@ pgsRegexGen *pgsRegexGen::clone()
 {
 	return pnew pgsRegexGen(*this);
 }
+
+pgsRegexGen *pgsRegexGen::reseed(const long &offset)
+{
+	pgsRegexGen *gen = pnew pgsRegexGen(*this);
+	gen->m_seed = offset_seed(offset);
+	gen->m_string_gens.Clear();
+	for (size_t i = 0; i < m_string_gens.GetCount(); i++)
+	{
+		gen->m_string_gens.Add(m_string_gens.Item(i).reseed(offset));
+	}
+	return gen;
+}
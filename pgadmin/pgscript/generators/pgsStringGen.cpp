@@ -81,3 +81,12 @@ pgsStringGen *pgsStringGen::clone()
 {
 	return pnew pgsStringGen(*this);
 }
+
+pgsStringGen *pgsStringGen::reseed(const long &offset)
+{
+	pgsStringGen *gen = pnew pgsStringGen(*this);
+	gen->m_seed = offset_seed(offset);
+	gen->m_w_size_randomizer = pgsRandomizer(m_w_size_randomizer->reseed(offset));
+	gen->m_letter_randomizer = pgsRandomizer(m_letter_randomizer->reseed(offset));
+	return gen;
+}
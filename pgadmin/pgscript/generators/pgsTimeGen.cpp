@@ -50,3 +50,14 @@ pgsTimeGen *pgsTimeGen::clone()
 {
 	return pnew pgsTimeGen(*this);
 }
+
+pgsTimeGen *pgsTimeGen::reseed(const long &offset)
+{
+	if (is_sequence())
+		return 0;
+
+	pgsTimeGen *gen = pnew pgsTimeGen(*this);
+	gen->m_seed = offset_seed(offset);
+	gen->m_randomizer = pgsRandomizer(m_randomizer->reseed(offset));
+	return gen;
+}
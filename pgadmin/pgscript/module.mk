@@ -9,7 +9,7 @@
 #
 #######################################################################
 
-pgadmin3_SOURCES += \
+TMP_pgscript += \
 	pgscript/pgsApplication.cpp \
 	pgscript/lex.pgs.cc \
 	pgscript/parser.tab.cc
@@ -19,7 +19,13 @@ EXTRA_DIST += \
 	pgscript/parser.sh \
 	pgscript/pgsParser.yy \
 	pgscript/pgsScanner.ll \
-	pgscript/README
+	pgscript/README \
+	pgscript/bench/arithmetic.pgs \
+	pgscript/bench/compare.sh \
+	pgscript/bench/generators.pgs \
+	pgscript/bench/loops.pgs \
+	pgscript/bench/README \
+	pgscript/bench/records.pgs
 
 include pgscript/exceptions/module.mk
 include pgscript/expressions/module.mk
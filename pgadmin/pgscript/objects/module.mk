@@ -9,7 +9,7 @@
 #
 #######################################################################
 
-pgadmin3_SOURCES += \
+TMP_pgscript += \
 	pgscript/objects/pgsGenerator.cpp \
 	pgscript/objects/pgsNumber.cpp \
 	pgscript/objects/pgsRecord.cpp \
@@ -38,6 +38,16 @@ wxString pgsGenerator::value() const
 	return m_randomizer->random();
 }
 
+bool pgsGenerator::uses_connection() const
+{
+	return m_randomizer->uses_connection();
+}
+
+pgsObjectGen *pgsGenerator::reseed(const long &offset) const
+{
+	return m_randomizer->reseed(offset);
+}
+
 pgsOperand pgsGenerator::operand() const
 {
 	switch (type())
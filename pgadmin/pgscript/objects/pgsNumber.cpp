@@ -11,26 +11,121 @@
 #include "pgAdmin3.h"
 #include "pgscript/objects/pgsNumber.h"
 
-#include <wx/regex.h>
 #include "pgscript/objects/pgsRecord.h"
 #include "pgscript/objects/pgsString.h"
 #include "pgscript/exceptions/pgsArithmeticException.h"
 #include "pgscript/exceptions/pgsCastException.h"
 
-#define PGS_INTEGER_FORM_1 wxT("^[+-]?[0-9]+$")
-#define PGS_REAL_FORM_1 wxT("^[+-]?[0-9]+[Ee][+-]?[0-9]+$")
-#define PGS_REAL_FORM_2 wxT("^[+-]?[0-9]*[.][0-9]+([Ee][+-]?[0-9]+)?$")
-#define PGS_REAL_FORM_3 wxT("^[+-]?[0-9]+[.][0-9]*([Ee][+-]?[0-9]+)?$")
+// Forms of the numbers:
+// integer: ^[+-]?[0-9]+$
+// real:    ^[+-]?[0-9]+[Ee][+-]?[0-9]+$
+//          ^[+-]?[0-9]*[.][0-9]+([Ee][+-]?[0-9]+)?$
+//          ^[+-]?[0-9]+[.][0-9]*([Ee][+-]?[0-9]+)?$
+
+static const wxLongLong_t PGS_INT_MAX = wxLL(9223372036854775807);
+static const wxLongLong_t PGS_INT_MIN = -PGS_INT_MAX - 1;
+
+static bool is_digit(wxChar c)
+{
+	return c >= wxT('0') && c <= wxT('9');
+}
+
+// Reads an integer, unless it doesn't fit in 64 bits
+static bool parse_int(const wxString &data, wxLongLong_t &value)
+{
+	size_t len = data.Length(), i = 0;
+	bool negative = false;
+
+	if (i < len && (data[i] == wxT('+') || data[i] == wxT('-')))
+	{
+		negative = (data[i] == wxT('-'));
+		i++;
+	}
+	if (i == len)
+		return false;
+
+	// Accumulated as a negative number, so that the smallest one fits too
+	wxLongLong_t result = 0;
+	for (; i < len; i++)
+	{
+		wxChar c = data[i];
+		if (!is_digit(c))
+			return false;
+
+		int digit = c - wxT('0');
+		if (result < (PGS_INT_MIN + digit) / 10)
+			return false;
+		result = result * 10 - digit;
+	}
+
+	if (!negative)
+	{
+		if (result == PGS_INT_MIN)
+			return false;
+		result = -result;
+	}
+
+	value = result;
+	return true;
+}
+
+bool pgsNumber::native_arith(const pgsArithOp &op, const wxLongLong_t &a,
+                             const wxLongLong_t &b, wxLongLong_t &result)
+{
+	switch (op)
+	{
+		case pgsOPlus:
+			if ((b > 0 && a > PGS_INT_MAX - b) || (b < 0 && a < PGS_INT_MIN - b))
+				return false;
+			result = a + b;
+			return true;
+		case pgsOMinus:
+			if ((b < 0 && a > PGS_INT_MAX + b) || (b > 0 && a < PGS_INT_MIN + b))
+				return false;
+			result = a - b;
+			return true;
+		case pgsOTimes:
+			if (a > 0 ? (b > 0 ? a > PGS_INT_MAX / b : b < PGS_INT_MIN / a)
+			        : (b > 0 ? a < PGS_INT_MIN / b : (a != 0 && b < PGS_INT_MAX / a)))
+				return false;
+			result = a * b;
+			return true;
+		case pgsOOver:
+			// Truncated, as MAPM::div()
+			if (b == 0 || (a == PGS_INT_MIN && b == -1))
+				return false;
+			result = a / b;
+			return true;
+		default:
+			// Of the sign of a, as MAPM's
+			if (b == 0 || (a == PGS_INT_MIN && b == -1))
+				return false;
+			result = a % b;
+			return true;
+	}
+}
 
 pgsNumber::pgsNumber(const wxString &data, const bool &is_real) :
 	pgsVariable(!is_real ? pgsVariable::pgsTInt : pgsVariable::pgsTReal),
-	m_data(data.Strip(wxString::both))
+	m_data(data.Strip(wxString::both)), m_native(false), m_int(0)
 {
+	if (!is_real)
+		m_native = parse_int(m_data, m_int);
+
 	wxASSERT(is_valid());
 }
 
+pgsNumber::pgsNumber(const wxLongLong_t &data) :
+	pgsVariable(pgsVariable::pgsTInt), m_native(true), m_int(data)
+{
+
+}
+
 bool pgsNumber::is_valid() const
 {
+	if (m_native)
+		return true;
+
 	pgsTypes type = num_type(m_data);
 	return (type == pgsTInt) || (type == pgsTReal && is_real());
 }
@@ -41,7 +136,8 @@ pgsNumber::~pgsNumber()
 }
 
 pgsNumber::pgsNumber(const pgsNumber &that) :
-	pgsVariable(that), m_data(that.m_data)
+	pgsVariable(that), m_data(that.m_data), m_native(that.m_native),
+	m_int(that.m_int)
 {
 	wxASSERT(is_valid());
 }
@@ -52,6 +148,8 @@ pgsNumber &pgsNumber::operator =(const pgsNumber &that)
 	{
 		pgsVariable::operator=(that);
 		m_data = that.m_data;
+		m_native = that.m_native;
+		m_int = that.m_int;
 	}
 
 	wxASSERT(is_valid());
@@ -66,6 +164,8 @@ pgsVariable *pgsNumber::clone() const
 
 wxString pgsNumber::value() const
 {
+	if (m_data.IsEmpty() && m_native)
+		return wxString::Format(wxT("%") wxLongLongFmtSpec wxT("d"), m_int);
 	return m_data;
 }
 
@@ -76,191 +176,186 @@ pgsOperand pgsNumber::eval(pgsVarMap &vars) const
 
 pgsVariable::pgsTypes pgsNumber::num_type(const wxString &num)
 {
-	if (wxRegEx(PGS_INTEGER_FORM_1).Matches(num))
+	// Scanned rather than matched with the regular expressions, as this
+	// is done for every number created
+	size_t len = num.Length(), i = 0;
+	size_t int_digits = 0, frac_digits = 0, exp_digits = 0;
+	bool dot = false, exp = false;
+
+	if (i < len && (num[i] == wxT('+') || num[i] == wxT('-')))
+		i++;
+	for (; i < len && is_digit(num[i]); i++)
+		int_digits++;
+
+	if (i < len && num[i] == wxT('.'))
 	{
-		return pgsTInt;
+		dot = true;
+		for (i++; i < len && is_digit(num[i]); i++)
+			frac_digits++;
 	}
-	else if (( wxRegEx(PGS_REAL_FORM_1).Matches(num)
-	           || wxRegEx(PGS_REAL_FORM_2).Matches(num)
-	           || wxRegEx(PGS_REAL_FORM_3).Matches(num)))
+
+	if (i < len && (num[i] == wxT('E') || num[i] == wxT('e')))
 	{
-		return pgsTReal;
+		exp = true;
+		i++;
+		if (i < len && (num[i] == wxT('+') || num[i] == wxT('-')))
+			i++;
+		for (; i < len && is_digit(num[i]); i++)
+			exp_digits++;
 	}
-	else
+
+	if (i != len || (exp && exp_digits == 0))
 	{
 		return pgsTString;
 	}
-}
-
-pgsOperand pgsNumber::pgs_plus(const pgsVariable &rhs) const
-{
-	if (rhs.is_number())
+	else if (!dot)
 	{
-		return pnew pgsNumber(pgsMapm::pgs_mapm_str(num(m_data)
-		                      + num(rhs.value())), is_real() || rhs.is_real());
+		if (int_digits == 0)
+			return pgsTString;
+		return exp ? pgsTReal : pgsTInt;
 	}
 	else
 	{
-		throw pgsArithmeticException(m_data, rhs.value());
+		return (int_digits + frac_digits == 0) ? pgsTString : pgsTReal;
 	}
 }
 
-pgsOperand pgsNumber::pgs_minus(const pgsVariable &rhs) const
+MAPM pgsNumber::mapm() const
+{
+	return num(value());
+}
+
+pgsOperand pgsNumber::arith(const pgsVariable &rhs, const pgsArithOp &op) const
 {
-	if (rhs.is_number())
+	if (!rhs.is_number())
 	{
-		return pnew pgsNumber(pgsMapm::pgs_mapm_str(num(m_data)
-		                      - num(rhs.value())), is_real() || rhs.is_real());
+		throw pgsArithmeticException(value(), rhs.value());
 	}
-	else
+
+	// Generators give another value every time they are read
+	const pgsNumber *that = dynamic_cast<const pgsNumber *>(&rhs);
+	if (that == 0)
 	{
-		throw pgsArithmeticException(m_data, rhs.value());
+		return arith(pgsNumber(rhs.value(), rhs.is_real()), op);
 	}
-}
 
-pgsOperand pgsNumber::pgs_times(const pgsVariable &rhs) const
-{
-	if (rhs.is_number())
+	if (m_native && that->m_native)
 	{
-		return pnew pgsNumber(pgsMapm::pgs_mapm_str(num(m_data)
-		                      * num(rhs.value())), is_real() || rhs.is_real());
+		wxLongLong_t result;
+		if (native_arith(op, m_int, that->m_int, result))
+			return pnew pgsNumber(result);
 	}
-	else
+
+	bool real = is_real() || that->is_real();
+	MAPM left = mapm(), right = that->mapm();
+
+	switch (op)
 	{
-		throw pgsArithmeticException(m_data, rhs.value());
+		case pgsOPlus:
+			return pnew pgsNumber(pgsMapm::pgs_mapm_str(left + right), real);
+		case pgsOMinus:
+			return pnew pgsNumber(pgsMapm::pgs_mapm_str(left - right), real);
+		case pgsOTimes:
+			return pnew pgsNumber(pgsMapm::pgs_mapm_str(left * right), real);
+		case pgsOOver:
+			if (right == 0)
+				throw pgsArithmeticException(value(), that->value());
+			if (real)
+				return pnew pgsNumber(pgsMapm::pgs_mapm_str(left / right), real);
+			else
+				return pnew pgsNumber(pgsMapm::pgs_mapm_str(left.div(right)), real);
+		default:
+			if (right == 0)
+				throw pgsArithmeticException(value(), that->value());
+			return pnew pgsNumber(pgsMapm::pgs_mapm_str(left % right), real);
 	}
 }
 
-pgsOperand pgsNumber::pgs_over(const pgsVariable &rhs) const
+int pgsNumber::compare(const pgsVariable &rhs) const
 {
-	if (rhs.is_number())
+	if (!rhs.is_number())
 	{
-		if (num(rhs.value()) != 0)
-		{
-			if (is_real() || rhs.is_real())
-				return pnew pgsNumber(pgsMapm::pgs_mapm_str(num(m_data)
-				                      / num(rhs.value())), is_real() || rhs.is_real());
-			else
-				return pnew pgsNumber(pgsMapm::pgs_mapm_str(num(m_data)
-				                      .div(num(rhs.value()))), is_real() || rhs.is_real());
-		}
-		else
-		{
-			throw pgsArithmeticException(m_data, rhs.value());
-		}
+		throw pgsArithmeticException(value(), rhs.value());
 	}
-	else
+
+	const pgsNumber *that = dynamic_cast<const pgsNumber *>(&rhs);
+	if (that == 0)
 	{
-		throw pgsArithmeticException(m_data, rhs.value());
+		return compare(pgsNumber(rhs.value(), rhs.is_real()));
 	}
+
+	if (m_native && that->m_native)
+		return m_int < that->m_int ? -1 : (m_int > that->m_int ? 1 : 0);
+
+	MAPM left = mapm(), right = that->mapm();
+	return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+pgsOperand pgsNumber::pgs_plus(const pgsVariable &rhs) const
+{
+	return arith(rhs, pgsOPlus);
+}
+
+pgsOperand pgsNumber::pgs_minus(const pgsVariable &rhs) const
+{
+	return arith(rhs, pgsOMinus);
+}
+
+pgsOperand pgsNumber::pgs_times(const pgsVariable &rhs) const
+{
+	return arith(rhs, pgsOTimes);
+}
+
+pgsOperand pgsNumber::pgs_over(const pgsVariable &rhs) const
+{
+	return arith(rhs, pgsOOver);
 }
 
 pgsOperand pgsNumber::pgs_modulo(const pgsVariable &rhs) const
 {
-	if (rhs.is_number())
-	{
-		if (num(rhs.value()) != 0)
-		{
-			return pnew pgsNumber(pgsMapm::pgs_mapm_str(num(m_data)
-			                      % num(rhs.value())), is_real() || rhs.is_real());
-		}
-		else
-		{
-			throw pgsArithmeticException(m_data, rhs.value());
-		}
-	}
-	else
-	{
-		throw pgsArithmeticException(m_data, rhs.value());
-	}
+	return arith(rhs, pgsOModulo);
 }
 
 pgsOperand pgsNumber::pgs_equal(const pgsVariable &rhs) const
 {
-	if (rhs.is_number())
-	{
-		return pnew pgsNumber(num(m_data) == num(rhs.value())
-		                      ? wxT("1") : wxT("0"));
-	}
-	else
-	{
-		throw pgsArithmeticException(m_data, rhs.value());
-	}
+	return pnew pgsNumber(wxLongLong_t(compare(rhs) == 0));
 }
 
 pgsOperand pgsNumber::pgs_different(const pgsVariable &rhs) const
 {
-	if (rhs.is_number())
-	{
-		return pnew pgsNumber(num(m_data) != num(rhs.value())
-		                      ? wxT("1") : wxT("0"));
-	}
-	else
-	{
-		throw pgsArithmeticException(m_data, rhs.value());
-	}
+	return pnew pgsNumber(wxLongLong_t(compare(rhs) != 0));
 }
 
 pgsOperand pgsNumber::pgs_greater(const pgsVariable &rhs) const
 {
-	if (rhs.is_number())
-	{
-		return pnew pgsNumber(num(m_data) > num(rhs.value())
-		                      ? wxT("1") : wxT("0"));
-	}
-	else
-	{
-		throw pgsArithmeticException(m_data, rhs.value());
-	}
+	return pnew pgsNumber(wxLongLong_t(compare(rhs) > 0));
 }
 
 pgsOperand pgsNumber::pgs_lower(const pgsVariable &rhs) const
 {
-	if (rhs.is_number())
-	{
-		return pnew pgsNumber(num(m_data) < num(rhs.value())
-		                      ? wxT("1") : wxT("0"));
-	}
-	else
-	{
-		throw pgsArithmeticException(m_data, rhs.value());
-	}
+	return pnew pgsNumber(wxLongLong_t(compare(rhs) < 0));
 }
 
 pgsOperand pgsNumber::pgs_lower_equal(const pgsVariable &rhs) const
 {
-	if (rhs.is_number())
-	{
-		return pnew pgsNumber(num(m_data) <= num(rhs.value())
-		                      ? wxT("1") : wxT("0"));
-	}
-	else
-	{
-		throw pgsArithmeticException(m_data, rhs.value());
-	}
+	return pnew pgsNumber(wxLongLong_t(compare(rhs) <= 0));
 }
 
 pgsOperand pgsNumber::pgs_greater_equal(const pgsVariable &rhs) const
 {
-	if (rhs.is_number())
-	{
-		return pnew pgsNumber(num(m_data) >= num(rhs.value())
-		                      ? wxT("1") : wxT("0"));
-	}
-	else
-	{
-		throw pgsArithmeticException(m_data, rhs.value());
-	}
+	return pnew pgsNumber(wxLongLong_t(compare(rhs) >= 0));
 }
 
 pgsOperand pgsNumber::pgs_not() const
 {
-	return pnew pgsNumber(num(m_data) == 0 ? wxT("1") : wxT("0"));
+	return pnew pgsNumber(wxLongLong_t(!pgs_is_true()));
 }
 
 bool pgsNumber::pgs_is_true() const
 {
-	return (num(m_data) != 0 ? true : false);
+	if (m_native)
+		return m_int != 0;
+	return (mapm() != 0 ? true : false);
 }
 
 pgsOperand pgsNumber::pgs_almost_equal(const pgsVariable &rhs) const
@@ -282,5 +377,5 @@ pgsRecord pgsNumber::record() const
 
 pgsString pgsNumber::string() const
 {
-	return pgsString(m_data);
+	return pgsString(value());
 }
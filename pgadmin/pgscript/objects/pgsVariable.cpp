@@ -11,6 +11,8 @@
 #include "pgAdmin3.h"
 #include "pgscript/objects/pgsVariable.h"
 
+#include "pgscript/utilities/pgsCompiler.h"
+
 pgsVariable::pgsVariable(const pgsTypes &type) :
 	pgsExpression(), m_type(type)
 {
@@ -32,6 +34,11 @@ MAPM pgsVariable::num(const wxString &var)
 	return pgsMapm::pgs_str_mapm(var);
 }
 
+void pgsVariable::compile(pgsCompiler &c) const
+{
+	c.emit(PGS_OP_CONST, c.constant(this));
+}
+
 bool pgsVariable::is_number() const
 {
 	return is_integer() || is_real();
@@ -20,13 +20,14 @@
 pgsApplication::pgsApplication(const wxString &host, const wxString &database,
                                const wxString &user, const wxString &password, int port) :
 	m_mutex(1, 1), m_stream(1, 1), m_connection(pnew pgConn(host, wxEmptyString, wxEmptyString, database, user,
-	        password, port)), m_defined_conn(true), m_thread(0), m_caller(0)
+	        password, port)), m_defined_conn(true), m_thread(0), m_caller(0), m_bench(0),
+	m_compiled(true)
 {
 	if (m_connection->GetStatus() != PGCONN_OK)
 	{
 		wxLogError(wxT("PGSCRIPT: Cannot connect to database %s:%d/%s with ")
-		           wxT("credentials '%s'/'%s'"), host.c_str(), port, database.c_str(),
-		           user.c_str(), password.c_str());
+		           wxT("user '%s'"), host.c_str(), port, database.c_str(),
+		           user.c_str());
 	}
 
 	wxLogScript(wxT("Application created"));
@@ -34,7 +35,8 @@ pgsApplication::pgsApplication(const wxString &host, const wxString &database,
 
 pgsApplication::pgsApplication(pgConn *connection) :
 	m_mutex(1, 1), m_stream(1, 1), m_connection(connection),
-	m_defined_conn(false), m_thread(0), m_caller(0)
+	m_defined_conn(false), m_thread(0), m_caller(0), m_bench(0),
+	m_compiled(true)
 {
 	wxLogScript(wxT("Application created"));
 }
@@ -85,6 +87,12 @@ bool pgsApplication::RunThread()
 {
 	bool created = false;
 
+	if (m_thread != 0)
+	{
+		m_thread->bench(m_bench);
+		m_thread->compiled(m_compiled);
+	}
+
 	if (m_thread != 0 && m_thread->Create() == wxTHREAD_NO_ERROR)
 	{
 		m_thread->SetPriority(WXTHREAD_MIN_PRIORITY);
@@ -136,6 +144,8 @@ void pgsApplication::Terminate()
 	if (IsRunning())
 	{
 		wxLogScript(wxT("Deleting pgScript"));
+		// The thread can't check whether it's deleted while it waits for a query
+		m_thread->cancel();
 		m_thread->Delete();
 	}
 }
@@ -181,6 +191,24 @@ void pgsApplication::ClearSymbols()
 	}
 }
 
+void pgsApplication::SetSymbol(const wxString &name, const pgsOperand &value)
+{
+	if (!IsRunning())
+	{
+		m_vars[name] = value;
+	}
+}
+
+void pgsApplication::SetBench(pgsBench *bench)
+{
+	m_bench = bench;
+}
+
+void pgsApplication::SetCompiled(bool compiled)
+{
+	m_compiled = compiled;
+}
+
 #if !defined(PGSCLI)
 void pgsApplication::SetCaller(wxWindow *caller, long event_id)
 {
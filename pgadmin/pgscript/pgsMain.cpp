@@ -0,0 +1,384 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgScript - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#include "pgAdmin3.h"
+
+#include <string>
+#include <wx/cmdline.h>
+#include <wx/filename.h>
+#include <wx/init.h>
+#include <wx/stream.h>
+#include <wx/txtstrm.h>
+#include <wx/wfstream.h>
+
+#if defined(__WXMSW__)
+#include <conio.h>
+#else
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "pgscript/pgsApplication.h"
+#include "pgscript/objects/pgsNumber.h"
+#include "pgscript/utilities/pgsBench.h"
+#include "utils/sysLogger.h"
+
+/** Exit status when the script raised an error. */
+#define PGS_EXIT_SCRIPT 1
+
+/** Exit status when the script could not be run at all. */
+#define PGS_EXIT_FAILURE 2
+
+/** What is run, and where: the same for each instance of the script. */
+class pgsRun
+{
+
+public:
+
+	wxString host, database, user, password, file;
+
+	long port;
+
+	wxMBConv *conv;
+
+	bool quiet;
+
+	/** Run the script by walking its tree, rather than compiled. */
+	bool tree;
+
+	pgsRun() :
+		port(0), conv(&wxConvLocal), quiet(false), tree(false)
+	{
+
+	}
+
+};
+
+// Runs the script on a connection of its own, and measures its statements
+// into bench if it is not NULL. The script finds which of the instances it
+// is in @PGS_INSTANCE (1 to @PGS_INSTANCES), to offset its seeds with it.
+static int run_script(const pgsRun &run, pgsBench *bench,
+                      long instance = 1, long instances = 1)
+{
+	pgsApplication app(run.host, run.database, run.user, run.password, run.port);
+	if (!app.IsConnectionValid())
+	{
+		wxFprintf(stderr, _("pgscript: could not connect to the database\n"));
+		return PGS_EXIT_FAILURE;
+	}
+
+	// The output of the script is thrown away in quiet mode
+	wxFFileOutputStream out_file(stdout);
+	wxCountingOutputStream nowhere;
+	wxTextOutputStream out(run.quiet ? (wxOutputStream &) nowhere
+	                       : (wxOutputStream &) out_file);
+
+	app.SetBench(bench);
+	app.SetCompiled(!run.tree);
+	app.SetSymbol(wxT("@PGS_INSTANCE"), pgsOperand(pnew pgsNumber((wxLongLong_t) instance)));
+	app.SetSymbol(wxT("@PGS_INSTANCES"), pgsOperand(pnew pgsNumber((wxLongLong_t) instances)));
+	if (!app.ParseFile(run.file, out, run.conv))
+	{
+		wxFprintf(stderr, _("pgscript: could not run the script\n"));
+		return PGS_EXIT_FAILURE;
+	}
+	app.Wait();
+	fflush(stdout);
+
+	return app.errorOccurred() ? PGS_EXIT_SCRIPT : 0;
+}
+
+// Reads the password on the terminal, without echoing it, as psql -W does
+static wxString prompt_password()
+{
+#if defined(__WXMSW__)
+	std::string password;
+	fputs("Password: ", stderr);
+	for (;;)
+	{
+		int c = _getch();
+		if (c == '\r' || c == '\n' || c == EOF)
+			break;
+		if (c == '\b')
+		{
+			if (!password.empty())
+				password.erase(password.size() - 1);
+		}
+		else
+			password += (char) c;
+	}
+	fputs("\n", stderr);
+	return wxString(password.c_str(), wxConvLocal);
+#else
+	const char *password = getpass("Password: ");
+	return password != 0 ? wxString(password, wxConvLocal) : wxString();
+#endif
+}
+
+#if !defined(__WXMSW__)
+static bool write_all(int fd, const char *data, size_t len)
+{
+	while (len > 0)
+	{
+		ssize_t written = write(fd, data, len);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return false;
+		data += written;
+		len -= written;
+	}
+	return true;
+}
+
+static wxString read_all(int fd)
+{
+	std::string data;
+	char buffer[4096];
+	for (;;)
+	{
+		ssize_t nb = read(fd, buffer, sizeof(buffer));
+		if (nb < 0 && errno == EINTR)
+			continue;
+		if (nb <= 0)
+			break;
+		data.append(buffer, nb);
+	}
+	return wxString(data.c_str(), wxConvUTF8);
+}
+
+// Runs nb instances of the script at the same time. They are processes
+// rather than threads, so that they don't share the symbol tables nor the
+// allocator of pgScript. Each one sends its measures to this process
+// through a pipe once it is done.
+static int run_parallel(const pgsRun &run, long nb, pgsBench *bench)
+{
+	wxArrayInt pids, pipes;
+	int status = 0;
+
+	fflush(stdout);
+	fflush(stderr);
+
+	for (long i = 0; i < nb; i++)
+	{
+		int fds[2];
+		if (pipe(fds) != 0)
+		{
+			wxFprintf(stderr, _("pgscript: could not create a pipe\n"));
+			status = PGS_EXIT_FAILURE;
+			break;
+		}
+
+		pid_t pid = fork();
+		if (pid < 0)
+		{
+			wxFprintf(stderr, _("pgscript: could not start instance %ld\n"), i + 1);
+			close(fds[0]);
+			close(fds[1]);
+			status = PGS_EXIT_FAILURE;
+			break;
+		}
+
+		if (pid == 0)
+		{
+			close(fds[0]);
+			for (size_t j = 0; j < pipes.GetCount(); j++)
+				close(pipes[j]);
+
+			pgsBench measures;
+			int code = run_script(run, bench != 0 ? &measures : 0, i + 1, nb);
+			if (bench != 0)
+			{
+				wxCharBuffer data = measures.save().mb_str(wxConvUTF8);
+				if (!write_all(fds[1], data.data(), strlen(data.data())))
+					code = PGS_EXIT_FAILURE;
+			}
+			close(fds[1]);
+			fflush(stdout);
+			fflush(stderr);
+			_exit(code);
+		}
+
+		close(fds[1]);
+		pids.Add(pid);
+		pipes.Add(fds[0]);
+	}
+
+	for (size_t i = 0; i < pids.GetCount(); i++)
+	{
+		wxString data = read_all(pipes[i]);
+		close(pipes[i]);
+
+		int child_status = 0;
+		while (waitpid(pids[i], &child_status, 0) < 0 && errno == EINTR)
+			;
+
+		int code = WIFEXITED(child_status) ? WEXITSTATUS(child_status) : PGS_EXIT_FAILURE;
+		if (bench != 0 && !bench->load(data))
+			code = PGS_EXIT_FAILURE;
+		status = wxMax(status, code);
+	}
+
+	return status;
+}
+#endif
+
+static int run_command_line()
+{
+	static const wxCmdLineEntryDesc cmdLineDesc[] =
+	{
+#if wxCHECK_VERSION(2, 9, 0)
+		{wxCMD_LINE_SWITCH, "?", "help", _("show this help message, and quit"), wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
+		{wxCMD_LINE_OPTION, "h", "host", _("database server host"), wxCMD_LINE_VAL_STRING},
+		{wxCMD_LINE_OPTION, "p", "port", _("database server port"), wxCMD_LINE_VAL_NUMBER},
+		{wxCMD_LINE_OPTION, "d", "dbname", _("database to connect to"), wxCMD_LINE_VAL_STRING},
+		{wxCMD_LINE_OPTION, "U", "username", _("database user name"), wxCMD_LINE_VAL_STRING},
+		{wxCMD_LINE_SWITCH, "W", "password", _("prompt for the password of the user"), wxCMD_LINE_VAL_NONE},
+		{wxCMD_LINE_OPTION, "e", "encoding", _("encoding of the script file"), wxCMD_LINE_VAL_STRING},
+		{wxCMD_LINE_SWITCH, "q", "quiet", _("do not print the output of the script"), wxCMD_LINE_VAL_NONE},
+		{wxCMD_LINE_SWITCH, "b", "bench", _("report the latencies and throughput of the statements"), wxCMD_LINE_VAL_NONE},
+		{wxCMD_LINE_SWITCH, "T", "tree", _("run the script by walking its tree, rather than compiled to bytecode"), wxCMD_LINE_VAL_NONE},
+		{wxCMD_LINE_OPTION, "j", "parallel", _("run N instances of the script at once, on N connections"), wxCMD_LINE_VAL_NUMBER},
+		{wxCMD_LINE_OPTION, "l", "log", _("log file of the interpreter"), wxCMD_LINE_VAL_STRING},
+		{wxCMD_LINE_OPTION, "L", "loglevel", _("log level, from 0 (none) to 4 (debug)"), wxCMD_LINE_VAL_NUMBER},
+		{wxCMD_LINE_PARAM, NULL, NULL, _("script"), wxCMD_LINE_VAL_STRING},
+#else
+		{wxCMD_LINE_SWITCH, wxT("?"), wxT("help"), _("show this help message, and quit"), wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
+		{wxCMD_LINE_OPTION, wxT("h"), wxT("host"), _("database server host"), wxCMD_LINE_VAL_STRING},
+		{wxCMD_LINE_OPTION, wxT("p"), wxT("port"), _("database server port"), wxCMD_LINE_VAL_NUMBER},
+		{wxCMD_LINE_OPTION, wxT("d"), wxT("dbname"), _("database to connect to"), wxCMD_LINE_VAL_STRING},
+		{wxCMD_LINE_OPTION, wxT("U"), wxT("username"), _("database user name"), wxCMD_LINE_VAL_STRING},
+		{wxCMD_LINE_SWITCH, wxT("W"), wxT("password"), _("prompt for the password of the user"), wxCMD_LINE_VAL_NONE},
+		{wxCMD_LINE_OPTION, wxT("e"), wxT("encoding"), _("encoding of the script file"), wxCMD_LINE_VAL_STRING},
+		{wxCMD_LINE_SWITCH, wxT("q"), wxT("quiet"), _("do not print the output of the script"), wxCMD_LINE_VAL_NONE},
+		{wxCMD_LINE_SWITCH, wxT("b"), wxT("bench"), _("report the latencies and throughput of the statements"), wxCMD_LINE_VAL_NONE},
+		{wxCMD_LINE_SWITCH, wxT("T"), wxT("tree"), _("run the script by walking its tree, rather than compiled to bytecode"), wxCMD_LINE_VAL_NONE},
+		{wxCMD_LINE_OPTION, wxT("j"), wxT("parallel"), _("run N instances of the script at once, on N connections"), wxCMD_LINE_VAL_NUMBER},
+		{wxCMD_LINE_OPTION, wxT("l"), wxT("log"), _("log file of the interpreter"), wxCMD_LINE_VAL_STRING},
+		{wxCMD_LINE_OPTION, wxT("L"), wxT("loglevel"), _("log level, from 0 (none) to 4 (debug)"), wxCMD_LINE_VAL_NUMBER},
+		{wxCMD_LINE_PARAM, NULL, NULL, _("script"), wxCMD_LINE_VAL_STRING},
+#endif
+		{wxCMD_LINE_NONE}
+	};
+
+	wxCmdLineParser parser(cmdLineDesc, wxTheApp->argc, wxTheApp->argv);
+	switch (parser.Parse())
+	{
+		case 0:
+			break;
+		case -1:
+			return 0;
+		default:
+			return PGS_EXIT_FAILURE;
+	}
+
+	pgsRun run;
+	parser.Found(wxT("h"), &run.host);
+	parser.Found(wxT("p"), &run.port);
+	parser.Found(wxT("d"), &run.database);
+	parser.Found(wxT("U"), &run.user);
+	run.quiet = parser.Found(wxT("q"));
+	run.tree = parser.Found(wxT("T"));
+	run.file = parser.GetParam(0);
+
+	if (!wxFileName::FileExists(run.file))
+	{
+		wxFprintf(stderr, _("pgscript: could not find the script %s\n"), run.file.c_str());
+		return PGS_EXIT_FAILURE;
+	}
+
+	wxString encoding;
+	wxCSConv *conv = 0;
+	if (parser.Found(wxT("e"), &encoding))
+	{
+		conv = new wxCSConv(encoding);
+		if (!conv->IsOk())
+		{
+			wxFprintf(stderr, _("pgscript: unknown encoding %s\n"), encoding.c_str());
+			delete conv;
+			return PGS_EXIT_FAILURE;
+		}
+		run.conv = conv;
+	}
+
+	long parallel = 1;
+	if (parser.Found(wxT("j"), &parallel) && parallel < 1)
+	{
+		wxFprintf(stderr, _("pgscript: the number of instances must be positive\n"));
+		delete conv;
+		return PGS_EXIT_FAILURE;
+	}
+#if defined(__WXMSW__)
+	if (parallel > 1)
+	{
+		wxFprintf(stderr, _("pgscript: --parallel is not supported on this platform\n"));
+		delete conv;
+		return PGS_EXIT_FAILURE;
+	}
+#endif
+
+	// Nothing is logged unless a log file is given
+	wxString log_file;
+	long log_level = LOG_NONE;
+	if (parser.Found(wxT("l"), &log_file))
+	{
+		sysLogger::logFile = log_file;
+		log_level = LOG_ERRORS;
+	}
+	parser.Found(wxT("L"), &log_level);
+	sysLogger::logLevel = log_level;
+	wxLog *previous = wxLog::SetActiveTarget(new sysLogger());
+
+	// Without -W, libpq finds the password in PGPASSWORD or ~/.pgpass. It is
+	// asked once, before the instances of the script are started.
+	if (parser.Found(wxT("W")))
+		run.password = prompt_password();
+
+	pgsBench measures;
+	pgsBench *bench = parser.Found(wxT("b")) ? &measures : 0;
+	wxLongLong_t start = pgsBench::now();
+	int status;
+
+#if !defined(__WXMSW__)
+	if (parallel > 1)
+		status = run_parallel(run, parallel, bench);
+	else
+#endif
+		status = run_script(run, bench);
+
+	if (bench != 0)
+	{
+		wxFFileOutputStream out_file(stdout);
+		wxTextOutputStream out(out_file);
+		bench->report(out, pgsBench::now() - start);
+		fflush(stdout);
+	}
+
+	delete wxLog::SetActiveTarget(previous);
+	delete conv;
+
+	return status;
+}
+
+int main(int argc, char **argv)
+{
+	if (!wxEntryStart(argc, argv))
+	{
+		fprintf(stderr, "pgscript: could not initialize wxWidgets\n");
+		return PGS_EXIT_FAILURE;
+	}
+
+	int status = run_command_line();
+
+	wxEntryCleanup();
+	return status;
+}
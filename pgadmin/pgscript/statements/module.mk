@@ -9,7 +9,7 @@
 #
 #######################################################################
 
-pgadmin3_SOURCES += \
+TMP_pgscript += \
 	pgscript/statements/pgsAssertStmt.cpp \
 	pgscript/statements/pgsBreakStmt.cpp \
 	pgscript/statements/pgsContinueStmt.cpp \
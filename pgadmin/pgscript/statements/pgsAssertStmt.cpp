@@ -12,6 +12,7 @@
 #include "pgscript/statements/pgsAssertStmt.h"
 
 #include "pgscript/exceptions/pgsAssertException.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsAssertStmt::pgsAssertStmt(const pgsExpression *cond, pgsThread *app) :
 	pgsStmt(app), m_cond(cond)
@@ -32,3 +33,9 @@ void pgsAssertStmt::eval(pgsVarMap &vars) const
 		throw pgsAssertException(m_cond->value());
 	}
 }
+
+void pgsAssertStmt::compile(pgsCompiler &c) const
+{
+	m_cond->compile(c);
+	c.emit(PGS_OP_ASSERT, c.expr(m_cond));
+}
@@ -12,6 +12,7 @@
 #include "pgscript/statements/pgsBreakStmt.h"
 
 #include "pgscript/exceptions/pgsBreakException.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsBreakStmt::pgsBreakStmt(pgsThread *app) :
 	pgsStmt(app)
@@ -28,3 +29,12 @@ void pgsBreakStmt::eval(pgsVarMap &vars) const
 {
 	throw pgsBreakException();
 }
+
+void pgsBreakStmt::compile(pgsCompiler &c) const
+{
+	// Out of a loop, it ends the program
+	if (c.in_loop())
+		c.add_break(c.emit(PGS_OP_JUMP));
+	else
+		c.emit(PGS_OP_HALT);
+}
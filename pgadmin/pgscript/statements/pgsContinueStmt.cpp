@@ -12,6 +12,7 @@
 #include "pgscript/statements/pgsContinueStmt.h"
 
 #include "pgscript/exceptions/pgsContinueException.h"
+#include "pgscript/utilities/pgsCompiler.h"
 
 pgsContinueStmt::pgsContinueStmt(pgsThread *app) :
 	pgsStmt(app)
@@ -28,3 +29,12 @@ void pgsContinueStmt::eval(pgsVarMap &vars) const
 {
 	throw pgsContinueException();
 }
+
+void pgsContinueStmt::compile(pgsCompiler &c) const
+{
+	// Out of a loop, it ends the program
+	if (c.in_loop())
+		c.add_continue(c.emit(PGS_OP_JUMP));
+	else
+		c.emit(PGS_OP_HALT);
+}
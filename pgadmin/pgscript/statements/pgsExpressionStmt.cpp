@@ -11,6 +11,8 @@
 #include "pgAdmin3.h"
 #include "pgscript/statements/pgsExpressionStmt.h"
 
+#include "pgscript/utilities/pgsCompiler.h"
+
 pgsExpressionStmt::pgsExpressionStmt(const pgsExpression *var, pgsThread *app) :
 	pgsStmt(app), m_var(var)
 {
@@ -24,5 +26,10 @@ pgsExpressionStmt::~pgsExpressionStmt()
 
 void pgsExpressionStmt::eval(pgsVarMap &vars) const
 {
-	m_var->eval(vars);
+	m_var->exec(vars);
+}
+
+void pgsExpressionStmt::compile(pgsCompiler &c) const
+{
+	m_var->compile_exec(c);
 }
@@ -11,6 +11,8 @@
 #include "pgAdmin3.h"
 #include "pgscript/statements/pgsIfStmt.h"
 
+#include "pgscript/utilities/pgsCompiler.h"
+
 pgsIfStmt::pgsIfStmt(const pgsExpression *cond, const pgsStmt *stmt_list_if,
                      const pgsStmt *stmt_list_else, pgsThread *app) :
 	pgsStmt(app), m_cond(cond), m_stmt_list_if(stmt_list_if),
@@ -37,3 +39,18 @@ void pgsIfStmt::eval(pgsVarMap &vars) const
 		m_stmt_list_else->eval(vars);
 	}
 }
+
+void pgsIfStmt::compile(pgsCompiler &c) const
+{
+	int line = c.line();
+	wxArrayInt no;
+	m_cond->compile_jump(c, no, false);
+	m_stmt_list_if->compile(c);
+	c.line(line);
+	int end = c.emit(PGS_OP_JUMP);
+
+	c.patch(no);
+	m_stmt_list_else->compile(c);
+	c.line(line);
+	c.patch(end);
+}
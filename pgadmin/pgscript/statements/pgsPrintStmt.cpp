@@ -12,6 +12,7 @@
 #include "pgscript/statements/pgsPrintStmt.h"
 
 #include "pgscript/exceptions/pgsException.h"
+#include "pgscript/utilities/pgsCompiler.h"
 #include "pgscript/utilities/pgsThread.h"
 #include "pgscript/utilities/pgsUtilities.h"
 
@@ -54,3 +55,9 @@ void pgsPrintStmt::eval(pgsVarMap &vars) const
 		m_app->UnlockOutput();
 	}
 }
+
+void pgsPrintStmt::compile(pgsCompiler &c) const
+{
+	m_var->compile(c);
+	c.emit(PGS_OP_PRINT);
+}
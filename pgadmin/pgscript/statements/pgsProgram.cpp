@@ -13,9 +13,13 @@
 
 #include "pgscript/exceptions/pgsException.h"
 #include "pgscript/statements/pgsStmtList.h"
+#include "pgscript/utilities/pgsCode.h"
+#include "pgscript/utilities/pgsCompiler.h"
+#include "pgscript/utilities/pgsMachine.h"
 
-pgsProgram::pgsProgram(pgsVarMap &vars) :
-	m_vars(vars)
+pgsProgram::pgsProgram(pgsVarMap &vars, pgsOutputStream &cout,
+                       pgsThread *app, bool compiled) :
+	m_vars(vars), m_cout(cout), m_app(app), m_compiled(compiled)
 {
 
 }
@@ -46,7 +50,20 @@ void pgsProgram::eval(pgsStmtList *stmt_list)
 
 	try
 	{
-		stmt_list->eval(m_vars);
+		if (m_compiled)
+		{
+			pgsCode code;
+			pgsCompiler compiler(code);
+			compiler.compile(*stmt_list);
+			code.dump();
+
+			pgsMachine machine(code, m_vars, m_cout, m_app);
+			machine.run();
+		}
+		else
+		{
+			stmt_list->eval(m_vars);
+		}
 	}
 	catch (const pgsException &)
 	{
@@ -11,6 +11,8 @@
 #include "pgAdmin3.h"
 #include "pgscript/statements/pgsStmt.h"
 
+#include "pgscript/utilities/pgsCompiler.h"
+
 pgsStmt::pgsStmt(pgsThread *app) :
 	m_line(0), m_app(app)
 {
@@ -31,3 +33,8 @@ int pgsStmt::line() const
 {
 	return m_line;
 }
+
+void pgsStmt::compile(pgsCompiler &c) const
+{
+	c.emit(PGS_OP_EXEC, c.stmt(this));
+}
@@ -15,6 +15,7 @@
 #include "pgscript/exceptions/pgsBreakException.h"
 #include "pgscript/exceptions/pgsContinueException.h"
 #include "pgscript/exceptions/pgsInterruptException.h"
+#include "pgscript/utilities/pgsCompiler.h"
 #include "pgscript/utilities/pgsThread.h"
 #include "pgscript/utilities/pgsUtilities.h"
 
@@ -113,3 +114,19 @@ void pgsStmtList::insert_back(pgsStmt *stmt)
 {
 	m_stmt_list.push_back(stmt);
 }
+
+void pgsStmtList::compile(pgsCompiler &c) const
+{
+	pgsListStmt::const_iterator it;
+	for (it = m_stmt_list.begin(); it != m_stmt_list.end(); it++)
+	{
+		pgsStmt *current = *it;
+
+		c.line(current->line());
+		current->compile(c);
+
+		// Errors are reported on the line of the statement
+		c.line(current->line());
+		c.emit(PGS_OP_NEXT);
+	}
+}
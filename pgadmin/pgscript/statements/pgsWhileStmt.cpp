@@ -14,6 +14,7 @@
 #include "pgscript/exceptions/pgsBreakException.h"
 #include "pgscript/exceptions/pgsContinueException.h"
 #include "pgscript/exceptions/pgsInterruptException.h"
+#include "pgscript/utilities/pgsCompiler.h"
 #include "pgscript/utilities/pgsThread.h"
 
 pgsWhileStmt::pgsWhileStmt(const pgsExpression *cond, const pgsStmt *stmt_list,
@@ -54,3 +55,19 @@ loop:
 end:
 	;
 }
+
+void pgsWhileStmt::compile(pgsCompiler &c) const
+{
+	int line = c.line();
+	int top = c.here();
+	wxArrayInt no;
+	m_cond->compile_jump(c, no, false);
+
+	c.begin_loop();
+	m_stmt_list->compile(c);
+	c.line(line);
+	int loop = c.emit(PGS_OP_LOOP, top);
+	c.end_loop(loop);
+
+	c.patch(no);
+}
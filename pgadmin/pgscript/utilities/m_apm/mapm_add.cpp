@@ -28,9 +28,9 @@
 #include "pgAdmin3.h"
 #include "pgscript/utilities/mapm-lib/m_apm_lc.h"
 
-static	M_APM	M_work1 = NULL;
-static	M_APM	M_work2 = NULL;
-static	int	M_add_firsttime = TRUE;
+static	M_THREAD_LOCAL M_APM	M_work1 = NULL;
+static	M_THREAD_LOCAL M_APM	M_work2 = NULL;
+static	M_THREAD_LOCAL int	M_add_firsttime = TRUE;
 
 /****************************************************************************/
 void	M_free_all_add()
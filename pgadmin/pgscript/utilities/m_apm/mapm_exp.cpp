@@ -27,9 +27,9 @@
 #include "pgAdmin3.h"
 #include "pgscript/utilities/mapm-lib/m_apm_lc.h"
 
-static  M_APM  MM_exp_log2R;
-static  M_APM  MM_exp_512R;
-static	int    MM_firsttime1 = TRUE;
+static  M_THREAD_LOCAL M_APM  MM_exp_log2R;
+static  M_THREAD_LOCAL M_APM  MM_exp_512R;
+static	M_THREAD_LOCAL int    MM_firsttime1 = TRUE;
 
 /****************************************************************************/
 void	M_free_all_exp()
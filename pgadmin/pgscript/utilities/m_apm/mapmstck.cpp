@@ -28,13 +28,13 @@
 #include "pgAdmin3.h"
 #include "pgscript/utilities/mapm-lib/m_apm_lc.h"
 
-static	int	M_stack_ptr  = -1;
-static	int	M_last_init  = -1;
-static	int	M_stack_size = 0;
+static	M_THREAD_LOCAL int	M_stack_ptr  = -1;
+static	M_THREAD_LOCAL int	M_last_init  = -1;
+static	M_THREAD_LOCAL int	M_stack_size = 0;
 
 static  const char    *M_stack_err_msg = "\'M_get_stack_var\', Out of memory";
 
-static	M_APM	*M_stack_array;
+static	M_THREAD_LOCAL M_APM	*M_stack_array;
 
 /****************************************************************************/
 void	M_free_all_stck()
@@ -27,16 +27,16 @@
 #include "pgAdmin3.h"
 #include "pgscript/utilities/mapm-lib/m_apm_lc.h"
 
-static  UCHAR	*M_mul_div = NULL;
-static  UCHAR   *M_mul_rem = NULL;
+static  M_THREAD_LOCAL UCHAR	*M_mul_div = NULL;
+static  M_THREAD_LOCAL UCHAR   *M_mul_rem = NULL;
 
-static  UCHAR   M_mul_div_10[100];
-static	UCHAR   M_mul_rem_10[100];
+static  M_THREAD_LOCAL UCHAR   M_mul_div_10[100];
+static	M_THREAD_LOCAL UCHAR   M_mul_rem_10[100];
 
-static	int	M_util_firsttime = TRUE;
-static	int     M_firsttime3 = TRUE;
+static	M_THREAD_LOCAL int	M_util_firsttime = TRUE;
+static	M_THREAD_LOCAL int     M_firsttime3 = TRUE;
 
-static	M_APM	M_work_0_5;
+static	M_THREAD_LOCAL M_APM	M_work_0_5;
 
 static  const char    *M_init_error_msg = "\'m_apm_init\', Out of memory";
 
@@ -49,7 +49,10 @@ M_APM	m_apm_init()
 	{
 		M_firsttime3 = FALSE;
 		M_init_util_data();
-		M_init_trig_globals();
+
+		/* the constants are shared by the threads */
+		if (MM_lc_PI_digits == 0)
+			M_init_trig_globals();
 	}
 
 	if ((atmp = (M_APM)MAPM_MALLOC(sizeof(M_APM_struct))) == NULL)
@@ -9,7 +9,7 @@
 #
 #######################################################################
 
-pgadmin3_SOURCES += \
+TMP_pgscript += \
 	pgscript/utilities/m_apm/mapm5sin.cpp \
 	pgscript/utilities/m_apm/mapmasin.cpp \
 	pgscript/utilities/m_apm/mapmasn0.cpp \
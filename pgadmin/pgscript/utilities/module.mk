@@ -9,10 +9,15 @@
 #
 #######################################################################
 
-pgadmin3_SOURCES += \
+TMP_pgscript += \
 	pgscript/utilities/pgsAlloc.cpp \
+	pgscript/utilities/pgsBench.cpp \
+	pgscript/utilities/pgsBulkCopy.cpp \
+	pgscript/utilities/pgsCode.cpp \
+	pgscript/utilities/pgsCompiler.cpp \
 	pgscript/utilities/pgsContext.cpp \
 	pgscript/utilities/pgsDriver.cpp \
+	pgscript/utilities/pgsMachine.cpp \
 	pgscript/utilities/pgsMapm.cpp \
 	pgscript/utilities/pgsThread.cpp \
 	pgscript/utilities/pgsUtilities.cpp
@@ -0,0 +1,279 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgScript - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#include "pgAdmin3.h"
+#include "pgscript/utilities/pgsBench.h"
+
+#include <wx/tokenzr.h>
+
+#ifdef __WXMSW__
+#include <windows.h>
+#else
+#include <time.h>
+#include <sys/time.h>
+#endif
+
+/** Width of the longest bar of a histogram. */
+#define PGS_BENCH_BAR 40
+
+// Bucket of the histogram a latency falls in
+static int bucket(wxLongLong_t usec)
+{
+	int i = 0;
+	while (usec > 1 && i < PGS_BENCH_BUCKETS - 1)
+	{
+		usec >>= 1;
+		i++;
+	}
+	return i;
+}
+
+static wxString to_string(const wxLongLong_t &value)
+{
+	return wxLongLong(value).ToString();
+}
+
+static double to_ms(const wxLongLong_t &usec)
+{
+	return (double)usec / 1000.0;
+}
+
+pgsBenchStmt::pgsBenchStmt() :
+	count(0), rows(0), total(0), min(0), max(0)
+{
+	for (int i = 0; i < PGS_BENCH_BUCKETS; i++)
+		buckets[i] = 0;
+}
+
+void pgsBenchStmt::add(const wxLongLong_t &usec, const wxLongLong_t &nb_rows)
+{
+	if (count == 0 || usec < min)
+		min = usec;
+	if (usec > max)
+		max = usec;
+	count++;
+	rows += nb_rows;
+	total += usec;
+	buckets[bucket(usec)]++;
+}
+
+void pgsBenchStmt::merge(const pgsBenchStmt &that)
+{
+	if (that.count == 0)
+		return;
+
+	if (count == 0 || that.min < min)
+		min = that.min;
+	if (that.max > max)
+		max = that.max;
+	count += that.count;
+	rows += that.rows;
+	total += that.total;
+	for (int i = 0; i < PGS_BENCH_BUCKETS; i++)
+		buckets[i] += that.buckets[i];
+}
+
+pgsBench::pgsBench()
+{
+
+}
+
+// wx only has a millisecond clock before 2.9.3, and its microsecond one
+// follows the wall clock, which may be set back meanwhile. The latencies
+// are only ever differences of these.
+wxLongLong_t pgsBench::now()
+{
+#ifdef __WXMSW__
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+
+	// Apart, or the product overflows once the machine has been up long enough
+	return (counter.QuadPart / frequency.QuadPart) * 1000000
+	       + (counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#else
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+		return (wxLongLong_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (wxLongLong_t)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
+void pgsBench::add(const wxString &stmt, const wxLongLong_t &usec,
+                   const wxLongLong_t &rows)
+{
+	pgsBenchMap::iterator it = m_stmts.find(stmt);
+	if (it != m_stmts.end())
+	{
+		it->second.add(usec, rows);
+		return;
+	}
+
+	// A script building its queries out of variables could make as many
+	// statements as executions
+	wxString key(stmt);
+	if (m_stmts.size() >= PGS_BENCH_MAX_STMTS)
+		key = _("(other statements)");
+	if (m_stmts.find(key) == m_stmts.end())
+		m_order.Add(key);
+	m_stmts[key].add(usec, rows);
+}
+
+void pgsBench::merge(const pgsBench &that)
+{
+	for (size_t i = 0; i < that.m_order.GetCount(); i++)
+	{
+		const wxString &key = that.m_order[i];
+		if (m_stmts.find(key) == m_stmts.end())
+			m_order.Add(key);
+		m_stmts[key].merge(that.m_stmts.find(key)->second);
+	}
+}
+
+wxString pgsBench::save() const
+{
+	// A line per statement: the numbers, then the statement, whose tabs
+	// and line returns are escaped
+	wxString data;
+	for (size_t i = 0; i < m_order.GetCount(); i++)
+	{
+		const pgsBenchStmt &stmt = m_stmts.find(m_order[i])->second;
+
+		data << to_string(stmt.count) << wxT("\t") << to_string(stmt.rows)
+		     << wxT("\t") << to_string(stmt.total) << wxT("\t")
+		     << to_string(stmt.min) << wxT("\t") << to_string(stmt.max);
+		for (int b = 0; b < PGS_BENCH_BUCKETS; b++)
+			data << wxT("\t") << to_string(stmt.buckets[b]);
+
+		wxString text(m_order[i]);
+		text.Replace(wxT("\\"), wxT("\\\\"));
+		text.Replace(wxT("\t"), wxT("\\t"));
+		text.Replace(wxT("\n"), wxT("\\n"));
+		text.Replace(wxT("\r"), wxT("\\r"));
+		data << wxT("\t") << text << wxT("\n");
+	}
+	return data;
+}
+
+bool pgsBench::load(const wxString &data)
+{
+	pgsBench loaded;
+	wxStringTokenizer lines(data, wxT("\n"));
+	while (lines.HasMoreTokens())
+	{
+		wxString line = lines.GetNextToken();
+		if (line.IsEmpty())
+			continue;
+
+		wxStringTokenizer fields(line, wxT("\t"), wxTOKEN_RET_EMPTY_ALL);
+		if (fields.CountTokens() != 5 + PGS_BENCH_BUCKETS + 1)
+			return false;
+
+		pgsBenchStmt stmt;
+		stmt.count = StrToLongLong(fields.GetNextToken()).GetValue();
+		stmt.rows = StrToLongLong(fields.GetNextToken()).GetValue();
+		stmt.total = StrToLongLong(fields.GetNextToken()).GetValue();
+		stmt.min = StrToLongLong(fields.GetNextToken()).GetValue();
+		stmt.max = StrToLongLong(fields.GetNextToken()).GetValue();
+		for (int b = 0; b < PGS_BENCH_BUCKETS; b++)
+			stmt.buckets[b] = StrToLongLong(fields.GetNextToken()).GetValue();
+
+		wxString escaped = fields.GetNextToken(), text;
+		for (size_t i = 0; i < escaped.Length(); i++)
+		{
+			if (escaped[i] == wxT('\\') && i + 1 < escaped.Length())
+			{
+				switch ((wxChar)escaped[++i])
+				{
+					case wxT('t'):
+						text += wxT('\t');
+						break;
+					case wxT('n'):
+						text += wxT('\n');
+						break;
+					case wxT('r'):
+						text += wxT('\r');
+						break;
+					default:
+						text += escaped[i];
+				}
+			}
+			else
+				text += escaped[i];
+		}
+
+		if (loaded.m_stmts.find(text) == loaded.m_stmts.end())
+			loaded.m_order.Add(text);
+		loaded.m_stmts[text].merge(stmt);
+	}
+
+	merge(loaded);
+	return true;
+}
+
+void pgsBench::report(pgsOutputStream &out, const wxLongLong_t &elapsed) const
+{
+	wxString indent = generate_spaces(PGSOUTBENCH.Length());
+	wxLongLong_t count = 0, rows = 0;
+
+	for (size_t i = 0; i < m_order.GetCount(); i++)
+	{
+		const pgsBenchStmt &stmt = m_stmts.find(m_order[i])->second;
+		count += stmt.count;
+		rows += stmt.rows;
+
+		wxString text(m_order[i]);
+		text.Replace(wxT("\n"), wxT("\n") + indent);
+		out << PGSOUTBENCH << text << wxT("\n");
+
+		out << indent << wxString::Format(_("%s executions, %s rows, %.1f rows/s"),
+		                                  to_string(stmt.count).c_str(), to_string(stmt.rows).c_str(),
+		                                  stmt.total > 0 ? (double)stmt.rows * 1000000.0 / stmt.total : 0.0)
+		    << wxT("\n");
+		out << indent << wxString::Format(_("latency (ms): min %.3f, avg %.3f, max %.3f"),
+		                                  to_ms(stmt.min), to_ms(stmt.total / stmt.count), to_ms(stmt.max))
+		    << wxT("\n");
+
+		// The buckets from the first to the last one used
+		int first = 0, last = PGS_BENCH_BUCKETS - 1;
+		wxLongLong_t highest = 0;
+		while (stmt.buckets[first] == 0)
+			first++;
+		while (stmt.buckets[last] == 0)
+			last--;
+		for (int b = first; b <= last; b++)
+			highest = wxMax(highest, stmt.buckets[b]);
+
+		for (int b = first; b <= last; b++)
+		{
+			int bar = (int)((stmt.buckets[b] * PGS_BENCH_BAR + highest - 1) / highest);
+			out << indent << wxString::Format(wxT("%10.3f - %10.3f ms %12s "),
+			                                  b == 0 ? 0.0 : to_ms((wxLongLong_t)1 << b),
+			                                  to_ms((wxLongLong_t)1 << (b + 1)),
+			                                  to_string(stmt.buckets[b]).c_str())
+			    << wxString(wxT('#'), bar) << wxT("\n");
+		}
+	}
+
+	double seconds = (double)elapsed / 1000000.0;
+	out << PGSOUTBENCH << wxString::Format(_("%s statements, %s rows in %.3f s"),
+	                                       to_string(count).c_str(), to_string(rows).c_str(), seconds);
+	if (elapsed > 0)
+		out << wxString::Format(_(": %.1f statements/s, %.1f rows/s"),
+		                        (double)count / seconds, (double)rows / seconds);
+	out << wxT("\n");
+}
@@ -0,0 +1,807 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgScript - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#include "pgAdmin3.h"
+#include "pgscript/utilities/pgsBulkCopy.h"
+
+#include <wx/thread.h>
+#include "db/pgConn.h"
+#include "pgscript/objects/pgsGenerator.h"
+#include "pgscript/objects/pgsNumber.h"
+#include "pgscript/utilities/pgsMapm.h"
+#include "pgscript/utilities/pgsThread.h"
+
+/** Characters formatted into a chunk, before it is sent. */
+#define PGS_COPY_CHUNK 262144
+
+/** Chunks formatted in advance, waiting to be sent. */
+#define PGS_COPY_QUEUE 4
+
+/** Threads formatting the rows at once, when the generators can be
+ * reseeded. It does not depend on the processors, nor do the rows. */
+#define PGS_COPY_WORKERS 4
+
+/** Rows of a chunk formatted by one of these threads. */
+#define PGS_COPY_CHUNK_ROWS 1024
+
+// Characters of the name of a variable, after the @
+static bool is_var_char(wxChar c)
+{
+	return (c >= wxT('a') && c <= wxT('z')) || (c >= wxT('A') && c <= wxT('Z'))
+	       || (c >= wxT('0') && c <= wxT('9')) || c == wxT('_') || c == wxT('#')
+	       || c == wxT('@');
+}
+
+static size_t skip_spaces(const wxString &text, size_t i)
+{
+	while (i < text.Length() && wxIsspace(text[i]))
+		i++;
+	return i;
+}
+
+// Appends a value in the text format of COPY
+static void append_value(wxString &rows, const wxString &value)
+{
+	if (value.find_first_of(wxT("\\\t\n\r")) == wxString::npos)
+	{
+		rows += value;
+		return;
+	}
+
+	for (size_t i = 0; i < value.Length(); i++)
+	{
+		wxChar c = value[i];
+		switch (c)
+		{
+			case wxT('\\'):
+				rows += wxT("\\\\");
+				break;
+			case wxT('\t'):
+				rows += wxT("\\t");
+				break;
+			case wxT('\n'):
+				rows += wxT("\\n");
+				break;
+			case wxT('\r'):
+				rows += wxT("\\r");
+				break;
+			default:
+				rows += c;
+		}
+	}
+}
+
+/** Where the chunks of rows come from. */
+class pgsBulkCopyChunks
+{
+
+public:
+
+	virtual ~pgsBulkCopyChunks()
+	{
+
+	}
+
+	/** Gets the next chunk. False if there are no more rows, or if they
+	 * can't be converted to the encoding of the connection. */
+	virtual bool next(wxCharBuffer &chunk) = 0;
+
+	virtual bool failed() const = 0;
+
+};
+
+/** Formats the rows in the text format of COPY, a chunk at a time. */
+class pgsBulkCopyRows : public pgsBulkCopyChunks
+{
+
+private:
+
+	const pgsOperand *m_columns;
+
+	size_t m_nb_columns;
+
+	wxLongLong_t m_left;
+
+	wxMBConv &m_conv;
+
+	wxString m_rows;
+
+	bool m_failed;
+
+public:
+
+	pgsBulkCopyRows(const pgsOperand *columns, size_t nb_columns,
+	                wxLongLong_t nb_rows, wxMBConv &conv) :
+		m_columns(columns), m_nb_columns(nb_columns), m_left(nb_rows),
+		m_conv(conv), m_failed(false)
+	{
+		m_rows.Alloc(PGS_COPY_CHUNK + 1024);
+	}
+
+	virtual bool next(wxCharBuffer &chunk)
+	{
+		if (m_left <= 0 || m_failed)
+			return false;
+
+		m_rows.Empty();
+		while (m_left > 0 && m_rows.Length() < PGS_COPY_CHUNK)
+		{
+			for (size_t i = 0; i < m_nb_columns; i++)
+			{
+				if (i > 0)
+					m_rows += wxT('\t');
+				append_value(m_rows, m_columns[i]->value());
+			}
+			m_rows += wxT('\n');
+			m_left--;
+		}
+
+		// There is at least a newline, unless the conversion failed
+		chunk = m_rows.mb_str(m_conv);
+		if (chunk.data() == 0 || *chunk.data() == '\0')
+		{
+			m_failed = true;
+			return false;
+		}
+		return true;
+	}
+
+	virtual bool failed() const
+	{
+		return m_failed;
+	}
+
+};
+
+class pgsBulkCopyWorkers;
+
+class pgsBulkCopyWorker : public wxThread
+{
+
+private:
+
+	pgsBulkCopyWorkers &m_workers;
+
+	size_t m_index;
+
+public:
+
+	pgsBulkCopyWorker(pgsBulkCopyWorkers &workers, size_t index) :
+		wxThread(wxTHREAD_JOINABLE), m_workers(workers), m_index(index)
+	{
+
+	}
+
+	virtual void *Entry();
+
+};
+
+/** Formats the rows in PGS_COPY_WORKERS threads at once. Each thread gets
+ * a copy of the generators, which can be reseeded, whose seed is offset
+ * by its number (1 to PGS_COPY_WORKERS). Chunk c is formatted by thread
+ * c % PGS_COPY_WORKERS, and the chunks are sent in their order: the rows
+ * are the same from one run to the next. The values of the generators,
+ * which can't be reseeded (sequences), are still drawn from the generator
+ * of the script, one chunk after the other, by the thread formatting it.
+ * The variables, which aren't generators, are copied. */
+class pgsBulkCopyWorkers : public pgsBulkCopyChunks
+{
+
+private:
+
+	const pgsOperand *m_columns;
+
+	size_t m_nb_columns;
+
+	wxLongLong_t m_nb_rows, m_nb_chunks;
+
+	wxMBConv &m_conv;
+
+	size_t m_nb_workers;
+
+	/** Generator of a column, for each thread: 0 if it can't be reseeded. */
+	pgsObjectGen **m_gens;
+
+	/** Value of a column, which isn't a generator, for each thread. */
+	wxString *m_fixed;
+
+	/** Is the column drawn from the generator of the script? */
+	bool *m_shared;
+
+	bool m_has_shared;
+
+	pgsBulkCopyWorker *m_threads[PGS_COPY_WORKERS];
+
+	wxMBConv *m_convs[PGS_COPY_WORKERS];
+
+	size_t m_nb_running;
+
+	/** Protects the queues of the chunks formatted, one per thread. */
+	wxMutex m_mutex;
+
+	wxCondition m_changed;
+
+	wxCharBuffer m_queue[PGS_COPY_WORKERS][PGS_COPY_QUEUE];
+
+	size_t m_first[PGS_COPY_WORKERS];
+
+	size_t m_count[PGS_COPY_WORKERS];
+
+	bool m_done[PGS_COPY_WORKERS];
+
+	/** The next chunk to be sent. */
+	wxLongLong_t m_next;
+
+	bool m_failed;
+
+	bool m_stop;
+
+	/** The next chunk, whose values are drawn from the generators of the
+	 * script. */
+	wxMutex m_turn_mutex;
+
+	wxCondition m_turn_changed;
+
+	wxLongLong_t m_turn;
+
+public:
+
+	pgsBulkCopyWorkers(const pgsOperand *columns, size_t nb_columns,
+	                   wxLongLong_t nb_rows, wxMBConv &conv) :
+		m_columns(columns), m_nb_columns(nb_columns), m_nb_rows(nb_rows),
+		m_nb_chunks((nb_rows + PGS_COPY_CHUNK_ROWS - 1) / PGS_COPY_CHUNK_ROWS),
+		m_conv(conv), m_nb_workers(0), m_gens(0), m_fixed(0), m_shared(0),
+		m_has_shared(false), m_nb_running(0), m_changed(m_mutex), m_next(0),
+		m_failed(false), m_stop(false), m_turn_changed(m_turn_mutex), m_turn(0)
+	{
+		for (size_t w = 0; w < PGS_COPY_WORKERS; w++)
+		{
+			m_threads[w] = 0;
+			m_convs[w] = 0;
+			m_first[w] = 0;
+			m_count[w] = 0;
+			m_done[w] = false;
+		}
+	}
+
+	~pgsBulkCopyWorkers()
+	{
+		stop();
+
+		if (m_gens != 0)
+		{
+			for (size_t i = 0; i < m_nb_workers * m_nb_columns; i++)
+				pdelete(m_gens[i]);
+		}
+		pdeletea(m_gens);
+		pdeletea(m_fixed);
+		pdeletea(m_shared);
+		for (size_t w = 0; w < PGS_COPY_WORKERS; w++)
+			pdelete(m_convs[w]);
+	}
+
+	/** Starts the threads. False if none of the generators can be
+	 * reseeded, or if the threads can't be started: the rows are formatted
+	 * by a single thread then. */
+	bool start()
+	{
+#if !defined(MAPM_THREAD_LOCAL) || defined(PGSDEBUG)
+		// The generators compute with MAPM, which keeps its working storage
+		// in static variables then; so does the allocator of PGSDEBUG
+		return false;
+#else
+		m_nb_workers = (size_t) wxMin((wxLongLong_t) PGS_COPY_WORKERS, m_nb_chunks);
+		if (m_nb_workers < 2)
+			return false;
+
+		m_gens = pnew pgsObjectGen *[m_nb_workers * m_nb_columns];
+		m_fixed = pnew wxString[m_nb_workers * m_nb_columns];
+		m_shared = pnew bool[m_nb_columns];
+
+		bool reseeded = false;
+		for (size_t i = 0; i < m_nb_columns; i++)
+		{
+			const pgsGenerator *gen = dynamic_cast<const pgsGenerator *>(m_columns[i].get());
+			m_shared[i] = false;
+			for (size_t w = 0; w < m_nb_workers; w++)
+			{
+				size_t k = w * m_nb_columns + i;
+				m_gens[k] = gen != 0 ? gen->reseed((long) w + 1) : 0;
+
+				// Copied as a whole, as the strings may be shared otherwise
+				if (gen == 0)
+					m_fixed[k] = wxString(m_columns[i]->value().c_str());
+			}
+			if (gen != 0 && m_gens[i] == 0)
+				m_shared[i] = m_has_shared = true;
+			else if (gen != 0)
+				reseeded = true;
+		}
+		if (!reseeded)
+			return false;
+
+		for (size_t w = 0; w < m_nb_workers; w++)
+		{
+			m_convs[w] = m_conv.Clone();
+			m_threads[w] = pnew pgsBulkCopyWorker(*this, w);
+			if (m_threads[w]->Create() != wxTHREAD_NO_ERROR)
+			{
+				stop();
+				return false;
+			}
+		}
+
+		for (size_t w = 0; w < m_nb_workers; w++)
+		{
+			if (m_threads[w]->Run() != wxTHREAD_NO_ERROR)
+			{
+				stop();
+				return false;
+			}
+			m_nb_running++;
+		}
+		return true;
+#endif
+	}
+
+	/** Formats the chunks of thread w. */
+	void work(size_t w)
+	{
+		wxString rows;
+		wxArrayString shared;
+
+		for (wxLongLong_t c = w; c < m_nb_chunks; c += m_nb_workers)
+		{
+			long nb = (long) wxMin((wxLongLong_t) PGS_COPY_CHUNK_ROWS,
+			                       m_nb_rows - c * PGS_COPY_CHUNK_ROWS);
+
+			// The values of the sequences, in the order of the chunks
+			if (m_has_shared)
+			{
+				wxMutexLocker lock(m_turn_mutex);
+				while (m_turn != c && !m_stop)
+					m_turn_changed.Wait();
+				if (m_stop)
+					break;
+
+				shared.Empty();
+				for (long r = 0; r < nb; r++)
+				{
+					for (size_t i = 0; i < m_nb_columns; i++)
+					{
+						if (m_shared[i])
+							shared.Add(m_columns[i]->value());
+					}
+				}
+				m_turn++;
+				m_turn_changed.Broadcast();
+			}
+
+			rows.Empty();
+			size_t s = 0;
+			for (long r = 0; r < nb; r++)
+			{
+				for (size_t i = 0; i < m_nb_columns; i++)
+				{
+					size_t k = w * m_nb_columns + i;
+					if (i > 0)
+						rows += wxT('\t');
+					if (m_gens[k] != 0)
+						append_value(rows, m_gens[k]->random());
+					else if (m_shared[i])
+						append_value(rows, shared[s++]);
+					else
+						append_value(rows, m_fixed[k]);
+				}
+				rows += wxT('\n');
+			}
+
+			wxCharBuffer chunk = rows.mb_str(*m_convs[w]);
+
+			wxMutexLocker lock(m_mutex);
+			if (chunk.data() == 0 || *chunk.data() == '\0')
+			{
+				m_failed = true;
+				break;
+			}
+			while (m_count[w] == PGS_COPY_QUEUE && !m_stop)
+				m_changed.Wait();
+			if (m_stop)
+				break;
+
+			// Handed over under the lock, as the buffers may be shared
+			m_queue[w][(m_first[w] + m_count[w]) % PGS_COPY_QUEUE] = chunk;
+			chunk = wxCharBuffer();
+			m_count[w]++;
+			m_changed.Broadcast();
+		}
+
+		{
+			wxMutexLocker lock(m_mutex);
+			m_done[w] = true;
+			m_changed.Broadcast();
+		}
+
+		// The working storage of MAPM in this thread
+		m_apm_free_thread_mem();
+	}
+
+	virtual bool next(wxCharBuffer &chunk)
+	{
+		wxMutexLocker lock(m_mutex);
+		if (m_next >= m_nb_chunks)
+			return false;
+
+		size_t w = (size_t)(m_next % m_nb_workers);
+		while (m_count[w] == 0 && !m_done[w])
+			m_changed.Wait();
+		if (m_count[w] == 0)
+			return false;
+
+		chunk = m_queue[w][m_first[w]];
+		m_queue[w][m_first[w]] = wxCharBuffer();
+		m_first[w] = (m_first[w] + 1) % PGS_COPY_QUEUE;
+		m_count[w]--;
+		m_next++;
+		m_changed.Broadcast();
+		return true;
+	}
+
+	virtual bool failed() const
+	{
+		return m_failed;
+	}
+
+	/** Stops formatting, and waits for the threads. */
+	void stop()
+	{
+		{
+			wxMutexLocker lock(m_mutex);
+			m_stop = true;
+			m_changed.Broadcast();
+		}
+		{
+			wxMutexLocker lock(m_turn_mutex);
+			m_turn_changed.Broadcast();
+		}
+
+		for (size_t w = 0; w < PGS_COPY_WORKERS; w++)
+		{
+			if (m_threads[w] == 0)
+				continue;
+			if (w < m_nb_running)
+				m_threads[w]->Wait();
+			pdelete(m_threads[w]);
+		}
+		m_nb_running = 0;
+	}
+
+};
+
+void *pgsBulkCopyWorker::Entry()
+{
+	m_workers.work(m_index);
+	return NULL;
+}
+
+/** Formats the chunks in a thread of its own, while the ones formatted
+ * before are sent. Values are drawn from the generators in the same order
+ * as without it: only one thread ever draws them. */
+class pgsBulkCopyProducer : public wxThread
+{
+
+private:
+
+	pgsBulkCopyChunks &m_rows;
+
+	wxMutex m_mutex;
+
+	wxCondition m_filled;
+
+	wxCondition m_emptied;
+
+	wxCharBuffer m_queue[PGS_COPY_QUEUE];
+
+	size_t m_first;
+
+	size_t m_count;
+
+	bool m_done;
+
+	bool m_stop;
+
+public:
+
+	pgsBulkCopyProducer(pgsBulkCopyChunks &rows) :
+		wxThread(wxTHREAD_JOINABLE), m_rows(rows), m_filled(m_mutex),
+		m_emptied(m_mutex), m_first(0), m_count(0), m_done(false),
+		m_stop(false)
+	{
+
+	}
+
+	virtual void *Entry()
+	{
+		wxCharBuffer chunk;
+		while (m_rows.next(chunk))
+		{
+			wxMutexLocker lock(m_mutex);
+			while (m_count == PGS_COPY_QUEUE && !m_stop)
+				m_emptied.Wait();
+			if (m_stop)
+				break;
+
+			// Handed over under the lock, as the buffers may be shared
+			m_queue[(m_first + m_count) % PGS_COPY_QUEUE] = chunk;
+			chunk = wxCharBuffer();
+			m_count++;
+			m_filled.Signal();
+		}
+
+		wxMutexLocker lock(m_mutex);
+		chunk = wxCharBuffer();
+		m_done = true;
+		m_filled.Signal();
+		return NULL;
+	}
+
+	/** Waits for the next chunk. False if there are no more. */
+	bool pop(wxCharBuffer &chunk)
+	{
+		wxMutexLocker lock(m_mutex);
+		while (m_count == 0 && !m_done)
+			m_filled.Wait();
+		if (m_count == 0)
+			return false;
+
+		chunk = m_queue[m_first];
+		m_queue[m_first] = wxCharBuffer();
+		m_first = (m_first + 1) % PGS_COPY_QUEUE;
+		m_count--;
+		m_emptied.Signal();
+		return true;
+	}
+
+	/** Stops formatting, and waits for the thread. */
+	void stop()
+	{
+		{
+			wxMutexLocker lock(m_mutex);
+			m_stop = true;
+			m_emptied.Signal();
+		}
+		Wait();
+	}
+
+};
+
+// Ends the COPY, with an error if abort is set
+static bool end_copy(pgConn *conn, const wxString &abort)
+{
+	return conn->EndPutCopy(abort) && conn->GetCopyFinalStatus(false)
+	       && abort.IsEmpty();
+}
+
+static bool send_chunk(pgConn *conn, const wxCharBuffer &chunk)
+{
+	return conn->PutCopyData(chunk.data(), strlen(chunk.data()));
+}
+
+// Sends all the rows within a COPY, which has been started, and ends it.
+// With prefetch, the chunks are formatted by a thread of their own, if it
+// can be started.
+static bool send_rows(pgsThread *app, pgsBulkCopyChunks &rows, bool prefetch)
+{
+	pgConn *conn = app->connection();
+	pgsBulkCopyProducer producer(rows);
+	bool threaded = prefetch && producer.Create() == wxTHREAD_NO_ERROR
+	                && producer.Run() == wxTHREAD_NO_ERROR;
+
+	wxCharBuffer chunk;
+	wxString abort;
+	while (threaded ? producer.pop(chunk) : rows.next(chunk))
+	{
+		if (app->TestDestroy() || app->cancelled())
+		{
+			abort = wxT("cancelled by pgScript");
+			break;
+		}
+		if (!send_chunk(conn, chunk))
+		{
+			abort = wxT("data could not be sent");
+			break;
+		}
+	}
+
+	if (threaded)
+		producer.stop();
+
+	if (abort.IsEmpty() && rows.failed())
+		abort = wxT("values could not be converted to the client encoding");
+
+	return end_copy(conn, abort);
+}
+
+pgsBulkCopy::pgsBulkCopy()
+{
+
+}
+
+bool pgsBulkCopy::parse(const wxString &query)
+{
+	m_copy.Clear();
+	m_vars.Clear();
+	m_rows.Clear();
+
+	wxString text = query.Strip(wxString::both), upper = text.Upper();
+	size_t len = text.Length(), from = 4, i;
+
+	if (!upper.StartsWith(wxT("COPY")) || len <= 4 || !wxIsspace(text[4]))
+		return false;
+
+	// FROM followed by a variable, instead of STDIN or a file name
+	for (;;)
+	{
+		from = upper.find(wxT("FROM"), from + 1);
+		if (from == wxString::npos)
+			return false;
+
+		i = from + 4;
+		if (!wxIsspace(text[from - 1]) || i >= len || !wxIsspace(text[i]))
+			continue;
+		i = skip_spaces(text, i);
+		if (i < len && text[i] == wxT('@'))
+			break;
+	}
+
+	// The variables, separated by commas
+	wxArrayString vars;
+	for (;;)
+	{
+		size_t end = i + 1;
+		while (end < len && is_var_char(text[end]))
+			end++;
+		if (end == i + 1)
+			return false;
+		vars.Add(text.Mid(i, end - i));
+
+		i = skip_spaces(text, end);
+		if (i >= len || text[i] != wxT(','))
+			break;
+		i = skip_spaces(text, i + 1);
+		if (i >= len || text[i] != wxT('@'))
+			return false;
+	}
+
+	// ROWS, followed by a number or a variable
+	if (upper.Mid(i, 4) != wxT("ROWS") || i + 4 >= len || !wxIsspace(text[i + 4]))
+		return false;
+	wxString rows = text.Mid(skip_spaces(text, i + 4));
+
+	if (rows.StartsWith(wxT("@")))
+	{
+		for (i = 1; i < rows.Length() && is_var_char(rows[i]); i++)
+			;
+		if (i == 1 || i < rows.Length())
+			return false;
+	}
+	else
+	{
+		for (i = 0; i < rows.Length() && wxIsdigit(rows[i]); i++)
+			;
+		if (i == 0 || i < rows.Length())
+			return false;
+	}
+
+	m_copy = text.Left(from).Strip(wxString::trailing) + wxT(" FROM STDIN");
+	m_vars = vars;
+	m_rows = rows;
+	return true;
+}
+
+bool pgsBulkCopy::is_valid() const
+{
+	return !m_copy.IsEmpty();
+}
+
+wxLongLong_t pgsBulkCopy::run(pgsVarMap &vars, pgsThread *app,
+                              wxString &error) const
+{
+	wxASSERT(is_valid());
+
+	// Number of rows
+	wxString count = m_rows;
+	if (count.StartsWith(wxT("@")))
+	{
+		if (vars.find(count) == vars.end())
+		{
+			error = wxString::Format(_("Unknown variable %s"), count.c_str());
+			return -1;
+		}
+		count = vars[count]->eval(vars)->value().Strip(wxString::both);
+	}
+	if (pgsNumber::num_type(count) != pgsNumber::pgsTInt
+	        || count.StartsWith(wxT("-")))
+	{
+		error = wxString::Format(_("Invalid number of rows: %s"), count.c_str());
+		return -1;
+	}
+	wxLongLong_t nb_rows = StrToLongLong(count).GetValue();
+	if (nb_rows == 0)
+		return 0;
+
+	// Columns: copies of the variables, which share the state of the
+	// generators with them
+	size_t nb_columns = m_vars.GetCount();
+	pgsOperand *columns = pnew pgsOperand[nb_columns];
+	bool uses_connection = false;
+	for (size_t i = 0; i < nb_columns; i++)
+	{
+		if (vars.find(m_vars[i]) == vars.end())
+		{
+			error = wxString::Format(_("Unknown variable %s"), m_vars[i].c_str());
+			pdeletea(columns);
+			return -1;
+		}
+
+		columns[i] = vars[m_vars[i]];
+		const pgsGenerator *gen = dynamic_cast<const pgsGenerator *>(columns[i].get());
+		if (gen != 0 && gen->uses_connection())
+			uses_connection = true;
+	}
+
+	pgConn *conn = app->connection();
+	pgsBulkCopyRows rows(columns, nb_columns, nb_rows, *conn->GetConv());
+	pgsBulkCopyWorkers workers(columns, nb_columns, nb_rows, *conn->GetConv());
+	pgsBulkCopyChunks *sent = &rows;
+	bool ok;
+
+	if (uses_connection)
+	{
+		// REFERENCE generators query the database, which they can't do
+		// during a COPY: each chunk gets a COPY of its own, and is formatted
+		// before it. A failure leaves the chunks sent before it loaded,
+		// unless the script runs in a transaction.
+		wxCharBuffer chunk;
+		ok = true;
+		while (ok && rows.next(chunk) && !app->TestDestroy() && !app->cancelled())
+		{
+			ok = conn->StartCopy(m_copy, false)
+			     && end_copy(conn, send_chunk(conn, chunk) ? wxString()
+			                 : wxString(wxT("data could not be sent")));
+		}
+	}
+	else if (conn->StartCopy(m_copy, false))
+	{
+		// Formatted by several threads, if the generators can be reseeded,
+		// or by a thread of its own
+		if (workers.start())
+			sent = &workers;
+		ok = send_rows(app, *sent, sent == &rows);
+	}
+	else
+	{
+		ok = false;
+	}
+
+	// The threads may still draw from the columns
+	workers.stop();
+	pdeletea(columns);
+
+	if (!ok)
+		error = conn->GetLastError();
+	else if (sent->failed())
+		error = _("The values could not be converted to the client encoding");
+	else if (app->TestDestroy() || app->cancelled())
+		error = _("Cancelled");
+	else
+		return nb_rows;
+	return -1;
+}
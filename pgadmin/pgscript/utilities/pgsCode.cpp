@@ -0,0 +1,241 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgScript - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#include "pgAdmin3.h"
+#include "pgscript/utilities/pgsCode.h"
+
+pgsCode::pgsCode() :
+	m_instrs(0), m_count(0), m_size(0), m_depth(0)
+{
+
+}
+
+pgsCode::~pgsCode()
+{
+	pdeletea(m_instrs);
+
+	for (size_t i = 0; i < m_owned.GetCount(); i++)
+	{
+		pgsVariable *var = (pgsVariable *)m_owned.Item(i);
+		pdelete(var);
+	}
+}
+
+const pgsInstr *pgsCode::instrs() const
+{
+	return m_instrs;
+}
+
+int pgsCode::count() const
+{
+	return m_count;
+}
+
+int pgsCode::depth() const
+{
+	return m_depth;
+}
+
+int pgsCode::count_slots() const
+{
+	return m_slots.GetCount();
+}
+
+const wxString &pgsCode::slot_name(const int &slot) const
+{
+	return m_slots.Item(slot);
+}
+
+const pgsVariable *pgsCode::constant(const int &i) const
+{
+	return (const pgsVariable *)m_consts.Item(i);
+}
+
+const pgsExpression *pgsCode::expr(const int &i) const
+{
+	return (const pgsExpression *)m_exprs.Item(i);
+}
+
+const pgsStmt *pgsCode::stmt(const int &i) const
+{
+	return (const pgsStmt *)m_stmts.Item(i);
+}
+
+void pgsCode::dump() const
+{
+	if (sysLogger::logLevel < LOG_DEBUG)
+		return;
+
+	wxLogScriptVerbose(wxT("Code: %d instructions, %d slots, %d operands deep"),
+	                   m_count, count_slots(), m_depth);
+
+	for (int i = 0; i < m_count; i++)
+	{
+		const pgsInstr &instr = m_instrs[i];
+		wxString args;
+
+		switch (instr.op)
+		{
+			case PGS_OP_CONST:
+				args << constant(instr.a)->value();
+				break;
+			case PGS_OP_LOAD:
+			case PGS_OP_STORE:
+			case PGS_OP_LINES:
+			case PGS_OP_COLUMNS:
+			case PGS_OP_RECORD_CHECK:
+			case PGS_OP_RECORD_LINE:
+			case PGS_OP_RECORD_GET:
+			case PGS_OP_RECORD_SET:
+			case PGS_OP_RECORD_REMOVE:
+				args << slot_name(instr.a);
+				break;
+			case PGS_OP_EVAL:
+			case PGS_OP_ASSERT:
+				args << expr(instr.a)->value();
+				break;
+			case PGS_OP_CAST:
+			case PGS_OP_JUMP:
+			case PGS_OP_JUMP_TRUE:
+			case PGS_OP_JUMP_FALSE:
+			case PGS_OP_LOOP:
+				args << instr.a;
+				break;
+			case PGS_OP_JUMP_NOT_RECORD:
+				args << instr.a << wxT(" ") << slot_name(instr.b);
+				break;
+			default:
+				break;
+		}
+
+		wxLogScriptVerbose(wxT("%5d  %-16s %s  (line %d)"), i,
+		                   op_name(instr.op), args.c_str(), instr.line);
+	}
+}
+
+int pgsCode::effect(const pgsOpCode &op)
+{
+	switch (op)
+	{
+		case PGS_OP_CONST:
+		case PGS_OP_LOAD:
+		case PGS_OP_EVAL:
+		case PGS_OP_LINES:
+		case PGS_OP_COLUMNS:
+			return 1;
+		case PGS_OP_STORE:
+		case PGS_OP_POP:
+		case PGS_OP_PLUS:
+		case PGS_OP_MINUS:
+		case PGS_OP_TIMES:
+		case PGS_OP_OVER:
+		case PGS_OP_MODULO:
+		case PGS_OP_EQUAL:
+		case PGS_OP_ALMOST_EQUAL:
+		case PGS_OP_DIFFERENT:
+		case PGS_OP_GREATER:
+		case PGS_OP_LOWER:
+		case PGS_OP_GREATER_EQUAL:
+		case PGS_OP_LOWER_EQUAL:
+		case PGS_OP_RECORD_GET:
+		case PGS_OP_RECORD_REMOVE:
+		case PGS_OP_JUMP_TRUE:
+		case PGS_OP_JUMP_FALSE:
+		case PGS_OP_PRINT:
+		case PGS_OP_ASSERT:
+			return -1;
+		case PGS_OP_RECORD_SET:
+			return -3;
+		default:
+			return 0;
+	}
+}
+
+const wxChar *pgsCode::op_name(const pgsOpCode &op)
+{
+	switch (op)
+	{
+		case PGS_OP_CONST:
+			return wxT("CONST");
+		case PGS_OP_LOAD:
+			return wxT("LOAD");
+		case PGS_OP_STORE:
+			return wxT("STORE");
+		case PGS_OP_POP:
+			return wxT("POP");
+		case PGS_OP_EVAL:
+			return wxT("EVAL");
+		case PGS_OP_EXEC:
+			return wxT("EXEC");
+		case PGS_OP_PLUS:
+			return wxT("PLUS");
+		case PGS_OP_MINUS:
+			return wxT("MINUS");
+		case PGS_OP_TIMES:
+			return wxT("TIMES");
+		case PGS_OP_OVER:
+			return wxT("OVER");
+		case PGS_OP_MODULO:
+			return wxT("MODULO");
+		case PGS_OP_EQUAL:
+			return wxT("EQUAL");
+		case PGS_OP_ALMOST_EQUAL:
+			return wxT("ALMOST_EQUAL");
+		case PGS_OP_DIFFERENT:
+			return wxT("DIFFERENT");
+		case PGS_OP_GREATER:
+			return wxT("GREATER");
+		case PGS_OP_LOWER:
+			return wxT("LOWER");
+		case PGS_OP_GREATER_EQUAL:
+			return wxT("GREATER_EQUAL");
+		case PGS_OP_LOWER_EQUAL:
+			return wxT("LOWER_EQUAL");
+		case PGS_OP_NOT:
+			return wxT("NOT");
+		case PGS_OP_TRIM:
+			return wxT("TRIM");
+		case PGS_OP_CAST:
+			return wxT("CAST");
+		case PGS_OP_LINES:
+			return wxT("LINES");
+		case PGS_OP_COLUMNS:
+			return wxT("COLUMNS");
+		case PGS_OP_RECORD_CHECK:
+			return wxT("RECORD_CHECK");
+		case PGS_OP_RECORD_LINE:
+			return wxT("RECORD_LINE");
+		case PGS_OP_RECORD_GET:
+			return wxT("RECORD_GET");
+		case PGS_OP_RECORD_SET:
+			return wxT("RECORD_SET");
+		case PGS_OP_RECORD_REMOVE:
+			return wxT("RECORD_REMOVE");
+		case PGS_OP_JUMP:
+			return wxT("JUMP");
+		case PGS_OP_JUMP_TRUE:
+			return wxT("JUMP_TRUE");
+		case PGS_OP_JUMP_FALSE:
+			return wxT("JUMP_FALSE");
+		case PGS_OP_JUMP_NOT_RECORD:
+			return wxT("JUMP_NOT_RECORD");
+		case PGS_OP_LOOP:
+			return wxT("LOOP");
+		case PGS_OP_NEXT:
+			return wxT("NEXT");
+		case PGS_OP_PRINT:
+			return wxT("PRINT");
+		case PGS_OP_ASSERT:
+			return wxT("ASSERT");
+		case PGS_OP_HALT:
+			return wxT("HALT");
+	}
+	return wxT("?");
+}
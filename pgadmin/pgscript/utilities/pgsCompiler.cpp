@@ -0,0 +1,214 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgScript - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#include "pgAdmin3.h"
+#include "pgscript/utilities/pgsCompiler.h"
+
+#include "pgscript/objects/pgsNumber.h"
+#include "pgscript/objects/pgsString.h"
+#include "pgscript/statements/pgsStmt.h"
+
+/** Instructions allocated at first, their number is doubled when needed. */
+#define PGS_CODE_SIZE 64
+
+pgsCompiler::pgsCompiler(pgsCode &code) :
+	m_code(code), m_line(0), m_depth(0)
+{
+	m_true = own(pnew pgsNumber(wxT("1"), pgsInt));
+	m_false = own(pnew pgsNumber(wxT("0"), pgsInt));
+	m_zero = m_false;
+	m_empty = own(pnew pgsString(wxT("")));
+}
+
+pgsCompiler::~pgsCompiler()
+{
+
+}
+
+void pgsCompiler::compile(const pgsStmt &stmt)
+{
+	m_line = stmt.line();
+	stmt.compile(*this);
+	emit(PGS_OP_HALT);
+
+	wxASSERT(m_depth == 0 && m_loop_breaks.IsEmpty());
+}
+
+int pgsCompiler::emit(const pgsOpCode &op, const int &a, const int &b)
+{
+	if (m_code.m_count == m_code.m_size)
+	{
+		int size = m_code.m_size > 0 ? 2 * m_code.m_size : PGS_CODE_SIZE;
+		pgsInstr *instrs = pnew pgsInstr[size];
+		for (int i = 0; i < m_code.m_count; i++)
+		{
+			instrs[i] = m_code.m_instrs[i];
+		}
+		pdeletea(m_code.m_instrs);
+		m_code.m_instrs = instrs;
+		m_code.m_size = size;
+	}
+
+	pgsInstr &instr = m_code.m_instrs[m_code.m_count];
+	instr.op = op;
+	instr.a = a;
+	instr.b = b;
+	instr.line = m_line;
+
+	m_depth += pgsCode::effect(op);
+	m_code.m_depth = wxMax(m_code.m_depth, m_depth);
+
+	return m_code.m_count++;
+}
+
+int pgsCompiler::here() const
+{
+	return m_code.m_count;
+}
+
+void pgsCompiler::patch(const int &address)
+{
+	m_code.m_instrs[address].a = here();
+}
+
+void pgsCompiler::patch(const wxArrayInt &addresses)
+{
+	for (size_t i = 0; i < addresses.GetCount(); i++)
+	{
+		patch(addresses.Item(i));
+	}
+}
+
+int pgsCompiler::slot(const wxString &name)
+{
+	pgsSlotMap::iterator it = m_slot_map.find(name);
+	if (it != m_slot_map.end())
+	{
+		return it->second;
+	}
+
+	int slot = m_code.m_slots.Add(name);
+	m_slot_map[name] = slot;
+	return slot;
+}
+
+int pgsCompiler::constant(const pgsVariable *var)
+{
+	return m_code.m_consts.Add((void *) var);
+}
+
+int pgsCompiler::expr(const pgsExpression *expr)
+{
+	return m_code.m_exprs.Add((void *) expr);
+}
+
+int pgsCompiler::stmt(const pgsStmt *stmt)
+{
+	return m_code.m_stmts.Add((void *) stmt);
+}
+
+int pgsCompiler::own(pgsVariable *var)
+{
+	m_code.m_owned.Add(var);
+	return constant(var);
+}
+
+int pgsCompiler::true_constant() const
+{
+	return m_true;
+}
+
+int pgsCompiler::false_constant() const
+{
+	return m_false;
+}
+
+int pgsCompiler::zero_constant() const
+{
+	return m_zero;
+}
+
+int pgsCompiler::empty_constant() const
+{
+	return m_empty;
+}
+
+int pgsCompiler::line() const
+{
+	return m_line;
+}
+
+void pgsCompiler::line(const int &line)
+{
+	m_line = line;
+}
+
+int pgsCompiler::depth() const
+{
+	return m_depth;
+}
+
+void pgsCompiler::depth(const int &depth)
+{
+	m_depth = depth;
+}
+
+void pgsCompiler::compile_truth(const pgsExpression &expr)
+{
+	wxArrayInt no;
+	expr.compile_jump(*this, no, false);
+	emit(PGS_OP_CONST, m_true);
+	int end = emit(PGS_OP_JUMP);
+
+	patch(no);
+	m_depth--;
+	emit(PGS_OP_CONST, m_false);
+	patch(end);
+}
+
+void pgsCompiler::begin_loop()
+{
+	m_loop_breaks.Add(m_breaks.GetCount());
+	m_loop_continues.Add(m_continues.GetCount());
+}
+
+bool pgsCompiler::in_loop() const
+{
+	return !m_loop_breaks.IsEmpty();
+}
+
+void pgsCompiler::add_break(const int &address)
+{
+	m_breaks.Add(address);
+}
+
+void pgsCompiler::add_continue(const int &address)
+{
+	m_continues.Add(address);
+}
+
+void pgsCompiler::end_loop(const int &continue_target)
+{
+	size_t first = m_loop_continues.Last();
+	m_loop_continues.RemoveAt(m_loop_continues.GetCount() - 1);
+	while (m_continues.GetCount() > first)
+	{
+		m_code.m_instrs[m_continues.Last()].a = continue_target;
+		m_continues.RemoveAt(m_continues.GetCount() - 1);
+	}
+
+	first = m_loop_breaks.Last();
+	m_loop_breaks.RemoveAt(m_loop_breaks.GetCount() - 1);
+	while (m_breaks.GetCount() > first)
+	{
+		patch(m_breaks.Last());
+		m_breaks.RemoveAt(m_breaks.GetCount() - 1);
+	}
+}
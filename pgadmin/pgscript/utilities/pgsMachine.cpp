@@ -0,0 +1,530 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgScript - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#include "pgAdmin3.h"
+#include "pgscript/utilities/pgsMachine.h"
+
+#include <wx/datetime.h>
+#include "pgscript/exceptions/pgsAssertException.h"
+#include "pgscript/exceptions/pgsInterruptException.h"
+#include "pgscript/exceptions/pgsParameterException.h"
+#include "pgscript/expressions/pgsAssignToRecord.h"
+#include "pgscript/expressions/pgsCast.h"
+#include "pgscript/expressions/pgsColumns.h"
+#include "pgscript/expressions/pgsIdentRecord.h"
+#include "pgscript/expressions/pgsLines.h"
+#include "pgscript/expressions/pgsRemoveLine.h"
+#include "pgscript/objects/pgsNumber.h"
+#include "pgscript/objects/pgsRecord.h"
+#include "pgscript/objects/pgsString.h"
+#include "pgscript/statements/pgsStmtList.h"
+#include "pgscript/utilities/pgsThread.h"
+
+pgsMachine::pgsMachine(const pgsCode &code, pgsVarMap &vars,
+                       pgsOutputStream &cout, pgsThread *app) :
+	m_code(code), m_vars(vars), m_cout(cout), m_app(app), m_slots(0),
+	m_stack(0), m_top(0), m_pc(0)
+{
+	m_slots = pnew pgsOperand *[wxMax(m_code.count_slots(), 1)];
+	for (int i = 0; i < m_code.count_slots(); i++)
+	{
+		m_slots[i] = 0;
+	}
+
+	m_stack = pnew pgsStackItem[wxMax(m_code.depth(), 1)];
+}
+
+pgsMachine::~pgsMachine()
+{
+	drop(m_top);
+	pdeletea(m_stack);
+	pdeletea(m_slots);
+}
+
+void pgsMachine::run()
+{
+	m_pc = 0;
+
+	try
+	{
+		execute();
+	}
+	catch (const pgsException &e)
+	{
+		if (!pgsStmtList::m_exception_thrown)
+		{
+			int line = m_code.instrs()[m_pc].line;
+
+			if (m_app != 0)
+			{
+				m_app->LockOutput();
+				m_app->last_error_line(line);
+			}
+
+			m_cout << wx_static_cast(const wxString, e.message())
+			       << wxT(" on line ") << line << wxT("\n");
+			pgsStmtList::m_exception_thrown = true;
+
+			if (m_app != 0)
+			{
+				m_app->UnlockOutput();
+			}
+		}
+		drop(m_top);
+		throw;
+	}
+	catch (const std::exception &e)
+	{
+		if (!pgsStmtList::m_exception_thrown)
+		{
+			if (m_app != 0)
+			{
+				m_app->LockOutput();
+				m_app->last_error_line(m_code.instrs()[m_pc].line);
+			}
+
+			m_cout << PGSOUTERROR << _("Unknown exception:\n")
+			       << wx_static_cast(const wxString,
+			                         wxString(e.what(), wxConvUTF8));
+			pgsStmtList::m_exception_thrown = true;
+
+			if (m_app != 0)
+			{
+				m_app->UnlockOutput();
+			}
+		}
+		drop(m_top);
+		throw;
+	}
+}
+
+void pgsMachine::execute()
+{
+	const pgsInstr *instrs = m_code.instrs();
+
+	for (;;)
+	{
+		const pgsInstr &instr = instrs[m_pc];
+		pgsOperand value;
+
+		switch (instr.op)
+		{
+			case PGS_OP_CONST:
+				push(m_code.constant(instr.a), false);
+				break;
+
+			case PGS_OP_LOAD:
+			{
+				pgsOperand *var = find(instr.a);
+				if (var != 0)
+				{
+					push(var->get(), false);
+					break;
+				}
+				else if (m_code.slot_name(instr.a) == pgsIdent::m_now)
+				{
+					time_t now = wxDateTime::GetTimeNow();
+					value = pnew pgsNumber(wxString() << now);
+				}
+				else
+				{
+					value = pnew pgsString(wxT(""));
+				}
+				push(value);
+				break;
+			}
+
+			case PGS_OP_STORE:
+			{
+				pop(value);
+				pgsOperand &var = bind(instr.a);
+				detach(var.get());
+				var.swap(value);
+				break;
+			}
+
+			case PGS_OP_POP:
+				drop();
+				break;
+
+			case PGS_OP_EVAL:
+				// The parts of the tree still evaluated as such may assign
+				// variables the stack borrows from
+				detach();
+				value = m_code.expr(instr.a)->eval(m_vars);
+				push(value);
+				break;
+
+			case PGS_OP_EXEC:
+				detach();
+				m_code.stmt(instr.a)->eval(m_vars);
+				break;
+
+			case PGS_OP_PLUS:
+				value = top(1) + top(0);
+				drop(2);
+				push(value);
+				break;
+
+			case PGS_OP_MINUS:
+				value = top(1) - top(0);
+				drop(2);
+				push(value);
+				break;
+
+			case PGS_OP_TIMES:
+				value = top(1) * top(0);
+				drop(2);
+				push(value);
+				break;
+
+			case PGS_OP_OVER:
+				value = top(1) / top(0);
+				drop(2);
+				push(value);
+				break;
+
+			case PGS_OP_MODULO:
+				value = top(1) % top(0);
+				drop(2);
+				push(value);
+				break;
+
+			case PGS_OP_EQUAL:
+				value = top(1) == top(0);
+				drop(2);
+				push(value);
+				break;
+
+			case PGS_OP_ALMOST_EQUAL:
+				value = top(1) &= top(0);
+				drop(2);
+				push(value);
+				break;
+
+			case PGS_OP_DIFFERENT:
+				value = top(1) != top(0);
+				drop(2);
+				push(value);
+				break;
+
+			case PGS_OP_GREATER:
+				value = top(1) > top(0);
+				drop(2);
+				push(value);
+				break;
+
+			case PGS_OP_LOWER:
+				value = top(1) < top(0);
+				drop(2);
+				push(value);
+				break;
+
+			case PGS_OP_GREATER_EQUAL:
+				value = top(1) >= top(0);
+				drop(2);
+				push(value);
+				break;
+
+			case PGS_OP_LOWER_EQUAL:
+				value = top(1) <= top(0);
+				drop(2);
+				push(value);
+				break;
+
+			case PGS_OP_NOT:
+				value = !top();
+				drop();
+				push(value);
+				break;
+
+			case PGS_OP_TRIM:
+				value = pnew pgsString(top().value().Strip(wxString::both));
+				drop();
+				push(value);
+				break;
+
+			case PGS_OP_CAST:
+				value = pgsCast::cast(instr.a, top());
+				drop();
+				push(value);
+				break;
+
+			case PGS_OP_LINES:
+			{
+				pgsOperand *var = find(instr.a);
+				value = pgsLines::count(var != 0 ? var->get() : 0);
+				push(value);
+				break;
+			}
+
+			case PGS_OP_COLUMNS:
+			{
+				pgsOperand *var = find(instr.a);
+				value = pgsColumns::count(var != 0 ? var->get() : 0);
+				push(value);
+				break;
+			}
+
+			case PGS_OP_RECORD_CHECK:
+				if (record(instr.a) == 0)
+				{
+					throw pgsParameterException(wxString() << m_code.slot_name(instr.a)
+					                            << wxT(" is not a record"));
+				}
+				break;
+
+			case PGS_OP_RECORD_LINE:
+			{
+				pgsRecord *rec = record(instr.a);
+				if (rec != 0)
+					value = pgsIdentRecord::get(*rec, top(), 0);
+				else
+					value = pnew pgsString(wxT(""));
+				drop();
+				push(value);
+				break;
+			}
+
+			case PGS_OP_RECORD_GET:
+			{
+				pgsRecord *rec = record(instr.a);
+				if (rec != 0)
+					value = pgsIdentRecord::get(*rec, top(1), &top(0));
+				else
+					value = pnew pgsString(wxT(""));
+				drop(2);
+				push(value);
+				break;
+			}
+
+			case PGS_OP_RECORD_SET:
+			{
+				pgsRecord *rec = record(instr.a);
+				if (rec == 0)
+				{
+					throw pgsParameterException(wxString() << m_code.slot_name(instr.a)
+					                            << wxT(" is not a record"));
+				}
+				detach(rec);
+
+				const pgsAssignToRecord *expr =
+				    static_cast<const pgsAssignToRecord *>(m_code.expr(instr.b));
+				expr->assign(*rec, top(2), top(1), top(0));
+				drop(3);
+				break;
+			}
+
+			case PGS_OP_RECORD_REMOVE:
+			{
+				pgsRecord *rec = record(instr.a);
+				if (rec == 0)
+				{
+					throw pgsParameterException(wxString() << m_code.slot_name(instr.a)
+					                            << wxT(" is not a record"));
+				}
+				detach(rec);
+
+				const pgsRemoveLine *expr =
+				    static_cast<const pgsRemoveLine *>(m_code.expr(instr.b));
+				expr->remove(*rec, top());
+				drop();
+				break;
+			}
+
+			case PGS_OP_JUMP:
+				m_pc = instr.a;
+				continue;
+
+			case PGS_OP_JUMP_TRUE:
+			{
+				bool jump = top().pgs_is_true();
+				drop();
+				if (jump)
+				{
+					m_pc = instr.a;
+					continue;
+				}
+				break;
+			}
+
+			case PGS_OP_JUMP_FALSE:
+			{
+				bool jump = !top().pgs_is_true();
+				drop();
+				if (jump)
+				{
+					m_pc = instr.a;
+					continue;
+				}
+				break;
+			}
+
+			case PGS_OP_JUMP_NOT_RECORD:
+				if (record(instr.b) == 0)
+				{
+					m_pc = instr.a;
+					continue;
+				}
+				break;
+
+			case PGS_OP_LOOP:
+				if (m_app != 0 && m_app->TestDestroy())
+					throw pgsInterruptException();
+				m_pc = instr.a;
+				continue;
+
+			case PGS_OP_NEXT:
+				if (m_app != 0)
+				{
+					if (m_app->TestDestroy())
+						throw pgsInterruptException();
+					m_app->Yield();
+				}
+				break;
+
+			case PGS_OP_PRINT:
+			{
+				wxString output = top().value();
+				drop();
+
+				if (m_app != 0)
+				{
+					m_app->LockOutput();
+				}
+
+				m_cout << PGSOUTPGSCRIPT << wx_static_cast(const wxString, output)
+				       << wxT("\n");
+
+				if (m_app != 0)
+				{
+					m_app->UnlockOutput();
+				}
+				break;
+			}
+
+			case PGS_OP_ASSERT:
+			{
+				bool success = top().pgs_is_true();
+				drop();
+				if (!success)
+				{
+					throw pgsAssertException(m_code.expr(instr.a)->value());
+				}
+				break;
+			}
+
+			case PGS_OP_HALT:
+				return;
+		}
+
+		m_pc++;
+	}
+}
+
+pgsOperand *pgsMachine::find(const int &slot)
+{
+	if (m_slots[slot] == 0)
+	{
+		pgsVarMap::iterator it = m_vars.find(m_code.slot_name(slot));
+		if (it != m_vars.end())
+		{
+			m_slots[slot] = &it->second;
+		}
+	}
+	return m_slots[slot];
+}
+
+pgsOperand &pgsMachine::bind(const int &slot)
+{
+	if (m_slots[slot] == 0)
+	{
+		m_slots[slot] = &m_vars[m_code.slot_name(slot)];
+	}
+	return *m_slots[slot];
+}
+
+pgsRecord *pgsMachine::record(const int &slot)
+{
+	pgsOperand *var = find(slot);
+	if (var != 0 && (*var)->is_record())
+	{
+		return dynamic_cast<pgsRecord *>(&**var);
+	}
+	return 0;
+}
+
+const pgsVariable &pgsMachine::top(const int &i) const
+{
+	return *m_stack[m_top - 1 - i].var;
+}
+
+void pgsMachine::push(const pgsVariable *var, const bool &owned)
+{
+	wxASSERT(m_top < wxMax(m_code.depth(), 1));
+	m_stack[m_top].var = var;
+	m_stack[m_top].owned = owned;
+	m_top++;
+}
+
+void pgsMachine::push(pgsOperand &value)
+{
+	push(value.release(), true);
+}
+
+void pgsMachine::pop(pgsOperand &value)
+{
+	pgsStackItem &item = m_stack[--m_top];
+	if (item.owned)
+	{
+		value = const_cast<pgsVariable *>(item.var);
+	}
+	else
+	{
+		value = item.var->clone();
+	}
+}
+
+void pgsMachine::drop(const int &nb)
+{
+	for (int i = 0; i < nb; i++)
+	{
+		pgsStackItem &item = m_stack[--m_top];
+		if (item.owned)
+		{
+			pgsVariable *var = const_cast<pgsVariable *>(item.var);
+			pdelete(var);
+		}
+	}
+}
+
+void pgsMachine::detach(const pgsVariable *var)
+{
+	for (int i = 0; i < m_top; i++)
+	{
+		if (!m_stack[i].owned && m_stack[i].var == var)
+		{
+			m_stack[i].var = var->clone();
+			m_stack[i].owned = true;
+		}
+	}
+}
+
+void pgsMachine::detach()
+{
+	for (int i = 0; i < m_top; i++)
+	{
+		if (!m_stack[i].owned)
+		{
+			m_stack[i].var = m_stack[i].var->clone();
+			m_stack[i].owned = true;
+		}
+	}
+}
@@ -11,20 +11,32 @@
 #include "pgAdmin3.h"
 #include "pgscript/utilities/pgsThread.h"
 
+#include "db/pgConn.h"
 #include "pgscript/pgsApplication.h"
 #include "pgscript/statements/pgsProgram.h"
+#include "pgscript/utilities/pgsBench.h"
 #include "pgscript/utilities/pgsContext.h"
 #include "pgscript/utilities/pgsDriver.h"
 
+/** Most queries remembered: each loop of a script has a few at most, the
+ * other ones are executed only once. */
+#define PGS_MAX_PREPARED 256
+
+/** The scripts of an application are run one after the other. */
+static int s_run = 0;
+
 pgsThread::pgsThread(pgsVarMap &vars, wxSemaphore &mutex,
                      pgConn *connection, const wxString &file, pgsOutputStream &out,
                      pgsApplication &app, wxMBConv *conv) :
 	wxThread(wxTHREAD_DETACHED), m_vars(vars), m_mutex(mutex),
 	m_connection(connection), m_data(file), m_out(out),
-	m_app(app), m_conv(conv), m_last_error_line(-1)
+	m_app(app), m_conv(conv), m_last_error_line(-1),
+	m_last_prepared(0), m_run(0), m_cancelled(false), m_bench(0),
+	m_compiled(true)
 {
 	wxLogScript(wxT("Starting thread"));
 	m_mutex.Wait();
+	m_run = ++s_run;
 }
 
 pgsThread::pgsThread(pgsVarMap &vars, wxSemaphore &mutex,
@@ -32,10 +44,13 @@ pgsThread::pgsThread(pgsVarMap &vars, wxSemaphore &mutex,
                      pgsApplication &app) :
 	wxThread(wxTHREAD_DETACHED), m_vars(vars), m_mutex(mutex),
 	m_connection(connection), m_data(string), m_out(out),
-	m_app(app), m_conv(0), m_last_error_line(-1)
+	m_app(app), m_conv(0), m_last_error_line(-1),
+	m_last_prepared(0), m_run(0), m_cancelled(false), m_bench(0),
+	m_compiled(true)
 {
 	wxLogScript(wxT("Starting thread"));
 	m_mutex.Wait();
+	m_run = ++s_run;
 }
 
 pgsThread::~pgsThread()
@@ -48,7 +63,7 @@ pgsThread::~pgsThread()
 
 void *pgsThread::Entry()
 {
-	pgsProgram program(m_vars);
+	pgsProgram program(m_vars, m_out, this, m_compiled);
 	pgsContext context(m_out);
 	pgscript::pgsDriver driver(context, program, *this);
 
@@ -65,6 +80,8 @@ void *pgsThread::Entry()
 		wxLogScript(wxT("String  parsed"));
 	}
 
+	deallocate();
+
 	return 0;
 }
 
@@ -92,3 +109,155 @@ int pgsThread::last_error_line() const
 {
 	return m_last_error_line;
 }
+
+pgSet *pgsThread::execute(const wxString &stmt, const wxString &query,
+                          const wxArrayString &params, bool preparable)
+{
+	int number = -1;
+
+	if (preparable)
+	{
+		pgsPreparedMap::iterator it = m_prepared.find(query);
+		if (it == m_prepared.end())
+		{
+			// The first time it is executed as it is, as it may well be
+			// the only time
+			if (m_prepared.size() < PGS_MAX_PREPARED)
+				m_prepared[query] = 0;
+		}
+		else
+		{
+			if (it->second == 0)
+				it->second = prepare(query, params.GetCount());
+			number = it->second;
+		}
+	}
+
+	if (number > 0)
+	{
+		pgSet *set = m_connection->ExecutePrepared(prepared_name(number), params, false);
+
+		// The script may have deallocated the statement itself, it is
+		// prepared again next time
+		if (m_connection->GetLastResultStatus() == PGRES_FATAL_ERROR
+		        && m_connection->GetLastResultError().sql_state == wxT("26000")
+		        && m_connection->GetTxStatus() == PGCONN_TXSTATUS_IDLE)
+		{
+			m_prepared[query] = 0;
+			delete set;
+		}
+		else
+			return set;
+	}
+
+	pgSet *set = m_connection->ExecuteSet(stmt, false);
+
+	// Scripts can't feed or read a COPY: the connection is made usable
+	// again, the query is reported as failed
+	int status = m_connection->GetLastResultStatus();
+	if (status == PGRES_COPY_IN || status == PGRES_COPY_OUT)
+	{
+		PGconn *conn = m_connection->connection();
+		PGresult *res;
+		char *buf;
+
+		if (status == PGRES_COPY_IN)
+			PQputCopyEnd(conn, "not supported by pgScript");
+		else
+		{
+			while (PQgetCopyData(conn, &buf, 0) > 0)
+				PQfreemem(buf);
+		}
+
+		while ((res = PQgetResult(conn)) != NULL)
+			PQclear(res);
+	}
+
+	return set;
+}
+
+int pgsThread::prepare(const wxString &query, int nParams)
+{
+	int status = m_connection->GetTxStatus();
+
+	// In an aborted transaction, it has to wait for the next one
+	if (status == PGCONN_TXSTATUS_INERROR)
+		return 0;
+
+	// Within the transaction of the script, a failure must not abort it
+	bool savepoint = (status == PGCONN_TXSTATUS_INTRANS);
+	if (savepoint && !m_connection->ExecuteVoid(wxT("SAVEPOINT pgscript_prepare"), false))
+		return -1;
+
+	int number = m_last_prepared + 1;
+	bool prepared = m_connection->Prepare(prepared_name(number), query, nParams, false);
+
+	if (savepoint)
+	{
+		if (!prepared)
+			m_connection->ExecuteVoid(wxT("ROLLBACK TO SAVEPOINT pgscript_prepare"), false);
+		m_connection->ExecuteVoid(wxT("RELEASE SAVEPOINT pgscript_prepare"), false);
+	}
+
+	if (!prepared)
+	{
+		wxLogScript(wxT("Cannot prepare the query, executing it as text"));
+		return -1;
+	}
+
+	m_last_prepared = number;
+	return number;
+}
+
+wxString pgsThread::prepared_name(int number) const
+{
+	return wxString::Format(wxT("pgscript_%d_%d"), m_run, number);
+}
+
+void pgsThread::deallocate()
+{
+	if (m_last_prepared == 0 || m_connection == 0
+	        || m_connection->GetStatus() != PGCONN_OK)
+		return;
+
+	// An aborted transaction has to be ended by the user: the statements
+	// are left to the end of the session then, the names aren't reused
+	if (m_connection->GetTxStatus() == PGCONN_TXSTATUS_INERROR)
+		return;
+
+	for (int number = 1; number <= m_last_prepared; number++)
+	{
+		m_connection->ExecuteVoid(wxT("DEALLOCATE ")
+		                          + prepared_name(number), false);
+	}
+	m_prepared.clear();
+}
+
+void pgsThread::cancel()
+{
+	m_cancelled = true;
+	if (m_connection != 0)
+		m_connection->CancelExecution();
+}
+
+bool pgsThread::cancelled() const
+{
+	return m_cancelled;
+}
+
+void pgsThread::bench(pgsBench *bench)
+{
+	m_bench = bench;
+}
+
+void pgsThread::compiled(bool compiled)
+{
+	m_compiled = compiled;
+}
+
+void pgsThread::measure(const wxString &stmt, const wxLongLong_t &usec,
+                        const wxLongLong_t &rows)
+{
+	if (m_bench != 0)
+		m_bench->add(stmt, usec, rows);
+}
@@ -18,6 +18,7 @@ pgadmin3_SOURCES += \
         schema/pgAggregate.cpp \
         schema/pgCast.cpp \
         schema/pgCatalogObject.cpp \
+        schema/pgCatalogSnapshot.cpp \
         schema/pgCheck.cpp \
         schema/pgCollation.cpp \
         schema/pgCollection.cpp \
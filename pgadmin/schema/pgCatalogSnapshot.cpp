@@ -0,0 +1,162 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgCatalogSnapshot.cpp - Catalog rows of all the tables of a schema
+//
+//////////////////////////////////////////////////////////////////////////
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// App headers
+#include "pgAdmin3.h"
+#include "utils/misc.h"
+#include "schema/pgCatalogSnapshot.h"
+#include "schema/pgDatabase.h"
+
+
+pgCatalogSnapshotSet::~pgCatalogSnapshotSet()
+{
+	pgCatalogRowsMap::iterator it;
+	for (it = rows.begin(); it != rows.end(); ++it)
+		delete it->second;
+
+	if (set)
+		delete set;
+}
+
+
+pgCatalogSnapshot::pgCatalogSnapshot(pgDatabase *db, OID _schemaOid)
+{
+	database = db;
+	schemaOid = _schemaOid;
+	created = wxGetLocalTimeMillis();
+}
+
+
+pgCatalogSnapshot::~pgCatalogSnapshot()
+{
+	Clear();
+}
+
+
+void pgCatalogSnapshot::Clear()
+{
+	pgCatalogSnapshotSetMap::iterator it;
+	for (it = sets.begin(); it != sets.end(); ++it)
+	{
+		if (it->second)
+			delete it->second;
+	}
+	sets.clear();
+	relations.clear();
+}
+
+
+void pgCatalogSnapshot::AddRelation(OID relid)
+{
+	relations[relid] = true;
+}
+
+
+void pgCatalogSnapshot::Invalidate(OID relid)
+{
+	relations.erase(relid);
+}
+
+
+bool pgCatalogSnapshot::HasRelation(OID relid)
+{
+	// Don't show what the catalog looked like ages ago
+	if (!relations.empty() && wxGetLocalTimeMillis() - created > CATALOG_SNAPSHOT_LIFETIME * 1000)
+	{
+		wxLogInfo(wxT("Dropping the catalog snapshot of schema %lu"), schemaOid);
+		Clear();
+	}
+
+	return relations.find(relid) != relations.end();
+}
+
+
+wxString pgCatalogSnapshot::GetRelationFilter() const
+{
+	return wxT("IN (SELECT oid FROM pg_class WHERE relkind IN ('r','s','t') AND relnamespace = ") + NumToStr(schemaOid) + wxT(")");
+}
+
+
+pgSet *pgCatalogSnapshot::GetRelationSet(const wxString &query, const wxString &relColumn, OID relid)
+{
+	if (!HasRelation(relid))
+		return NULL;
+
+	pgCatalogSnapshotSet *snapshotSet;
+	pgCatalogSnapshotSetMap::iterator it = sets.find(query);
+
+	if (it == sets.end())
+	{
+		// Remember failed queries too, so they aren't repeated for every relation
+		snapshotSet = LoadSet(query, relColumn);
+		sets[query] = snapshotSet;
+	}
+	else
+		snapshotSet = it->second;
+
+	if (!snapshotSet || snapshotSet->served.find(relid) != snapshotSet->served.end())
+		return NULL;
+
+	snapshotSet->served[relid] = true;
+
+	pgSet *set;
+	pgCatalogRowsMap::iterator rows = snapshotSet->rows.find(relid);
+	if (rows == snapshotSet->rows.end())
+		set = snapshotSet->set->CopyRows(wxArrayLong());
+	else
+	{
+		set = snapshotSet->set->CopyRows(*rows->second);
+
+		delete rows->second;
+		snapshotSet->rows.erase(rows);
+	}
+
+	return set;
+}
+
+
+pgCatalogSnapshotSet *pgCatalogSnapshot::LoadSet(const wxString &query, const wxString &relColumn)
+{
+	wxLogInfo(wxT("Reading the catalog snapshot of schema %lu"), schemaOid);
+
+	pgSet *set = database->ExecuteSet(query);
+	if (!set)
+		return NULL;
+
+	int col = set->ColNumber(relColumn);
+	if (col < 0)
+	{
+		delete set;
+		return NULL;
+	}
+
+	pgCatalogSnapshotSet *snapshotSet = new pgCatalogSnapshotSet(set);
+
+	for (long row = 0; row < set->NumRows(); row++)
+	{
+		OID relid = (OID)strtoul(set->GetCharPtr(row, col), NULL, 10);
+
+		pgCatalogRowsMap::iterator it = snapshotSet->rows.find(relid);
+		if (it == snapshotSet->rows.end())
+		{
+			wxArrayLong *relRows = new wxArrayLong();
+			relRows->Add(row);
+			snapshotSet->rows[relid] = relRows;
+		}
+		else
+			it->second->Add(row);
+	}
+
+	return snapshotSet;
+}
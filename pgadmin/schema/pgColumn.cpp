@@ -550,12 +550,12 @@ pgObject *pgColumnFactory::CreateObjects(pgCollection *coll, ctlTree *browser, c
 	int currentlimit;
 
 	// grab inherited tables
-	sql = wxT("SELECT inhparent::regclass AS inhrelname,\n")
+	sql = wxT("SELECT inhrelid, inhparent::regclass AS inhrelname,\n")
 	      wxT("  (SELECT count(*) FROM pg_attribute WHERE attrelid=inhparent AND attnum>0) AS colscount\n")
 	      wxT("  FROM pg_inherits\n")
-	      wxT("  WHERE inhrelid =  ") + collection->GetOidStr() + wxT("::oid\n")
-	      wxT("  ORDER BY inhseqno");
-	pgSet *inhtables = database->ExecuteSet(sql);
+	      wxT("  WHERE inhrelid ");
+	pgSet *inhtables = collection->GetSchema()->ExecuteRelationSet(sql, wxT("\n  ORDER BY inhseqno"),
+	                   wxT("inhrelid"), collection->GetOid(), browser != 0);
 
 	wxString systemRestriction;
 	if (!settings->GetShowSystemObjects())
@@ -576,10 +576,7 @@ pgObject *pgColumnFactory::CreateObjects(pgCollection *coll, ctlTree *browser, c
 		    wxT("  EXISTS(SELECT 1 FROM  pg_constraint WHERE conrelid=att.attrelid AND contype='f'")
 		    wxT(" AND att.attnum=ANY(conkey)) As isfk");
 	if (database->BackendMinimumVersion(9, 1))
-	{
-		sql += wxT(",\n(SELECT array_agg(label) FROM pg_seclabels sl1 WHERE sl1.objoid=att.attrelid AND sl1.objsubid=att.attnum) AS labels");
-		sql += wxT(",\n(SELECT array_agg(provider) FROM pg_seclabels sl2 WHERE sl2.objoid=att.attrelid AND sl2.objsubid=att.attnum) AS providers");
-	}
+		sql += wxT(",\n  sl.labels, sl.providers");
 
 	sql += wxT("\n")
 	       wxT("  FROM pg_attribute att\n")
@@ -595,13 +592,16 @@ pgObject *pgColumnFactory::CreateObjects(pgCollection *coll, ctlTree *browser, c
 	       wxT("  LEFT OUTER JOIN pg_index pi ON pi.indrelid=att.attrelid AND indisprimary\n");
 	if (database->BackendMinimumVersion(9, 1))
 		sql += wxT("  LEFT OUTER JOIN pg_collation coll ON att.attcollation=coll.oid\n")
-		       wxT("  LEFT OUTER JOIN pg_namespace nspc ON coll.collnamespace=nspc.oid\n");
-	sql += wxT(" WHERE att.attrelid = ") + collection->GetOidStr()
-	       + restriction + systemRestriction + wxT("\n")
-	       wxT("   AND att.attisdropped IS FALSE\n")
-	       wxT(" ORDER BY att.attnum");
-
-	pgSet *columns = database->ExecuteSet(sql);
+		       wxT("  LEFT OUTER JOIN pg_namespace nspc ON coll.collnamespace=nspc.oid\n")
+		       wxT("  LEFT OUTER JOIN (SELECT objoid, objsubid, array_agg(label) AS labels, array_agg(provider) AS providers\n")
+		       wxT("                     FROM pg_seclabels GROUP BY objoid, objsubid) sl ON sl.objoid=att.attrelid AND sl.objsubid=att.attnum\n");
+	sql += wxT(" WHERE att.attrelid ");
+
+	pgSet *columns = collection->GetSchema()->ExecuteRelationSet(sql,
+	                 restriction + systemRestriction + wxT("\n")
+	                 wxT("   AND att.attisdropped IS FALSE\n")
+	                 wxT(" ORDER BY att.attnum"),
+	                 wxT("attrelid"), collection->GetOid(), browser != 0);
 	if (columns)
 	{
 		currentcol = 0;
@@ -174,8 +174,7 @@ int pgDatabase::Connect()
 		else
 		{
 			useServerConnection = false;
-			wxString applicationname = appearanceFactory->GetLongAppName() + _(" - Browser");
-			conn = CreateConn(applicationname);
+			conn = server->GetConnPool()->Borrow(GetName(), GetOid());
 
 			if (!conn)
 			{
@@ -225,12 +224,36 @@ void pgDatabase::CheckAlive()
 		connected = connection()->IsAlive();
 }
 
-void pgDatabase::Disconnect()
+// Once it's been unused for a while, the session of the database is parked
+// in the pool of the server, so the backend is shared with others, or
+// eventually closed. It's taken back when the database is used again.
+void pgDatabase::ParkIdleConnection()
 {
+	pgConnPool *pool = server->GetConnPool();
+
+	if (connected && conn && !useServerConnection && pool && !conn->IsParked() &&
+	        time(NULL) - conn->GetLastUsed() >= CONNPOOL_PARK_TIME)
+		conn->Park(pool);
+}
+
+// The connection is given back to the pool of the server. Before the
+// database is dropped or renamed, no connection must be left to it at all.
+void pgDatabase::Disconnect(bool closePooled)
+{
+	pgConnPool *pool = server->GetConnPool();
+
 	connected = false;
 	if (conn)
-		delete conn;
+	{
+		if (pool && !closePooled)
+			pool->Return(conn);
+		else
+			delete conn;
+	}
 	conn = 0;
+
+	if (pool && closePooled)
+		pool->Close(GetName());
 }
 
 
@@ -506,7 +529,7 @@ bool pgDatabase::DropObject(wxFrame *frame, ctlTree *browser, bool cascaded)
 
 		return false;
 	}
-	Disconnect();
+	Disconnect(true);
 
 	bool done = server->ExecuteVoid(wxT("DROP DATABASE ") + GetQuotedIdentifier() + wxT(";"));
 	if (!done)
@@ -285,7 +285,7 @@ pgObject *pgForeignKeyFactory::CreateObjects(pgCollection *coll, ctlTree *browse
 	pgTableObjCollection *collection = (pgTableObjCollection *)coll;
 	pgForeignKey *foreignKey = 0;
 
-	sql = wxT("SELECT ct.oid, conname, condeferrable, condeferred, confupdtype, confdeltype, confmatchtype, ")
+	sql = wxT("SELECT ct.oid, conrelid, conname, condeferrable, condeferred, confupdtype, confdeltype, confmatchtype, ")
 	      wxT("conkey, confkey, confrelid, nl.nspname as fknsp, cl.relname as fktab, ")
 	      wxT("nr.nspname as refnsp, cr.relname as reftab, description");
 	if (collection->GetDatabase()->BackendMinimumVersion(9, 1))
@@ -296,11 +296,12 @@ pgObject *pgForeignKeyFactory::CreateObjects(pgCollection *coll, ctlTree *browse
 	       wxT("  JOIN pg_class cr ON cr.oid=confrelid\n")
 	       wxT("  JOIN pg_namespace nr ON nr.oid=cr.relnamespace\n")
 	       wxT("  LEFT OUTER JOIN pg_description des ON (des.objoid=ct.oid AND des.classoid='pg_constraint'::regclass)\n")
-	       wxT(" WHERE contype='f' AND conrelid = ") + collection->GetOidStr()
-	       + restriction + wxT("\n")
-	       wxT(" ORDER BY conname");
+	       wxT(" WHERE contype='f' AND conrelid ");
 
-	pgSet *foreignKeys = collection->GetDatabase()->ExecuteSet(sql);
+	pgSet *foreignKeys = collection->GetSchema()->ExecuteRelationSet(sql,
+	                     restriction + wxT("\n")
+	                     wxT(" ORDER BY conname"),
+	                     wxT("conrelid"), collection->GetOid(), browser != 0);
 
 	if (foreignKeys)
 	{
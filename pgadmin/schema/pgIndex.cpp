@@ -559,10 +559,11 @@ pgObject *pgIndexBaseFactory::CreateObjects(pgCollection *coll, ctlTree *browser
 	         wxT("  LEFT OUTER JOIN pg_constraint con ON (con.tableoid = dep.refclassid AND con.oid = dep.refobjid)\n")
 	         wxT("  LEFT OUTER JOIN pg_description des ON (des.objoid=cls.oid AND des.classoid='pg_class'::regclass)\n")
 	         wxT("  LEFT OUTER JOIN pg_description desp ON (desp.objoid=con.oid AND desp.objsubid = 0 AND desp.classoid='pg_constraint'::regclass)\n")
-	         wxT(" WHERE indrelid = ") + collection->GetOidStr()
-	         + restriction + wxT("\n")
-	         wxT(" ORDER BY cls.relname");
-	pgSet *indexes = collection->GetDatabase()->ExecuteSet(query);
+	         wxT(" WHERE indrelid ");
+	pgSet *indexes = collection->GetSchema()->ExecuteRelationSet(query,
+	                 restriction + wxT("\n")
+	                 wxT(" ORDER BY cls.relname"),
+	                 wxT("indrelid"), collection->GetOid(), browser != 0);
 
 	if (indexes)
 	{
@@ -1238,7 +1238,7 @@ void pgServerObject::FillOwned(ctlTree *browser, ctlListView *referencedBy, cons
 
 		if (!conn)
 		{
-			tmpConn = GetServer()->CreateConn(dbname);
+			tmpConn = GetServer()->GetConnPool()->Borrow(dbname);
 			conn = tmpConn;
 		}
 
@@ -1318,7 +1318,7 @@ void pgServerObject::FillOwned(ctlTree *browser, ctlListView *referencedBy, cons
 		}
 
 		if (tmpConn)
-			delete tmpConn;
+			GetServer()->GetConnPool()->Return(tmpConn);
 	}
 }
 
@@ -17,6 +17,7 @@
 #include "frm/menu.h"
 #include "utils/misc.h"
 #include "schema/pgSchema.h"
+#include "schema/pgCatalogSnapshot.h"
 #include "frm/frmMain.h"
 #include "schema/pgCatalogObject.h"
 #include "schema/edbPackage.h"
@@ -177,6 +178,45 @@ wxString pgCatalog::GetTranslatedMessage(int kindOfMessage) const
 pgSchemaBase::pgSchemaBase(pgaFactory &factory, const wxString &newName)
 	: pgDatabaseObject(factory, newName)
 {
+	catalogSnapshot = 0;
+}
+
+
+pgSchemaBase::~pgSchemaBase()
+{
+	if (catalogSnapshot)
+		delete catalogSnapshot;
+}
+
+
+pgCatalogSnapshot *pgSchemaBase::NewCatalogSnapshot()
+{
+	if (catalogSnapshot)
+		delete catalogSnapshot;
+
+	catalogSnapshot = new pgCatalogSnapshot(GetDatabase(), GetOid());
+	return catalogSnapshot;
+}
+
+
+void pgSchemaBase::InvalidateCatalogSnapshot(OID relid)
+{
+	if (catalogSnapshot)
+		catalogSnapshot->Invalidate(relid);
+}
+
+
+pgSet *pgSchemaBase::ExecuteRelationSet(const wxString &select, const wxString &rest, const wxString &relColumn, OID relid, bool fromSnapshot)
+{
+	pgSet *set = 0;
+
+	if (fromSnapshot && catalogSnapshot && catalogSnapshot->HasRelation(relid))
+		set = catalogSnapshot->GetRelationSet(select + catalogSnapshot->GetRelationFilter() + rest, relColumn, relid);
+
+	if (!set)
+		set = GetDatabase()->ExecuteSet(select + wxT("= ") + NumToStr(relid) + rest);
+
+	return set;
 }
 
 wxString pgCatalog::GetDisplayName()
@@ -67,6 +67,7 @@ pgServer::pgServer(const wxString &newName, const wxString &newHostAddr, const w
 	lastSystemOID = 0;
 
 	conn = NULL;
+	connPool = NULL;
 	passwordValid = true;
 	storePwd = _storePwd;
 	rolename = newRolename;
@@ -95,6 +96,11 @@ pgServer::pgServer(const wxString &newName, const wxString &newHostAddr, const w
 
 pgServer::~pgServer()
 {
+	if (winMain && winMain->GetConnMonitor())
+		winMain->GetConnMonitor()->Unwatch(this);
+
+	if (connPool)
+		delete connPool;
 	if (conn)
 		delete conn;
 
@@ -276,6 +282,15 @@ bool pgServer::Disconnect(frmMain *form)
 	}
 #endif
 
+	if (winMain && winMain->GetConnMonitor())
+		winMain->GetConnMonitor()->Unwatch(this);
+
+	if (connPool)
+	{
+		delete connPool;
+		connPool = 0;
+	}
+
 	if (conn)
 	{
 		delete conn;
@@ -847,6 +862,10 @@ int pgServer::Connect(frmMain *form, bool askPassword, const wxString &pwd, bool
 		}
 
 		connected = true;
+		if (!connPool)
+			connPool = new pgConnPool(conn, appearanceFactory->GetLongAppName() + _(" - Browser"));
+		if (form && form->GetConnMonitor())
+			form->GetConnMonitor()->Watch(this, conn, GetSSHTunnel());
 		bool hasUptime = false;
 
 		wxString sql = wxT("SELECT usecreatedb, usesuper");
@@ -1221,6 +1240,17 @@ void pgServer::ShowTreeDetail(ctlTree *browser, frmMain *form, ctlListView *prop
 				properties->AppendItem(_("Configuration loaded since"), GetConfLoadedSince());
 			if (conn->BackendMinimumVersion(8, 1))
 				properties->AppendItem(wxT("Autovacuum"), (autovacuumRunning ? _("running") : _("not running")));
+
+			// What the connection monitor found out in the background
+			pgConnMonitorStats stats;
+			if (winMain && winMain->GetConnMonitor() && winMain->GetConnMonitor()->GetStats(this, stats) && stats.probes > 0)
+			{
+				properties->AppendYesNoItem(_("Responding?"), stats.alive);
+				if (stats.lastLatency >= 0)
+					properties->AppendItem(_("Response time"), wxString::Format(_("%ld ms (min %ld ms, average %ld ms, max %ld ms)"),
+					                       stats.lastLatency, stats.minLatency, stats.GetAvgLatency(), stats.maxLatency));
+				properties->AppendItem(_("Failed probes"), wxString::Format(wxT("%ld / %ld"), stats.failures, stats.probes));
+			}
 			if (conn->BackendMinimumVersion(8, 5))
 			{
 				properties->AppendItem(_("In recovery"), (GetInRecovery() ? _("yes") : _("no")));
@@ -17,6 +17,7 @@
 #include "frm/frmMain.h"
 #include "frm/frmMaintenance.h"
 #include "schema/pgTable.h"
+#include "schema/pgCatalogSnapshot.h"
 #include "schema/pgColumn.h"
 #include "schema/pgIndexConstraint.h"
 #include "schema/pgForeignKey.h"
@@ -1166,7 +1167,10 @@ pgObject *pgTable::Refresh(ctlTree *browser, const wxTreeItemId item)
 	pgTable *table = 0;
 	pgCollection *coll = browser->GetParentCollection(item);
 	if (coll)
+	{
+		GetSchema()->InvalidateCatalogSnapshot(GetOid());
 		table = (pgTable *)tableFactory.CreateObjects(coll, 0, wxT("\n   AND rel.oid=") + GetOidStr());
+	}
 
 	return table;
 }
@@ -1434,21 +1438,7 @@ pgObject *pgTableFactory::CreateObjects(pgCollection *collection, ctlTree *brows
 	{
 		query = wxT("SELECT rel.oid, rel.relname, rel.reltablespace AS spcoid, spc.spcname, pg_get_userbyid(rel.relowner) AS relowner, rel.relacl, rel.relhasoids, ")
 		        wxT("rel.relhassubclass, rel.reltuples, des.description, con.conname, con.conkey,\n")
-		        wxT("       EXISTS(select 1 FROM pg_trigger\n")
-		        wxT("                       JOIN pg_proc pt ON pt.oid=tgfoid AND pt.proname='logtrigger'\n")
-		        wxT("                       JOIN pg_proc pc ON pc.pronamespace=pt.pronamespace AND pc.proname='slonyversion'\n")
-		        wxT("                     WHERE tgrelid=rel.oid) AS isrepl,\n");
-
-		if (collection->GetConnection()->BackendMinimumVersion(9, 0))
-		{
-			query += wxT("       (select count(*) FROM pg_trigger\n")
-			         wxT("                     WHERE tgrelid=rel.oid AND tgisinternal = FALSE) AS triggercount\n");
-		}
-		else
-		{
-			query += wxT("       (select count(*) FROM pg_trigger\n")
-			         wxT("                     WHERE tgrelid=rel.oid AND tgisconstraint = FALSE) AS triggercount\n");
-		}
+		        wxT("       rpl.tgrelid IS NOT NULL AS isrepl, COALESCE(trc.triggercount, 0) AS triggercount\n");
 
 		if (collection->GetConnection()->BackendMinimumVersion(9, 1))
 			query += wxT(", rel.relpersistence \n");
@@ -1494,15 +1484,32 @@ pgObject *pgTableFactory::CreateObjects(pgCollection *collection, ctlTree *brows
 		if (collection->GetConnection()->BackendMinimumVersion(9, 0))
 			query += wxT(", rel.reloftype, typ.typname\n");
 		if (collection->GetDatabase()->BackendMinimumVersion(9, 1))
-		{
-			query += wxT(",\n(SELECT array_agg(label) FROM pg_seclabels sl1 WHERE sl1.objoid=rel.oid AND sl1.objsubid=0) AS labels");
-			query += wxT(",\n(SELECT array_agg(provider) FROM pg_seclabels sl2 WHERE sl2.objoid=rel.oid AND sl2.objsubid=0) AS providers");
-		}
+			query += wxT(", sl.labels, sl.providers\n");
 
+		// The triggers (and security labels) are joined as one set each,
+		// instead of looking them up for every single table
 		query += wxT("  FROM pg_class rel\n")
 		         wxT("  LEFT OUTER JOIN pg_tablespace spc on spc.oid=rel.reltablespace\n")
 		         wxT("  LEFT OUTER JOIN pg_description des ON (des.objoid=rel.oid AND des.objsubid=0 AND des.classoid='pg_class'::regclass)\n")
-		         wxT("  LEFT OUTER JOIN pg_constraint con ON con.conrelid=rel.oid AND con.contype='p'\n");
+		         wxT("  LEFT OUTER JOIN pg_constraint con ON con.conrelid=rel.oid AND con.contype='p'\n")
+		         wxT("  LEFT OUTER JOIN (SELECT DISTINCT tgrelid FROM pg_trigger\n")
+		         wxT("                     JOIN pg_proc pt ON pt.oid=tgfoid AND pt.proname='logtrigger'\n")
+		         wxT("                     JOIN pg_proc pc ON pc.pronamespace=pt.pronamespace AND pc.proname='slonyversion') rpl ON rpl.tgrelid=rel.oid\n");
+
+		if (collection->GetConnection()->BackendMinimumVersion(9, 0))
+		{
+			query += wxT("  LEFT OUTER JOIN (SELECT tgrelid, count(*) AS triggercount FROM pg_trigger\n")
+			         wxT("                    WHERE tgisinternal = FALSE GROUP BY tgrelid) trc ON trc.tgrelid=rel.oid\n");
+		}
+		else
+		{
+			query += wxT("  LEFT OUTER JOIN (SELECT tgrelid, count(*) AS triggercount FROM pg_trigger\n")
+			         wxT("                    WHERE tgisconstraint = FALSE GROUP BY tgrelid) trc ON trc.tgrelid=rel.oid\n");
+		}
+
+		if (collection->GetDatabase()->BackendMinimumVersion(9, 1))
+			query += wxT("  LEFT OUTER JOIN (SELECT objoid, array_agg(label) AS labels, array_agg(provider) AS providers FROM pg_seclabels\n")
+			         wxT("                    WHERE objsubid=0 GROUP BY objoid) sl ON sl.objoid=rel.oid\n");
 
 		// Add the toast table for vacuum parameters.
 		if (collection->GetConnection()->BackendMinimumVersion(8, 4))
@@ -1544,11 +1551,19 @@ pgObject *pgTableFactory::CreateObjects(pgCollection *collection, ctlTree *brows
 	tables = collection->GetDatabase()->ExecuteSet(query);
 	if (tables)
 	{
+		// Listing all the tables of the schema: their columns, indexes etc.
+		// can be read for the whole schema at once, when they're needed.
+		pgCatalogSnapshot *snapshot = 0;
+		if (browser && restriction.IsEmpty())
+			snapshot = collection->GetSchema()->NewCatalogSnapshot();
+
 		while (!tables->Eof())
 		{
 			table = new pgTable(collection->GetSchema(), tables->GetVal(wxT("relname")));
 
 			table->iSetOid(tables->GetOid(wxT("oid")));
+			if (snapshot)
+				snapshot->AddRelation(table->GetOid());
 			table->iSetOwner(tables->GetVal(wxT("relowner")));
 			table->iSetAcl(tables->GetVal(wxT("relacl")));
 			if (collection->GetConnection()->BackendMinimumVersion(8, 0))
@@ -415,12 +415,19 @@ pgObject *pgTriggerFactory::CreateObjects(pgCollection *coll, ctlTree *browser,
 	{
 		trig_sql += wxT("NOT tgisconstraint");
 	}
+	pgSet *triggers;
 	if (restriction.IsEmpty())
-		trig_sql += wxT("\n  AND tgrelid = ") + collection->GetOidStr() + wxT("\n");
+	{
+		trig_sql += wxT("\n  AND tgrelid ");
+		triggers = collection->GetSchema()->ExecuteRelationSet(trig_sql, wxT("\n ORDER BY tgname"),
+		           wxT("tgrelid"), collection->GetOid(), browser != 0);
+	}
 	else
+	{
 		trig_sql += restriction + wxT("\n");
-	trig_sql += wxT(" ORDER BY tgname");
-	pgSet *triggers = collection->GetDatabase()->ExecuteSet(trig_sql);
+		trig_sql += wxT(" ORDER BY tgname");
+		triggers = collection->GetDatabase()->ExecuteSet(trig_sql);
+	}
 
 	if (triggers)
 	{
@@ -140,3 +140,101 @@ wxString CSVLineTokenizer::GetNextLine(bool &partial)
 
 	return token;
 }
+
+void CSVRecordParser::Reset()
+{
+	m_input.Clear();
+	m_pos = 0;
+	m_state = CSV_FIELD_START;
+	m_field.Clear();
+	m_fields.Empty();
+}
+
+void CSVRecordParser::SetInput(const wxString &str)
+{
+	m_input = str;
+	m_pos = 0;
+}
+
+bool CSVRecordParser::GetNextRecord(wxArrayString &fields)
+{
+	const wxChar *s = m_input.c_str();
+	size_t len = m_input.length();
+	size_t run = m_pos;     // start of the characters not added to m_field yet
+
+	while (m_pos < len)
+	{
+		wxChar c = s[m_pos];
+
+		switch (m_state)
+		{
+			case CSV_FIELD_START:
+				if (c == wxT('\"'))
+				{
+					m_state = CSV_QUOTED;
+					run = ++m_pos;
+					continue;
+				}
+				if (c == wxT('\n') && m_fields.IsEmpty())
+				{
+					// Skip empty lines
+					run = ++m_pos;
+					continue;
+				}
+				m_state = CSV_UNQUOTED;
+				run = m_pos;
+				break;
+
+			case CSV_QUOTED:
+				if (c == wxT('\"'))
+				{
+					m_field.append(s + run, m_pos - run);
+					m_state = CSV_QUOTE;
+				}
+				m_pos++;
+				continue;
+
+			case CSV_QUOTE:
+				if (c == wxT('\"'))
+				{
+					// A doubled quote stands for one, which starts the next run
+					m_state = CSV_QUOTED;
+					run = m_pos++;
+					continue;
+				}
+				m_state = CSV_UNQUOTED;
+				run = m_pos;
+				break;
+		}
+
+		// CSV_UNQUOTED
+		if (c == wxT(',') || c == wxT('\n'))
+		{
+			m_field.append(s + run, m_pos - run);
+			if (c == wxT('\n') && !m_field.IsEmpty() && m_field.Last() == wxT('\r'))
+				m_field.RemoveLast();
+
+			m_fields.Add(m_field);
+			m_field.Clear();
+			m_state = CSV_FIELD_START;
+			run = ++m_pos;
+
+			if (c == wxT('\n'))
+			{
+				fields = m_fields;
+				m_fields.Empty();
+				return true;
+			}
+		}
+		else
+			m_pos++;
+	}
+
+	// Keep what's left of the piece for the next one
+	if (m_state == CSV_UNQUOTED || m_state == CSV_QUOTED)
+		m_field.append(s + run, len - run);
+
+	m_input.Clear();
+	m_pos = 0;
+	return false;
+}
@@ -0,0 +1,431 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// lockGraph.cpp - Wait-for graph of the backends of a server
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/arrimpl.cpp>
+
+// App headers
+#include "utils/lockGraph.h"
+
+WX_DEFINE_OBJARRAY(lockGraphObjects);
+WX_DEFINE_OBJARRAY(lockGraphNodes);
+
+// The table lock modes, and the ones each of them conflicts with
+enum
+{
+	LOCKMODE_UNKNOWN = 0,
+	LOCKMODE_ACCESSSHARE,
+	LOCKMODE_ROWSHARE,
+	LOCKMODE_ROWEXCLUSIVE,
+	LOCKMODE_SHAREUPDATEEXCLUSIVE,
+	LOCKMODE_SHARE,
+	LOCKMODE_SHAREROWEXCLUSIVE,
+	LOCKMODE_EXCLUSIVE,
+	LOCKMODE_ACCESSEXCLUSIVE
+};
+
+#define LOCKBIT(mode) (1 << LOCKMODE_##mode)
+
+static const int lockConflicts[] =
+{
+	0,
+	LOCKBIT(ACCESSEXCLUSIVE),
+	LOCKBIT(EXCLUSIVE) | LOCKBIT(ACCESSEXCLUSIVE),
+	LOCKBIT(SHARE) | LOCKBIT(SHAREROWEXCLUSIVE) | LOCKBIT(EXCLUSIVE) | LOCKBIT(ACCESSEXCLUSIVE),
+	LOCKBIT(SHAREUPDATEEXCLUSIVE) | LOCKBIT(SHARE) | LOCKBIT(SHAREROWEXCLUSIVE) | LOCKBIT(EXCLUSIVE) | LOCKBIT(ACCESSEXCLUSIVE),
+	LOCKBIT(ROWEXCLUSIVE) | LOCKBIT(SHAREUPDATEEXCLUSIVE) | LOCKBIT(SHAREROWEXCLUSIVE) | LOCKBIT(EXCLUSIVE) | LOCKBIT(ACCESSEXCLUSIVE),
+	LOCKBIT(ROWEXCLUSIVE) | LOCKBIT(SHAREUPDATEEXCLUSIVE) | LOCKBIT(SHARE) | LOCKBIT(SHAREROWEXCLUSIVE) | LOCKBIT(EXCLUSIVE) | LOCKBIT(ACCESSEXCLUSIVE),
+	LOCKBIT(ROWSHARE) | LOCKBIT(ROWEXCLUSIVE) | LOCKBIT(SHAREUPDATEEXCLUSIVE) | LOCKBIT(SHARE) | LOCKBIT(SHAREROWEXCLUSIVE) | LOCKBIT(EXCLUSIVE) | LOCKBIT(ACCESSEXCLUSIVE),
+	LOCKBIT(ACCESSSHARE) | LOCKBIT(ROWSHARE) | LOCKBIT(ROWEXCLUSIVE) | LOCKBIT(SHAREUPDATEEXCLUSIVE) | LOCKBIT(SHARE) | LOCKBIT(SHAREROWEXCLUSIVE) | LOCKBIT(EXCLUSIVE) | LOCKBIT(ACCESSEXCLUSIVE)
+};
+
+static const wxChar *lockModeNames[] =
+{
+	wxT(""),
+	wxT("AccessShareLock"),
+	wxT("RowShareLock"),
+	wxT("RowExclusiveLock"),
+	wxT("ShareUpdateExclusiveLock"),
+	wxT("ShareLock"),
+	wxT("ShareRowExclusiveLock"),
+	wxT("ExclusiveLock"),
+	wxT("AccessExclusiveLock")
+};
+
+
+lockGraph::lockGraph()
+{
+	roots = 0;
+	cycles = 0;
+	waiting = 0;
+}
+
+
+void lockGraph::Clear()
+{
+	objects.Empty();
+	objectIndex.clear();
+	nodes.Empty();
+	nodeIndex.clear();
+	order.Empty();
+
+	roots = 0;
+	cycles = 0;
+	waiting = 0;
+}
+
+
+int lockGraph::GetLockMode(const wxString &mode)
+{
+	for (int m = LOCKMODE_ACCESSSHARE; m <= LOCKMODE_ACCESSEXCLUSIVE; m++)
+	{
+		if (mode == lockModeNames[m])
+			return m;
+	}
+
+	// SIReadLock, which never blocks
+	return LOCKMODE_UNKNOWN;
+}
+
+
+bool lockGraph::Conflicts(int mode1, int mode2)
+{
+	return (lockConflicts[mode1] & (1 << mode2)) != 0;
+}
+
+
+void lockGraph::AddLock(long pid, const wxString &object, const wxString &name, const wxString &mode, bool granted)
+{
+	lockGraphObject *obj;
+	lockGraphObjectMap::iterator it = objectIndex.find(object);
+
+	if (it == objectIndex.end())
+	{
+		obj = new lockGraphObject();
+		obj->name = name;
+		objectIndex[object] = objects.GetCount();
+		objects.Add(obj);
+	}
+	else
+		obj = &objects[it->second];
+
+	wxArrayLong &locks = granted ? obj->holders : obj->waiters;
+	locks.Add(pid);
+	locks.Add(GetLockMode(mode));
+}
+
+
+int lockGraph::AddNode(long pid)
+{
+	lockGraphPidMap::iterator it = nodeIndex.find(pid);
+	if (it != nodeIndex.end())
+		return it->second;
+
+	lockGraphNode *node = new lockGraphNode();
+	node->pid = pid;
+
+	int i = nodes.GetCount();
+	nodeIndex[pid] = i;
+	nodes.Add(node);
+	return i;
+}
+
+
+int lockGraph::FindNode(long pid) const
+{
+	lockGraphPidMap::const_iterator it = nodeIndex.find(pid);
+	return it == nodeIndex.end() ? -1 : it->second;
+}
+
+
+void lockGraph::Build()
+{
+	nodes.Empty();
+	nodeIndex.clear();
+	order.Empty();
+
+	AddEdges();
+	FindComponents();
+	FindRoots();
+
+	// The objects aren't needed anymore
+	objects.Empty();
+	objectIndex.clear();
+}
+
+
+// A waiter waits for every other backend holding a lock on the object in
+// a conflicting mode. Waiters queued behind other waiters, which don't
+// conflict with any lock held, don't get an edge, as pg_locks doesn't tell
+// the order of the queue.
+void lockGraph::AddEdges()
+{
+	wxArrayInt seen;
+	int stamp = 0;
+
+	for (size_t o = 0; o < objects.GetCount(); o++)
+	{
+		const lockGraphObject &obj = objects[o];
+
+		for (size_t w = 0; w + 1 < obj.waiters.GetCount(); w += 2)
+		{
+			long waiterPid = obj.waiters.Item(w);
+			int waiterMode = obj.waiters.Item(w + 1);
+			int from = -1;
+
+			stamp++;
+			for (size_t h = 0; h + 1 < obj.holders.GetCount(); h += 2)
+			{
+				long holderPid = obj.holders.Item(h);
+				if (holderPid == waiterPid || !Conflicts(waiterMode, obj.holders.Item(h + 1)))
+					continue;
+
+				if (from < 0)
+				{
+					from = AddNode(waiterPid);
+					while (seen.GetCount() < nodes.GetCount())
+						seen.Add(0);
+				}
+
+				int to = AddNode(holderPid);
+				while (seen.GetCount() < nodes.GetCount())
+					seen.Add(0);
+
+				// The holder may hold the object in more than one mode
+				if (seen[to] == stamp)
+					continue;
+				seen[to] = stamp;
+
+				nodes[from].waitsFor.Add(to);
+				nodes[to].blocks.Add(from);
+			}
+
+			if (from >= 0 && nodes[from].waitingOn.IsEmpty())
+				nodes[from].waitingOn = wxString(lockModeNames[waiterMode]) + wxT(" ") + obj.name;
+		}
+	}
+
+	waiting = 0;
+	for (size_t i = 0; i < nodes.GetCount(); i++)
+	{
+		if (!nodes[i].waitsFor.IsEmpty())
+			waiting++;
+	}
+}
+
+
+// Tarjan's strongly connected components, without recursion, as the
+// chains may be long
+void lockGraph::FindComponents()
+{
+	size_t n = nodes.GetCount();
+	wxArrayInt index, low, onStack, stack, callNode, callEdge, members;
+	int counter = 0, components = 0;
+
+	cycles = 0;
+	if (!n)
+		return;
+
+	index.Add(-1, n);
+	low.Add(0, n);
+	onStack.Add(0, n);
+
+	for (size_t start = 0; start < n; start++)
+	{
+		if (index[start] >= 0)
+			continue;
+
+		index[start] = low[start] = counter++;
+		stack.Add(start);
+		onStack[start] = 1;
+		callNode.Add(start);
+		callEdge.Add(0);
+
+		while (!callNode.IsEmpty())
+		{
+			size_t top = callNode.GetCount() - 1;
+			int v = callNode[top];
+			size_t e = callEdge[top];
+
+			if (e < nodes[v].waitsFor.GetCount())
+			{
+				int w = nodes[v].waitsFor[e];
+				callEdge[top] = e + 1;
+
+				if (index[w] < 0)
+				{
+					index[w] = low[w] = counter++;
+					stack.Add(w);
+					onStack[w] = 1;
+					callNode.Add(w);
+					callEdge.Add(0);
+				}
+				else if (onStack[w])
+					low[v] = wxMin(low[v], index[w]);
+				continue;
+			}
+
+			if (low[v] == index[v])
+			{
+				int w;
+				members.Empty();
+				do
+				{
+					w = stack.Last();
+					stack.RemoveAt(stack.GetCount() - 1);
+					onStack[w] = 0;
+					nodes[w].component = components;
+					members.Add(w);
+				}
+				while (w != v);
+
+				if (members.GetCount() > 1)
+				{
+					for (size_t i = 0; i < members.GetCount(); i++)
+						nodes[members[i]].inCycle = true;
+					cycles++;
+				}
+				components++;
+			}
+
+			callNode.RemoveAt(top);
+			callEdge.RemoveAt(top);
+			if (top > 0)
+			{
+				int u = callNode[top - 1];
+				low[u] = wxMin(low[u], low[v]);
+			}
+		}
+	}
+}
+
+
+// The components nobody in them waits for anyone outside of are the roots:
+// a backend, which isn't waiting, or a deadlock. The others are laid out
+// by the steps to the nearest root.
+void lockGraph::FindRoots()
+{
+	size_t n = nodes.GetCount(), i, j;
+	wxArrayInt waitsOut, sources, visited, queue;
+	int components = 0;
+
+	roots = 0;
+	for (i = 0; i < n; i++)
+		components = wxMax(components, nodes[i].component + 1);
+
+	waitsOut.Add(0, components);
+	for (i = 0; i < n; i++)
+	{
+		for (j = 0; j < nodes[i].waitsFor.GetCount(); j++)
+		{
+			if (nodes[nodes[i].waitsFor[j]].component != nodes[i].component)
+				waitsOut[nodes[i].component] = 1;
+		}
+	}
+
+	// Count the backends waiting for each root, directly or not
+	visited.Add(-1, n);
+	wxArrayInt counted;
+	counted.Add(-1, components);
+
+	for (i = 0; i < n; i++)
+	{
+		int comp = nodes[i].component;
+		if (waitsOut[comp])
+			continue;
+
+		sources.Add(i);
+		if (counted[comp] >= 0)
+			continue;
+
+		queue.Empty();
+		for (j = i; j < n; j++)
+		{
+			if (nodes[j].component == comp)
+			{
+				visited[j] = comp;
+				queue.Add(j);
+			}
+		}
+
+		size_t members = queue.GetCount();
+		for (j = 0; j < queue.GetCount(); j++)
+		{
+			const wxArrayInt &blocks = nodes[queue[j]].blocks;
+			for (size_t k = 0; k < blocks.GetCount(); k++)
+			{
+				if (visited[blocks[k]] != comp)
+				{
+					visited[blocks[k]] = comp;
+					queue.Add(blocks[k]);
+				}
+			}
+		}
+
+		counted[comp] = queue.GetCount() - members;
+		roots++;
+	}
+
+	for (i = 0; i < sources.GetCount(); i++)
+		nodes[sources[i]].blocked = counted[nodes[sources[i]].component];
+
+	// Start with the roots blocking most, walking the edges backwards
+	for (i = 0; i < sources.GetCount(); i++)
+	{
+		const lockGraphNode &node = nodes[sources[i]];
+		size_t lo = 0, hi = order.GetCount();
+
+		while (lo < hi)
+		{
+			size_t mid = (lo + hi) / 2;
+			const lockGraphNode &other = nodes[order[mid]];
+			if (other.blocked > node.blocked || (other.blocked == node.blocked && other.pid < node.pid))
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		order.Insert(sources[i], lo);
+		nodes[sources[i]].layer = 0;
+	}
+
+	for (i = 0; i < order.GetCount(); i++)
+	{
+		int u = order[i];
+		const wxArrayInt &blocks = nodes[u].blocks;
+
+		for (j = 0; j < blocks.GetCount(); j++)
+		{
+			lockGraphNode &v = nodes[blocks[j]];
+			if (v.layer < 0)
+			{
+				v.layer = nodes[u].layer + 1;
+				v.next = u;
+				order.Add(blocks[j]);
+			}
+		}
+	}
+}
+
+
+wxArrayLong lockGraph::GetChain(int node) const
+{
+	wxArrayLong chain;
+
+	while (node >= 0 && chain.GetCount() <= nodes.GetCount())
+	{
+		chain.Add(nodes[node].pid);
+		node = nodes[node].next;
+	}
+	return chain;
+}
@@ -16,6 +16,8 @@ pgadmin3_SOURCES += \
 	utils/misc.cpp \
 	utils/pgconfig.cpp \
 	utils/registry.cpp \
+	utils/lockGraph.cpp \
+	utils/statusHistory.cpp \
 	utils/sysLogger.cpp \
 	utils/sysProcess.cpp \
 	utils/sysSettings.cpp \
@@ -0,0 +1,683 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2014, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// statusHistory.cpp - Recorded activity of the Server Status window
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/filename.h>
+#include <wx/arrimpl.cpp>
+
+// App headers
+#include "utils/statusHistory.h"
+#include "utils/misc.h"
+
+WX_DEFINE_OBJARRAY(statusHistoryRows);
+WX_DEFINE_OBJARRAY(statusHistoryFrames);
+WX_DEFINE_OBJARRAY(statusHistoryWaits);
+WX_DEFINE_OBJARRAY(statusHistoryBlockers);
+
+WX_DECLARE_STRING_HASH_MAP(size_t, statusHistoryWaitMap);
+WX_DECLARE_HASH_MAP(long, statusHistoryBlocker *, wxIntegerHash, wxIntegerEqual, statusHistoryBlockerMap);
+
+// The changed columns of a row are flagged in a mask, the highest bit of
+// which flags a changed state
+#define HISTORY_MAX_COLUMNS 31
+#define HISTORY_STATE_BIT   0x80000000U
+
+
+static void PutByte(wxMemoryBuffer &buf, unsigned char value)
+{
+	buf.AppendByte((char)value);
+}
+
+
+static void PutInt(wxMemoryBuffer &buf, wxUint32 value)
+{
+	buf.AppendData(&value, sizeof(value));
+}
+
+
+static void PutString(wxMemoryBuffer &buf, const wxString &text)
+{
+	wxCharBuffer utf = text.mb_str(wxConvUTF8);
+	const char *data = utf.data();
+	wxUint32 len = data ? strlen(data) : 0;
+
+	PutInt(buf, len);
+	if (len)
+		buf.AppendData(data, len);
+}
+
+
+static bool GetByte(const char *&p, const char *last, unsigned char &value)
+{
+	if (last - p < 1)
+		return false;
+	value = (unsigned char) * p++;
+	return true;
+}
+
+
+static bool GetInt(const char *&p, const char *last, wxUint32 &value)
+{
+	if (last - p < (ptrdiff_t)sizeof(value))
+		return false;
+	memcpy(&value, p, sizeof(value));
+	p += sizeof(value);
+	return true;
+}
+
+
+static bool GetString(const char *&p, const char *last, wxString &text)
+{
+	wxUint32 len;
+	if (!GetInt(p, last, len) || (wxUint32)(last - p) < len)
+		return false;
+	text = len ? wxString(p, wxConvUTF8, len) : wxString();
+	p += len;
+	return true;
+}
+
+
+// FNV-1a of the UTF-8 text
+static wxUint32 HashQuery(const wxString &query)
+{
+	wxCharBuffer utf = query.mb_str(wxConvUTF8);
+	const unsigned char *c = (const unsigned char *)utf.data();
+	wxUint32 hash = 2166136261U;
+
+	for (; c && *c; c++)
+	{
+		hash ^= *c;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+
+static int CompareWaits(statusHistoryWait **a, statusHistoryWait **b)
+{
+	if ((*a)->seconds != (*b)->seconds)
+		return (*a)->seconds > (*b)->seconds ? -1 : 1;
+	return 0;
+}
+
+
+static int CompareBlockers(statusHistoryBlocker **a, statusHistoryBlocker **b)
+{
+	if ((*a)->seconds != (*b)->seconds)
+		return (*a)->seconds > (*b)->seconds ? -1 : 1;
+	return 0;
+}
+
+
+statusHistory::statusHistory(int _blockedCol, int _queryCol)
+{
+	blockedCol = _blockedCol;
+	queryCol = _queryCol;
+
+	failed = false;
+	writePos = 0;
+
+	firstFrame = 0;
+	sinceKey = 0;
+	queryBytes = 0;
+
+	replayFrame = -1;
+}
+
+
+statusHistory::~statusHistory()
+{
+	if (file.IsOpened())
+		file.Close();
+	if (!fileName.IsEmpty() && wxFileExists(fileName))
+		wxRemoveFile(fileName);
+}
+
+
+bool statusHistory::Open()
+{
+	if (failed)
+		return false;
+
+	fileName = wxFileName::CreateTempFileName(wxT("pgadmin_status"));
+	if (fileName.IsEmpty() || !file.Open(fileName, wxFile::read_write))
+	{
+		wxLogError(_("Could not create a temporary file for the activity history, the activity won't be recorded."));
+		failed = true;
+		return false;
+	}
+	return true;
+}
+
+
+wxDateTime statusHistory::GetFrameTime(long number) const
+{
+	long index = number - firstFrame;
+	if (index < 0 || index >= (long)frames.GetCount())
+		return wxDateTime();
+
+	wxDateTime time((time_t)(frames[index].time / 1000).ToLong());
+	time.SetMillisecond((frames[index].time % 1000).ToLong());
+	return time;
+}
+
+
+bool statusHistory::Record(const statusHistoryRows &rows)
+{
+	if (!file.IsOpened() && !Open())
+		return false;
+	if (failed)
+		return false;
+
+	long number = firstFrame + frames.GetCount();
+	bool key = frames.IsEmpty() || sinceKey >= HISTORY_KEY_INTERVAL;
+	wxMemoryBuffer buf;
+
+	EncodeFrame(rows, key, number, buf);
+	size_t size = buf.GetDataLen();
+	if (size > HISTORY_FILE_SIZE / 4)
+	{
+		wxLogInfo(wxT("Not recording the activity, a frame would take %d bytes"), (int)size);
+		return false;
+	}
+
+	wxFileOffset pos = writePos;
+	if (pos + (wxFileOffset)size > HISTORY_FILE_SIZE)
+	{
+		// Start over at the beginning. The frames behind the end of the
+		// last lap are the oldest ones, and won't be reached anymore.
+		while (!frames.IsEmpty() && frames[0].offset >= pos)
+			DropFrame();
+		pos = 0;
+	}
+	DropFrames(pos, size);
+
+	if (!key && frames.IsEmpty())
+	{
+		// The frames this one was based on have been overwritten
+		key = true;
+		buf.SetDataLen(0);
+		EncodeFrame(rows, true, number, buf);
+		size = buf.GetDataLen();
+		if (pos + (wxFileOffset)size > HISTORY_FILE_SIZE)
+			pos = 0;
+	}
+
+	if (file.Seek(pos) == wxInvalidOffset || file.Write(buf.GetData(), size) != size)
+	{
+		wxLogError(_("Could not write to the temporary file for the activity history, the activity won't be recorded anymore."));
+		failed = true;
+		return false;
+	}
+
+	statusHistoryFrame *frame = new statusHistoryFrame();
+	frame->time = wxGetLocalTimeMillis();
+	frame->offset = pos;
+	frame->size = size;
+	frame->key = key;
+	frames.Add(frame);
+
+	writePos = pos + size;
+	sinceKey = key ? 1 : sinceKey + 1;
+	lastRows = rows;
+
+	PruneQueries();
+	return true;
+}
+
+
+void statusHistory::DropFrame()
+{
+	frames.RemoveAt(0);
+	firstFrame++;
+
+	if (replayFrame < firstFrame)
+		replayFrame = -1;
+}
+
+
+// Drop the frames, which are overwritten by one written at offset, and then
+// the ones up to the next key frame, which can't be replayed without them.
+void statusHistory::DropFrames(wxFileOffset offset, size_t size)
+{
+	while (!frames.IsEmpty() &&
+	        frames[0].offset < offset + (wxFileOffset)size &&
+	        frames[0].offset + (wxFileOffset)frames[0].size > offset)
+		DropFrame();
+
+	while (!frames.IsEmpty() && !frames[0].key)
+		DropFrame();
+}
+
+
+// The texts of the queries are kept, as long as a frame still kept could
+// refer to them. Key frames refer to all the queries of their rows, and the
+// first frame kept is a key frame.
+void statusHistory::PruneQueries()
+{
+	if (queryBytes <= HISTORY_QUERY_BUDGET)
+		return;
+
+	wxArrayLong dropped;
+	statusHistoryQueryMap::iterator it;
+	for (it = queries.begin(); it != queries.end(); ++it)
+	{
+		if (it->second.lastFrame < firstFrame)
+			dropped.Add((long)it->first);
+	}
+
+	for (size_t i = 0; i < dropped.GetCount(); i++)
+	{
+		it = queries.find((wxUint32)dropped.Item(i));
+		queryBytes -= sizeof(statusHistoryQuery) + it->second.text.Length() * sizeof(wxChar);
+		queries.erase(it);
+	}
+}
+
+
+// Returns the hash the query is written as, or 0 if its text needs to be
+// written, as another query has got the same hash.
+wxUint32 statusHistory::AddQuery(const wxString &query, long number)
+{
+	wxUint32 hash = HashQuery(query);
+	if (!hash)
+		return 0;
+
+	statusHistoryQueryMap::iterator it = queries.find(hash);
+	if (it != queries.end())
+	{
+		if (it->second.text != query)
+			return 0;
+		it->second.lastFrame = number;
+		return hash;
+	}
+
+	statusHistoryQuery &entry = queries[hash];
+	entry.text = query;
+	entry.lastFrame = number;
+	queryBytes += sizeof(statusHistoryQuery) + query.Length() * sizeof(wxChar);
+	return hash;
+}
+
+
+// A frame is:
+//   key (byte), number of columns (byte), number of rows (int)
+//   for every row: pid (int), mask of the columns written (int),
+//                  state (byte, if flagged), the columns flagged
+//   number of lock edges (int), and the pid waiting and the pid waited for
+//   of each of them (int, int)
+// The columns are texts (length, UTF-8), except the query (hash, or 0 and
+// the text). The PID and "blocked by" columns aren't written as such.
+void statusHistory::EncodeFrame(const statusHistoryRows &rows, bool key, long number, wxMemoryBuffer &buf)
+{
+	statusHistoryPidMap prev;
+	wxArrayLong edges;
+	size_t i;
+	int col, cols = rows.GetCount() ? wxMin((int)rows[0].cols.GetCount(), HISTORY_MAX_COLUMNS) : 0;
+
+	if (!key)
+	{
+		for (i = 0; i < lastRows.GetCount(); i++)
+			prev[lastRows[i].pid] = i;
+	}
+
+	PutByte(buf, key ? 1 : 0);
+	PutByte(buf, cols);
+	PutInt(buf, rows.GetCount());
+
+	for (i = 0; i < rows.GetCount(); i++)
+	{
+		const statusHistoryRow &row = rows[i];
+		const statusHistoryRow *old = NULL;
+		wxUint32 mask = 0;
+
+		statusHistoryPidMap::iterator it = prev.find(row.pid);
+		if (it != prev.end())
+			old = &lastRows[it->second];
+
+		for (col = 1; col < cols && col < (int)row.cols.GetCount(); col++)
+		{
+			if (col == blockedCol)
+				continue;
+			if (!old || col >= (int)old->cols.GetCount() || old->cols[col] != row.cols[col])
+				mask |= 1U << col;
+		}
+		if (!old || old->state != row.state)
+			mask |= HISTORY_STATE_BIT;
+
+		PutInt(buf, (wxUint32)row.pid);
+		PutInt(buf, mask);
+		if (mask & HISTORY_STATE_BIT)
+			PutByte(buf, row.state);
+
+		for (col = 1; col < cols && col < (int)row.cols.GetCount(); col++)
+		{
+			if (!(mask & (1U << col)))
+				continue;
+
+			if (col == queryCol)
+			{
+				wxUint32 hash = AddQuery(row.cols[col], number);
+				PutInt(buf, hash);
+				if (hash)
+					continue;
+			}
+			PutString(buf, row.cols[col]);
+		}
+
+		if (blockedCol > 0 && blockedCol < (int)row.cols.GetCount() && !row.cols[blockedCol].IsEmpty())
+		{
+			edges.Add(row.pid);
+			edges.Add(StrToLong(row.cols[blockedCol]));
+		}
+	}
+
+	PutInt(buf, edges.GetCount() / 2);
+	for (i = 0; i < edges.GetCount(); i++)
+		PutInt(buf, (wxUint32)edges.Item(i));
+}
+
+
+bool statusHistory::ReadFrame(long index, wxMemoryBuffer &buf)
+{
+	const statusHistoryFrame &frame = frames[index];
+
+	buf.SetDataLen(0);
+	if (file.Seek(frame.offset) == wxInvalidOffset)
+		return false;
+
+	ssize_t read = file.Read(buf.GetWriteBuf(frame.size), frame.size);
+	buf.UngetWriteBuf(read > 0 ? read : 0);
+	return read == (ssize_t)frame.size;
+}
+
+
+// Apply a frame to the rows of the frame before it (which are ignored for a
+// key frame)
+bool statusHistory::DecodeFrame(const wxMemoryBuffer &buf, const statusHistoryRows &prev, statusHistoryRows &rows, wxArrayLong *edges)
+{
+	const char *p = (const char *)buf.GetData(), *last = p + buf.GetDataLen();
+	statusHistoryPidMap prevPids, pids;
+	statusHistoryPidMap::iterator it;
+	unsigned char key, cols, state;
+	wxUint32 count, pid, mask, hash;
+	size_t i;
+	int col;
+
+	rows.Empty();
+	if (edges)
+		edges->Empty();
+
+	if (!GetByte(p, last, key) || !GetByte(p, last, cols) || !GetInt(p, last, count))
+		return false;
+
+	if (!key)
+	{
+		for (i = 0; i < prev.GetCount(); i++)
+			prevPids[prev[i].pid] = i;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		if (!GetInt(p, last, pid) || !GetInt(p, last, mask))
+			return false;
+
+		statusHistoryRow *row = new statusHistoryRow();
+		rows.Add(row);
+
+		it = prevPids.find((long)(wxInt32)pid);
+		if (it != prevPids.end())
+			*row = prev[it->second];
+		else
+		{
+			for (col = 0; col < cols; col++)
+				row->cols.Add(wxEmptyString);
+		}
+
+		row->pid = (long)(wxInt32)pid;
+		if (row->cols.GetCount())
+			row->cols[0] = NumToStr(row->pid);
+
+		if (mask & HISTORY_STATE_BIT)
+		{
+			if (!GetByte(p, last, state))
+				return false;
+			row->state = state;
+		}
+
+		for (col = 1; col < cols; col++)
+		{
+			if (!(mask & (1U << col)))
+				continue;
+			if (col >= (int)row->cols.GetCount())
+				return false;
+
+			if (col == queryCol)
+			{
+				if (!GetInt(p, last, hash))
+					return false;
+				if (hash)
+				{
+					statusHistoryQueryMap::iterator q = queries.find(hash);
+					row->cols[col] = q != queries.end() ? q->second.text : wxString();
+					continue;
+				}
+			}
+			if (!GetString(p, last, row->cols[col]))
+				return false;
+		}
+
+		if (blockedCol > 0 && blockedCol < (int)row->cols.GetCount())
+			row->cols[blockedCol] = wxEmptyString;
+		pids[row->pid] = i;
+	}
+
+	if (!GetInt(p, last, count))
+		return false;
+
+	for (i = 0; i < count; i++)
+	{
+		wxUint32 waiter, holder;
+		if (!GetInt(p, last, waiter) || !GetInt(p, last, holder))
+			return false;
+
+		if (edges)
+		{
+			edges->Add((long)(wxInt32)waiter);
+			edges->Add((long)(wxInt32)holder);
+		}
+
+		it = pids.find((long)(wxInt32)waiter);
+		if (it != pids.end() && blockedCol > 0 && blockedCol < (int)rows[it->second].cols.GetCount())
+			rows[it->second].cols[blockedCol] = NumToStr((long)(wxInt32)holder);
+	}
+
+	return true;
+}
+
+
+// Replay the frames from the key frame before the one asked for, or from
+// the one replayed last, when scrubbing forward
+bool statusHistory::GetFrame(long number, statusHistoryRows &rows)
+{
+	long index = number - firstFrame, i, start;
+	statusHistoryRows prev;
+	wxMemoryBuffer buf;
+
+	if (index < 0 || index >= (long)frames.GetCount())
+		return false;
+
+	for (start = index; start > 0 && !frames[start].key; start--)
+		;
+
+	i = start;
+	if (replayFrame >= firstFrame + start && replayFrame <= number)
+	{
+		prev = replayRows;
+		i = replayFrame - firstFrame + 1;
+	}
+
+	for (; i <= index; i++)
+	{
+		if (!ReadFrame(i, buf) || !DecodeFrame(buf, prev, rows))
+		{
+			replayFrame = -1;
+			return false;
+		}
+		prev = rows;
+	}
+
+	replayFrame = number;
+	replayRows = prev;
+	rows = prev;
+	return true;
+}
+
+
+// Go through all the frames kept. Every frame counts for the time until the
+// next one was recorded.
+bool statusHistory::Aggregate(statusHistoryWaits &waits, statusHistoryBlockers &blockers, size_t maxEntries)
+{
+	statusHistoryRows prev, rows;
+	statusHistoryWaitMap waitIndex;
+	statusHistoryBlockerMap open;
+	statusHistoryBlockerMap::iterator b;
+	wxArrayLong edges;
+	wxMemoryBuffer buf;
+	long i, count = frames.GetCount();
+	size_t j;
+	bool ok = true;
+
+	waits.Empty();
+	blockers.Empty();
+
+	for (i = 0; i < count; i++)
+	{
+		if (!ReadFrame(i, buf) || !DecodeFrame(buf, prev, rows, &edges))
+		{
+			ok = false;
+			break;
+		}
+
+		double seconds = 0;
+		if (i + 1 < count)
+			seconds = (frames[i + 1].time - frames[i].time).ToDouble() / 1000.0;
+
+		statusHistoryPidMap pids, holding;
+		statusHistoryPidMap::iterator it;
+		statusHistoryWaitMap waiting;
+
+		for (j = 0; j < rows.GetCount(); j++)
+			pids[rows[j].pid] = j;
+
+		for (j = 0; j + 1 < edges.GetCount(); j += 2)
+		{
+			wxString query;
+			it = pids.find(edges.Item(j));
+			if (it != pids.end() && queryCol < (int)rows[it->second].cols.GetCount())
+				query = rows[it->second].cols[queryCol];
+
+			waiting[query]++;
+			holding[edges.Item(j + 1)]++;
+		}
+
+		for (statusHistoryWaitMap::iterator w = waiting.begin(); w != waiting.end(); ++w)
+		{
+			statusHistoryWaitMap::iterator at = waitIndex.find(w->first);
+			statusHistoryWait *wait;
+
+			if (at == waitIndex.end())
+			{
+				wait = new statusHistoryWait();
+				wait->query = w->first;
+				wait->seconds = 0;
+				wait->maxWaiting = 0;
+				waitIndex[w->first] = waits.GetCount();
+				waits.Add(wait);
+			}
+			else
+				wait = &waits[at->second];
+
+			wait->seconds += seconds * w->second;
+			if ((long)w->second > wait->maxWaiting)
+				wait->maxWaiting = w->second;
+		}
+
+		// Blockers, which have stopped blocking, are done with
+		wxArrayLong done;
+		for (b = open.begin(); b != open.end(); ++b)
+		{
+			if (holding.find(b->first) == holding.end())
+				done.Add(b->first);
+		}
+		for (j = 0; j < done.GetCount(); j++)
+		{
+			blockers.Add(open[done.Item(j)]);
+			open.erase(done.Item(j));
+		}
+
+		for (it = holding.begin(); it != holding.end(); ++it)
+		{
+			statusHistoryBlocker *blocker;
+
+			b = open.find(it->first);
+			if (b == open.end())
+			{
+				blocker = new statusHistoryBlocker();
+				blocker->pid = it->first;
+				blocker->start = frames[i].time;
+				blocker->seconds = 0;
+				blocker->maxWaiting = 0;
+
+				statusHistoryPidMap::iterator holder = pids.find(it->first);
+				if (holder != pids.end() && queryCol < (int)rows[holder->second].cols.GetCount())
+					blocker->query = rows[holder->second].cols[queryCol];
+				open[it->first] = blocker;
+			}
+			else
+				blocker = b->second;
+
+			blocker->seconds += seconds;
+			if ((long)it->second > blocker->maxWaiting)
+				blocker->maxWaiting = it->second;
+		}
+
+		prev = rows;
+	}
+
+	for (b = open.begin(); b != open.end(); ++b)
+	{
+		if (ok)
+			blockers.Add(b->second);
+		else
+			delete b->second;
+	}
+
+	if (!ok)
+	{
+		waits.Empty();
+		blockers.Empty();
+		return false;
+	}
+
+	waits.Sort(CompareWaits);
+	if (waits.GetCount() > maxEntries)
+		waits.RemoveAt(maxEntries, waits.GetCount() - maxEntries);
+
+	blockers.Sort(CompareBlockers);
+	if (blockers.GetCount() > maxEntries)
+		blockers.RemoveAt(maxEntries, blockers.GetCount() - maxEntries);
+
+	return true;
+}
@@ -33,6 +33,7 @@ sysSettings::sysSettings(const wxString &name) : wxConfig(name)
 {
 	// Open the default settings file
 	defaultSettings = NULL;
+	resultFormatGeneration = 0;
 	if (!settingsIni.IsEmpty())
 	{
 		wxFileInputStream fst(settingsIni);
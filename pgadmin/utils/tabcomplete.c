@@ -26,6 +26,7 @@
  * Callbacks to the C++ world
  */
 char *pg_query_to_single_ordered_string(char *query, void *dbptr);
+char *pg_cached_completion(const char *kind, const char *text, const char *addon, void *dbptr);
 
 
 /*
@@ -227,12 +228,48 @@ static char *complete_from_const(const char *text, const char *string)
 	return strdup(string);
 }
 
+/*
+ * The kind of names a query lists, as known to the completion cache of the
+ * database, or NULL if the query has to be sent to the server.
+ */
+static const char *completion_kind(const char *query, const SchemaQuery *squery)
+{
+	if (squery == &Query_for_list_of_tables)
+		return "r";
+	if (squery == &Query_for_list_of_views)
+		return "v";
+	if (squery == &Query_for_list_of_sequences)
+		return "S";
+	if (squery == &Query_for_list_of_indexes)
+		return "i";
+	if (squery == &Query_for_list_of_tsv)
+		return "rSv";
+	if (squery == &Query_for_list_of_tisv)
+		return "riSv";
+	if (squery == &Query_for_list_of_functions)
+		return "f";
+	if (query != NULL && strcmp(query, Query_for_list_of_attributes) == 0)
+		return "a";
+	if (query != NULL && strcmp(query, Query_for_list_of_schemas) == 0)
+		return "n";
+	return NULL;
+}
+
 static char *_complete_from_query(const char *text, const char *query, const SchemaQuery *squery, const char *addon, void *dbptr)
 {
 	int string_length = strlen(text);
 	char *e_text;
 	char *complete_query = NULL;
 	char *t;
+	const char *kind = completion_kind(query, squery);
+
+	/* Try the names cached in the background first. A schema query's addon adds extra names. */
+	if (kind != NULL && (squery == NULL || addon == NULL))
+	{
+		t = pg_cached_completion(kind, text, addon, dbptr);
+		if (t != NULL)
+			return t;
+	}
 
 	e_text = malloc(string_length*2+1);
 	PQescapeString(e_text, text, string_length);